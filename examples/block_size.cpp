@@ -0,0 +1,91 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <atomic>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_params;
+        using zaudio::time_point;
+        using zaudio::stream_context;
+        using zaudio::make_stream_params;
+        using zaudio::make_audio_stream;
+        using zaudio::start_stream;
+        using zaudio::stop_stream;
+        using zaudio::thread_sleep;
+        using zaudio::buffer_group;
+        using zaudio::null_stream_api;
+        using zaudio::null_stream_clock;
+
+        //create an alias for a 32 bit float sample
+        using sample_type = sample<sample_format::f32>;
+
+        auto&& context = stream_context<sample_type>{std::unique_ptr<zaudio::stream_api<sample_type>>{new null_stream_api<sample_type>(null_stream_clock::free_running)}};
+
+        //device buffers of 441 frames, as some hosts hand out 10 ms at 44.1kHz
+        auto&& params = make_stream_params<sample_type>(44100,441,2,2);
+
+        std::atomic<long> callbacks{0};
+        std::atomic<bool> fixed{true};
+
+        //an fft sized processor, it only ever wants whole blocks
+        auto&& callback = [&](buffer_group<sample_type>& buffers,
+                              time_point stream_time,
+                              stream_params<sample_type>& params) noexcept
+        {
+            if(buffers.output.frame_count() != params.block_size())
+            {
+                fixed = false;
+            }
+            for(auto&& frame: buffers.output)
+            {
+                for(auto&& samp: frame)
+                {
+                    samp = 0;
+                }
+            }
+            ++callbacks;
+            return no_error;
+        };
+
+        //1024 needs a fifo, 147 divides the device buffer and is sliced in place
+        for(std::size_t block: {1024,147})
+        {
+            params.block_size(block);
+            callbacks = 0;
+            auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+            start_stream(stream);
+            thread_sleep(std::chrono::milliseconds(500));
+            stop_stream(stream);
+            std::cout<<"Block Size: "<<block<<std::endl;
+            std::cout<<"Callbacks: "<<callbacks.load()<<(fixed.load() ? ", all of them full blocks" : ", some of them short")<<std::endl;
+            std::cout<<"Added Latency: "<<stream.block_latency()<<" frames"<<std::endl;
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
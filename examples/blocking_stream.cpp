@@ -0,0 +1,91 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_mode;
+        using zaudio::stream_context;
+        using zaudio::make_stream_context;
+        using zaudio::make_stream_params;
+        using zaudio::audio_stream;
+        using zaudio::buffer_view;
+        using zaudio::null_stream_api;
+        using zaudio::two_pi;
+
+        //create an alias for a 32 bit float sample
+        using sample_type = sample<sample_format::f32>;
+
+        //the null api paces blocking writes like a device, make_stream_context<sample_type>() would use the real one
+        auto&& context = make_stream_context<sample_type,null_stream_api>();
+
+        //the device runs 16 bit, writes are converted a buffer at a time
+        auto&& params = make_stream_params<sample_type>(48000,256,0,2);
+        params.mode(stream_mode::blocking);
+        params.device_format(sample_format::i16);
+
+        //a decoder or network receiver would hand us batches much larger than a device buffer
+        constexpr std::size_t batch = 4800;
+        std::vector<sample_type> samples(batch * params.output_frame_width());
+        buffer_view<sample_type> view(samples.data(),batch,params.output_frame_width());
+
+        sample_type phs = 0;
+        sample_type stp = 440.0 / params.sample_rate() * two_pi;
+
+        audio_stream<sample_type> stream(params,context);
+        stream.start();
+        auto&& start = zaudio::stream_time_base::audio_clock::now();
+        for(int i = 0; i < 20; ++i)
+        {
+            for(auto&& frame: view)
+            {
+                auto&& value = std::sin(phs);
+                if((phs += stp) > two_pi) { phs -= two_pi; }
+                for(auto&& samp: frame)
+                {
+                    samp = value;
+                }
+            }
+            //returns once the device has room for the last of the batch
+            auto&& err = stream.write(view);
+            if(err != no_error)
+            {
+                std::cout<<err.second<<std::endl;
+                break;
+            }
+        }
+        auto&& elapsed = std::chrono::duration<double>(zaudio::stream_time_base::audio_clock::now() - start).count();
+        std::cout<<"Wrote "<<20 * batch / params.sample_rate()<<" seconds of audio in "<<elapsed<<" seconds, "
+                 <<stream.write_available()<<" frames can be written without waiting"<<std::endl;
+        stream.stop();
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+//a stereo callback of 512 frames
+constexpr std::size_t frames = 512;
+constexpr std::size_t channels = 2;
+constexpr std::size_t samples = frames * channels;
+
+//runs f until at least the given time has passed, returns samples per second
+template<typename F>
+double samples_per_second(F&& f, double seconds = 0.1)
+{
+    using audio_clock = stream_time_base::audio_clock;
+    std::size_t count = 0;
+    auto&& start = audio_clock::now();
+    auto&& elapsed = 0.0;
+    do
+    {
+        for(int i = 0; i < 64; ++i)
+        {
+            f();
+        }
+        count += 64 * samples;
+        elapsed = std::chrono::duration<double>(audio_clock::now() - start).count();
+    }
+    while(elapsed < seconds);
+    return count / elapsed;
+}
+
+template<typename sample_t>
+bool same(const std::vector<sample_t>& a, const std::vector<sample_t>& b)
+{
+    return std::memcmp(a.data(),b.data(),a.size() * sizeof(sample_t)) == 0;
+}
+
+//times the exported kernel against the scalar template and checks both produce the same bits
+template<typename sample_t, typename K, typename R>
+void row(const char* name, const std::vector<sample_t>& input, K&& kernel, R&& reference)
+{
+    std::vector<sample_t> a = input;
+    std::vector<sample_t> b = input;
+    kernel(a);
+    reference(b);
+    auto&& exact = same(a,b);
+    auto&& fast = samples_per_second([&]{ kernel(a); });
+    auto&& slow = samples_per_second([&]{ reference(b); });
+    std::cout<<std::setw(12)<<name<<std::fixed<<std::setprecision(0)
+             <<std::setw(12)<<fast / 1e6<<std::setw(12)<<slow / 1e6
+             <<std::setw(8)<<(exact ? "yes" : "NO")<<std::endl;
+}
+
+template<typename sample_t>
+void run(const char* name)
+{
+    std::cout<<std::endl<<name<<", "<<frames<<" frames of "<<channels<<" channels, millions of samples per second"<<std::endl;
+    std::cout<<std::setw(12)<<"op"<<std::setw(12)<<"kernel"<<std::setw(12)<<"scalar"<<std::setw(8)<<"exact"<<std::endl;
+    std::vector<sample_t> input(samples);
+    std::vector<sample_t> other(samples);
+    for(std::size_t i = 0; i < samples; ++i)
+    {
+        input[i] = static_cast<sample_t>(((i * 7919) % 2001)) / sample_t(1000) - sample_t(1);
+        other[i] = static_cast<sample_t>(((i * 104729) % 2001)) / sample_t(1000) - sample_t(1);
+    }
+    row<sample_t>("fill",input,
+        [](std::vector<sample_t>& v){ fill_samples(v.data(),v.size(),sample_t(0)); },
+        [](std::vector<sample_t>& v){ fill_samples<sample_t>(v.data(),v.size(),sample_t(0)); });
+    row<sample_t>("copy",input,
+        [&](std::vector<sample_t>& v){ copy_samples(other.data(),v.data(),v.size()); },
+        [&](std::vector<sample_t>& v){ copy_samples<sample_t>(other.data(),v.data(),v.size()); });
+    //gains of minus one keep repeated runs from drifting into denormals or overflow
+    row<sample_t>("gain",input,
+        [](std::vector<sample_t>& v){ apply_gain(v.data(),v.size(),sample_t(-1)); },
+        [](std::vector<sample_t>& v){ apply_gain<sample_t>(v.data(),v.size(),sample_t(-1)); });
+    row<sample_t>("gain ramp",input,
+        [](std::vector<sample_t>& v){ apply_gain_ramp(v.data(),frames,channels,sample_t(-1),sample_t(-1)); },
+        [](std::vector<sample_t>& v){ apply_gain_ramp<sample_t>(v.data(),frames,channels,sample_t(-1),sample_t(-1)); });
+    row<sample_t>("mix",input,
+        [&](std::vector<sample_t>& v){ mix_samples(other.data(),v.data(),v.size(),sample_t(-0.0)); },
+        [&](std::vector<sample_t>& v){ mix_samples<sample_t>(other.data(),v.data(),v.size(),sample_t(-0.0)); });
+    row<sample_t>("clip",input,
+        [](std::vector<sample_t>& v){ clip_samples(v.data(),v.size(),sample_t(-0.5),sample_t(0.5)); },
+        [](std::vector<sample_t>& v){ clip_samples<sample_t>(v.data(),v.size(),sample_t(-0.5),sample_t(0.5)); });
+    //each side keeps its own filter state
+    std::vector<sample_t> kernel_x1(channels), kernel_y1(channels), scalar_x1(channels), scalar_y1(channels);
+    row<sample_t>("dc removal",input,
+        [&](std::vector<sample_t>& v){ remove_dc(v.data(),frames,channels,sample_t(0.995),kernel_x1.data(),kernel_y1.data()); },
+        [&](std::vector<sample_t>& v){ remove_dc<sample_t>(v.data(),frames,channels,sample_t(0.995),scalar_x1.data(),scalar_y1.data()); });
+    //reductions, the result is written back so the comparison covers it
+    row<sample_t>("peak",input,
+        [](std::vector<sample_t>& v){ v[0] = sample_peak(v.data(),v.size()); },
+        [](std::vector<sample_t>& v){ v[0] = sample_peak<sample_t>(v.data(),v.size()); });
+    row<sample_t>("sum",input,
+        [](std::vector<sample_t>& v){ v[0] = sample_sum(v.data() + 1,v.size() - 1); },
+        [](std::vector<sample_t>& v){ v[0] = sample_sum<sample_t>(v.data() + 1,v.size() - 1); });
+}
+
+int main(int argc, char** argv)
+{
+    std::cout<<"avx2: "<<(cpu_has_avx2() ? "yes" : "no")<<", sse2: "<<(cpu_has_sse2() ? "yes" : "no")<<std::endl;
+    run<float>("float32");
+    run<double>("float64");
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <cstdint>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+using sample_type = sample<sample_format::f32>;
+
+//a processor that does almost nothing so the dispatch cost dominates
+class gain_process final : public audio_process<sample_type>
+{
+public:
+    std::atomic<std::uint64_t> calls{0};
+
+    virtual stream_error on_process(buffer_group<sample_type>& buffers, time_point, stream_params<sample_type>&) noexcept
+    {
+        calls.store(calls.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+        buffers.output[0][0] = sample_type(0.5f);
+        return no_error;
+    }
+};
+
+//device buffers of 256 frames regrouped into blocks of one frame, so the stream calls the callback 256 times per buffer
+//everything but the call itself is the same for every kind of callback
+template<typename make_stream_t>
+double nanoseconds_per_call(make_stream_t&& make_stream, const std::atomic<std::uint64_t>& calls)
+{
+    auto&& context = stream_context<sample_type>{std::unique_ptr<stream_api<sample_type>>{new null_stream_api<sample_type>(null_stream_clock::free_running)}};
+    auto&& params = make_stream_params<sample_type>(48000,256,0,2);
+    params.block_size(1);
+    auto&& stream = make_stream(params,context);
+    start_stream(stream);
+    thread_sleep(std::chrono::milliseconds(200));
+    auto&& before = calls.load();
+    auto&& start = stream_time_base::audio_clock::now();
+    thread_sleep(std::chrono::seconds(1));
+    auto&& counted = calls.load() - before;
+    auto&& elapsed = stream_time_base::audio_clock::now() - start;
+    stop_stream(stream);
+    return std::chrono::duration<double,std::nano>(elapsed).count() / counted;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //only the audio thread writes the counters, so a plain load and store is enough
+        std::atomic<std::uint64_t> lambda_calls{0};
+        auto&& lambda = [&](buffer_group<sample_type>& buffers, time_point, stream_params<sample_type>&) noexcept
+        {
+            lambda_calls.store(lambda_calls.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+            buffers.output[0][0] = sample_type(0.5f);
+            return no_error;
+        };
+        gain_process proc;
+
+        std::cout<<std::fixed<<std::setprecision(2)<<"Stream cost per callback call, blocks of one frame:"<<std::endl;
+        std::cout<<"\tlambda via std::function:        "<<nanoseconds_per_call([&](stream_params<sample_type>& params, stream_context<sample_type>& context)
+        {
+            return audio_stream<sample_type>(params,context,stream_callback<sample_type>{lambda});
+        },lambda_calls)<<"ns"<<std::endl;
+        std::cout<<"\tlambda, statically dispatched:   "<<nanoseconds_per_call([&](stream_params<sample_type>& params, stream_context<sample_type>& context)
+        {
+            return audio_stream<sample_type>(params,context,lambda);
+        },lambda_calls)<<"ns"<<std::endl;
+        std::cout<<"\taudio_process via std::bind:     "<<nanoseconds_per_call([&](stream_params<sample_type>& params, stream_context<sample_type>& context)
+        {
+            return audio_stream<sample_type>(params,context,proc.get_callback());
+        },proc.calls)<<"ns"<<std::endl;
+        std::cout<<"\taudio_process, statically dispatched: "<<nanoseconds_per_call([&](stream_params<sample_type>& params, stream_context<sample_type>& context)
+        {
+            return audio_stream<sample_type>(params,context,proc);
+        },proc.calls)<<"ns"<<std::endl;
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
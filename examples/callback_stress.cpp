@@ -0,0 +1,134 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <cmath>
+#include <atomic>
+#include <zaudio.hpp>
+
+//swaps the stream callback thousands of times per second while the stream runs
+//and reports the worst case timing seen by the audio thread and the swapping thread
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_params;
+        using zaudio::stream_callback;
+        using zaudio::time_point;
+        using zaudio::make_stream_context;
+        using zaudio::make_stream_params;
+        using zaudio::make_audio_stream;
+        using zaudio::start_stream;
+        using zaudio::stop_stream;
+        using zaudio::thread_sleep;
+        using zaudio::buffer_group;
+        using zaudio::two_pi;
+
+        using sample_type = sample<sample_format::f32>;
+        using audio_clock = zaudio::stream_time_base::audio_clock;
+        using nanoseconds = std::chrono::nanoseconds;
+
+        auto&& context = make_stream_context<sample_type>();
+
+        auto&& params = make_stream_params<sample_type>(44100,128,0,2);
+
+        const auto swaps_per_second = 5000;
+        const auto run_time = std::chrono::seconds(5);
+
+        std::atomic<long long> worst_interval{0};
+        std::atomic<long long> worst_callback{0};
+        std::atomic<long> callback_count{0};
+        std::atomic<long long> last_entry{0};
+
+        auto&& update_max = [](std::atomic<long long>& target, long long value) noexcept
+        {
+            auto&& current = target.load(std::memory_order_relaxed);
+            while(value > current && !target.compare_exchange_weak(current,value,std::memory_order_relaxed)){ continue; }
+        };
+
+        //every callback measures the time since the previous one and the time it spends running
+        auto&& make_sine = [&](sample_type hz) noexcept
+        {
+            auto&& phs = std::make_shared<sample_type>(0);
+            return stream_callback<sample_type>([&,phs,hz](buffer_group<sample_type>& buffers,
+                                                           time_point stream_time,
+                                                           stream_params<sample_type>& params) noexcept
+            {
+                auto&& entry = std::chrono::duration_cast<nanoseconds>(audio_clock::now().time_since_epoch()).count();
+                auto&& previous = last_entry.exchange(entry,std::memory_order_relaxed);
+                if(previous != 0)
+                {
+                    update_max(worst_interval,entry - previous);
+                }
+
+                sample_type stp = hz / params.sample_rate() * two_pi;
+                for(auto&& frame: buffers.output)
+                {
+                    auto&& value = std::sin(*phs);
+                    if((*phs += stp) > two_pi) { *phs -= two_pi; }
+                    for(auto&& samp: frame)
+                    {
+                        samp = value;
+                    }
+                }
+
+                ++callback_count;
+                update_max(worst_callback,std::chrono::duration_cast<nanoseconds>(audio_clock::now().time_since_epoch()).count() - entry);
+                return no_error;
+            });
+        };
+
+        auto&& low = make_sine(440.0);
+        auto&& high = make_sine(660.0);
+
+        auto&& stream = make_audio_stream<sample_type>(params,context,low);
+
+        start_stream(stream);
+
+        long swaps = 0;
+        long long worst_exchange = 0;
+        auto&& start = audio_clock::now();
+        while(audio_clock::now() - start < run_time)
+        {
+            auto&& before = audio_clock::now();
+            stream.exchange_callback(stream_callback<sample_type>(swaps % 2 == 0 ? high : low));
+            worst_exchange = std::max<long long>(worst_exchange,std::chrono::duration_cast<nanoseconds>(audio_clock::now() - before).count());
+            ++swaps;
+            thread_sleep(std::chrono::microseconds(1000000 / swaps_per_second));
+        }
+
+        stop_stream(stream);
+
+        auto&& period = 1e9 * params.frame_count() / params.sample_rate();
+        std::cout<<"Swaps: "<<swaps<<std::endl;
+        std::cout<<"Callbacks: "<<callback_count.load()<<std::endl;
+        std::cout<<"Buffer period: "<<period / 1000.0<<"us"<<std::endl;
+        std::cout<<"Worst callback interval: "<<worst_interval.load() / 1000.0<<"us"<<std::endl;
+        std::cout<<"Worst callback duration: "<<worst_callback.load() / 1000.0<<"us"<<std::endl;
+        std::cout<<"Worst exchange_callback duration: "<<worst_exchange / 1000.0<<"us"<<std::endl;
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
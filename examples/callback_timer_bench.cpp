@@ -0,0 +1,93 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <cstdint>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+constexpr std::size_t iterations = std::size_t(1) << 24;
+
+//nanoseconds per call of f, averaged over iterations calls
+template<typename F>
+double per_call(F&& f)
+{
+    auto&& start = stream_time_base::audio_clock::now();
+    for(std::size_t i = 0; i < iterations; ++i)
+    {
+        f(i);
+    }
+    return std::chrono::duration<double,std::nano>(stream_time_base::audio_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        using sample_type = sample<sample_format::f32>;
+
+        //what stream_api adds per device buffer, one clock reading and one record
+        std::atomic<std::int64_t> sink{0};
+        auto&& clock_cost = per_call([&](std::size_t)
+        {
+            sink.store(stream_time_base::audio_clock::now().time_since_epoch().count(),std::memory_order_relaxed);
+        });
+        callback_timer timer;
+        auto&& record_cost = per_call([&](std::size_t i)
+        {
+            //spread the durations over many buckets like a real callback would
+            timer.record(2000 + (i * 2654435761u) % 100000,5333333);
+        });
+        std::cout<<std::fixed<<std::setprecision(1)
+                 <<"clock read: "<<clock_cost<<"ns, record: "<<record_cost<<"ns, per buffer: "<<clock_cost + record_cost<<"ns"<<std::endl;
+        std::cout<<"synthetic: "<<timer.statistics()<<std::endl;
+
+        //a free running null stream, the callback burns a little time so the histogram has something to show
+        auto&& context = stream_context<sample_type>{std::unique_ptr<stream_api<sample_type>>{new null_stream_api<sample_type>(null_stream_clock::free_running)}};
+        auto&& params = make_stream_params<sample_type>(48000,256,0,2);
+        auto&& callback = [&](buffer_group<sample_type>& buffers,
+                              time_point stream_time,
+                              stream_params<sample_type>& params) noexcept
+        {
+            sample_type phase = sample_type(buffers.timing.frame_position % 97);
+            for(auto&& frame: buffers.output)
+            {
+                phase = phase * sample_type(0.999) + sample_type(0.001);
+                for(auto&& samp: frame)
+                {
+                    samp = phase;
+                }
+            }
+            return no_error;
+        };
+        auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+        start_stream(stream);
+        thread_sleep(std::chrono::milliseconds(500));
+        //only what happens after the stream settled
+        stream.reset_callback_statistics();
+        thread_sleep(std::chrono::seconds(1));
+        stop_stream(stream);
+        std::cout<<"null stream: "<<stream.callback_statistics()<<std::endl;
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
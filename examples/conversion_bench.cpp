@@ -0,0 +1,121 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+//one buffer of 512 frames of stereo, the size a callback would convert
+constexpr std::size_t block = 1024;
+
+const sample_format device_formats[] = {sample_format::f32,sample_format::f64,sample_format::u8,sample_format::i8,
+                                        sample_format::i16,sample_format::i24,sample_format::i32,sample_format::i64};
+
+//runs f over the block until at least the given time has passed, returns samples per second
+template<typename F>
+double samples_per_second(F&& f, double seconds = 0.1)
+{
+    using audio_clock = stream_time_base::audio_clock;
+    std::size_t samples = 0;
+    auto&& start = audio_clock::now();
+    auto&& elapsed = 0.0;
+    do
+    {
+        for(int i = 0; i < 64; ++i)
+        {
+            f();
+        }
+        samples += 64 * block;
+        elapsed = std::chrono::duration<double>(audio_clock::now() - start).count();
+    }
+    while(elapsed < seconds);
+    return samples / elapsed;
+}
+
+//the generic conversion, used as the scalar reference for every pair
+template<typename sample_t,typename device_t>
+void reference_to_device(const sample_t* in, void* out, std::size_t count, dither_state* dither)
+{
+    convert_samples<sample_t,device_t>(in,static_cast<device_t*>(out),count,dither);
+}
+
+template<typename sample_t>
+typename sample_converter<sample_t>::to_device_type reference_converter(sample_format device)
+{
+    switch(device)
+    {
+    case sample_format::f32: return &reference_to_device<sample_t,float>;
+    case sample_format::f64: return &reference_to_device<sample_t,double>;
+    case sample_format::u8:  return &reference_to_device<sample_t,std::uint8_t>;
+    case sample_format::i8:  return &reference_to_device<sample_t,std::int8_t>;
+    case sample_format::i16: return &reference_to_device<sample_t,std::int16_t>;
+    case sample_format::i24: return &reference_to_device<sample_t,sample<sample_format::i24>>;
+    case sample_format::i32: return &reference_to_device<sample_t,std::int32_t>;
+    default:                 return &reference_to_device<sample_t,std::int64_t>;
+    }
+}
+
+template<typename sample_t>
+void run(const char* name)
+{
+    std::vector<sample_t> app(block);
+    for(std::size_t i = 0; i < block; ++i)
+    {
+        app[i] = static_cast<sample_t>(0.9 * std::sin(i * 0.01));
+    }
+    //full precision values spread over every lsb, some past full scale, for the exactness check
+    std::vector<sample_t> probe(block);
+    for(std::size_t i = 0; i < block; ++i)
+    {
+        probe[i] = static_cast<sample_t>(1.1 * std::sin(i * 12.9898));
+    }
+    std::vector<unsigned char> device(block * sizeof(double));
+    dither_state dither;
+
+    std::cout<<std::endl<<name<<" <-> device, millions of samples per second"<<std::endl;
+    std::cout<<std::setw(16)<<"device"<<std::setw(12)<<"to device"<<std::setw(12)<<"+tpdf"<<std::setw(12)<<"scalar"<<std::setw(12)<<"from device"<<std::setw(8)<<"exact"<<std::endl;
+    for(auto&& format: device_formats)
+    {
+        auto&& converter = make_sample_converter<sample_t>(format);
+        auto&& reference = reference_converter<sample_t>(format);
+        //without dither the kernels round to nearest exactly like the scalar reference
+        std::vector<unsigned char> expected(block * sizeof(double));
+        converter.to_device(probe.data(),device.data(),block,nullptr);
+        reference(probe.data(),expected.data(),block,nullptr);
+        auto&& exact = std::equal(expected.begin(),expected.begin() + block * sample_size(format),device.begin());
+        auto&& to = samples_per_second([&]{ converter.to_device(app.data(),device.data(),block,nullptr); });
+        auto&& dithered = samples_per_second([&]{ converter.to_device(app.data(),device.data(),block,&dither); });
+        auto&& scalar = samples_per_second([&]{ reference(app.data(),device.data(),block,nullptr); });
+        auto&& from = samples_per_second([&]{ converter.from_device(device.data(),app.data(),block); });
+        std::cout<<std::setw(16)<<format<<std::fixed<<std::setprecision(0)
+                 <<std::setw(12)<<to / 1e6<<std::setw(12)<<dithered / 1e6<<std::setw(12)<<scalar / 1e6<<std::setw(12)<<from / 1e6
+                 <<std::setw(8)<<(exact ? "yes" : "NO")<<std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::cout<<"avx2: "<<(cpu_has_avx2() ? "yes" : "no")<<", sse2: "<<(cpu_has_sse2() ? "yes" : "no")<<std::endl;
+    run<float>("float32");
+    run<double>("float64");
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <cstdlib>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_params;
+        using zaudio::time_point;
+        using zaudio::stream_context;
+        using zaudio::make_stream_api;
+        using zaudio::make_duplex_stream_api;
+        using zaudio::make_stream_params;
+        using zaudio::make_audio_stream;
+        using zaudio::start_stream;
+        using zaudio::stop_stream;
+        using zaudio::thread_sleep;
+        using zaudio::buffer_group;
+        using zaudio::pa_stream_api;
+        using zaudio::duplex_stream_api;
+
+        //create an alias for a 32 bit float sample
+        using sample_type = sample<sample_format::f32>;
+
+        //capture with one stream api and play with another, each on its own device clock
+        auto&& context = stream_context<sample_type>{make_duplex_stream_api<sample_type>(make_stream_api<sample_type,pa_stream_api>(),
+                                                                                         make_stream_api<sample_type,pa_stream_api>())};
+
+        //the input api's devices come first, then the output api's
+        std::cout<<context.get_device_info_list()<<std::endl;
+        long input = argc > 1 ? std::atol(argv[1]) : context.default_input_device_id();
+        long output = argc > 2 ? std::atol(argv[2]) : context.default_output_device_id();
+        std::cout<<"Usage: duplex_stream [input device] [output device]"<<std::endl;
+
+        auto&& params = make_stream_params<sample_type>(48000,256,2,2,input,output);
+
+        auto&& callback = [&](buffer_group<sample_type>& buffers,
+                              time_point stream_time,
+                              stream_params<sample_type>& params) noexcept
+        {
+            for(std::size_t i = 0; i < buffers.output.frame_count(); ++i)
+            {
+                for(std::size_t j = 0; j < params.output_frame_width(); ++j)
+                {
+                    buffers.output[i][j] = buffers.input[i][j];
+                }
+            }
+            return no_error;
+        };
+
+        auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+        std::cout<<stream.stream_info()<<std::endl;
+
+        //the drift between the two devices and how the bridge follows it
+        auto&& duplex = dynamic_cast<duplex_stream_api<sample_type>*>(stream.api());
+
+        start_stream(stream);
+        for(int i = 0; i < 10; ++i)
+        {
+            thread_sleep(std::chrono::seconds(1));
+            std::cout<<duplex->drift()<<std::endl;
+        }
+        stop_stream(stream);
+        std::cout<<stream.xruns()<<std::endl;
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
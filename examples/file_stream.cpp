@@ -0,0 +1,117 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <cmath>
+#include <string>
+#include <chrono>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+using sample_type = sample<sample_format::f32>;
+
+//waits for a stream to reach the end of its file, returns the seconds it took
+double run_to_end(audio_stream<sample_type>& stream)
+{
+    auto&& begin = std::chrono::steady_clock::now();
+    start_stream(stream);
+    while(stream.playback_state() == running)
+    {
+        thread_sleep(std::chrono::milliseconds(1));
+    }
+    stop_stream(stream);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+//usage: file_stream [input.wav [output.wav]]
+//without an input a test tone is rendered first, the input is then run through a gain into the output
+int main(int argc, char** argv)
+{
+    try
+    {
+        std::string input = argc > 1 ? argv[1] : "file_stream_tone.wav";
+        std::string output = argc > 2 ? argv[2] : "file_stream_out.wav";
+
+        if(argc < 2)
+        {
+            //an output only stream, 60 seconds of a 440Hz tone rendered as fast as the callback runs
+            file_stream_options options;
+            options.output_path = input;
+            options.length = 60 * 48000;
+            auto&& context = stream_context<sample_type>{std::unique_ptr<stream_api<sample_type>>{new file_stream_api<sample_type>(options)}};
+            auto&& params = make_stream_params<sample_type>(48000,512,0,2);
+
+            sample_type phs = 0;
+            sample_type stp = 440.0 / params.sample_rate() * two_pi;
+            auto&& callback = [&](buffer_group<sample_type>& buffers,
+                                  time_point stream_time,
+                                  stream_params<sample_type>& params) noexcept
+            {
+                for(auto&& frame: buffers.output)
+                {
+                    auto&& value = 0.5 * std::sin(phs);
+                    if((phs += stp) > two_pi) { phs -= two_pi; }
+                    for(auto&& samp: frame)
+                    {
+                        samp = value;
+                    }
+                }
+                return no_error;
+            };
+            auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+            auto&& seconds = run_to_end(stream);
+            std::cout<<"Rendered 60 seconds to "<<input<<" in "<<seconds<<"s ("<<60.0 / seconds<<"x realtime)"<<std::endl;
+        }
+
+        //the file decides the channels, rate and device format, a float file is handed to the callback straight from the mapping
+        file_stream_options options;
+        options.input_path = input;
+        options.output_path = output;
+        auto&& api = new file_stream_api<sample_type>(options);
+        auto&& format = api->input_format();
+        auto&& context = stream_context<sample_type>{std::unique_ptr<stream_api<sample_type>>{api}};
+        std::cout<<format;
+
+        auto&& params = make_stream_params<sample_type>(format.sample_rate,512,format.channels,format.channels);
+        params.device_format(format.format);
+        auto&& callback = [](buffer_group<sample_type>& buffers,
+                             time_point stream_time,
+                             stream_params<sample_type>& params) noexcept
+        {
+            for(std::size_t i = 0; i < buffers.output.frame_count(); ++i)
+            {
+                auto&& source = buffers.input[i];
+                auto&& frame = buffers.output[i];
+                for(std::size_t c = 0; c < frame.size(); ++c)
+                {
+                    frame[c] = 0.5f * source[c];
+                }
+            }
+            return no_error;
+        };
+        auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+        auto&& seconds = run_to_end(stream);
+        auto&& audio = api->position() / format.sample_rate;
+        std::cout<<"Processed "<<audio<<" seconds into "<<output<<" in "<<seconds<<"s ("<<audio / seconds<<"x realtime)"<<std::endl;
+        std::cout<<stream.callback_statistics()<<std::endl;
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+//the frame count of a typical callback
+constexpr std::size_t frames = 512;
+
+const std::size_t channel_counts[] = {1,2,4,6,8,16,64};
+
+//runs f until at least the given time has passed, returns samples per second
+template<typename F>
+double samples_per_second(F&& f, std::size_t samples_per_call, double seconds = 0.1)
+{
+    using audio_clock = stream_time_base::audio_clock;
+    std::size_t samples = 0;
+    auto&& start = audio_clock::now();
+    auto&& elapsed = 0.0;
+    do
+    {
+        for(int i = 0; i < 64; ++i)
+        {
+            f();
+        }
+        samples += 64 * samples_per_call;
+        elapsed = std::chrono::duration<double>(audio_clock::now() - start).count();
+    }
+    while(elapsed < seconds);
+    return samples / elapsed;
+}
+
+template<typename sample_t>
+void run(const char* name)
+{
+    std::cout<<std::endl<<name<<", "<<frames<<" frames, millions of samples per second"<<std::endl;
+    std::cout<<std::setw(10)<<"channels"<<std::setw(14)<<"deinterleave"<<std::setw(12)<<"interleave"<<std::setw(14)<<"frame loop"<<std::endl;
+    for(auto&& channels: channel_counts)
+    {
+        std::vector<sample_t> interleaved(frames * channels);
+        for(std::size_t i = 0; i < interleaved.size(); ++i)
+        {
+            interleaved[i] = static_cast<sample_t>(i);
+        }
+        //caller provided planar scratch
+        std::vector<sample_t> storage(frames * channels);
+        std::vector<sample_t*> planar(channels);
+        for(std::size_t c = 0; c < channels; ++c)
+        {
+            planar[c] = storage.data() + c * frames;
+        }
+        buffer_view<sample_t> buffer(interleaved.data(),frames,channels);
+        planar_view<sample_t> channels_view(planar.data(),frames,channels);
+
+        auto&& split = samples_per_second([&]{ deinterleave(buffer,channels_view); },frames * channels);
+        auto&& join = samples_per_second([&]{ interleave(channels_view,buffer); },frames * channels);
+        //the same transpose written against the frame iterators, as a callback would without the kernels
+        auto&& loop = samples_per_second([&]
+        {
+            std::size_t f = 0;
+            for(auto&& frame: buffer)
+            {
+                for(std::size_t c = 0; c < channels; ++c)
+                {
+                    planar[c][f] = frame[c];
+                }
+                ++f;
+            }
+        },frames * channels);
+        std::cout<<std::setw(10)<<channels<<std::fixed<<std::setprecision(0)
+                 <<std::setw(14)<<split / 1e6<<std::setw(12)<<join / 1e6<<std::setw(14)<<loop / 1e6<<std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::cout<<"avx2: "<<(cpu_has_avx2() ? "yes" : "no")<<", sse2: "<<(cpu_has_sse2() ? "yes" : "no")<<std::endl;
+    run<float>("float32");
+    run<double>("float64");
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_params;
+        using zaudio::time_point;
+        using zaudio::make_stream_context;
+        using zaudio::make_stream_params;
+        using zaudio::make_audio_stream;
+        using zaudio::buffer_group;
+        using zaudio::latency_mode;
+        using zaudio::latency_target;
+        using zaudio::duration;
+
+        //create an alias for a 32 bit float sample
+        using sample_type = sample<sample_format::f32>;
+
+        auto&& context = make_stream_context<sample_type>();
+
+        auto&& callback = [](buffer_group<sample_type>& buffers,
+                             time_point stream_time,
+                             stream_params<sample_type>& params) noexcept
+        {
+            for(auto&& frame: buffers.output)
+            {
+                for(auto&& samp: frame)
+                {
+                    samp = 0;
+                }
+            }
+            return no_error;
+        };
+
+        //the same stream opened with each kind of target, the device decides what it really gets
+        for(auto&& target: {latency_target(latency_mode::lowest),
+                            latency_target(latency_mode::low),
+                            latency_target(latency_mode::high),
+                            latency_target(duration(0.02))})
+        {
+            auto&& params = make_stream_params<sample_type>(48000,256,2,2);
+            params.input_latency(target);
+            params.output_latency(target);
+            auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+            std::cout<<"Requested: "<<target<<std::endl<<stream.stream_info()<<std::endl;
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
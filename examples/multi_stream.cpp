@@ -0,0 +1,105 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <cmath>
+#include <atomic>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_params;
+        using zaudio::time_point;
+        using zaudio::make_stream_context;
+        using zaudio::make_stream_params;
+        using zaudio::make_audio_stream;
+        using zaudio::start_stream;
+        using zaudio::stop_stream;
+        using zaudio::thread_sleep;
+        using zaudio::buffer_group;
+        using zaudio::null_stream_api;
+        using zaudio::two_pi;
+
+        //create an alias for a 32 bit float sample
+        using sample_type = sample<sample_format::f32>;
+
+        //one context, the backend is initialized once for every stream below
+        auto&& context = make_stream_context<sample_type,null_stream_api>();
+
+        std::atomic<long> tone_callbacks{0};
+        std::atomic<long> silence_callbacks{0};
+
+        sample_type phs = 0;
+        sample_type stp = 440.0 / 48000.0 * two_pi;
+
+        auto&& tone = [&](buffer_group<sample_type>& buffers,
+                          time_point stream_time,
+                          stream_params<sample_type>& params) noexcept
+        {
+            for(auto&& frame: buffers.output)
+            {
+                auto&& value = std::sin(phs);
+                if((phs += stp) > two_pi) { phs -= two_pi; }
+                for(auto&& samp: frame)
+                {
+                    samp = value;
+                }
+            }
+            ++tone_callbacks;
+            return no_error;
+        };
+
+        auto&& silence = [&](buffer_group<sample_type>& buffers,
+                             time_point stream_time,
+                             stream_params<sample_type>& params) noexcept
+        {
+            for(auto&& frame: buffers.output)
+            {
+                for(auto&& samp: frame)
+                {
+                    samp = 0;
+                }
+            }
+            ++silence_callbacks;
+            return no_error;
+        };
+
+        //each stream has its own callback, params and state
+        auto&& tone_stream = make_audio_stream<sample_type>(make_stream_params<sample_type>(48000,256,0,2),context,tone);
+        auto&& silence_stream = make_audio_stream<sample_type>(make_stream_params<sample_type>(44100,512,2,2),context,silence);
+        std::cout<<context.stream_count()<<" streams on one context"<<std::endl;
+
+        start_stream(tone_stream);
+        start_stream(silence_stream);
+        thread_sleep(std::chrono::seconds(1));
+        stop_stream(silence_stream);
+        stop_stream(tone_stream);
+
+        std::cout<<"Tone: "<<tone_callbacks.load()<<" callbacks of "<<tone_stream.params().frame_count()<<" frames"<<std::endl;
+        std::cout<<"Silence: "<<silence_callbacks.load()<<" callbacks of "<<silence_stream.params().frame_count()<<" frames"<<std::endl;
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <cmath>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_params;
+        using zaudio::time_point;
+        using zaudio::make_stream_context;
+        using zaudio::make_stream_params;
+        using zaudio::make_audio_stream;
+        using zaudio::start_stream;
+        using zaudio::stop_stream;
+        using zaudio::thread_sleep;
+        using zaudio::buffer_group;
+        using zaudio::two_pi;
+
+        //create an alias for a 32 bit float sample
+        using sample_type = sample<sample_format::f32>;
+
+        auto&& context = make_stream_context<sample_type>();
+
+        //eight output channels of 24 bit audio in blocks of 100 frames, more than most devices offer as they are
+        auto&& params = make_stream_params<sample_type>(48000,100,0,8);
+        params.device_format(sample_format::i24);
+        params.negotiate(true);
+
+        sample_type phs = 0;
+        sample_type stp = 440.0 / params.sample_rate() * two_pi;
+
+        //the callback still gets 8 channels of 100 frames whatever the device was opened with
+        auto&& callback = [&](buffer_group<sample_type>& buffers,
+                              time_point stream_time,
+                              stream_params<sample_type>& params) noexcept
+        {
+            for(auto&& frame: buffers.output)
+            {
+                auto&& value = std::sin(phs) * sample_type(0.25);
+                if((phs += stp) > two_pi) { phs -= two_pi; }
+                for(auto&& samp: frame)
+                {
+                    samp = value;
+                }
+            }
+            return no_error;
+        };
+
+        auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+        std::cout<<stream.plan()<<std::endl;
+        start_stream(stream);
+        thread_sleep(std::chrono::seconds(2));
+        stop_stream(stream);
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <cmath>
+#include <atomic>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_params;
+        using zaudio::time_point;
+        using zaudio::stream_context;
+        using zaudio::make_stream_context;
+        using zaudio::make_stream_params;
+        using zaudio::make_audio_stream;
+        using zaudio::start_stream;
+        using zaudio::stop_stream;
+        using zaudio::thread_sleep;
+        using zaudio::buffer_group;
+        using zaudio::null_stream_api;
+        using zaudio::null_stream_clock;
+        using zaudio::two_pi;
+
+        //create an alias for a 32 bit float sample
+        using sample_type = sample<sample_format::f32>;
+
+        //create a stream context with the headless api, no audio device is needed
+        auto&& context = make_stream_context<sample_type,null_stream_api>();
+
+        std::cout<<context.get_device_info_list()<<std::endl;
+
+        auto&& params = make_stream_params<sample_type>(48000,256,0,2);
+
+        sample_type phs = 0;
+        sample_type stp = 440.0 / params.sample_rate() * two_pi;
+        std::atomic<long> callbacks{0};
+
+        //the same callback that would be used with a real device
+        auto&& callback = [&](buffer_group<sample_type>& buffers,
+                              time_point stream_time,
+                              stream_params<sample_type>& params) noexcept
+        {
+            for(auto&& frame: buffers.output)
+            {
+                auto&& value = std::sin(phs);
+                if((phs += stp) > two_pi) { phs -= two_pi; }
+                for(auto&& samp: frame)
+                {
+                    samp = value;
+                }
+            }
+            ++callbacks;
+            return no_error;
+        };
+
+        {
+            auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+            start_stream(stream);
+            thread_sleep(std::chrono::seconds(1));
+            stop_stream(stream);
+            std::cout<<"Paced: "<<callbacks.load()<<" callbacks in 1 second, cpu load: "<<stream.cpu_load()<<std::endl;
+        }
+
+        //the same stream without pacing measures how fast the callback can run
+        callbacks = 0;
+        auto&& fast_context = stream_context<sample_type>{std::unique_ptr<zaudio::stream_api<sample_type>>{new null_stream_api<sample_type>(null_stream_clock::free_running)}};
+        {
+            auto&& stream = make_audio_stream<sample_type>(params,fast_context,callback);
+            start_stream(stream);
+            thread_sleep(std::chrono::seconds(1));
+            stop_stream(stream);
+            std::cout<<"Free running: "<<callbacks.load()<<" callbacks in 1 second ("
+                     <<callbacks.load() * params.frame_count() / params.sample_rate()<<"x realtime), cpu load: "<<stream.cpu_load()<<std::endl;
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
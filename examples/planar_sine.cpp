@@ -0,0 +1,80 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <cmath>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        using namespace zaudio;
+
+        using sample_type = sample<sample_format::f32>;
+
+        auto&& context = make_stream_context<sample_type>();
+        auto&& params = make_stream_params<sample_type>(44100,512,0,2);
+
+        //ask the backend for one buffer per channel
+        params.layout(buffer_layout::planar);
+
+        sample_type phs = 0;
+        const sample_type stp = 440.0 / params.sample_rate() * two_pi;
+
+        auto&& callback = [&](buffer_group<sample_type>& buffers,
+                              time_point stream_time,
+                              stream_params<sample_type>& params) noexcept
+        {
+            //render the first channel as one contiguous run
+            auto&& left = buffers.planar_output[0];
+            for(auto&& samp: left)
+            {
+                samp = std::sin(phs);
+                if((phs += stp) > two_pi) { phs -= two_pi; }
+            }
+            //every other channel is a scaled copy, a loop the compiler can vectorize
+            for(std::size_t c = 1; c < buffers.planar_output.channel_count(); ++c)
+            {
+                auto&& channel = buffers.planar_output[c];
+                for(std::size_t i = 0; i < channel.size(); ++i)
+                {
+                    channel[i] = left[i] * 0.5f;
+                }
+            }
+            return no_error;
+        };
+
+        if(context.is_configuration_supported(params) == no_error)
+        {
+            auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+            start_stream(stream);
+            sleep(std::chrono::seconds(1));
+            stop_stream(stream);
+        }
+        else
+        {
+            std::cout<<"UNSUPPORTED"<<std::endl;
+        }
+    }
+    catch(std::exception& e)
+    {
+        std::cerr<<e.what()<<std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+//create an alias for a 32 bit float sample
+using sample_type = sample<sample_format::f32>;
+
+using node_type = graph_node<sample_type>;
+
+//a sine on every channel of its one output
+class oscillator final : public node_type
+{
+public:
+    oscillator(double frequency, double sample_rate) : node_type({},{port_info{"out",2}}),
+                                                       _phase(0),
+                                                       _step(frequency / sample_rate * two_pi)
+    {}
+
+    stream_error on_process(graph_buffers<sample_type>& buffers, time_point, stream_params<sample_type>&) noexcept override
+    {
+        for(auto&& frame: buffers.output(0))
+        {
+            auto&& value = static_cast<sample_type>(0.25 * std::sin(_phase));
+            if((_phase += _step) > two_pi) { _phase -= two_pi; }
+            for(auto&& samp: frame)
+            {
+                samp = value;
+            }
+        }
+        return no_error;
+    }
+
+private:
+    double _phase;
+
+    double _step;
+};
+
+//sums its two inputs
+class mixer final : public node_type
+{
+public:
+    mixer() : node_type({port_info{"a",2},port_info{"b",2}},{port_info{"out",2}})
+    {}
+
+    stream_error on_process(graph_buffers<sample_type>& buffers, time_point, stream_params<sample_type>&) noexcept override
+    {
+        auto&& a = buffers.input(0);
+        auto&& b = buffers.input(1);
+        auto&& out = buffers.output(0);
+        for(std::size_t i = 0; i < out.size(); ++i)
+        {
+            out.data()[i] = a[i / 2][i % 2] + b[i / 2][i % 2];
+        }
+        return no_error;
+    }
+};
+
+//an ordinary audio_process, it goes into the graph through make_process_node
+class gain final : public audio_process<sample_type>
+{
+public:
+    explicit gain(sample_type amount) : _amount(amount)
+    {}
+
+    stream_error on_process(buffer_group<sample_type>& buffers, time_point, stream_params<sample_type>&) noexcept override
+    {
+        auto&& in = buffers.input;
+        for(std::size_t f = 0; f < buffers.output.frame_count(); ++f)
+        {
+            for(std::size_t c = 0; c < buffers.output.frame_width(); ++c)
+            {
+                buffers.output[f][c] = in[f][c] * _amount;
+            }
+        }
+        return no_error;
+    }
+
+private:
+    sample_type _amount;
+};
+
+//records the loudest output sample, it has no outputs so nothing else is needed for it
+class meter final : public node_type
+{
+public:
+    meter() : node_type({port_info{"in",2}},{}),
+              _peak(0)
+    {}
+
+    stream_error on_process(graph_buffers<sample_type>& buffers, time_point, stream_params<sample_type>&) noexcept override
+    {
+        auto&& in = buffers.input(0);
+        float peak = _peak.load(std::memory_order_relaxed);
+        for(auto&& frame: in)
+        {
+            for(auto&& samp: frame)
+            {
+                peak = std::max(peak,std::fabs(static_cast<float>(samp)));
+            }
+        }
+        _peak.store(peak,std::memory_order_relaxed);
+        return no_error;
+    }
+
+    float peak() noexcept
+    {
+        return _peak.exchange(0);
+    }
+
+private:
+    std::atomic<float> _peak;
+};
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        auto&& context = make_stream_context<sample_type,null_stream_api>();
+
+        //no input, stereo output, blocks of up to 256 frames
+        using graph_type = processing_graph<sample_type>;
+        graph_type graph(0,2,256);
+
+        //a chain of gains: each buffer is dead once the next gain has read it, so two buffers serve the whole chain
+        auto&& osc = graph.add_node(std::make_shared<oscillator>(440.0,48000.0));
+        graph_type::node_id last = osc;
+        for(int i = 0; i < 6; ++i)
+        {
+            auto&& next = graph.add_node(make_process_node<sample_type>(std::make_shared<gain>(0.9f),2,2));
+            graph.connect(last,0,next,0);
+            last = next;
+        }
+        auto&& first_gain = osc + 1;
+        auto&& level = std::make_shared<meter>();
+        auto&& level_node = graph.add_node(level);
+        graph.connect(last,0,level_node,0);
+        graph.connect(last,0,graph_type::output_node,0);
+        graph.compile();
+        std::cout<<graph.schedule_info();
+
+        auto&& stream = make_audio_stream<sample_type>(make_stream_params<sample_type>(48000,512,0,2),context,graph);
+        start_stream(stream);
+        thread_sleep(std::chrono::milliseconds(500));
+        std::cout<<"Peak: "<<level->peak()<<std::endl;
+
+        //while the stream runs: mix in a second tone, the stream swaps to the new schedule between two callbacks
+        auto&& fifth = graph.add_node(std::make_shared<oscillator>(660.0,48000.0));
+        auto&& mix = graph.add_node(std::make_shared<mixer>());
+        graph.connect(last,0,mix,0);
+        graph.connect(fifth,0,mix,1);
+        graph.connect(mix,0,graph_type::output_node,0);
+        graph.connect(mix,0,level_node,0);
+
+        //a cycle is refused and the running schedule stays
+        graph.connect(mix,0,first_gain,0);
+        std::cout<<"Cycle: "<<graph.compile().second<<std::endl;
+        graph.connect(osc,0,first_gain,0);
+
+        auto&& swapped = graph.compile();
+        std::cout<<"Swap: "<<swapped.first<<std::endl<<graph.schedule_info();
+        thread_sleep(std::chrono::milliseconds(500));
+        std::cout<<"Peak: "<<level->peak()<<std::endl;
+        stop_stream(stream);
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <atomic>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_params;
+        using zaudio::time_point;
+        using zaudio::stream_context;
+        using zaudio::make_stream_params;
+        using zaudio::make_audio_stream;
+        using zaudio::make_realtime_policy;
+        using zaudio::realtime_policy;
+        using zaudio::start_stream;
+        using zaudio::stop_stream;
+        using zaudio::thread_sleep;
+        using zaudio::buffer_group;
+        using zaudio::null_stream_api;
+        using zaudio::null_stream_clock;
+
+        //create an alias for a 32 bit float sample
+        using sample_type = sample<sample_format::f32>;
+
+        //free running, so the callback rate shows how expensive each buffer is
+        auto&& context = stream_context<sample_type>{std::unique_ptr<zaudio::stream_api<sample_type>>{new null_stream_api<sample_type>(null_stream_clock::free_running)}};
+
+        auto&& params = make_stream_params<sample_type>(48000,256,0,2);
+
+        std::atomic<long> callbacks{0};
+
+        //the tail of a one pole lowpass fed silence, after a few thousand samples its state is denormal
+        sample_type state = 1;
+        auto&& callback = [&](buffer_group<sample_type>& buffers,
+                              time_point stream_time,
+                              stream_params<sample_type>& params) noexcept
+        {
+            for(auto&& frame: buffers.output)
+            {
+                state = state * sample_type(0.999) + sample_type(1e-39) * sample_type(0.001);
+                for(auto&& samp: frame)
+                {
+                    samp = state;
+                }
+            }
+            ++callbacks;
+            return no_error;
+        };
+
+        //the default policy leaves the audio thread alone, the second adds the usual realtime setup
+        for(auto&& policy: {realtime_policy(), make_realtime_policy()})
+        {
+            params.realtime_policy(policy);
+            state = 1;
+            callbacks = 0;
+            auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+            start_stream(stream);
+            thread_sleep(std::chrono::seconds(1));
+            stop_stream(stream);
+            std::cout<<(policy.empty() ? "Default policy" : "Realtime policy")<<": "<<callbacks.load()<<" callbacks in 1 second"<<std::endl;
+            std::cout<<stream.realtime_status()<<std::endl;
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
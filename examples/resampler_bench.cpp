@@ -0,0 +1,101 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+//stereo blocks of the size a callback would hand over
+constexpr std::size_t channels = 2;
+
+constexpr std::size_t block = 512;
+
+const resample_quality presets[] = {resample_quality::draft,resample_quality::standard,resample_quality::high,resample_quality::best};
+
+struct conversion
+{
+    const char* name;
+
+    double input_rate;
+
+    double output_rate;
+};
+
+//the last one is not rational, it runs on the interpolated filter bank like a drift corrected ratio would
+const conversion conversions[] = {{"44.1k -> 48k",44100.0,48000.0},
+                                  {"48k -> 44.1k",48000.0,44100.0},
+                                  {"48k -> 96k",48000.0,96000.0},
+                                  {"96k -> 48k",96000.0,48000.0},
+                                  {"44.1k -> 48k+100ppm",44100.0,48004.8}};
+
+//converts blocks until at least the given time has passed, returns input samples per second
+double samples_per_second(sample_rate_converter& src, double seconds = 0.2)
+{
+    using audio_clock = stream_time_base::audio_clock;
+    std::vector<float> in(block * channels);
+    for(std::size_t i = 0; i < block; ++i)
+    {
+        for(std::size_t c = 0; c < channels; ++c)
+        {
+            in[i * channels + c] = static_cast<float>(0.5 * std::sin(i * 0.05 + c));
+        }
+    }
+    std::vector<float> out((src.expected_output(block) + 1) * channels);
+    std::size_t samples = 0;
+    auto&& start = audio_clock::now();
+    auto&& elapsed = 0.0;
+    do
+    {
+        for(int i = 0; i < 16; ++i)
+        {
+            src.process(buffer_view<float>(in.data(),block,channels),buffer_view<float>(out.data(),out.size() / channels,channels));
+        }
+        samples += 16 * block * channels;
+        elapsed = std::chrono::duration<double>(audio_clock::now() - start).count();
+    }
+    while(elapsed < seconds);
+    return samples / elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    std::cout<<"avx2+fma: "<<(cpu_has_avx2() && cpu_has_fma() ? "yes" : "no")<<std::endl;
+    std::cout<<"stereo, "<<block<<" frame blocks, millions of input samples per second (times realtime)"<<std::endl;
+    std::cout<<std::setw(22)<<"conversion";
+    for(auto&& quality: presets)
+    {
+        std::cout<<std::setw(18)<<quality;
+    }
+    std::cout<<std::endl;
+    for(auto&& conv: conversions)
+    {
+        std::cout<<std::setw(22)<<conv.name;
+        for(auto&& quality: presets)
+        {
+            sample_rate_converter src(conv.input_rate,conv.output_rate,channels,quality,block);
+            auto&& rate = samples_per_second(src);
+            std::cout<<std::fixed<<std::setprecision(1)<<std::setw(10)<<rate / 1e6
+                     <<" ("<<std::setprecision(0)<<std::setw(4)<<rate / (conv.input_rate * channels)<<"x)";
+        }
+        std::cout<<std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+//stereo blocks the size of a typical callback pushed through a ring of a few blocks
+constexpr std::size_t channels = 2;
+constexpr std::size_t block = 256;
+constexpr std::size_t ring_frames = 4096;
+constexpr std::size_t total_frames = std::size_t(1) << 26;
+
+enum class access
+{
+    copy,
+    window
+};
+
+//pins the calling thread, reports when the system refused
+void pin(std::size_t cpu)
+{
+    realtime_policy policy;
+    policy.cpu_mask(std::uint64_t(1) << (cpu % 64));
+    auto&& status = apply_realtime_policy(policy);
+    if(status.affinity != realtime_result::applied)
+    {
+        std::cout<<"(could not pin to cpu "<<cpu<<": "<<status.affinity<<") ";
+    }
+}
+
+//returns frames per second moved from one pinned thread to the other
+double run(ring_memory memory, access mode, std::size_t producer_cpu, std::size_t consumer_cpu, bool& is_mirrored, bool& is_exact)
+{
+    audio_ring_buffer<float> ring(ring_frames,channels,memory);
+    is_mirrored = ring.mirrored();
+    std::thread producer([&]
+    {
+        pin(producer_cpu);
+        std::vector<float> source(block * channels);
+        std::size_t sent = 0;
+        while(sent < total_frames)
+        {
+            std::size_t count = 0;
+            if(mode == access::copy)
+            {
+                for(std::size_t i = 0; i < source.size(); ++i)
+                {
+                    source[i] = static_cast<float>(sent + i / channels);
+                }
+                count = ring.write(source.data(),block);
+            }
+            else
+            {
+                //render straight into the ring
+                auto&& window = ring.write_window(block);
+                for(std::size_t f = 0; f < window.frame_count(); ++f)
+                {
+                    for(std::size_t c = 0; c < channels; ++c)
+                    {
+                        window.data()[f * channels + c] = static_cast<float>(sent + f);
+                    }
+                }
+                count = window.frame_count();
+                ring.commit_write(count);
+            }
+            sent += count;
+            if(count == 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    pin(consumer_cpu);
+    std::vector<float> sink(block * channels);
+    std::size_t received = 0;
+    bool exact = true;
+    auto&& start = stream_time_base::audio_clock::now();
+    while(received < total_frames)
+    {
+        std::size_t count = 0;
+        if(mode == access::copy)
+        {
+            count = ring.read(sink.data(),block);
+            //only the first sample of each block is checked so the check does not dominate
+            exact = exact && (count == 0 || sink[0] == static_cast<float>(received));
+        }
+        else
+        {
+            auto&& window = ring.read_window(block);
+            count = window.frame_count();
+            exact = exact && (count == 0 || window.data()[0] == static_cast<float>(received));
+            ring.commit_read(count);
+        }
+        received += count;
+        if(count == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    auto&& elapsed = std::chrono::duration<double>(stream_time_base::audio_clock::now() - start).count();
+    producer.join();
+    is_exact = exact;
+    return total_frames / elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned cpus = std::max(1u,std::thread::hardware_concurrency());
+    std::cout<<cpus<<" cpus, producer on cpu 0, consumer on cpu "<<(cpus > 1 ? 1 : 0)
+             <<", "<<block<<" frame blocks of "<<channels<<" channels, millions of frames per second"<<std::endl;
+    std::cout<<std::setw(10)<<"memory"<<std::setw(8)<<"api"<<std::setw(10)<<"mirrored"<<std::setw(10)<<"frames"<<std::setw(8)<<"exact"<<std::endl;
+    for(auto&& memory: {ring_memory::plain,ring_memory::mirrored})
+    {
+        for(auto&& mode: {access::copy,access::window})
+        {
+            bool is_mirrored = false;
+            bool is_exact = false;
+            auto&& rate = run(memory,mode,0,cpus > 1 ? 1 : 0,is_mirrored,is_exact);
+            std::cout<<std::setw(10)<<(memory == ring_memory::plain ? "plain" : "mirrored")
+                     <<std::setw(8)<<(mode == access::copy ? "copy" : "window")
+                     <<std::setw(10)<<(is_mirrored ? "yes" : "no")
+                     <<std::fixed<<std::setprecision(1)<<std::setw(10)<<rate / 1e6
+                     <<std::setw(8)<<(is_exact ? "yes" : "NO")<<std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <zaudio.hpp>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //bring the needed zaudio components into scope
+        using zaudio::no_error;
+        using zaudio::sample;
+        using zaudio::sample_format;
+        using zaudio::stream_params;
+        using zaudio::time_point;
+        using zaudio::stream_context;
+        using zaudio::make_stream_params;
+        using zaudio::make_audio_stream;
+        using zaudio::start_stream;
+        using zaudio::stop_stream;
+        using zaudio::thread_sleep;
+        using zaudio::buffer_group;
+        using zaudio::null_stream_api;
+        using zaudio::monotonic_clock;
+
+        //create an alias for a 32 bit float sample
+        using sample_type = sample<sample_format::f32>;
+
+        auto&& context = stream_context<sample_type>{std::unique_ptr<zaudio::stream_api<sample_type>>{new null_stream_api<sample_type>()}};
+
+        auto&& params = make_stream_params<sample_type>(48000,512,0,2);
+
+        //a click that has to be heard a quarter second from now, not whenever the buffer holding it happens to be processed
+        auto&& click_time = monotonic_clock::now() + std::chrono::milliseconds(250);
+        std::atomic<std::int64_t> click_frame{-1};
+        std::atomic<bool> device_time{false};
+
+        auto&& callback = [&](buffer_group<sample_type>& buffers,
+                              time_point stream_time,
+                              stream_params<sample_type>& params) noexcept
+        {
+            auto&& timing = buffers.timing;
+            //the frame the dac plays at click_time, it only lands in one buffer
+            auto&& frame = timing.output_frame_at(click_time) - static_cast<std::int64_t>(timing.frame_position);
+            std::int64_t index = 0;
+            for(auto&& out: buffers.output)
+            {
+                for(auto&& samp: out)
+                {
+                    samp = index == frame ? sample_type(1) : sample_type(0);
+                }
+                ++index;
+            }
+            if(frame >= 0 && frame < index)
+            {
+                click_frame = static_cast<std::int64_t>(timing.frame_position) + frame;
+                device_time = timing.device_time;
+            }
+            return no_error;
+        };
+
+        auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+        start_stream(stream);
+        thread_sleep(std::chrono::milliseconds(500));
+        stop_stream(stream);
+
+        std::cout<<"Frames Played: "<<stream.frame_position()<<std::endl;
+        std::cout<<"Click Frame: "<<click_frame.load()<<(device_time.load() ? ", placed on device time" : ", placed on estimated time")<<std::endl;
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
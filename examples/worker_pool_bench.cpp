@@ -0,0 +1,160 @@
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <zaudio.hpp>
+
+using namespace zaudio;
+
+//create an alias for a 32 bit float sample
+using sample_type = sample<sample_format::f32>;
+
+//a 64 channel bus of 256 frame buffers, each channel runs its own chain of filters
+constexpr std::size_t channels = 64;
+
+constexpr std::size_t frames = 256;
+
+constexpr std::size_t stages = 24;
+
+//one biquad lowpass per stage, transposed direct form 2
+struct channel_strip
+{
+    float z1[stages] = {};
+
+    float z2[stages] = {};
+
+    void process(float* samples, std::size_t count) noexcept
+    {
+        const float b0 = 0.0675f, b1 = 0.135f, b2 = 0.0675f, a1 = -1.143f, a2 = 0.413f;
+        for(std::size_t s = 0; s < stages; ++s)
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                auto&& in = samples[i];
+                auto&& out = b0 * in + z1[s];
+                z1[s] = b1 * in - a1 * out + z2[s];
+                z2[s] = b2 * in - a2 * out;
+                samples[i] = out;
+            }
+        }
+    }
+};
+
+struct result
+{
+    double callbacks_per_second;
+
+    callback_statistics timing;
+};
+
+//runs the bus on the headless backend as fast as it goes, with the channels spread over workers threads besides the audio thread
+result run(std::size_t workers, std::uint64_t audio_cpu, std::uint64_t worker_cpus)
+{
+    auto&& context = stream_context<sample_type>{std::unique_ptr<stream_api<sample_type>>{new null_stream_api<sample_type>(null_stream_clock::free_running)}};
+    realtime_policy worker_policy;
+    worker_policy.cpu_mask(worker_cpus);
+    worker_policy.flush_denormals(true);
+    worker_pool pool(workers,worker_policy);
+
+    std::vector<channel_strip> strips(channels);
+    std::vector<float> planes(channels * frames);
+    auto&& job = [&](std::size_t c)
+    {
+        auto&& plane = planes.data() + c * frames;
+        for(std::size_t i = 0; i < frames; ++i)
+        {
+            plane[i] = (i % 64) < 32 ? 0.5f : -0.5f;
+        }
+        strips[c].process(plane,frames);
+    };
+    auto&& callback = [&](buffer_group<sample_type>& buffers,
+                          time_point stream_time,
+                          stream_params<sample_type>& params) noexcept
+    {
+        pool.run(channels,job);
+        //a stereo fold down of the bus
+        for(std::size_t f = 0; f < buffers.output.frame_count(); ++f)
+        {
+            float left = 0;
+            float right = 0;
+            for(std::size_t c = 0; c < channels; c += 2)
+            {
+                left += planes[c * frames + f];
+                right += planes[(c + 1) * frames + f];
+            }
+            buffers.output[f][0] = left;
+            buffers.output[f][1] = right;
+        }
+        return no_error;
+    };
+
+    auto&& params = make_stream_params<sample_type>(48000,frames,0,2);
+    realtime_policy audio_policy;
+    audio_policy.cpu_mask(audio_cpu);
+    audio_policy.flush_denormals(true);
+    params.realtime_policy(audio_policy);
+    auto&& stream = make_audio_stream<sample_type>(params,context,callback);
+    start_stream(stream);
+    thread_sleep(std::chrono::milliseconds(200));
+    stream.reset_callback_statistics();
+    thread_sleep(std::chrono::seconds(1));
+    auto&& timing = stream.callback_statistics();
+    stop_stream(stream);
+    return result{static_cast<double>(timing.callbacks),timing};
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        //the audio thread gets cpu 0, worker n cpu n + 1
+        std::size_t cores = std::max(1u,std::thread::hardware_concurrency());
+        if(argc > 1)
+        {
+            cores = static_cast<std::size_t>(std::stoul(argv[1]));
+        }
+        auto&& all = cores >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << cores) - 1;
+        auto&& audio_cpu = cores > 1 ? std::uint64_t(1) : std::uint64_t(0);
+        auto&& worker_cpus = cores > 1 ? all & ~std::uint64_t(1) : std::uint64_t(0);
+
+        std::cout<<channels<<" channels of "<<stages<<" biquads, "<<frames<<" frame buffers, "
+                 <<"period "<<frames * 1000000 / 48000<<"us"<<std::endl;
+        std::cout<<std::setw(8)<<"cores"<<std::setw(14)<<"callbacks/s"<<std::setw(10)<<"speedup"
+                 <<std::setw(12)<<"mean us"<<std::setw(12)<<"p99 us"<<std::setw(12)<<"max us"<<std::endl;
+        double single = 0;
+        for(std::size_t used = 1; used <= cores; ++used)
+        {
+            auto&& r = run(used - 1,audio_cpu,worker_cpus);
+            if(used == 1)
+            {
+                single = r.callbacks_per_second;
+            }
+            std::cout<<std::setw(8)<<used<<std::fixed<<std::setprecision(0)<<std::setw(14)<<r.callbacks_per_second
+                     <<std::setprecision(2)<<std::setw(10)<<r.callbacks_per_second / single
+                     <<std::setprecision(1)<<std::setw(12)<<r.timing.mean.count() / 1000.0
+                     <<std::setw(12)<<r.timing.p99.count() / 1000.0<<std::setw(12)<<r.timing.max.count() / 1000.0<<std::endl;
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cout<<e.what()<<std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,223 @@
+#ifndef ZAUDIO_ADAPTIVE_RESAMPLER
+#define ZAUDIO_ADAPTIVE_RESAMPLER
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "sample_utility.hpp"
+#include "sample_conversion.hpp"
+#include "buffer_algorithm.hpp"
+#include "audio_ring_buffer.hpp"
+#include "error_utility.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <new>
+#include <algorithm>
+#include <ostream>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\class drift_controller
+     *\brief steers the resampling ratio of a fifo between two device clocks so the fifo stays at its target fill
+     *\note a second order loop, the integrator settles on the relative drift of the clocks and the proportional term pulls the fill back to the target
+     *\note the fill is low pass filtered first, it jumps by a whole device buffer whenever either side runs
+     */
+    class ZAUDIO_EXPORT drift_controller
+    {
+    public:
+        //drift beyond this is a broken clock rather than one to follow
+        constexpr static double max_drift = 0.005;
+
+        //the ratio never leaves 1 +- max_correction
+        constexpr static double max_correction = 0.01;
+
+        drift_controller() noexcept;
+
+        //sample_rate is the consumer's, bandwidth is the loop bandwidth in Hz, lower settles slower but follows less jitter
+        void prepare(double sample_rate, double target_fill, double bandwidth = 0.05) noexcept;
+
+        //start again from the target fill, the drift estimate is kept
+        void reset() noexcept;
+
+        //fill is the fifo level before frames output frames are produced, returns the input frames to consume per output frame
+        double update(double fill, std::size_t frames) noexcept;
+
+        double ratio() const noexcept;
+
+        //relative drift of the producer clock against the consumer clock, positive when the producer runs fast
+        double drift() const noexcept;
+
+        //the filtered fifo level in frames
+        double fill() const noexcept;
+
+    private:
+        double _sample_rate;
+
+        double _target;
+
+        double _kp;
+
+        double _ki;
+
+        //corner of the fill filter in Hz
+        double _smoothing;
+
+        //filtered fill error in seconds
+        double _error;
+
+        double _drift;
+
+        double _ratio;
+    };
+
+    /*!
+     *\struct drift_statistics
+     *\brief a snapshot of the fifo that bridges two device clocks
+     */
+    struct drift_statistics
+    {
+        //the producer clock against the consumer clock in parts per million, positive when the producer runs fast
+        double drift_ppm = 0;
+
+        //input frames consumed per output frame
+        double ratio = 1;
+
+        //the filtered fifo level in frames
+        double fill = 0;
+
+        std::size_t target_fill = 0;
+
+        //above this the fifo starts again from the target, the most delay the bridge adds
+        std::size_t max_fill = 0;
+
+        //the fifo ran dry
+        std::uint64_t underflows = 0;
+
+        //the fifo went past max_fill or the producer found it full
+        std::uint64_t overflows = 0;
+
+        //false until the fifo first reaches its target after a start or xrun
+        bool locked = false;
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, const drift_statistics& stats);
+
+    /*!
+     *\class adaptive_resampler
+     *\brief reads interleaved frames from an audio_ring_buffer at a ratio that may change every call
+     *\note cubic hermite interpolation over four frames, history frames are carried between calls so the ratio can change without a discontinuity
+     *\note prepare allocates, process and reset never do
+     */
+    template<typename sample_t>
+    class adaptive_resampler
+    {
+    public:
+        //frames kept from the previous call, the interpolated point always has two on either side
+        constexpr static std::size_t history = 4;
+
+        adaptive_resampler() noexcept : _channels(0),
+                                        _max_consumed(0),
+                                        _phase(0)
+        {}
+
+        //for output buffers of up to max_frames frames at ratios up to max_ratio, not realtime safe
+        stream_error prepare(std::size_t channels, std::size_t max_frames, double max_ratio) noexcept
+        {
+            _channels = channels;
+            _max_consumed = static_cast<std::size_t>(std::ceil(max_frames * max_ratio)) + 1;
+            try
+            {
+                _taps.assign((history + _max_consumed) * _channels,sample_t());
+            }
+            catch(const std::bad_alloc&)
+            {
+                return make_stream_error(stream_status::system_error,"Unable to allocate resampler buffers.");
+            }
+            reset();
+            return no_error;
+        }
+
+        //forget the history and phase
+        void reset() noexcept
+        {
+            _phase = 0;
+            fill_samples(_taps.data(),_taps.size(),sample_t());
+        }
+
+        //input frames the next call to process consumes
+        std::size_t required(std::size_t frames, double ratio) const noexcept
+        {
+            return std::min(static_cast<std::size_t>(_phase + frames * ratio),_max_consumed);
+        }
+
+        //frames frames of interleaved output from the fifo, consuming required(frames,ratio) frames of it
+        //false when the fifo ran short, the missing frames are silence
+        bool process(audio_ring_buffer<sample_t>& fifo, sample_t* out, std::size_t frames, double ratio) noexcept
+        {
+            using scale = detail::sample_scale<sample_t>;
+            const std::size_t consumed = required(frames,ratio);
+            auto&& fresh = _taps.data() + history * _channels;
+            auto&& got = fifo.read(fresh,consumed);
+            fill_samples(fresh + got * _channels,(consumed - got) * _channels,sample_t());
+            for(std::size_t f = 0; f < frames; ++f)
+            {
+                auto&& t = _phase + f * ratio;
+                auto&& i = static_cast<std::size_t>(t);
+                auto&& mu = t - static_cast<double>(i);
+                const sample_t* taps = _taps.data() + i * _channels;
+                for(std::size_t c = 0; c < _channels; ++c)
+                {
+                    auto&& y0 = scale::to_double(taps[c]);
+                    auto&& y1 = scale::to_double(taps[c + _channels]);
+                    auto&& y2 = scale::to_double(taps[c + 2 * _channels]);
+                    auto&& y3 = scale::to_double(taps[c + 3 * _channels]);
+                    //catmull-rom between y1 and y2
+                    auto&& a = 0.5 * (y3 - y0) + 1.5 * (y1 - y2);
+                    auto&& b = y0 - 2.5 * y1 + 2.0 * y2 - 0.5 * y3;
+                    auto&& d = 0.5 * (y2 - y0);
+                    out[f * _channels + c] = scale::from_double(((a * mu + b) * mu + d) * mu + y1,nullptr);
+                }
+            }
+            //the last history frames become the first taps of the next call
+            std::copy(_taps.data() + consumed * _channels,_taps.data() + (consumed + history) * _channels,_taps.data());
+            _phase += frames * ratio - static_cast<double>(consumed);
+            return got == consumed;
+        }
+
+    private:
+        std::size_t _channels;
+
+        std::size_t _max_consumed;
+
+        //position of the next output frame, in frames after the first tap
+        double _phase;
+
+        //history frames followed by the frames read this call
+        std::vector<sample_t> _taps;
+    };
+}
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef ZAUDIO_AUDIO_FILE
+#define ZAUDIO_AUDIO_FILE
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "sample_utility.hpp"
+#include "error_utility.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\enum audio_file_type
+     *\brief the containers audio_file_reader and audio_file_writer understand
+     */
+    enum class audio_file_type
+    {
+        //riff wave, a writer turns it into rf64 once it grows past 4GB
+        wav,
+        //ebu tech 3306 rf64 from the first byte, bw64 files are read as rf64
+        rf64,
+        //headerless interleaved pcm in the host byte order
+        raw
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, audio_file_type type);
+
+    /*!
+     *\struct audio_file_format
+     *\brief the layout of the samples in an audio file
+     *\note wav and rf64 hold u8, i16, i24, i32, f32 and f64, raw files hold any sample_format
+     */
+    struct audio_file_format
+    {
+        audio_file_type type = audio_file_type::wav;
+
+        sample_format format = sample_format::f32;
+
+        std::size_t channels = 2;
+
+        double sample_rate = 48000.0;
+
+        std::size_t frame_bytes() const noexcept
+        {
+            return channels * sample_size(format);
+        }
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, const audio_file_format& format);
+
+    /*!
+     *\class audio_file_reader
+     *\brief an audio file mapped read only into memory, the samples are read in place
+     *\note the whole file is mapped at once and the system is told it will be read sequentially, pages come in as they are touched
+     *\note a data chunk that claims more than the file holds, as a recorder that crashed leaves behind, is cut to the whole frames present
+     *\note a file larger than the address space cannot be mapped, on 64 bit systems that is no limit
+     */
+    class ZAUDIO_EXPORT audio_file_reader
+    {
+    public:
+        audio_file_reader() noexcept;
+
+        audio_file_reader(audio_file_reader&& other) noexcept;
+
+        audio_file_reader& operator=(audio_file_reader&& other) noexcept;
+
+        audio_file_reader(const audio_file_reader&) = delete;
+
+        audio_file_reader& operator=(const audio_file_reader&) = delete;
+
+        ~audio_file_reader();
+
+        //maps path and reads its wav or rf64 header
+        stream_error open(const std::string& path) noexcept;
+
+        //maps path as headerless samples laid out as raw says, raw.type is ignored
+        stream_error open_raw(const std::string& path, const audio_file_format& raw) noexcept;
+
+        void close() noexcept;
+
+        bool is_open() const noexcept;
+
+        const audio_file_format& format() const noexcept;
+
+        std::uint64_t frame_count() const noexcept;
+
+        //the first sample of the data chunk, frame_count() * format().frame_bytes() bytes, null when there are no frames
+        const void* data() const noexcept;
+
+        //the first sample of frame
+        const void* frame(std::uint64_t frame) const noexcept;
+
+        //asks the system to start reading frames [frame, frame + frames) in the background, never blocks
+        void prefetch(std::uint64_t frame, std::uint64_t frames) const noexcept;
+
+    private:
+        stream_error _map(const std::string& path) noexcept;
+
+        stream_error _parse() noexcept;
+
+        void _release() noexcept;
+
+        audio_file_format _format;
+
+        const unsigned char* _mapping;
+
+        std::uint64_t _mapping_size;
+
+        const unsigned char* _data;
+
+        std::uint64_t _frames;
+
+        //the file mapping handle on windows
+        void* _handle;
+    };
+
+    /*!
+     *\class audio_file_writer
+     *\brief writes interleaved frames to a wav, rf64 or raw file through one large batch buffer
+     *\note frames are gathered in the batch and reach the file in writes of the whole batch, so a stream costs one system call per batch
+     *\note write_window hands out the batch itself, a stream_api converts its output straight into it
+     *\note flush writes the batch and rewrites the header, the file is complete after every flush
+     *\note a wav file is written with a reserved chunk after the header, it becomes rf64 in place if it grows past 4GB
+     */
+    class ZAUDIO_EXPORT audio_file_writer
+    {
+    public:
+        audio_file_writer() noexcept;
+
+        audio_file_writer(const audio_file_writer&) = delete;
+
+        audio_file_writer& operator=(const audio_file_writer&) = delete;
+
+        ~audio_file_writer();
+
+        //creates or truncates path, batch_frames frames are gathered before each write
+        stream_error open(const std::string& path, const audio_file_format& format, std::size_t batch_frames = 65536) noexcept;
+
+        //flushes, pads the data chunk to an even size and closes the file
+        stream_error close() noexcept;
+
+        bool is_open() const noexcept;
+
+        const audio_file_format& format() const noexcept;
+
+        //frames written so far, including the ones still in the batch
+        std::uint64_t frame_count() const noexcept;
+
+        //space for frames frames in the batch, writes the batch out first if they do not fit
+        //frames is at most batch_frames, null when the batch could not be written
+        void* write_window(std::size_t frames) noexcept;
+
+        //adds frames frames of the last write window to the file
+        void commit_write(std::size_t frames) noexcept;
+
+        //copies frames frames into the batch, writing it out as it fills
+        stream_error write(const void* frames, std::size_t count) noexcept;
+
+        //writes the batch and updates the header
+        stream_error flush() noexcept;
+
+    private:
+        stream_error _write(const void* bytes, std::size_t size) noexcept;
+
+        stream_error _write_header(bool pad) noexcept;
+
+        audio_file_format _format;
+
+        //the native file handle, -1 when closed
+        std::intptr_t _file;
+
+        std::unique_ptr<unsigned char[]> _batch;
+
+        std::size_t _batch_frames;
+
+        std::size_t _batched;
+
+        std::uint64_t _frames;
+
+        //header bytes before the data
+        std::size_t _data_offset;
+    };
+}
+
+#endif
@@ -83,6 +83,25 @@ namespace zaudio
       using std::placeholders::_1;
       return std::bind(&audio_process<sample_t>::on_error,this,_1);
   }
+
+  namespace detail
+  {
+      /*!
+       *\struct process_invoker
+       *\brief forwards stream callbacks to an audio_process held by pointer
+       *\note when P is declared final the call to on_process can be devirtualized
+       */
+      template<typename sample_t,typename P>
+      struct process_invoker
+      {
+          P* proc;
+
+          stream_error operator()(buffer_group<sample_t>& buffers, time_point tp, stream_params<sample_t>& params) noexcept
+          {
+              return proc->on_process(buffers,tp,params);
+          }
+      };
+  }
 }
 
 #endif
@@ -0,0 +1,412 @@
+#ifndef ZAUDIO_AUDIO_RING_BUFFER
+#define ZAUDIO_AUDIO_RING_BUFFER
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "sample_utility.hpp"
+#include "buffer_view.hpp"
+#include "buffer_algorithm.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\class mirrored_memory
+     *\brief size() bytes of memory mapped twice, back to back, so data()[i] and data()[i + size()] are the same byte
+     *\note size must be a multiple of granularity(), on failure data() is null
+     */
+    class ZAUDIO_EXPORT mirrored_memory
+    {
+    public:
+        mirrored_memory() noexcept;
+
+        explicit mirrored_memory(std::size_t bytes) noexcept;
+
+        mirrored_memory(mirrored_memory&& other) noexcept;
+
+        mirrored_memory& operator=(mirrored_memory&& other) noexcept;
+
+        mirrored_memory(const mirrored_memory&) = delete;
+
+        mirrored_memory& operator=(const mirrored_memory&) = delete;
+
+        ~mirrored_memory();
+
+        void* data() const noexcept;
+
+        std::size_t size() const noexcept;
+
+        //the page size, or the allocation granularity on windows
+        static std::size_t granularity() noexcept;
+
+    private:
+        void _release() noexcept;
+
+        unsigned char* _data;
+
+        std::size_t _size;
+
+        //the file mapping handle on windows
+        void* _handle;
+    };
+
+    /*!
+     *\enum ring_memory
+     *\brief how an audio_ring_buffer lays out its storage
+     */
+    enum class ring_memory
+    {
+        //one allocation, windows stop at the end of it
+        plain,
+        //the storage is mapped twice so every window is contiguous, falls back to plain if the system refuses
+        mirrored
+    };
+
+    /*!
+     *\class audio_ring_buffer
+     *\brief a lock free, single producer single consumer queue of interleaved frames
+     *\note one thread may write and one other thread may read, both sides are realtime safe
+     *\note the capacity is a power of two frames, mirrored buffers round it up further to a whole number of pages
+     *\note windows hand out the ring storage itself, commit the frames used before asking for the next window
+     */
+    template<typename sample_t>
+    class audio_ring_buffer : public detail::fail_if_type_is_not_sample<sample_t>
+    {
+    public:
+        //may throw std::bad_alloc
+        audio_ring_buffer(std::size_t frames, std::size_t channels, ring_memory memory = ring_memory::plain);
+
+        audio_ring_buffer(const audio_ring_buffer&) = delete;
+
+        audio_ring_buffer& operator=(const audio_ring_buffer&) = delete;
+
+        std::size_t capacity() const noexcept;
+
+        std::size_t channel_count() const noexcept;
+
+        //true when the storage really is mirrored
+        bool mirrored() const noexcept;
+
+        //producer side
+        std::size_t writable() const noexcept;
+
+        //up to frames frames of free space starting at the write position
+        //a plain buffer stops the window at the end of the storage, a second window continues from the start
+        buffer_view<sample_t> write_window(std::size_t frames = static_cast<std::size_t>(-1)) noexcept;
+
+        //publishes frames frames of the last write window to the consumer
+        void commit_write(std::size_t frames) noexcept;
+
+        //copies as many frames of in as fit, returns the number copied
+        std::size_t write(const sample_t* in, std::size_t frames) noexcept;
+
+        std::size_t write(buffer_view<sample_t> in) noexcept;
+
+        //consumer side
+        std::size_t readable() const noexcept;
+
+        //up to frames frames of queued audio starting at the read position
+        buffer_view<sample_t> read_window(std::size_t frames = static_cast<std::size_t>(-1)) noexcept;
+
+        //hands frames frames of the last read window back to the producer
+        void commit_read(std::size_t frames) noexcept;
+
+        //copies as many queued frames as fit into out, returns the number copied
+        std::size_t read(sample_t* out, std::size_t frames) noexcept;
+
+        std::size_t read(buffer_view<sample_t> out) noexcept;
+
+        //empties the buffer, neither side may be in use
+        void reset() noexcept;
+
+    private:
+        sample_t* _frame(std::size_t position) noexcept;
+
+        //written once by the constructor, shared by both sides
+        std::size_t _capacity;
+
+        std::size_t _mask;
+
+        std::size_t _channels;
+
+        sample_t* _data;
+
+        //used when the storage is not mirrored, _data points at its first cache line aligned sample
+        std::vector<sample_t> _plain;
+
+        mirrored_memory _mirror;
+
+        //keeps the shared fields off the cache lines the indices are written on
+        char _padding0[64];
+
+        //frames read so far, only written by the consumer
+        std::atomic<std::size_t> _read;
+
+        //the consumer's last look at _write, so it only touches the producer's line when it runs dry
+        std::size_t _write_seen;
+
+        char _padding1[64];
+
+        //frames written so far, only written by the producer
+        std::atomic<std::size_t> _write;
+
+        //the producer's last look at _read
+        std::size_t _read_seen;
+
+        char _padding2[64];
+    };
+
+    namespace detail
+    {
+        inline std::size_t next_power_of_two(std::size_t n) noexcept
+        {
+            std::size_t p = 1;
+            while(p < n)
+            {
+                p <<= 1;
+            }
+            return p;
+        }
+    }
+
+    template<typename sample_t>
+    audio_ring_buffer<sample_t>::audio_ring_buffer(std::size_t frames,
+                                                   std::size_t channels,
+                                                   ring_memory memory) : _capacity(detail::next_power_of_two(std::max<std::size_t>(frames,1))),
+                                                                         _mask(0),
+                                                                         _channels(std::max<std::size_t>(channels,1)),
+                                                                         _data(nullptr),
+                                                                         _read(0),
+                                                                         _write_seen(0),
+                                                                         _write(0),
+                                                                         _read_seen(0)
+    {
+        if(memory == ring_memory::mirrored)
+        {
+            //the wrap point has to fall on a page boundary, grow the capacity until the storage is whole pages
+            auto&& frame_bytes = _channels * sizeof(sample_t);
+            auto&& granularity = mirrored_memory::granularity();
+            while((_capacity * frame_bytes) % granularity != 0)
+            {
+                _capacity <<= 1;
+            }
+            _mirror = mirrored_memory(_capacity * frame_bytes);
+            _data = static_cast<sample_t*>(_mirror.data());
+        }
+        if(_data == nullptr)
+        {
+            _capacity = detail::next_power_of_two(std::max<std::size_t>(frames,1));
+            _plain.assign(_capacity * _channels + 64,sample_t());
+            _data = _plain.data();
+            while(reinterpret_cast<std::uintptr_t>(_data) % 64 != 0)
+            {
+                ++_data;
+            }
+        }
+        _mask = _capacity - 1;
+    }
+
+    template<typename sample_t>
+    std::size_t audio_ring_buffer<sample_t>::capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    template<typename sample_t>
+    std::size_t audio_ring_buffer<sample_t>::channel_count() const noexcept
+    {
+        return _channels;
+    }
+
+    template<typename sample_t>
+    bool audio_ring_buffer<sample_t>::mirrored() const noexcept
+    {
+        return _mirror.data() != nullptr;
+    }
+
+    template<typename sample_t>
+    sample_t* audio_ring_buffer<sample_t>::_frame(std::size_t position) noexcept
+    {
+        return _data + (position & _mask) * _channels;
+    }
+
+    template<typename sample_t>
+    std::size_t audio_ring_buffer<sample_t>::writable() const noexcept
+    {
+        return _capacity - (_write.load(std::memory_order_relaxed) - _read.load(std::memory_order_acquire));
+    }
+
+    template<typename sample_t>
+    buffer_view<sample_t> audio_ring_buffer<sample_t>::write_window(std::size_t frames) noexcept
+    {
+        auto&& write = _write.load(std::memory_order_relaxed);
+        std::size_t free = _capacity - (write - _read_seen);
+        if(free < frames)
+        {
+            _read_seen = _read.load(std::memory_order_acquire);
+            free = _capacity - (write - _read_seen);
+        }
+        std::size_t count = std::min(frames,free);
+        if(!mirrored())
+        {
+            count = std::min(count,_capacity - (write & _mask));
+        }
+        return buffer_view<sample_t>(_frame(write),count,_channels);
+    }
+
+    template<typename sample_t>
+    void audio_ring_buffer<sample_t>::commit_write(std::size_t frames) noexcept
+    {
+        _write.store(_write.load(std::memory_order_relaxed) + frames,std::memory_order_release);
+    }
+
+    template<typename sample_t>
+    std::size_t audio_ring_buffer<sample_t>::write(const sample_t* in, std::size_t frames) noexcept
+    {
+        //at most two windows, the second only when a plain buffer wraps
+        std::size_t done = 0;
+        auto&& write = _write.load(std::memory_order_relaxed);
+        while(done < frames)
+        {
+            std::size_t free = _capacity - (write + done - _read_seen);
+            if(free < frames - done)
+            {
+                _read_seen = _read.load(std::memory_order_acquire);
+                free = _capacity - (write + done - _read_seen);
+            }
+            std::size_t count = std::min(frames - done,free);
+            if(!mirrored())
+            {
+                count = std::min(count,_capacity - ((write + done) & _mask));
+            }
+            if(count == 0)
+            {
+                break;
+            }
+            copy_samples(in + done * _channels,_frame(write + done),count * _channels);
+            done += count;
+        }
+        _write.store(write + done,std::memory_order_release);
+        return done;
+    }
+
+    template<typename sample_t>
+    std::size_t audio_ring_buffer<sample_t>::write(buffer_view<sample_t> in) noexcept
+    {
+        return write(in.data(),in.frame_count());
+    }
+
+    template<typename sample_t>
+    std::size_t audio_ring_buffer<sample_t>::readable() const noexcept
+    {
+        return _write.load(std::memory_order_acquire) - _read.load(std::memory_order_relaxed);
+    }
+
+    template<typename sample_t>
+    buffer_view<sample_t> audio_ring_buffer<sample_t>::read_window(std::size_t frames) noexcept
+    {
+        auto&& read = _read.load(std::memory_order_relaxed);
+        std::size_t queued = _write_seen - read;
+        if(queued < frames)
+        {
+            _write_seen = _write.load(std::memory_order_acquire);
+            queued = _write_seen - read;
+        }
+        std::size_t count = std::min(frames,queued);
+        if(!mirrored())
+        {
+            count = std::min(count,_capacity - (read & _mask));
+        }
+        return buffer_view<sample_t>(_frame(read),count,_channels);
+    }
+
+    template<typename sample_t>
+    void audio_ring_buffer<sample_t>::commit_read(std::size_t frames) noexcept
+    {
+        _read.store(_read.load(std::memory_order_relaxed) + frames,std::memory_order_release);
+    }
+
+    template<typename sample_t>
+    std::size_t audio_ring_buffer<sample_t>::read(sample_t* out, std::size_t frames) noexcept
+    {
+        std::size_t done = 0;
+        auto&& read = _read.load(std::memory_order_relaxed);
+        while(done < frames)
+        {
+            std::size_t queued = _write_seen - (read + done);
+            if(queued < frames - done)
+            {
+                _write_seen = _write.load(std::memory_order_acquire);
+                queued = _write_seen - (read + done);
+            }
+            std::size_t count = std::min(frames - done,queued);
+            if(!mirrored())
+            {
+                count = std::min(count,_capacity - ((read + done) & _mask));
+            }
+            if(count == 0)
+            {
+                break;
+            }
+            copy_samples(_frame(read + done),out + done * _channels,count * _channels);
+            done += count;
+        }
+        _read.store(read + done,std::memory_order_release);
+        return done;
+    }
+
+    template<typename sample_t>
+    std::size_t audio_ring_buffer<sample_t>::read(buffer_view<sample_t> out) noexcept
+    {
+        return read(out.data(),out.frame_count());
+    }
+
+    template<typename sample_t>
+    void audio_ring_buffer<sample_t>::reset() noexcept
+    {
+        _read.store(0);
+        _write.store(0);
+        _read_seen = 0;
+        _write_seen = 0;
+    }
+
+    /*!
+     *\fn make_audio_ring_buffer
+     *\brief helper function that creates an audio_ring_buffer sized for frames frames of channels channels
+     */
+    template<typename sample_t>
+    std::unique_ptr<audio_ring_buffer<typename std::decay<sample_t>::type>> make_audio_ring_buffer(std::size_t frames,
+                                                                                                 std::size_t channels,
+                                                                                                 ring_memory memory = ring_memory::plain)
+    {
+        return std::unique_ptr<audio_ring_buffer<typename std::decay<sample_t>::type>>{new audio_ring_buffer<typename std::decay<sample_t>::type>(frames,channels,memory)};
+    }
+}
+
+#endif
@@ -21,8 +21,11 @@ This file is part of zaudio.
 #include "error_utility.hpp"
 #include "stream_params.hpp"
 #include "stream_context.hpp"
+#include "stream_callback.hpp"
+#include "audio_process.hpp"
 
 #include <type_traits>
+#include <memory>
 
 
 /*!
@@ -31,13 +34,11 @@ This file is part of zaudio.
  */
 namespace zaudio
 {
-    template<typename sample_t>
-    struct audio_process;
-
-
     /*!
     *\class audio_stream
     *\brief represents a program level connection to the audio context
+    *\note callables and audio_process types passed to the templated overloads are stored with their exact type,
+    * the stream_api runs each device buffer in code instantiated for that type, where every call of the callable is direct
     */
 
     template<typename sample_t>
@@ -61,12 +62,41 @@ namespace zaudio
                             const callback& cb,
                             const stream_error_callback& error_callback = default_stream_error_callback());
 
+      template<typename F,typename = typename std::enable_if<detail::is_stream_callable<sample_t,F>::value>::type>
+      explicit audio_stream(const stream_params_type& params,
+                            F&& cb,
+                            const stream_error_callback& error_callback = default_stream_error_callback());
+
+      template<typename F,typename = typename std::enable_if<detail::is_stream_callable<sample_t,F>::value>::type>
+      explicit audio_stream(const stream_params_type& params,
+                            context_type& ctx,
+                            F&& cb,
+                            const stream_error_callback& error_callback = default_stream_error_callback());
+
+      //for blocking streams, which never call a callback
+      explicit audio_stream(const stream_params_type& params);
+
+      explicit audio_stream(const stream_params_type& params,
+                            context_type& ctx);
+
+      template<typename P,typename = typename std::enable_if<std::is_base_of<audio_process<sample_t>,P>::value>::type>
       explicit audio_stream(const stream_params_type& params,
-                            audio_process<sample_t>& proc);
+                            P& proc);
 
+      template<typename P,typename = typename std::enable_if<std::is_base_of<audio_process<sample_t>,P>::value>::type>
       explicit audio_stream(const stream_params_type& params,
                             context_type& ctx,
-                            audio_process<sample_t>& proc);
+                            P& proc);
+
+      //the stream moves with its open api, a moved from stream may only be destroyed or assigned to
+      audio_stream(audio_stream&& other) noexcept;
+
+      audio_stream& operator=(audio_stream&& other) noexcept;
+
+      //two streams would release the same api
+      audio_stream(const audio_stream&) = delete;
+
+      audio_stream& operator=(const audio_stream&) = delete;
 
       ~audio_stream();
 
@@ -80,6 +110,9 @@ namespace zaudio
 
       callback exchange_callback(callback&& cb);
 
+      template<typename F,typename = typename std::enable_if<detail::is_stream_callable<sample_t,F>::value>::type>
+      callback exchange_callback(F&& cb);
+
       stream_error_callback exchange_error_callback(stream_error_callback&& cb);
 
       const stream_params_type& params() noexcept;
@@ -88,26 +121,75 @@ namespace zaudio
 
       double cpu_load() noexcept;
 
+      std::size_t dropped_error_count() const noexcept;
+
+      std::size_t coalesced_error_count() const noexcept;
+
+      zaudio::realtime_status realtime_status() const noexcept;
+
+      //frames of delay added when params.block_size() needs a fifo, see block_adapter
+      std::size_t block_latency() const noexcept;
+
+      //the latencies and sample rate the device settled on for params.input_latency() and output_latency()
+      const zaudio::stream_info& stream_info() const noexcept;
+
+      //how a stream opened with params.negotiate() differs from the params it was given
+      const stream_plan& plan() const noexcept;
+
+      //the backend instance running this stream, for what only that backend reports, such as duplex_stream_api::drift()
+      stream_api<sample_t>* api() const noexcept;
+
+      //device frames processed since the stream last started
+      std::uint64_t frame_position() const noexcept;
+
+      //underflows and overflows since the api was created or the counters were reset
+      xrun_statistics xruns() const noexcept;
+
+      void reset_xruns() noexcept;
+
+      //processing time percentiles and deadline margins of the device buffers
+      zaudio::callback_statistics callback_statistics() const noexcept;
+
+      void reset_callback_statistics() noexcept;
+
+      //blocking streams only, write and read wait until the whole buffer has been transferred
+      stream_error write(buffer_view<sample_t> frames) noexcept;
+
+      stream_error read(buffer_view<sample_t> frames) noexcept;
+
+      //frames that can be transferred without waiting, negative if the backend cannot tell
+      long write_available() noexcept;
+
+      long read_available() noexcept;
+
     private:
       void init();
 
       void destroy() noexcept;
 
-      stream_params_type _params;
+      callback _exchange_callback(detail::callback_holder<sample_t>* next);
+
+      //heap allocated so the address the open api holds survives a move
+      std::unique_ptr<stream_params_type> _params;
 
-      callback _callback;
+      //heap allocated so the api can hold on to them while we swap in replacements
+      std::shared_ptr<detail::callback_holder<sample_t>> _callback;
 
-      stream_error_callback _error_callback;
+      std::shared_ptr<stream_error_callback> _error_callback;
 
       std::reference_wrapper<context_type> _context;
 
+      //this stream's own backend instance, owned by _context
+      stream_api<sample_t>* _api = nullptr;
+
     };
 
 
     template<typename sample_t>
-    audio_stream<sample_t>::audio_stream() : _params(),
+    audio_stream<sample_t>::audio_stream() : _params(new stream_params_type()),
+                                             _callback(detail::make_callback_holder<sample_t>(callback())),
                                              _context(default_stream_context<sample_t>()),
-                                             _error_callback(default_stream_error_callback())
+                                             _error_callback(new stream_error_callback(default_stream_error_callback()))
     {
         init();
     }
@@ -115,10 +197,10 @@ namespace zaudio
     template<typename sample_t>
     audio_stream<sample_t>::audio_stream(const stream_params_type& params,
                                          const callback& cb,
-                                         const stream_error_callback& error_callback) : _params(params),
+                                         const stream_error_callback& error_callback) : _params(new stream_params_type(params)),
                                                                                         _context(default_stream_context<sample_t>()),
-                                                                                        _callback(cb),
-                                                                                        _error_callback(error_callback)
+                                                                                        _callback(detail::make_callback_holder<sample_t>(cb)),
+                                                                                        _error_callback(new stream_error_callback(error_callback))
     {
         init();
     }
@@ -127,35 +209,107 @@ namespace zaudio
     audio_stream<sample_t>::audio_stream(const stream_params_type& params,
                                          context_type& ctx,
                                          const callback& cb,
-                                         const stream_error_callback& error_callback) : _params(params),
-                                                                                        _callback(cb),
-                                                                                        _error_callback(error_callback),
+                                         const stream_error_callback& error_callback) : _params(new stream_params_type(params)),
+                                                                                        _callback(detail::make_callback_holder<sample_t>(cb)),
+                                                                                        _error_callback(new stream_error_callback(error_callback)),
+                                                                                        _context(ctx)
+    {
+        init();
+    }
+
+    template<typename sample_t>
+    template<typename F,typename>
+    audio_stream<sample_t>::audio_stream(const stream_params_type& params,
+                                         F&& cb,
+                                         const stream_error_callback& error_callback) : _params(new stream_params_type(params)),
+                                                                                        _context(default_stream_context<sample_t>()),
+                                                                                        _callback(detail::make_callback_holder<sample_t>(std::forward<F>(cb))),
+                                                                                        _error_callback(new stream_error_callback(error_callback))
+    {
+        init();
+    }
+
+    template<typename sample_t>
+    template<typename F,typename>
+    audio_stream<sample_t>::audio_stream(const stream_params_type& params,
+                                         context_type& ctx,
+                                         F&& cb,
+                                         const stream_error_callback& error_callback) : _params(new stream_params_type(params)),
+                                                                                        _callback(detail::make_callback_holder<sample_t>(std::forward<F>(cb))),
+                                                                                        _error_callback(new stream_error_callback(error_callback)),
                                                                                         _context(ctx)
     {
         init();
     }
 
     template<typename sample_t>
+    audio_stream<sample_t>::audio_stream(const stream_params_type& params) : _params(new stream_params_type(params)),
+                                                                             _callback(detail::make_callback_holder<sample_t>(callback())),
+                                                                             _error_callback(new stream_error_callback(default_stream_error_callback())),
+                                                                             _context(default_stream_context<sample_t>())
+    {
+        init();
+    }
+
+    template<typename sample_t>
+    audio_stream<sample_t>::audio_stream(const stream_params_type& params,
+                                         context_type& ctx) : _params(new stream_params_type(params)),
+                                                              _callback(detail::make_callback_holder<sample_t>(callback())),
+                                                              _error_callback(new stream_error_callback(default_stream_error_callback())),
+                                                              _context(ctx)
+    {
+        init();
+    }
+
+    template<typename sample_t>
+    template<typename P,typename>
     audio_stream<sample_t>::audio_stream(const stream_params_type& params,
-                                         audio_process<sample_t>& proc) : _params(params),
-                                                                          _callback(proc.get_callback()),
-                                                                          _error_callback(proc.get_error_callback()),
-                                                                          _context(default_stream_context<sample_t>())
+                                         P& proc) : _params(new stream_params_type(params)),
+                                                    _callback(detail::make_callback_holder<sample_t>(detail::process_invoker<sample_t,P>{&proc})),
+                                                    _error_callback(new stream_error_callback(proc.get_error_callback())),
+                                                    _context(default_stream_context<sample_t>())
     {
         init();
     }
 
     template<typename sample_t>
+    template<typename P,typename>
     audio_stream<sample_t>::audio_stream(const stream_params_type& params,
                                          context_type& ctx,
-                                         audio_process<sample_t>& proc) : _params(params),
-                                                                          _callback(proc.get_callback()),
-                                                                          _error_callback(proc.get_error_callback()),
-                                                                          _context(ctx)
+                                         P& proc) : _params(new stream_params_type(params)),
+                                                    _callback(detail::make_callback_holder<sample_t>(detail::process_invoker<sample_t,P>{&proc})),
+                                                    _error_callback(new stream_error_callback(proc.get_error_callback())),
+                                                    _context(ctx)
     {
         init();
     }
 
+    template<typename sample_t>
+    audio_stream<sample_t>::audio_stream(audio_stream&& other) noexcept : _params(std::move(other._params)),
+                                                                         _callback(std::move(other._callback)),
+                                                                         _error_callback(std::move(other._error_callback)),
+                                                                         _context(other._context),
+                                                                         _api(other._api)
+    {
+        other._api = nullptr;
+    }
+
+    template<typename sample_t>
+    audio_stream<sample_t>& audio_stream<sample_t>::operator=(audio_stream&& other) noexcept
+    {
+        if(this != &other)
+        {
+            destroy();
+            _params = std::move(other._params);
+            _callback = std::move(other._callback);
+            _error_callback = std::move(other._error_callback);
+            _context = other._context;
+            _api = other._api;
+            other._api = nullptr;
+        }
+        return *this;
+    }
+
     template<typename sample_t>
     audio_stream<sample_t>::~audio_stream()
     {
@@ -165,98 +319,220 @@ namespace zaudio
     template<typename sample_t>
     stream_error audio_stream<sample_t>::start() noexcept
     {
-        return _context.get().api()->start();
+        return _api->start();
     }
 
     template<typename sample_t>
     stream_error audio_stream<sample_t>::pasue() noexcept
     {
-        return _context.get().api()->pause();
+        return _api->pause();
     }
 
     template<typename sample_t>
     stream_error audio_stream<sample_t>::stop() noexcept
     {
-        return _context.get().api()->stop();
+        return _api->stop();
     }
 
     template<typename sample_t>
     stream_error audio_stream<sample_t>::playback_state() noexcept
     {
-        return _context.get().api()->playback_state();
+        return _api->playback_state();
     }
 
+    //the new callback takes effect at the next buffer boundary
+    //the previous one is released here, on the calling thread, once the audio thread is done with it
     template<typename sample_t>
     typename audio_stream<sample_t>::callback audio_stream<sample_t>::exchange_callback(callback&& cb)
     {
-        auto&& out = _callback;
-        auto& mtx = _context.get().api()->callback_mutex();
-        std::unique_lock<std::timed_mutex> lk{mtx,std::defer_lock};
-        if(lk.try_lock_for(std::chrono::seconds(1)))
-        {
-            _callback = cb;
-            return out;
-        }
-        else
-        {
-            throw stream_exception(make_stream_error(stream_status::system_error, "Unable to aquire lock to swap callback."));
-        }
+        return _exchange_callback(detail::make_callback_holder<sample_t>(std::move(cb)));
+    }
+
+    template<typename sample_t>
+    template<typename F,typename>
+    typename audio_stream<sample_t>::callback audio_stream<sample_t>::exchange_callback(F&& cb)
+    {
+        return _exchange_callback(detail::make_callback_holder<sample_t>(std::forward<F>(cb)));
     }
 
     template<typename sample_t>
     stream_error_callback audio_stream<sample_t>::exchange_error_callback(stream_error_callback&& cb)
     {
-        auto&& out = _error_callback;
-        auto& mtx = _context.get().api()->callback_mutex();
-        std::unique_lock<std::timed_mutex> lk{mtx,std::defer_lock};
-        if(lk.try_lock_for(std::chrono::seconds(1)))
-        {
-            _error_callback = cb;
-            return out;
-        }
-        else
-        {
-            throw stream_exception(make_stream_error(stream_status::system_error, "Unable to aquire lock to swap error callback."));
-        }
+        std::shared_ptr<stream_error_callback> next{new stream_error_callback(std::move(cb))};
+        _api->exchange_error_callback(*next);
+        stream_error_callback out = std::move(*_error_callback);
+        _error_callback = std::move(next);
+        return out;
     }
 
     template<typename sample_t>
     const typename audio_stream<sample_t>::stream_params_type& audio_stream<sample_t>::params() noexcept
     {
-        return _params;
+        return *_params;
     }
 
     template<typename sample_t>
     void audio_stream<sample_t>::params(const stream_params_type& p) noexcept
     {
-        _params = p;
+        *_params = p;
     }
 
     template<typename sample_t>
     double audio_stream<sample_t>::cpu_load() noexcept
     {
-        return _context.get().api()->cpu_load();
+        return _api->cpu_load();
+    }
+
+
+    template<typename sample_t>
+    std::size_t audio_stream<sample_t>::dropped_error_count() const noexcept
+    {
+        return _api->dropped_error_count();
+    }
+
+    template<typename sample_t>
+    std::size_t audio_stream<sample_t>::coalesced_error_count() const noexcept
+    {
+        return _api->coalesced_error_count();
+    }
+
+
+    template<typename sample_t>
+    zaudio::realtime_status audio_stream<sample_t>::realtime_status() const noexcept
+    {
+        return _api->realtime_status();
+    }
+
+    template<typename sample_t>
+    std::size_t audio_stream<sample_t>::block_latency() const noexcept
+    {
+        return _api->block_latency();
+    }
+
+    template<typename sample_t>
+    const zaudio::stream_info& audio_stream<sample_t>::stream_info() const noexcept
+    {
+        return _api->stream_info();
+    }
+
+    template<typename sample_t>
+    const stream_plan& audio_stream<sample_t>::plan() const noexcept
+    {
+        return _api->plan();
+    }
+
+    template<typename sample_t>
+    stream_api<sample_t>* audio_stream<sample_t>::api() const noexcept
+    {
+        return _api;
+    }
+
+    template<typename sample_t>
+    std::uint64_t audio_stream<sample_t>::frame_position() const noexcept
+    {
+        return _api->frame_position();
+    }
+
+    template<typename sample_t>
+    xrun_statistics audio_stream<sample_t>::xruns() const noexcept
+    {
+        return _api->xruns();
+    }
+
+    template<typename sample_t>
+    void audio_stream<sample_t>::reset_xruns() noexcept
+    {
+        _api->reset_xruns();
+    }
+
+    template<typename sample_t>
+    zaudio::callback_statistics audio_stream<sample_t>::callback_statistics() const noexcept
+    {
+        return _api->callback_statistics();
+    }
+
+    template<typename sample_t>
+    void audio_stream<sample_t>::reset_callback_statistics() noexcept
+    {
+        _api->reset_callback_statistics();
+    }
+
+
+    template<typename sample_t>
+    stream_error audio_stream<sample_t>::write(buffer_view<sample_t> frames) noexcept
+    {
+        return _api->write(frames);
+    }
+
+    template<typename sample_t>
+    stream_error audio_stream<sample_t>::read(buffer_view<sample_t> frames) noexcept
+    {
+        return _api->read(frames);
+    }
+
+    template<typename sample_t>
+    long audio_stream<sample_t>::write_available() noexcept
+    {
+        return _api->write_available();
+    }
+
+    template<typename sample_t>
+    long audio_stream<sample_t>::read_available() noexcept
+    {
+        return _api->read_available();
     }
 
 
     template<typename sample_t>
     void audio_stream<sample_t>::init()
     {
-        _context.get().api()->set_callback(_callback);
-        _context.get().api()->set_error_callback(_error_callback);
-        auto&& is_compat = _context.get().is_configuration_supported(params());
+        _api = _context.get().acquire_stream();
+        if(_api == nullptr)
+        {
+            throw stream_exception(make_stream_error(stream_status::system_error,"The stream context cannot run another stream."));
+        }
+        _api->set_callback(_callback->ref);
+        _api->set_error_callback(*_error_callback);
+        if(_params->negotiate())
+        {
+            //_params becomes the configuration that was opened
+            auto&& negotiated = _api->open_negotiated(*_params);
+            if(negotiated != no_error)
+            {
+                destroy();
+                throw stream_exception(negotiated);
+            }
+            return;
+        }
+        auto&& is_compat = _api->is_configuration_supported(params());
         if(is_compat != no_error)
         {
+            destroy();
             throw stream_exception(is_compat);
         }
-        _context.get().api()->open_stream(params());
+        _api->open_stream(params());
     }
 
     template<typename sample_t>
     void audio_stream<sample_t>::destroy() noexcept
     {
-        _context.get().api()->close_stream();
+        if(_api != nullptr)
+        {
+            _api->close_stream();
+            _api->release_callbacks();
+            _context.get().release_stream(_api);
+            _api = nullptr;
+        }
+    }
 
+    template<typename sample_t>
+    typename audio_stream<sample_t>::callback audio_stream<sample_t>::_exchange_callback(detail::callback_holder<sample_t>* next)
+    {
+        std::shared_ptr<detail::callback_holder<sample_t>> holder{next};
+        _api->exchange_callback(holder->ref);
+        auto&& out = _callback->release();
+        _callback = std::move(holder);
+        return out;
     }
 
 
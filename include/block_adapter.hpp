@@ -0,0 +1,362 @@
+#ifndef ZAUDIO_BLOCK_ADAPTER
+#define ZAUDIO_BLOCK_ADAPTER
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "format_adapter.hpp"
+#include "rate_adapter.hpp"
+#include "buffer_group.hpp"
+#include "buffer_algorithm.hpp"
+
+#include <vector>
+#include <new>
+#include <algorithm>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    namespace detail
+    {
+        inline std::size_t greatest_common_divisor(std::size_t a, std::size_t b) noexcept
+        {
+            while(b != 0)
+            {
+                auto&& r = a % b;
+                a = b;
+                b = r;
+            }
+            return a;
+        }
+    }
+
+    /*!
+     *\class block_adapter
+     *\brief runs the stream callback on blocks of params.block_size() frames, whatever the device buffer size is
+     *\note when the device buffer is a fixed multiple of the block, the blocks are slices of the device buffers and nothing is copied or delayed
+     *\note otherwise input is gathered into a block and output is queued behind latency() frames of silence
+     *\note a block that lies entirely inside a device input buffer is handed to the callback in place
+     */
+    template<typename sample_t>
+    class block_adapter
+    {
+    public:
+        block_adapter() noexcept : _block(0),
+                                   _device(0),
+                                   _latency(0),
+                                   _input_width(0),
+                                   _output_width(0),
+                                   _filled(0),
+                                   _queued(0),
+                                   _position(0),
+                                   _split(false),
+                                   _variable(false),
+                                   _layout(buffer_layout::interleaved)
+        {}
+
+        //select the block size and allocate the fifos, not realtime safe
+        stream_error prepare(const stream_params<sample_t>& params) noexcept
+        {
+            //blocking streams move whatever the caller hands them, there is no callback to feed
+            _block = params.mode() == stream_mode::blocking ? 0 : params.block_size();
+            //a resampled stream hands over the frames each device buffer spans at the stream rate, a frame more or less each time
+            const bool resampled = params.device_sample_rate() != params.sample_rate();
+            _device = resampled ? rate_adapter<sample_t>::max_frames(params) : params.frame_count();
+            _input_width = params.input_frame_width();
+            _output_width = params.output_frame_width();
+            _variable = params.variable_frame_count() || resampled;
+            _split = active() && !_variable && _device % _block == 0;
+            //the output for device frame n must exist once n input frames have arrived, only whole blocks of them have been processed
+            //n mod block reaches block - gcd(block,device) at worst, so that much silence is queued up front
+            //when the host picks the buffer sizes n can land anywhere in a block
+            _latency = !active() ? 0 : (_variable ? _block - 1 : _block - detail::greatest_common_divisor(_block,_device));
+            try
+            {
+                _input_channels.resize(_input_width);
+                _output_channels.resize(_output_width);
+                if(!active() || _split)
+                {
+                    _input.clear();
+                    _output.clear();
+                }
+                else if(params.layout() == buffer_layout::planar)
+                {
+                    _input.allocate(_input_width,_block);
+                    //never more than latency() + one device buffer is queued, see process
+                    _output.allocate(_output_width,_latency + _device);
+                }
+                else
+                {
+                    _input.allocate(1,_block * _input_width);
+                    _output.allocate(1,(_latency + _device) * _output_width);
+                }
+            }
+            catch(const std::bad_alloc&)
+            {
+                return make_stream_error(stream_status::system_error,"Unable to allocate block buffers.");
+            }
+            _layout = params.layout();
+            reset();
+            return no_error;
+        }
+
+        //false when the callback runs on the device buffers as they are
+        bool active() const noexcept
+        {
+            return _block != 0 && (_block != _device || _variable);
+        }
+
+        //frames of output delay added between the callback and the device, also the added round trip delay
+        std::size_t latency() const noexcept
+        {
+            return _latency;
+        }
+
+        //frames handed to the callback at a time
+        std::size_t block_size() const noexcept
+        {
+            return active() ? _block : _device;
+        }
+
+        //drops partial input and queued output and queues latency() frames of silence again, the stream must not be running
+        void reset() noexcept
+        {
+            _filled = 0;
+            _queued = 0;
+            _position = 0;
+            if(active() && !_split)
+            {
+                if(_layout == buffer_layout::planar)
+                {
+                    for(std::size_t c = 0; c < _output_width; ++c)
+                    {
+                        fill_samples(_output[c],_latency,sample_t());
+                    }
+                }
+                else
+                {
+                    fill_samples(_output[0],_latency * _output_width,sample_t());
+                }
+                _queued = _latency;
+            }
+        }
+
+        //runs run(buffer_group<sample_t>&) on every block completed by frames device frames of interleaved input and output
+        //frames is at most params.frame_count(), and exactly that unless params.variable_frame_count() or the stream is resampled
+        //timing describes the device buffers, each block gets the timing of its own first frame
+        template<typename F>
+        stream_error process(const sample_t* input, sample_t* output, std::size_t frames, const stream_timing& timing, F&& run) noexcept
+        {
+            return _process(input,output,frames,timing,run);
+        }
+
+        //the same for planar buffers, one pointer per channel
+        template<typename F>
+        stream_error process(const sample_t* const* input, sample_t* const* output, std::size_t frames, const stream_timing& timing, F&& run) noexcept
+        {
+            return _process(input,output,frames,timing,run);
+        }
+
+    private:
+        std::size_t _block;
+
+        std::size_t _device;
+
+        std::size_t _latency;
+
+        std::size_t _input_width;
+
+        std::size_t _output_width;
+
+        //frames gathered towards the next input block
+        std::size_t _filled;
+
+        //frames of output waiting for the device, the oldest at the start of _output
+        std::size_t _queued;
+
+        //the first frame of the next block, input frames line up with the device and output frames trail it by _latency
+        std::uint64_t _position;
+
+        //the device buffer is a whole number of blocks
+        bool _split;
+
+        //the device buffers are any size up to _device
+        bool _variable;
+
+        buffer_layout _layout;
+
+        //one block of input and latency() + frame_count frames of output, a single run when interleaved or one run per channel when planar
+        detail::aligned_channels<sample_t> _input;
+
+        detail::aligned_channels<sample_t> _output;
+
+        //channel pointers handed to the callback when planar
+        std::vector<sample_t*> _input_channels;
+
+        std::vector<sample_t*> _output_channels;
+
+        template<typename in_t, typename out_t, typename F>
+        stream_error _process(in_t input, out_t output, std::size_t frames, const stream_timing& timing, F& run) noexcept
+        {
+            stream_error ret = no_error;
+            if(_split)
+            {
+                for(std::size_t done = 0; done < frames && ret == no_error; done += _block)
+                {
+                    auto&& buffers = _group(_at(input,done,_input_width,_input_channels),_at(output,done,_output_width,_output_channels),_block);
+                    buffers.timing = timing.advanced(static_cast<std::int64_t>(done));
+                    ret = run(buffers);
+                }
+                return ret;
+            }
+            auto&& queue = output == nullptr ? nullptr : _storage(output);
+            for(std::size_t done = 0; done < frames;)
+            {
+                const std::size_t count = std::min(_block - _filled,frames - done);
+                auto&& block_input = _at(input,done,_input_width,_input_channels);
+                if(input != nullptr && count != _block)
+                {
+                    _copy(block_input,0,_storage(input),_filled,count,_input_width);
+                    block_input = _storage(input);
+                }
+                _filled += count;
+                done += count;
+                if(_filled == _block)
+                {
+                    _filled = 0;
+                    auto&& buffers = _group(block_input,_at(queue,_queued,_output_width,_output_channels),_block);
+                    buffers.timing = _block_timing(timing);
+                    ret = run(buffers);
+                    if(ret != no_error)
+                    {
+                        //the stream is about to be aborted, leave the device silent rather than half written
+                        _silence(output,frames);
+                        reset();
+                        return ret;
+                    }
+                    _queued += output == nullptr ? 0 : _block;
+                    _position += _block;
+                }
+            }
+            if(output != nullptr)
+            {
+                //the oldest frames go to the device, the rest move to the front, at most latency() frames
+                _copy(queue,0,output,0,frames,_output_width);
+                _queued -= frames;
+                _copy(queue,frames,queue,0,_queued,_output_width);
+            }
+            return ret;
+        }
+
+        //the block starting at _position, its output is heard _latency frames after the device frame with the same position
+        stream_timing _block_timing(const stream_timing& device) const noexcept
+        {
+            auto&& t = device.advanced(static_cast<std::int64_t>(_position - device.frame_position));
+            t.output_time += stream_timing::ticks(static_cast<double>(_latency) / device.sample_rate);
+            return t;
+        }
+
+        sample_t* _storage(const sample_t*) noexcept
+        {
+            return _input[0];
+        }
+
+        sample_t* _storage(sample_t*) noexcept
+        {
+            return _output[0];
+        }
+
+        sample_t* const* _storage(const sample_t* const*) noexcept
+        {
+            return _input.channels();
+        }
+
+        sample_t* const* _storage(sample_t* const*) noexcept
+        {
+            return _output.channels();
+        }
+
+        template<typename T>
+        static T* _at(T* buffer, std::size_t frame, std::size_t width, std::vector<sample_t*>&) noexcept
+        {
+            return buffer == nullptr ? nullptr : buffer + frame * width;
+        }
+
+        template<typename T>
+        static T* const* _at(T* const* buffer, std::size_t frame, std::size_t width, std::vector<sample_t*>& channels) noexcept
+        {
+            if(buffer == nullptr)
+            {
+                return nullptr;
+            }
+            for(std::size_t c = 0; c < width; ++c)
+            {
+                channels[c] = const_cast<sample_t*>(buffer[c]) + frame;
+            }
+            return channels.data();
+        }
+
+        static void _copy(const sample_t* in, std::size_t in_frame, sample_t* out, std::size_t out_frame, std::size_t frames, std::size_t width) noexcept
+        {
+            copy_samples(in + in_frame * width,out + out_frame * width,frames * width);
+        }
+
+        static void _copy(const sample_t* const* in, std::size_t in_frame, sample_t* const* out, std::size_t out_frame, std::size_t frames, std::size_t width) noexcept
+        {
+            for(std::size_t c = 0; c < width; ++c)
+            {
+                copy_samples(in[c] + in_frame,out[c] + out_frame,frames);
+            }
+        }
+
+        void _silence(sample_t* output, std::size_t frames) noexcept
+        {
+            if(output != nullptr)
+            {
+                fill_samples(output,frames * _output_width,sample_t());
+            }
+        }
+
+        void _silence(sample_t* const* output, std::size_t frames) noexcept
+        {
+            if(output != nullptr)
+            {
+                for(std::size_t c = 0; c < _output_width; ++c)
+                {
+                    fill_samples(output[c],frames,sample_t());
+                }
+            }
+        }
+
+        buffer_group<sample_t> _group(const sample_t* input, sample_t* output, std::size_t frames) const noexcept
+        {
+            return buffer_group<sample_t>{buffer_view<sample_t>{input,frames,_input_width},
+                                          buffer_view<sample_t>{output,frames,_output_width}};
+        }
+
+        buffer_group<sample_t> _group(const sample_t* const* input, sample_t* const* output, std::size_t frames) const noexcept
+        {
+            return buffer_group<sample_t>{planar_view<sample_t>{input,frames,input == nullptr ? 0 : _input_width},
+                                          planar_view<sample_t>{output,frames,output == nullptr ? 0 : _output_width}};
+        }
+    };
+}
+
+#endif
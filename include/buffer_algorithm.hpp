@@ -0,0 +1,451 @@
+#ifndef ZAUDIO_BUFFER_ALGORITHM
+#define ZAUDIO_BUFFER_ALGORITHM
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "buffer_view.hpp"
+#include "planar_view.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*
+     * Bulk operations over runs of samples
+     * float and double have sse2/avx2 kernels selected at runtime, any other sample type uses the templates below
+     * the templates are the scalar reference, calling one with an explicit template argument always selects it
+     * every kernel returns the same bits as the reference, sums use a fixed order of partial sums to make that possible
+     * runs that are read and written must either be the same run or not overlap
+     */
+
+    namespace detail
+    {
+        template<typename T>
+        struct non_deduced
+        {
+            using type = T;
+        };
+
+        //number of partial sums sample_sum keeps, one per sample of 128 bytes
+        template<typename sample_t>
+        constexpr std::size_t sum_lanes() noexcept
+        {
+            return sizeof(sample_t) > 4 ? 16 : 32;
+        }
+
+        //folds the partial sums of sample_sum in halves, then adds the samples that did not fill a row
+        template<typename sample_t>
+        sample_t finish_sum(sample_t* partial, const sample_t* data, std::size_t first, std::size_t count) noexcept
+        {
+            for(std::size_t width = sum_lanes<sample_t>() / 2; width > 0; width /= 2)
+            {
+                for(std::size_t j = 0; j < width; ++j)
+                {
+                    partial[j] = partial[j] + partial[j + width];
+                }
+            }
+            sample_t sum = partial[0];
+            for(std::size_t i = first; i < count; ++i)
+            {
+                sum = sum + data[i];
+            }
+            return sum;
+        }
+
+        //the gain applied to frame f of a ramp
+        template<typename sample_t>
+        inline sample_t ramp_gain(sample_t start, sample_t step, std::size_t frame) noexcept
+        {
+            return start + step * static_cast<sample_t>(frame);
+        }
+    }
+
+    /*!
+     *\fn fill_samples
+     *\brief sets count samples to value
+     */
+    template<typename sample_t>
+    void fill_samples(sample_t* data, std::size_t count, sample_t value) noexcept
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            data[i] = value;
+        }
+    }
+
+    /*!
+     *\fn copy_samples
+     *\brief copies count samples from in to out
+     */
+    template<typename sample_t>
+    void copy_samples(const sample_t* in, sample_t* out, std::size_t count) noexcept
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = in[i];
+        }
+    }
+
+    /*!
+     *\fn apply_gain
+     *\brief multiplies count samples by gain
+     */
+    template<typename sample_t>
+    void apply_gain(sample_t* data, std::size_t count, sample_t gain) noexcept
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            data[i] = data[i] * gain;
+        }
+    }
+
+    /*!
+     *\fn apply_gain_ramp
+     *\brief multiplies frames interleaved frames by a gain moving linearly from start towards end
+     *\note frame f gets start + (end - start) / frames * f, so consecutive buffers can continue a ramp
+     */
+    template<typename sample_t>
+    void apply_gain_ramp(sample_t* data, std::size_t frames, std::size_t channels, sample_t start, sample_t end) noexcept
+    {
+        if(frames == 0)
+        {
+            return;
+        }
+        const sample_t step = (end - start) / static_cast<sample_t>(frames);
+        for(std::size_t f = 0; f < frames; ++f)
+        {
+            const sample_t gain = detail::ramp_gain(start,step,f);
+            for(std::size_t c = 0; c < channels; ++c)
+            {
+                data[f * channels + c] = data[f * channels + c] * gain;
+            }
+        }
+    }
+
+    /*!
+     *\fn mix_samples
+     *\brief adds count samples of in scaled by gain to out
+     */
+    template<typename sample_t>
+    void mix_samples(const sample_t* in, sample_t* out, std::size_t count, sample_t gain) noexcept
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = out[i] + in[i] * gain;
+        }
+    }
+
+    /*!
+     *\fn clip_samples
+     *\brief limits count samples to [lo,hi]
+     *\note nan becomes lo
+     */
+    template<typename sample_t>
+    void clip_samples(sample_t* data, std::size_t count, sample_t lo, sample_t hi) noexcept
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            const sample_t v = data[i] > lo ? data[i] : lo;
+            data[i] = v < hi ? v : hi;
+        }
+    }
+
+    /*!
+     *\fn sample_peak
+     *\brief returns the largest absolute value of count samples, nan is ignored
+     */
+    template<typename sample_t>
+    sample_t sample_peak(const sample_t* data, std::size_t count) noexcept
+    {
+        sample_t peak = 0;
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            const sample_t v = data[i] < 0 ? -data[i] : data[i];
+            peak = v > peak ? v : peak;
+        }
+        return peak;
+    }
+
+    /*!
+     *\fn sample_sum
+     *\brief returns the sum of count samples
+     *\note sample i is added to partial sum i % detail::sum_lanes() and the partial sums are folded in halves
+     */
+    template<typename sample_t>
+    sample_t sample_sum(const sample_t* data, std::size_t count) noexcept
+    {
+        sample_t partial[detail::sum_lanes<sample_t>()] = {};
+        std::size_t i = 0;
+        for(; i + detail::sum_lanes<sample_t>() <= count; i += detail::sum_lanes<sample_t>())
+        {
+            for(std::size_t j = 0; j < detail::sum_lanes<sample_t>(); ++j)
+            {
+                partial[j] = partial[j] + data[i + j];
+            }
+        }
+        return detail::finish_sum(partial,data,i,count);
+    }
+
+    /*!
+     *\fn remove_dc
+     *\brief runs a one pole dc blocking filter over frames interleaved frames
+     *\note x1 and y1 hold the previous input and output of each channel and are updated
+     */
+    template<typename sample_t>
+    void remove_dc(sample_t* data, std::size_t frames, std::size_t channels, sample_t pole, sample_t* x1, sample_t* y1) noexcept
+    {
+        for(std::size_t f = 0; f < frames; ++f)
+        {
+            auto&& frame = data + f * channels;
+            for(std::size_t c = 0; c < channels; ++c)
+            {
+                const sample_t x = frame[c];
+                const sample_t y = (x - x1[c]) + pole * y1[c];
+                x1[c] = x;
+                y1[c] = y;
+                frame[c] = y;
+            }
+        }
+    }
+
+    /*!
+     *\fn map_channels
+     *\brief copies frames interleaved frames of in_channels channels to frames of out_channels channels
+     *\note a single channel is spread to every output channel and every channel is averaged down to a single one
+     *\note otherwise channels pass through by index, extra input channels are dropped and extra output channels are silent
+     */
+    template<typename sample_t>
+    void map_channels(const sample_t* in, std::size_t in_channels, sample_t* out, std::size_t out_channels, std::size_t frames) noexcept
+    {
+        for(std::size_t f = 0; f < frames; ++f)
+        {
+            auto&& source = in + f * in_channels;
+            auto&& target = out + f * out_channels;
+            if(out_channels == 1 && in_channels > 1)
+            {
+                double sum = 0;
+                for(std::size_t c = 0; c < in_channels; ++c)
+                {
+                    sum += static_cast<double>(source[c]);
+                }
+                target[0] = static_cast<sample_t>(sum / in_channels);
+                continue;
+            }
+            for(std::size_t c = 0; c < out_channels; ++c)
+            {
+                target[c] = in_channels == 1 ? source[0] : (c < in_channels ? source[c] : sample_t());
+            }
+        }
+    }
+
+    ZAUDIO_EXPORT void fill_samples(float* data, std::size_t count, float value) noexcept;
+    ZAUDIO_EXPORT void fill_samples(double* data, std::size_t count, double value) noexcept;
+    ZAUDIO_EXPORT void copy_samples(const float* in, float* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void copy_samples(const double* in, double* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void apply_gain(float* data, std::size_t count, float gain) noexcept;
+    ZAUDIO_EXPORT void apply_gain(double* data, std::size_t count, double gain) noexcept;
+    ZAUDIO_EXPORT void apply_gain_ramp(float* data, std::size_t frames, std::size_t channels, float start, float end) noexcept;
+    ZAUDIO_EXPORT void apply_gain_ramp(double* data, std::size_t frames, std::size_t channels, double start, double end) noexcept;
+    ZAUDIO_EXPORT void mix_samples(const float* in, float* out, std::size_t count, float gain) noexcept;
+    ZAUDIO_EXPORT void mix_samples(const double* in, double* out, std::size_t count, double gain) noexcept;
+    ZAUDIO_EXPORT void clip_samples(float* data, std::size_t count, float lo, float hi) noexcept;
+    ZAUDIO_EXPORT void clip_samples(double* data, std::size_t count, double lo, double hi) noexcept;
+    ZAUDIO_EXPORT float sample_peak(const float* data, std::size_t count) noexcept;
+    ZAUDIO_EXPORT double sample_peak(const double* data, std::size_t count) noexcept;
+    ZAUDIO_EXPORT float sample_sum(const float* data, std::size_t count) noexcept;
+    ZAUDIO_EXPORT double sample_sum(const double* data, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void remove_dc(float* data, std::size_t frames, std::size_t channels, float pole, float* x1, float* y1) noexcept;
+    ZAUDIO_EXPORT void remove_dc(double* data, std::size_t frames, std::size_t channels, double pole, double* x1, double* y1) noexcept;
+
+    //the same operations over views, a frame_view is a single channel or frame, a buffer_view is every sample of every frame
+
+    template<typename sample_t>
+    void fill_samples(frame_view<sample_t> view, typename detail::non_deduced<sample_t>::type value) noexcept
+    {
+        fill_samples(view.data(),view.size(),value);
+    }
+
+    template<typename sample_t>
+    void fill_samples(buffer_view<sample_t> view, typename detail::non_deduced<sample_t>::type value) noexcept
+    {
+        fill_samples(view.data(),view.size(),value);
+    }
+
+    //out must hold at least in.size() samples
+    template<typename sample_t>
+    void copy_samples(frame_view<sample_t> in, frame_view<sample_t> out) noexcept
+    {
+        copy_samples(const_cast<const sample_t*>(in.data()),out.data(),in.size());
+    }
+
+    template<typename sample_t>
+    void copy_samples(buffer_view<sample_t> in, buffer_view<sample_t> out) noexcept
+    {
+        copy_samples(const_cast<const sample_t*>(in.data()),out.data(),in.size());
+    }
+
+    template<typename sample_t>
+    void apply_gain(frame_view<sample_t> view, typename detail::non_deduced<sample_t>::type gain) noexcept
+    {
+        apply_gain(view.data(),view.size(),gain);
+    }
+
+    template<typename sample_t>
+    void apply_gain(buffer_view<sample_t> view, typename detail::non_deduced<sample_t>::type gain) noexcept
+    {
+        apply_gain(view.data(),view.size(),gain);
+    }
+
+    template<typename sample_t>
+    void apply_gain_ramp(frame_view<sample_t> view,
+                         typename detail::non_deduced<sample_t>::type start,
+                         typename detail::non_deduced<sample_t>::type end) noexcept
+    {
+        apply_gain_ramp(view.data(),view.size(),1,start,end);
+    }
+
+    template<typename sample_t>
+    void apply_gain_ramp(buffer_view<sample_t> view,
+                         typename detail::non_deduced<sample_t>::type start,
+                         typename detail::non_deduced<sample_t>::type end) noexcept
+    {
+        apply_gain_ramp(view.data(),view.frame_count(),view.frame_width(),start,end);
+    }
+
+    //out must hold at least in.size() samples
+    template<typename sample_t>
+    void mix_samples(frame_view<sample_t> in, frame_view<sample_t> out, typename detail::non_deduced<sample_t>::type gain = 1) noexcept
+    {
+        mix_samples(const_cast<const sample_t*>(in.data()),out.data(),in.size(),gain);
+    }
+
+    template<typename sample_t>
+    void mix_samples(buffer_view<sample_t> in, buffer_view<sample_t> out, typename detail::non_deduced<sample_t>::type gain = 1) noexcept
+    {
+        mix_samples(const_cast<const sample_t*>(in.data()),out.data(),in.size(),gain);
+    }
+
+    template<typename sample_t>
+    void clip_samples(frame_view<sample_t> view,
+                      typename detail::non_deduced<sample_t>::type lo = -1,
+                      typename detail::non_deduced<sample_t>::type hi = 1) noexcept
+    {
+        clip_samples(view.data(),view.size(),lo,hi);
+    }
+
+    template<typename sample_t>
+    void clip_samples(buffer_view<sample_t> view,
+                      typename detail::non_deduced<sample_t>::type lo = -1,
+                      typename detail::non_deduced<sample_t>::type hi = 1) noexcept
+    {
+        clip_samples(view.data(),view.size(),lo,hi);
+    }
+
+    template<typename sample_t>
+    sample_t sample_peak(frame_view<sample_t> view) noexcept
+    {
+        return sample_peak(const_cast<const sample_t*>(view.data()),view.size());
+    }
+
+    template<typename sample_t>
+    sample_t sample_peak(buffer_view<sample_t> view) noexcept
+    {
+        return sample_peak(const_cast<const sample_t*>(view.data()),view.size());
+    }
+
+    template<typename sample_t>
+    sample_t sample_sum(frame_view<sample_t> view) noexcept
+    {
+        return sample_sum(const_cast<const sample_t*>(view.data()),view.size());
+    }
+
+    template<typename sample_t>
+    sample_t sample_sum(buffer_view<sample_t> view) noexcept
+    {
+        return sample_sum(const_cast<const sample_t*>(view.data()),view.size());
+    }
+
+    /*!
+     *\class dc_blocker
+     *\brief removes the dc offset of each channel of a stream with a one pole highpass, y = x - x1 + pole * y1
+     *\note the default pole puts the cutoff near 35Hz at 44.1kHz, closer to 1 is lower
+     */
+    template<typename sample_t>
+    class dc_blocker
+    {
+    public:
+        //may throw std::bad_alloc
+        explicit dc_blocker(std::size_t channels, sample_t pole = sample_t(0.995)) : _pole(pole),
+                                                                                     _x1(channels,sample_t()),
+                                                                                     _y1(channels,sample_t())
+        {}
+
+        void reset() noexcept
+        {
+            for(std::size_t c = 0; c < channel_count(); ++c)
+            {
+                _x1[c] = sample_t();
+                _y1[c] = sample_t();
+            }
+        }
+
+        std::size_t channel_count() const noexcept
+        {
+            return _x1.size();
+        }
+
+        sample_t pole() const noexcept
+        {
+            return _pole;
+        }
+        void pole(sample_t p) noexcept
+        {
+            _pole = p;
+        }
+
+        //buffer.frame_width() must be channel_count()
+        void process(buffer_view<sample_t> buffer) noexcept
+        {
+            remove_dc(buffer.data(),buffer.frame_count(),channel_count(),_pole,_x1.data(),_y1.data());
+        }
+
+        //buffer.channel_count() must be channel_count()
+        void process(planar_view<sample_t> buffer) noexcept
+        {
+            for(std::size_t c = 0; c < channel_count(); ++c)
+            {
+                remove_dc(buffer[c].data(),buffer.frame_count(),1,_pole,&_x1[c],&_y1[c]);
+            }
+        }
+
+    private:
+        sample_t _pole;
+
+        std::vector<sample_t> _x1;
+
+        std::vector<sample_t> _y1;
+    };
+}
+
+#endif
@@ -20,18 +20,44 @@ This file is part of zaudio.
 
 
 #include "buffer_view.hpp"
+#include "planar_view.hpp"
+#include "sample_utility.hpp"
+#include "stream_timing.hpp"
 
 namespace zaudio
 {
+    /*!
+     *\struct buffer_group
+     *\brief the buffers handed to a stream callback
+     *\note layout says which pair is in use, the other pair is empty
+     */
     template<typename sample_t>
     struct buffer_group
     {
     public:
         using buffer_view_type = buffer_view<sample_t>;
-        buffer_group(const buffer_view_type& in,const buffer_view_type& out) noexcept : input(in), output(out)
+        using planar_view_type = planar_view<sample_t>;
+        buffer_group(const buffer_view_type& in,const buffer_view_type& out) noexcept : input(in),
+                                                                                       output(out),
+                                                                                       planar_input(),
+                                                                                       planar_output(),
+                                                                                       layout(buffer_layout::interleaved),
+                                                                                       timing()
+        {}
+        buffer_group(const planar_view_type& in,const planar_view_type& out) noexcept : input(static_cast<sample_t*>(nullptr),0,0),
+                                                                                       output(static_cast<sample_t*>(nullptr),0,0),
+                                                                                       planar_input(in),
+                                                                                       planar_output(out),
+                                                                                       layout(buffer_layout::planar),
+                                                                                       timing()
         {}
         const buffer_view_type input;
         buffer_view_type output;
+        const planar_view_type planar_input;
+        planar_view_type planar_output;
+        const buffer_layout layout;
+        //frame position and converter times of the first frame of these buffers
+        stream_timing timing;
     };
 }
 #endif
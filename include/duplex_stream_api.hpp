@@ -0,0 +1,537 @@
+#ifndef ZAUDIO_DUPLEX_STREAM_API
+#define ZAUDIO_DUPLEX_STREAM_API
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_api.hpp"
+#include "audio_ring_buffer.hpp"
+#include "adaptive_resampler.hpp"
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <string>
+#include <algorithm>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\class duplex_stream_api
+     *\brief a duplex stream made of an input stream and an output stream that run on separate, independently clocked devices
+     *\note the two may come from different backends, the device list is the input backend's devices followed by the output backend's
+     *\note input goes through a fifo to the output callback, which runs the stream callback, an adaptive_resampler steered by a drift_controller keeps the fifo at bridge_frames()
+     *\note the fifo adds bridge_frames() of input latency, stream_info includes it, never more than drift().max_fill frames are held
+     *\note the fifo running dry or past max_fill counts as an input underflow or overflow and the bridge starts again from the target fill
+     *\note errors of the two device streams are delivered to the error callback from their own dispatcher threads
+     */
+    template<typename sample_t>
+    class duplex_stream_api : public stream_api<sample_t>
+    {
+        using base = stream_api<sample_t>;
+        using callback_ref = typename base::callback_ref;
+        using error_callback = typename base::error_callback;
+    public:
+        duplex_stream_api(std::unique_ptr<stream_api<sample_t>> input, std::unique_ptr<stream_api<sample_t>> output) noexcept : _input_api(std::move(input)),
+                                                                                                                               _output_api(std::move(output)),
+                                                                                                                               _capture_ref{&_capture,this},
+                                                                                                                               _playback_ref{&_playback,this},
+                                                                                                                               _bridge_frames(0),
+                                                                                                                               _target(0),
+                                                                                                                               _max_fill(0),
+                                                                                                                               _locked(false),
+                                                                                                                               _dropped(0),
+                                                                                                                               _dropped_seen(0),
+                                                                                                                               _captured_at(0),
+                                                                                                                               _drift(0),
+                                                                                                                               _ratio(1),
+                                                                                                                               _fill(0),
+                                                                                                                               _underflows(0),
+                                                                                                                               _overflows(0),
+                                                                                                                               _locked_published(false)
+        {
+            _child_errors = [this](const stream_error& err)
+            {
+                std::lock_guard<std::mutex> guard(_child_error_lock);
+                auto&& cb = _error_callback.load();
+                if(cb != nullptr && *cb)
+                {
+                    (*cb)(err);
+                }
+            };
+            _input_api->set_callback(_capture_ref);
+            _output_api->set_callback(_playback_ref);
+            _input_api->set_error_callback(_child_errors);
+            _output_api->set_error_callback(_child_errors);
+        }
+        virtual ~duplex_stream_api()
+        {
+            close_stream();
+            _output_api->release_callbacks();
+            _input_api->release_callbacks();
+        }
+        virtual std::string name() const noexcept
+        {
+            return "LibZaudio: Duplex Stream API";
+        }
+        virtual std::string info() const noexcept
+        {
+            return "Input: " + _input_api->name() + ", Output: " + _output_api->name();
+        }
+        virtual stream_error start() noexcept
+        {
+            if(_fifo == nullptr)
+            {
+                return make_stream_error(stream_status::system_error,"The duplex stream is not open.");
+            }
+            _prepare_start();
+            //both device streams are stopped, the fifo can be emptied from here
+            _fifo->reset();
+            _resampler.reset();
+            _controller.reset();
+            _locked = false;
+            _dropped_seen = _dropped.load(std::memory_order_relaxed);
+            auto&& err = _input_api->start();
+            if(err != no_error)
+            {
+                return err;
+            }
+            err = _output_api->start();
+            if(err != no_error)
+            {
+                _input_api->stop();
+            }
+            return err;
+        }
+        virtual stream_error pause() noexcept
+        {
+            auto&& out = _output_api->pause();
+            auto&& in = _input_api->pause();
+            return out != no_error ? out : in;
+        }
+        virtual stream_error stop() noexcept
+        {
+            auto&& out = _output_api->stop();
+            auto&& in = _input_api->stop();
+            return out != no_error ? out : in;
+        }
+        virtual stream_error playback_state() noexcept
+        {
+            return _output_api->playback_state();
+        }
+        virtual std::string get_error_string(const stream_error& err) noexcept
+        {
+            return err.second;
+        }
+        virtual stream_error open_stream(const stream_params<sample_t>& params) noexcept
+        {
+            auto&& compat = is_configuration_supported(params);
+            if(compat != no_error)
+            {
+                return compat;
+            }
+            _params = &const_cast<stream_params<sample_t>&>(params);
+            _capture_params = _device_params(params,true);
+            _playback_params = _device_params(params,false);
+            //the device streams convert and map channels, the bridge hands sample_t frames of the callback widths around
+            stream_params<sample_t> bridge = params;
+            bridge.device_input_frame_width(params.input_frame_width());
+            bridge.device_output_frame_width(params.output_frame_width());
+            //and resample, the bridge runs at the stream rate
+            bridge.device_sample_rate(params.sample_rate());
+            compat = _format.prepare(bridge,detail::type_to_format_id<sample_t>::value,buffer_layout::interleaved);
+            if(compat == no_error)
+            {
+                compat = _rates.prepare(bridge);
+            }
+            if(compat == no_error)
+            {
+                compat = _blocks.prepare(bridge);
+            }
+            if(compat == no_error)
+            {
+                compat = _prepare_bridge(params);
+            }
+            if(compat != no_error)
+            {
+                return compat;
+            }
+            compat = _input_api->open_stream(_capture_params);
+            if(compat != no_error)
+            {
+                return compat;
+            }
+            compat = _output_api->open_stream(_playback_params);
+            if(compat != no_error)
+            {
+                _input_api->close_stream();
+                return compat;
+            }
+            _info.input_latency = _input_api->stream_info().input_latency + duration((_target + adaptive_resampler<sample_t>::history) / params.sample_rate());
+            _info.output_latency = _output_api->stream_info().output_latency;
+            _info.sample_rate = params.sample_rate();
+            return no_error;
+        }
+        virtual stream_error close_stream() noexcept
+        {
+            _info = zaudio::stream_info();
+            auto&& out = _output_api->close_stream();
+            auto&& in = _input_api->close_stream();
+            return out != no_error ? out : in;
+        }
+        virtual long get_device_count() noexcept
+        {
+            return _input_api->get_device_count() + _output_api->get_device_count();
+        }
+        virtual device_info get_device_info(long id) noexcept
+        {
+            auto&& inputs = _input_api->get_device_count();
+            if(id < inputs)
+            {
+                return _input_api->get_device_info(id);
+            }
+            auto&& info = _output_api->get_device_info(id - inputs);
+            info.device_index += static_cast<std::size_t>(inputs);
+            return info;
+        }
+        virtual stream_error is_configuration_supported(const stream_params<sample_t>& params) noexcept
+        {
+            if(params.mode() == stream_mode::blocking)
+            {
+                return make_stream_error(stream_status::system_error,"Duplex streams need a callback.");
+            }
+            if(params.input_frame_width() == 0 || params.output_frame_width() == 0)
+            {
+                return make_stream_error(stream_status::system_error,"Duplex streams need input and output channels.");
+            }
+            if(params.input_device_id() >= _input_api->get_device_count())
+            {
+                return make_stream_error(stream_status::system_error,"The input device must belong to the input stream api.");
+            }
+            if(params.output_device_id() >= 0 && params.output_device_id() < _input_api->get_device_count())
+            {
+                return make_stream_error(stream_status::system_error,"The output device must belong to the output stream api.");
+            }
+            auto&& in = _input_api->is_configuration_supported(_device_params(params,true));
+            return in != no_error ? in : _output_api->is_configuration_supported(_device_params(params,false));
+        }
+        virtual long default_input_device_id() const noexcept
+        {
+            return _input_api->default_input_device_id();
+        }
+        virtual long default_output_device_id() const noexcept
+        {
+            auto&& id = _output_api->default_output_device_id();
+            return id < 0 ? id : id + _input_api->get_device_count();
+        }
+        virtual double cpu_load() const noexcept
+        {
+            return std::max(_input_api->cpu_load(),_output_api->cpu_load());
+        }
+
+        //frames the fifo is kept at, takes effect when the stream is next opened
+        //0 keeps three device buffers, one for each callback to arrive at any phase of the other and one of scheduling jitter
+        std::size_t bridge_frames() const noexcept
+        {
+            return _bridge_frames;
+        }
+        void bridge_frames(std::size_t frames) noexcept
+        {
+            _bridge_frames = frames;
+        }
+
+        //safe to read from any thread
+        drift_statistics drift() const noexcept
+        {
+            drift_statistics stats;
+            stats.drift_ppm = _drift.load(std::memory_order_relaxed) * 1e6;
+            stats.ratio = _ratio.load(std::memory_order_relaxed);
+            stats.fill = _fill.load(std::memory_order_relaxed);
+            stats.target_fill = _target;
+            stats.max_fill = _max_fill;
+            stats.underflows = _underflows.load(std::memory_order_relaxed);
+            stats.overflows = _overflows.load(std::memory_order_relaxed);
+            stats.locked = _locked_published.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        //the device streams, for their xruns, callback statistics and stream_info
+        stream_api<sample_t>& input_stream() noexcept
+        {
+            return *_input_api;
+        }
+        stream_api<sample_t>& output_stream() noexcept
+        {
+            return *_output_api;
+        }
+
+    protected:
+        virtual std::unique_ptr<stream_api<sample_t>> _make_stream() noexcept
+        {
+            auto&& input = _input_api->make_stream();
+            auto&& output = _output_api->make_stream();
+            if(input == nullptr || output == nullptr)
+            {
+                return nullptr;
+            }
+            std::unique_ptr<duplex_stream_api<sample_t>> stream(new (std::nothrow) duplex_stream_api<sample_t>(std::move(input),std::move(output)));
+            if(stream != nullptr)
+            {
+                stream->bridge_frames(_bridge_frames);
+            }
+            return std::move(stream);
+        }
+
+    private:
+        using base::_params;
+
+        using base::_error_callback;
+
+        using base::_on_process_device;
+
+        using base::_format;
+
+        using base::_prepare_start;
+
+        using base::_rates;
+
+        using base::_blocks;
+
+        using base::_info;
+
+        std::unique_ptr<stream_api<sample_t>> _input_api;
+
+        std::unique_ptr<stream_api<sample_t>> _output_api;
+
+        //what the device streams were opened with, they must outlive them
+        stream_params<sample_t> _capture_params;
+
+        stream_params<sample_t> _playback_params;
+
+        const callback_ref _capture_ref;
+
+        const callback_ref _playback_ref;
+
+        error_callback _child_errors;
+
+        //both device streams may report at once
+        std::mutex _child_error_lock;
+
+        std::size_t _bridge_frames;
+
+        //set by open_stream
+        std::size_t _target;
+
+        std::size_t _max_fill;
+
+        //input frames of the callback width, written by the input thread and read by the output thread
+        std::unique_ptr<audio_ring_buffer<sample_t>> _fifo;
+
+        //the rest belongs to the output thread while the stream runs
+        adaptive_resampler<sample_t> _resampler;
+
+        drift_controller _controller;
+
+        //one buffer of resampled input handed to the callback
+        std::vector<sample_t> _input;
+
+        bool _locked;
+
+        //frames the input thread could not queue, only it writes
+        std::atomic<std::uint64_t> _dropped;
+
+        std::uint64_t _dropped_seen;
+
+        //callback_time of the last input buffer, in audio_clock ticks
+        std::atomic<typename base::audio_clock::duration::rep> _captured_at;
+
+        //published for drift()
+        std::atomic<double> _drift;
+
+        std::atomic<double> _ratio;
+
+        std::atomic<double> _fill;
+
+        std::atomic<std::uint64_t> _underflows;
+
+        std::atomic<std::uint64_t> _overflows;
+
+        std::atomic<bool> _locked_published;
+
+        //params for one of the device streams, device ids are the duplex ids taken back to the backend's own
+        stream_params<sample_t> _device_params(const stream_params<sample_t>& params, bool capture) const noexcept
+        {
+            auto&& output_id = params.output_device_id() < 0 ? -1 : params.output_device_id() - _input_api->get_device_count();
+            stream_params<sample_t> device(params.sample_rate(),
+                                           params.frame_count(),
+                                           capture ? params.input_frame_width() : 0,
+                                           capture ? 0 : params.output_frame_width(),
+                                           capture ? params.input_device_id() : -1,
+                                           capture ? -1 : output_id);
+            device.device_format(params.device_format());
+            device.dither_mode(params.dither_mode());
+            device.realtime_policy(params.realtime_policy());
+            device.variable_frame_count(params.variable_frame_count());
+            device.report_xruns(params.report_xruns());
+            device.input_latency(params.input_latency());
+            device.output_latency(params.output_latency());
+            device.device_sample_rate(params.device_sample_rate());
+            if(params.device_sample_rate() != params.sample_rate())
+            {
+                //the bridge is sized for buffers of frame_count() frames at the stream rate
+                device.block_size(params.frame_count());
+            }
+            if(capture)
+            {
+                device.device_input_frame_width(params.device_input_frame_width());
+            }
+            else
+            {
+                device.device_output_frame_width(params.device_output_frame_width());
+            }
+            return device;
+        }
+
+        stream_error _prepare_bridge(const stream_params<sample_t>& params) noexcept
+        {
+            auto&& frames = params.frame_count();
+            _target = _bridge_frames != 0 ? _bridge_frames : 3 * frames;
+            try
+            {
+                _fifo.reset(new audio_ring_buffer<sample_t>(2 * (_target + frames),params.input_frame_width(),ring_memory::mirrored));
+                _input.assign(frames * params.input_frame_width(),sample_t());
+            }
+            catch(const std::bad_alloc&)
+            {
+                _fifo.reset();
+                return make_stream_error(stream_status::system_error,"Unable to allocate the duplex fifo.");
+            }
+            //the producer has at least a device buffer of room left when the consumer notices
+            _max_fill = _fifo->capacity() - frames;
+            _controller.prepare(params.sample_rate(),static_cast<double>(_target));
+            return _resampler.prepare(params.input_frame_width(),frames,1.0 + drift_controller::max_correction);
+        }
+
+        static stream_error _capture(void* object, buffer_group<sample_t>& buffers, time_point, stream_params<sample_t>&)
+        {
+            auto&& self = *static_cast<duplex_stream_api<sample_t>*>(object);
+            auto&& frames = buffers.input.frame_count();
+            //published by the release in write
+            self._captured_at.store(buffers.timing.callback_time.time_since_epoch().count(),std::memory_order_relaxed);
+            auto&& queued = self._fifo->write(buffers.input);
+            if(queued < frames)
+            {
+                self._dropped.store(self._dropped.load(std::memory_order_relaxed) + (frames - queued),std::memory_order_release);
+            }
+            return no_error;
+        }
+
+        static stream_error _playback(void* object, buffer_group<sample_t>& buffers, time_point, stream_params<sample_t>&)
+        {
+            auto&& self = *static_cast<duplex_stream_api<sample_t>*>(object);
+            return self._bridge(buffers.output.data(),buffers.output.frame_count(),buffers.timing);
+        }
+
+        //output thread, resamples a buffer of input from the fifo and runs the stream callback on it
+        stream_error _bridge(sample_t* output, std::size_t frames, const stream_timing& device) noexcept
+        {
+            xrun_flags flags = xrun_flags::none;
+            auto&& queued = _fifo->readable();
+            auto&& dropped = _dropped.load(std::memory_order_acquire);
+            //the fifo only grows a whole input buffer at a time, counting what the input device captured since then keeps the fill smooth
+            auto&& since = device.callback_time - time_point(typename base::audio_clock::duration(_captured_at.load(std::memory_order_relaxed)));
+            auto&& pending = std::chrono::duration_cast<duration>(since).count() * device.sample_rate;
+            const std::size_t in_flight = pending <= 0 ? 0 : std::min(static_cast<std::size_t>(pending),_params->frame_count());
+            std::size_t fill = queued + in_flight;
+            if(_locked && (fill > _max_fill || dropped != _dropped_seen))
+            {
+                flags = flags | xrun_flags::input_overflow;
+                _overflows.store(_overflows.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+                _locked = false;
+            }
+            _dropped_seen = dropped;
+            if(!_locked && fill >= _target)
+            {
+                _skip(std::min(fill - _target,queued));
+                fill = _target;
+                _resampler.reset();
+                _controller.reset();
+                _locked = true;
+            }
+            if(_locked)
+            {
+                auto&& ratio = _controller.update(static_cast<double>(fill),frames);
+                if(!_resampler.process(*_fifo,_input.data(),frames,ratio))
+                {
+                    flags = flags | xrun_flags::input_underflow;
+                    _underflows.store(_underflows.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+                    _locked = false;
+                }
+            }
+            else
+            {
+                //waiting for the fifo to fill, as a device does while it primes
+                fill_samples(_input.data(),_input.size(),sample_t());
+            }
+            _drift.store(_controller.drift(),std::memory_order_relaxed);
+            _ratio.store(_controller.ratio(),std::memory_order_relaxed);
+            _fill.store(_controller.fill(),std::memory_order_relaxed);
+            _locked_published.store(_locked,std::memory_order_relaxed);
+            //the output clock drives the stream, the input was captured a fifo and an input latency earlier
+            stream_timing timing = device;
+            timing.frame_position = this->frame_position();
+            timing.input_time = timing.callback_time - stream_timing::ticks((fill + adaptive_resampler<sample_t>::history) / timing.sample_rate) -
+                                std::chrono::duration_cast<typename base::audio_clock::duration>(_input_api->stream_info().input_latency);
+            timing.device_time = false;
+            return _on_process_device(_input.data(),output,frames,timing,flags);
+        }
+
+        //drops frames from the front of the fifo
+        void _skip(std::size_t frames) noexcept
+        {
+            while(frames != 0)
+            {
+                auto&& window = _fifo->read_window(frames);
+                if(window.frame_count() == 0)
+                {
+                    break;
+                }
+                _fifo->commit_read(window.frame_count());
+                frames -= window.frame_count();
+            }
+        }
+    };
+
+    /*!
+     *\fn make_duplex_stream_api
+     *\brief helper function that joins an input stream api and an output stream api into one duplex stream api
+     * ie: stream_context<float>{make_duplex_stream_api<float>(make_stream_api<float,pa_stream_api>(),make_stream_api<float,pa_stream_api>())}
+     */
+    template<typename sample_t>
+    std::unique_ptr<stream_api<typename std::decay<sample_t>::type>> make_duplex_stream_api(std::unique_ptr<stream_api<typename std::decay<sample_t>::type>> input,
+                                                                                            std::unique_ptr<stream_api<typename std::decay<sample_t>::type>> output) noexcept
+    {
+        return std::unique_ptr<stream_api<typename std::decay<sample_t>::type>>{new duplex_stream_api<typename std::decay<sample_t>::type>(std::move(input),std::move(output))};
+    }
+}
+
+#endif
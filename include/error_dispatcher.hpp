@@ -0,0 +1,135 @@
+#ifndef ZAUDIO_ERROR_DISPATCHER
+#define ZAUDIO_ERROR_DISPATCHER
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "error_utility.hpp"
+
+#include <atomic>
+#include <thread>
+#include <cstddef>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\class stream_error_queue
+     *\brief a preallocated, lock free, single producer single consumer queue of stream_errors
+     *\note messages are copied into the queue so they may point at storage that does not outlive the push
+     */
+    class ZAUDIO_EXPORT stream_error_queue
+    {
+    public:
+        constexpr static std::size_t capacity = 64;
+
+        constexpr static std::size_t message_size = 128;
+
+        stream_error_queue() noexcept;
+
+        //producer side, realtime safe
+        //returns false if the error was coalesced with an identical pending error or the queue was full
+        bool push(const stream_error& err) noexcept;
+
+        //consumer side
+        //the message of the popped error stays valid until the next call to pop
+        bool pop(stream_error& err) noexcept;
+
+        bool empty() const noexcept;
+
+        std::size_t dropped() const noexcept;
+
+        std::size_t coalesced() const noexcept;
+
+    private:
+        struct entry
+        {
+            stream_status status;
+            char message[message_size];
+        };
+
+        entry _entries[capacity];
+
+        entry _popped;
+
+        //next slot to read, only written by the consumer
+        std::atomic<std::size_t> _head;
+
+        //keeps the two indices on separate cache lines
+        char _padding[64];
+
+        //next slot to write, only written by the producer
+        std::atomic<std::size_t> _tail;
+
+        std::atomic<std::size_t> _dropped;
+
+        std::atomic<std::size_t> _coalesced;
+    };
+
+    /*!
+     *\class stream_error_dispatcher
+     *\brief delivers errors reported from the audio thread to a stream_error_callback on its own thread
+     */
+    class ZAUDIO_EXPORT stream_error_dispatcher
+    {
+    public:
+        explicit stream_error_dispatcher(std::atomic<stream_error_callback*>& callback) noexcept;
+
+        ~stream_error_dispatcher();
+
+        //start the delivery thread if it is not already running
+        void start() noexcept;
+
+        //deliver anything still queued and stop the delivery thread
+        void stop() noexcept;
+
+        //realtime safe, never blocks
+        bool report(const stream_error& err) noexcept;
+
+        //wait until no delivery that started before this call is still using the previous callback
+        void wait_for_delivery_boundary() const noexcept;
+
+        //wait until everything reported so far has been delivered
+        void flush() const noexcept;
+
+        std::size_t dropped_error_count() const noexcept;
+
+        std::size_t coalesced_error_count() const noexcept;
+
+    private:
+        void _run() noexcept;
+
+        void _deliver_pending() noexcept;
+
+        std::atomic<stream_error_callback*>& _callback;
+
+        stream_error_queue _queue;
+
+        //odd while an error is being delivered
+        std::atomic<std::size_t> _delivery_epoch;
+
+        std::atomic<bool> _running;
+
+        std::thread _thread;
+    };
+}
+
+#endif
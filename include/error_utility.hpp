@@ -19,6 +19,7 @@ This file is part of zaudio.
 */
 #include "config.hpp"
 #include <string>
+#include <cstring>
 #include <exception>
 #include <future>
 #include <iostream>
@@ -76,7 +77,8 @@ namespace zaudio
   {
       /*!
        *\struct stream_error_type
-       *\brief a workaround type for c++11 std::pair not having a constexpr contructor
+       *\brief a stream_status and message pair with a constexpr constructor in c++11
+       *\note errors created inside the library and in a program compare equal when their status and message text match
        */
       struct stream_error_type
       {
@@ -88,14 +90,15 @@ namespace zaudio
 
           stream_error_message second;
 
+          //the same literal has a different address in the library and in the program, so messages are compared by content
           friend bool operator==(const stream_error_type& lhs,const stream_error_type& rhs)
           {
-              return lhs.first == rhs.first && lhs.second == rhs.second;
+              return lhs.first == rhs.first && (lhs.second == rhs.second || std::strcmp(lhs.second,rhs.second) == 0);
           }
 
           friend bool operator!=(const stream_error_type& lhs,const stream_error_type& rhs)
           {
-              return lhs.first != rhs.first || lhs.second != rhs.second;
+              return !(lhs == rhs);
           }
       };
   }
@@ -105,11 +108,8 @@ namespace zaudio
    *\typedef stream_error
    *\brief a grouping of a stream_status and a stream_error_message
    */
-  //use std pair if c++14 else use stream_error_type
-  using stream_error = std::conditional<__cplusplus == 201402L,
-                                        std::pair<stream_status,
-                                        stream_error_message>,
-                                        detail::stream_error_type>::type;
+  //the same type in every language mode, a std::pair would compare its messages by address
+  using stream_error = detail::stream_error_type;
 
  /*!
   *\fn stream_error operator<<
@@ -0,0 +1,598 @@
+#ifndef file_stream_api_hpp
+#define file_stream_api_hpp
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_api.hpp"
+#include "null_stream_api.hpp"
+#include "audio_file.hpp"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <system_error>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <new>
+
+namespace zaudio
+{
+    /*!
+     *\struct file_stream_options
+     *\brief the files a file_stream_api reads and writes and how fast it goes through them
+     */
+    struct file_stream_options
+    {
+        //wav and rf64 files are recognised by their header, empty for silent input
+        std::string input_path;
+
+        //read input_path as headerless samples in params.device_format() with params.device_input_frame_width() channels
+        bool raw_input = false;
+
+        //created or truncated when the stream opens, empty to discard the output
+        std::string output_path;
+
+        //the samples are stored in params.device_format()
+        audio_file_type output_type = audio_file_type::wav;
+
+        //free running goes through the files as fast as the callback allows
+        null_stream_clock clock = null_stream_clock::free_running;
+
+        //output frames gathered in memory before each write to the file, never less than a buffer
+        std::size_t batch_frames = 65536;
+
+        //frames a callback stream runs before it ends by itself, 0 for the length of the input file or until stopped without one
+        //input past the end of the file is silent
+        std::uint64_t length = 0;
+    };
+
+    /*!
+     *\class file_stream_api
+     *\brief a stream_api that reads its input from an audio file and writes its output to another, with no device present
+     *\note the input file is memory mapped, when params.device_format() is sample_t the input buffers handed to the callback point straight into the mapping
+     *\note the output is converted straight into a batch of options.batch_frames frames, which reaches the file in one write
+     *\note the device format is the format of a wav or rf64 input file, and so must be its channels and sample rate, negotiation finds them
+     *\note a callback stream stops itself at the end of its length, the output file is complete by the time playback_state() reports stopped
+     *\note the last buffer before the end is shorter than params.frame_count() when the length is not a whole number of buffers
+     *\note stop and start pick up where the stream left off, open_stream starts over and truncates the output file
+     *\note blocking streams never wait, read returns an error once it passes the end of the input file
+     */
+    template<typename sample_t>
+    class file_stream_api : public stream_api<sample_t>
+    {
+        using base = stream_api<sample_t>;
+        using audio_clock = typename base::audio_clock;
+    public:
+        explicit file_stream_api(file_stream_options options) : _options(std::move(options)),
+                                                                _input_error(no_error),
+                                                                _running(false),
+                                                                _open(false),
+                                                                _cpu_load(0.0),
+                                                                _position(0),
+                                                                _length(0),
+                                                                _input_frames(0),
+                                                                _direct(false)
+        {
+            if(!_options.input_path.empty() && !_options.raw_input)
+            {
+                //mapped now so the device reports the layout of the file before a stream is negotiated
+                _input_error = _input_file.open(_options.input_path);
+            }
+        }
+        virtual ~file_stream_api()
+        {
+            close_stream();
+        }
+        using base::id;
+        virtual std::string name() const noexcept
+        {
+            return "LibZaudio: File Stream API";
+        }
+        virtual std::string info() const noexcept
+        {
+            return "Reads and writes wav, rf64 and raw audio files, memory mapped input and batched output";
+        }
+        virtual stream_error start() noexcept
+        {
+            if(!_open)
+            {
+                return make_stream_error(stream_status::system_error,"No stream is open.");
+            }
+            _join();
+            _prepare_start();
+            if(_params->mode() != stream_mode::blocking && _length != 0 && _position.load() >= _length)
+            {
+                return make_stream_error(stream_status::system_error,"The end of the stream was reached.");
+            }
+            _running.store(true);
+            if(_params->mode() == stream_mode::blocking)
+            {
+                return no_error;
+            }
+            try
+            {
+                _thread = std::thread(&file_stream_api<sample_t>::_run,this);
+            }
+            catch(const std::system_error&)
+            {
+                _running.store(false);
+                return make_stream_error(stream_status::system_error,"Unable to start the file stream thread.");
+            }
+            return no_error;
+        }
+        virtual stream_error pause() noexcept
+        {
+            return stop();
+        }
+        virtual stream_error stop() noexcept
+        {
+            _running.store(false);
+            _join();
+            //the audio thread already flushed, a blocking stream has not
+            if(_output_file.is_open())
+            {
+                return _output_file.flush();
+            }
+            return no_error;
+        }
+        virtual stream_error playback_state() noexcept
+        {
+            return _running.load() ? running : stopped;
+        }
+        virtual std::string get_error_string(const stream_error& err) noexcept
+        {
+            return err.second;
+        }
+        virtual stream_error open_stream(const stream_params<sample_t>& params) noexcept
+        {
+            auto&& compat = is_configuration_supported(params);
+            if(compat == no_error)
+            {
+                close_stream();
+                //files are interleaved, planar streams are transposed by _format
+                compat = _format.prepare(params,params.device_format(),buffer_layout::interleaved);
+                if(compat != no_error)
+                {
+                    return compat;
+                }
+                _params = &const_cast<stream_params<sample_t>&>(params);
+                compat = _prepare_blocking();
+                if(compat == no_error)
+                {
+                    compat = _rates.prepare(params);
+                }
+                if(compat == no_error)
+                {
+                    compat = _blocks.prepare(params);
+                }
+                if(compat != no_error)
+                {
+                    return compat;
+                }
+                auto&& size = sample_size(params.device_format());
+                const bool reading = params.device_input_frame_width() != 0 && !_options.input_path.empty();
+                if(reading && _options.raw_input)
+                {
+                    audio_file_format raw;
+                    raw.type = audio_file_type::raw;
+                    raw.format = params.device_format();
+                    raw.channels = params.device_input_frame_width();
+                    raw.sample_rate = params.device_sample_rate();
+                    compat = _input_file.open_raw(_options.input_path,raw);
+                    if(compat != no_error)
+                    {
+                        return compat;
+                    }
+                }
+                _input_frames = reading ? _input_file.frame_count() : 0;
+                try
+                {
+                    //unsigned 8 bit silence is the midpoint
+                    _input.assign(params.frame_count() * params.device_input_frame_width() * size,params.device_format() == sample_format::u8 ? 0x80 : 0);
+                    _output.assign(params.frame_count() * params.device_output_frame_width() * size,0);
+                    _staging.clear();
+                    //the mapping is used in place when it is aligned for the samples, a wav header of odd size leaves it unaligned
+                    auto&& alignment = (size & (size - 1)) == 0 ? size : 1;
+                    _direct = _input_frames == 0 || reinterpret_cast<std::uintptr_t>(_input_file.data()) % alignment == 0;
+                    if(!_direct)
+                    {
+                        _staging.resize(_input.size());
+                    }
+                }
+                catch(const std::bad_alloc&)
+                {
+                    _input_file.close();
+                    return make_stream_error(stream_status::system_error,"Unable to allocate stream buffers.");
+                }
+                if(params.device_output_frame_width() != 0 && !_options.output_path.empty())
+                {
+                    audio_file_format out;
+                    out.type = _options.output_type;
+                    out.format = params.device_format();
+                    out.channels = params.device_output_frame_width();
+                    out.sample_rate = params.device_sample_rate();
+                    compat = _output_file.open(_options.output_path,out,std::max(_options.batch_frames,params.frame_count()));
+                    if(compat != no_error)
+                    {
+                        return compat;
+                    }
+                }
+                _position.store(0);
+                _length = _options.length != 0 ? _options.length : _input_frames;
+                //a file has no buffering, the only latency is the buffer itself
+                const duration buffer{params.frame_count() / params.device_sample_rate()};
+                _info = zaudio::stream_info();
+                _info.input_latency = buffer;
+                _info.output_latency = buffer;
+                _info.sample_rate = params.device_sample_rate();
+                _open = true;
+            }
+            return compat;
+        }
+        virtual stream_error close_stream() noexcept
+        {
+            auto&& ret = stop();
+            auto&& closed = _output_file.close();
+            if(_options.raw_input)
+            {
+                _input_file.close();
+            }
+            _open = false;
+            _info = zaudio::stream_info();
+            return ret != no_error ? ret : closed;
+        }
+        virtual long get_device_count() noexcept
+        {
+            return 1;
+        }
+        virtual device_info get_device_info(long id) noexcept
+        {
+            if(id != 0)
+            {
+                return device_info();
+            }
+            //a wav or rf64 input fixes the channels and rate of the device
+            const bool fixed = _input_file.is_open() && !_options.raw_input;
+            return make_device_info("File Device",0,
+                                    fixed ? _input_file.format().channels : std::size_t(32),
+                                    std::size_t(32),
+                                    fixed ? _input_file.format().sample_rate : 48000.0,
+                                    duration(0),duration(0),duration(0),duration(0));
+        }
+        virtual stream_error is_configuration_supported(const stream_params<sample_t>& params) noexcept
+        {
+            if(params.sample_rate() <= 0 || params.device_sample_rate() <= 0 || params.frame_count() == 0)
+            {
+                return make_stream_error(stream_status::system_error,"Invalid sample rate or frame count.");
+            }
+            if(sample_size(params.device_format()) == 0)
+            {
+                return make_stream_error(stream_status::system_error,"Invalid device sample format.");
+            }
+            if(params.input_latency().time() < duration(0) || params.output_latency().time() < duration(0))
+            {
+                return make_stream_error(stream_status::system_error,"Invalid latency target.");
+            }
+            if(params.device_input_frame_width() != 0 && !_options.input_path.empty() && !_options.raw_input)
+            {
+                if(_input_error != no_error)
+                {
+                    return _input_error;
+                }
+                auto&& file = _input_file.format();
+                //blocking transfers are not mapped between stream and device channels
+                if(params.device_input_frame_width() != file.channels ||
+                   (params.mode() == stream_mode::blocking && params.input_frame_width() != file.channels))
+                {
+                    return make_stream_error(stream_status::system_error,"Invalid number of channels for the input file.");
+                }
+                if(params.device_format() != file.format)
+                {
+                    return make_stream_error(stream_status::system_error,"The device format does not match the input file.");
+                }
+                if(params.device_sample_rate() != file.sample_rate)
+                {
+                    return make_stream_error(stream_status::system_error,"The sample rate does not match the input file.");
+                }
+            }
+            if(params.mode() == stream_mode::blocking && params.device_output_frame_width() != params.output_frame_width() && !_options.output_path.empty())
+            {
+                return make_stream_error(stream_status::system_error,"Invalid number of channels for the output file.");
+            }
+            if(params.device_output_frame_width() != 0 && !_options.output_path.empty() && _options.output_type != audio_file_type::raw &&
+               (params.device_format() == sample_format::i8 || params.device_format() == sample_format::i64))
+            {
+                return make_stream_error(stream_status::system_error,"The device format cannot be stored in a wav file.");
+            }
+            return no_error;
+        }
+        virtual long default_input_device_id() const noexcept
+        {
+            return 0;
+        }
+        virtual long default_output_device_id() const noexcept
+        {
+            return 0;
+        }
+        //measured time spent in the callback as a fraction of the buffer period, above 1 when running slower than realtime
+        virtual double cpu_load() const noexcept
+        {
+            return _cpu_load.load(std::memory_order_relaxed);
+        }
+
+        //a file always has room and data
+        virtual long write_available() noexcept
+        {
+            if(!_running.load() || _params->mode() != stream_mode::blocking)
+            {
+                return -1;
+            }
+            return static_cast<long>(_params->frame_count());
+        }
+        virtual long read_available() noexcept
+        {
+            if(!_running.load() || _params->mode() != stream_mode::blocking)
+            {
+                return -1;
+            }
+            auto&& position = _position.load();
+            const std::uint64_t left = _input_frames > position ? _input_frames - position : 0;
+            return static_cast<long>(std::min<std::uint64_t>(left,_params->frame_count()));
+        }
+
+        const file_stream_options& options() const noexcept
+        {
+            return _options;
+        }
+        //the layout of the input file, valid once it is open
+        const audio_file_format& input_format() const noexcept
+        {
+            return _input_file.format();
+        }
+        //input frames processed since the stream was opened, safe to read from any thread
+        std::uint64_t position() const noexcept
+        {
+            return _position.load(std::memory_order_acquire);
+        }
+        //frames a callback stream runs in all, 0 when it runs until stopped
+        std::uint64_t length() const noexcept
+        {
+            return _length;
+        }
+
+    private:
+        using base::_params;
+
+        using base::_on_process_device;
+
+        using base::_format;
+
+        using base::_prepare_start;
+
+        using base::_callback_timing;
+
+        using base::_prepare_blocking;
+
+        using base::_rates;
+
+        using base::_blocks;
+
+        using base::_info;
+
+        using base::_errors;
+
+        file_stream_options _options;
+
+        audio_file_reader _input_file;
+
+        //why a wav or rf64 input could not be opened, reported by is_configuration_supported
+        stream_error _input_error;
+
+        audio_file_writer _output_file;
+
+        //silent input past the end of the file and discarded output without one, in params.device_format()
+        std::vector<unsigned char> _input;
+
+        std::vector<unsigned char> _output;
+
+        //a copy of the input when the mapping is not aligned for the samples
+        std::vector<unsigned char> _staging;
+
+        std::thread _thread;
+
+        std::atomic<bool> _running;
+
+        bool _open;
+
+        std::atomic<double> _cpu_load;
+
+        //only the audio thread, or the reading thread of a blocking stream, writes it
+        std::atomic<std::uint64_t> _position;
+
+        std::uint64_t _length;
+
+        std::uint64_t _input_frames;
+
+        bool _direct;
+
+        //frames past the end of the input are silent
+        const void* _input_at(std::uint64_t position, std::size_t frames) noexcept
+        {
+            if(position >= _input_frames)
+            {
+                return _input.data();
+            }
+            if(_direct)
+            {
+                return _input_file.frame(position);
+            }
+            std::memcpy(_staging.data(),_input_file.frame(position),frames * _input_file.format().frame_bytes());
+            return _staging.data();
+        }
+
+        virtual stream_error _write_device(const void* buffer, std::size_t frames) noexcept
+        {
+            if(!_running.load())
+            {
+                return make_stream_error(stream_status::system_error,"The stream is not running.");
+            }
+            if(!_output_file.is_open())
+            {
+                return no_error;
+            }
+            return _output_file.write(buffer,frames);
+        }
+
+        virtual stream_error _read_device(void* buffer, std::size_t frames) noexcept
+        {
+            if(!_running.load())
+            {
+                return make_stream_error(stream_status::system_error,"The stream is not running.");
+            }
+            auto&& position = _position.load(std::memory_order_relaxed);
+            auto&& frame_bytes = _params->input_frame_width() * sample_size(_format.device_format());
+            const std::uint64_t left = _input_frames > position ? _input_frames - position : 0;
+            const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(left,frames));
+            if(count != 0)
+            {
+                std::memcpy(buffer,_input_file.frame(position),count * frame_bytes);
+            }
+            std::memset(static_cast<unsigned char*>(buffer) + count * frame_bytes,_params->device_format() == sample_format::u8 ? 0x80 : 0,(frames - count) * frame_bytes);
+            _position.store(position + frames,std::memory_order_release);
+            if(count < frames && !_options.input_path.empty())
+            {
+                return make_stream_error(stream_status::system_error,"The end of the input file was reached.");
+            }
+            return no_error;
+        }
+
+        void _join() noexcept
+        {
+            if(_thread.joinable() && _thread.get_id() != std::this_thread::get_id())
+            {
+                _thread.join();
+            }
+        }
+
+        void _run() noexcept
+        {
+            const bool paced = _options.clock == null_stream_clock::paced;
+            const bool writing = _output_file.is_open();
+            //madvise is a system call, so read ahead a batch at a time
+            const std::uint64_t readahead = std::max<std::uint64_t>(_options.batch_frames,_params->frame_count());
+            auto&& latency = std::chrono::duration_cast<typename audio_clock::duration>(_info.output_latency);
+            auto&& next = audio_clock::now();
+            double load = 0.0;
+            xrun_flags xruns = xrun_flags::none;
+            std::uint64_t prefetched = 0;
+
+            while(_running.load(std::memory_order_acquire))
+            {
+                auto&& position = _position.load(std::memory_order_relaxed);
+                std::size_t frames = _params->frame_count();
+                if(_length != 0)
+                {
+                    if(position >= _length)
+                    {
+                        break;
+                    }
+                    frames = static_cast<std::size_t>(std::min<std::uint64_t>(frames,_length - position));
+                }
+                if(position < _input_frames)
+                {
+                    //never straddle the end of the file, the rest of the buffer comes from the silent one
+                    frames = static_cast<std::size_t>(std::min<std::uint64_t>(frames,_input_frames - position));
+                    if(position + frames > prefetched)
+                    {
+                        prefetched = position + readahead;
+                        _input_file.prefetch(position,readahead);
+                    }
+                }
+                auto&& input = _input_at(position,frames);
+                void* output = _output.data();
+                if(writing)
+                {
+                    //the batch is written out here once it is full, the only system call on the way
+                    output = _output_file.write_window(frames);
+                    if(output == nullptr)
+                    {
+                        _errors.report(make_stream_error(stream_status::system_error,"Unable to write the output file."));
+                        break;
+                    }
+                }
+                const duration period{frames / _params->device_sample_rate()};
+                auto&& timing = _callback_timing(frames);
+                if(paced)
+                {
+                    //the same simulated device clock as null_stream_api, one buffer of latency each way
+                    timing.input_time = next - latency;
+                    timing.output_time = next + latency;
+                    timing.device_time = true;
+                }
+                auto&& begin = audio_clock::now();
+                auto&& ret = _on_process_device(input,output,frames,timing,xruns);
+                xruns = xrun_flags::none;
+                auto&& elapsed = std::chrono::duration_cast<duration>(audio_clock::now() - begin);
+                if(writing)
+                {
+                    _output_file.commit_write(frames);
+                }
+                _position.store(position + frames,std::memory_order_release);
+
+                load += 0.1 * ((elapsed / period) - load);
+                _cpu_load.store(load,std::memory_order_relaxed);
+
+                if(ret != no_error)
+                {
+                    //mirror a device api aborting the stream
+                    break;
+                }
+                if(paced)
+                {
+                    next += std::chrono::duration_cast<typename audio_clock::duration>(period);
+                    auto&& now = audio_clock::now();
+                    if(next > now)
+                    {
+                        thread_sleep(next - now);
+                    }
+                    else if(now - next > period)
+                    {
+                        //no frame is lost, but a device would have underflowed here
+                        next = now;
+                        xruns = (_params->output_frame_width() != 0 ? xrun_flags::output_underflow : xrun_flags::none) |
+                                (_params->input_frame_width() != 0 ? xrun_flags::input_overflow : xrun_flags::none);
+                    }
+                }
+            }
+            //the file is complete before playback_state() can report the stream stopped
+            if(writing)
+            {
+                auto&& flushed = _output_file.flush();
+                if(flushed != no_error)
+                {
+                    _errors.report(flushed);
+                }
+            }
+            _running.store(false);
+        }
+    };
+}
+
+#endif
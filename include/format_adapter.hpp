@@ -0,0 +1,481 @@
+#ifndef ZAUDIO_FORMAT_ADAPTER
+#define ZAUDIO_FORMAT_ADAPTER
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sample_conversion.hpp"
+#include "interleave.hpp"
+#include "stream_params.hpp"
+#include "error_utility.hpp"
+#include "buffer_algorithm.hpp"
+
+#include <vector>
+#include <new>
+#include <cstdint>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    //scratch buffers owned by the library start each channel on a boundary of this many bytes
+    constexpr static std::size_t buffer_alignment = 64;
+
+    namespace detail
+    {
+        /*!
+         *\class aligned_channels
+         *\brief storage for one or more runs of samples, each starting on a buffer_alignment boundary
+         */
+        template<typename sample_t>
+        class aligned_channels
+        {
+        public:
+            aligned_channels() noexcept : _stride(0)
+            {}
+
+            //may throw std::bad_alloc
+            void allocate(std::size_t channels, std::size_t samples)
+            {
+                //a multiple of buffer_alignment samples is always a multiple of buffer_alignment bytes
+                _stride = (samples + buffer_alignment - 1) / buffer_alignment * buffer_alignment;
+                _storage.assign(channels * _stride + buffer_alignment,sample_t());
+                auto&& first = _storage.data();
+                while(reinterpret_cast<std::uintptr_t>(first) % buffer_alignment != 0)
+                {
+                    ++first;
+                }
+                _channels.resize(channels);
+                for(std::size_t c = 0; c < channels; ++c)
+                {
+                    _channels[c] = first + c * _stride;
+                }
+            }
+
+            void clear() noexcept
+            {
+                _storage.clear();
+                _channels.clear();
+                _stride = 0;
+            }
+
+            sample_t* const* channels() noexcept
+            {
+                return _channels.data();
+            }
+
+            const sample_t* const* channels() const noexcept
+            {
+                return _channels.data();
+            }
+
+            sample_t* operator[](std::size_t channel) noexcept
+            {
+                return _channels[channel];
+            }
+
+        private:
+            std::vector<sample_t> _storage;
+
+            std::vector<sample_t*> _channels;
+
+            std::size_t _stride;
+        };
+    }
+
+    /*!
+     *\class format_adapter
+     *\brief converts device buffers to and from the processing format and layout of a stream
+     *\note when the device format matches sample_t the device buffers are used directly
+     *\note planar device buffers are arrays of one pointer per channel, as portaudio passes them with paNonInterleaved
+     *\note a planar stream on interleaved device buffers is transposed through aligned scratch in both directions
+     *\note when params.device_input_frame_width() or device_output_frame_width() differ from the frame widths the channels go through map_channels
+     *\note that needs interleaved device buffers and a callback stream
+     */
+    template<typename sample_t>
+    class format_adapter
+    {
+    public:
+        format_adapter() noexcept : _converter{nullptr,nullptr},
+                                    _dither(nullptr),
+                                    _device_format(detail::type_to_format_id<sample_t>::value),
+                                    _layout(buffer_layout::interleaved),
+                                    _device_layout(buffer_layout::interleaved),
+                                    _frame_count(0),
+                                    _input_width(0),
+                                    _output_width(0),
+                                    _device_input_width(0),
+                                    _device_output_width(0)
+        {}
+
+        //select the conversion and allocate its buffers, not realtime safe
+        stream_error prepare(const stream_params<sample_t>& params, sample_format device) noexcept
+        {
+            return prepare(params,device,params.layout());
+        }
+
+        //device_layout is the layout of the buffers the backend exchanges, which may differ from params.layout()
+        stream_error prepare(const stream_params<sample_t>& params, sample_format device, buffer_layout device_layout) noexcept
+        {
+            _device_format = device;
+            _layout = params.layout();
+            _device_layout = params.layout() == buffer_layout::planar ? device_layout : buffer_layout::interleaved;
+            _frame_count = params.frame_count();
+            _input_width = params.input_frame_width();
+            _output_width = params.output_frame_width();
+            _device_input_width = params.device_input_frame_width();
+            _device_output_width = params.device_output_frame_width();
+            _converter = make_sample_converter<sample_t>(device);
+            if(active() && _converter.to_device == nullptr)
+            {
+                return make_stream_error(stream_status::system_error,"Unsupported device sample format.");
+            }
+            if(mapped() && (_device_layout == buffer_layout::planar || params.mode() == stream_mode::blocking))
+            {
+                return make_stream_error(stream_status::system_error,"Channel mapping needs interleaved device buffers and a callback stream.");
+            }
+            _dither = params.dither_mode() == dither_mode::tpdf ? &_dither_state : nullptr;
+            try
+            {
+                _input_channels.resize(_input_width);
+                _output_channels.resize(_output_width);
+                _device_input_channels.resize(_device_input_width);
+                _device_output_channels.resize(_device_output_width);
+                _input_staging.clear();
+                _output_staging.clear();
+                _input_mapping.clear();
+                _output_mapping.clear();
+                if(mapped() && active())
+                {
+                    _input_mapping.allocate(1,_frame_count * _device_input_width);
+                    _output_mapping.allocate(1,_frame_count * _device_output_width);
+                }
+                if(!_converts() && !transposed())
+                {
+                    _input.clear();
+                    _output.clear();
+                }
+                else if(_layout == buffer_layout::planar)
+                {
+                    _input.allocate(_input_width,_frame_count);
+                    _output.allocate(_output_width,_frame_count);
+                    if(_converts() && transposed())
+                    {
+                        _input_staging.allocate(1,params.input_sample_count());
+                        _output_staging.allocate(1,params.output_sample_count());
+                    }
+                }
+                else
+                {
+                    _input.allocate(1,params.input_sample_count());
+                    _output.allocate(1,params.output_sample_count());
+                }
+            }
+            catch(const std::bad_alloc&)
+            {
+                return make_stream_error(stream_status::system_error,"Unable to allocate conversion buffers.");
+            }
+            return no_error;
+        }
+
+        bool active() const noexcept
+        {
+            return _device_format != detail::type_to_format_id<sample_t>::value;
+        }
+
+        sample_format device_format() const noexcept
+        {
+            return _device_format;
+        }
+
+        buffer_layout layout() const noexcept
+        {
+            return _layout;
+        }
+
+        buffer_layout device_layout() const noexcept
+        {
+            return _device_layout;
+        }
+
+        //true when a planar stream runs on interleaved device buffers
+        bool transposed() const noexcept
+        {
+            return _layout != _device_layout;
+        }
+
+        //true when the device has a different number of channels than the callback
+        bool mapped() const noexcept
+        {
+            return _device_input_width != _input_width || _device_output_width != _output_width;
+        }
+
+        //the interleaved input buffer handed to the callback, frames is at most params.frame_count()
+        const sample_t* input(const void* device, std::size_t frames) noexcept
+        {
+            if(device == nullptr)
+            {
+                return nullptr;
+            }
+            return _interleaved_input(device,frames,_converts() ? _input[0] : nullptr);
+        }
+
+        //the interleaved output buffer handed to the callback
+        sample_t* output(void* device) noexcept
+        {
+            if(!_converts() || device == nullptr)
+            {
+                return static_cast<sample_t*>(device);
+            }
+            return _output[0];
+        }
+
+        //write the interleaved output of the callback to the device buffer
+        void commit_output(void* device, std::size_t frames) noexcept
+        {
+            if(_converts() && device != nullptr)
+            {
+                _interleaved_output(_output[0],device,frames);
+            }
+        }
+
+        //the planar input channels handed to the callback
+        //device is an array of channel pointers, or one interleaved buffer when transposed()
+        const sample_t* const* planar_input(const void* device, std::size_t frames) noexcept
+        {
+            if(device == nullptr)
+            {
+                return nullptr;
+            }
+            if(transposed())
+            {
+                auto&& interleaved = _interleaved_input(device,frames,_converts() ? _input_staging[0] : nullptr);
+                deinterleave(interleaved,_input.channels(),frames,_input_width);
+                return _input.channels();
+            }
+            auto&& channels = static_cast<const void* const*>(device);
+            for(std::size_t c = 0; c < _input_width; ++c)
+            {
+                if(active())
+                {
+                    _converter.from_device(channels[c],_input[c],frames);
+                    _input_channels[c] = _input[c];
+                }
+                else
+                {
+                    _input_channels[c] = static_cast<sample_t*>(const_cast<void*>(channels[c]));
+                }
+            }
+            return _input_channels.data();
+        }
+
+        //the planar output channels handed to the callback
+        sample_t* const* planar_output(void* device) noexcept
+        {
+            if(device == nullptr)
+            {
+                return nullptr;
+            }
+            if(active() || transposed())
+            {
+                return _output.channels();
+            }
+            auto&& channels = static_cast<void* const*>(device);
+            for(std::size_t c = 0; c < _output_width; ++c)
+            {
+                _output_channels[c] = static_cast<sample_t*>(channels[c]);
+            }
+            return _output_channels.data();
+        }
+
+        //write the planar output of the callback to the device buffers
+        void commit_planar_output(void* device, std::size_t frames) noexcept
+        {
+            if(device == nullptr)
+            {
+                return;
+            }
+            if(transposed())
+            {
+                const auto& planar = _output;
+                auto&& interleaved = _converts() ? _output_staging[0] : static_cast<sample_t*>(device);
+                interleave(planar.channels(),interleaved,frames,_output_width);
+                _interleaved_output(interleaved,device,frames);
+            }
+            else if(active())
+            {
+                auto&& channels = static_cast<void* const*>(device);
+                for(std::size_t c = 0; c < _output_width; ++c)
+                {
+                    _converter.to_device(_output[c],channels[c],frames,_dither);
+                }
+            }
+        }
+
+        //the device input buffers frame frames in, for splitting a host buffer larger than params.frame_count()
+        const void* device_input_at(const void* device, std::size_t frame) noexcept
+        {
+            if(device == nullptr || frame == 0)
+            {
+                return device;
+            }
+            if(_device_layout == buffer_layout::planar)
+            {
+                auto&& channels = static_cast<const void* const*>(device);
+                for(std::size_t c = 0; c < _device_input_width; ++c)
+                {
+                    _device_input_channels[c] = static_cast<const unsigned char*>(channels[c]) + frame * sample_size(_device_format);
+                }
+                return _device_input_channels.data();
+            }
+            return static_cast<const unsigned char*>(device) + frame * _device_input_width * sample_size(_device_format);
+        }
+
+        void* device_output_at(void* device, std::size_t frame) noexcept
+        {
+            if(device == nullptr || frame == 0)
+            {
+                return device;
+            }
+            if(_device_layout == buffer_layout::planar)
+            {
+                auto&& channels = static_cast<void* const*>(device);
+                for(std::size_t c = 0; c < _device_output_width; ++c)
+                {
+                    _device_output_channels[c] = static_cast<unsigned char*>(channels[c]) + frame * sample_size(_device_format);
+                }
+                return _device_output_channels.data();
+            }
+            return static_cast<unsigned char*>(device) + frame * _device_output_width * sample_size(_device_format);
+        }
+
+        //converts samples interleaved samples for a blocking write, any length
+        void to_device(const sample_t* in, void* device, std::size_t samples) noexcept
+        {
+            _converter.to_device(in,device,samples,_dither);
+        }
+
+        //converts samples interleaved samples for a blocking read, any length
+        void from_device(const void* device, sample_t* out, std::size_t samples) noexcept
+        {
+            _converter.from_device(device,out,samples);
+        }
+
+    private:
+        sample_converter<sample_t> _converter;
+
+        dither_state _dither_state;
+
+        dither_state* _dither;
+
+        sample_format _device_format;
+
+        buffer_layout _layout;
+
+        buffer_layout _device_layout;
+
+        std::size_t _frame_count;
+
+        std::size_t _input_width;
+
+        std::size_t _output_width;
+
+        std::size_t _device_input_width;
+
+        std::size_t _device_output_width;
+
+        //conversion scratch, a single run when interleaved or one run per channel when planar
+        detail::aligned_channels<sample_t> _input;
+
+        detail::aligned_channels<sample_t> _output;
+
+        //interleaved samples in sample_t between the device format and the transpose
+        detail::aligned_channels<sample_t> _input_staging;
+
+        detail::aligned_channels<sample_t> _output_staging;
+
+        //channel pointers handed to the callback
+        std::vector<sample_t*> _input_channels;
+
+        std::vector<sample_t*> _output_channels;
+
+        //offset device channel pointers handed back by device_input_at and device_output_at
+        std::vector<const void*> _device_input_channels;
+
+        std::vector<void*> _device_output_channels;
+
+        //interleaved samples in sample_t at the device width, between the device format and map_channels
+        detail::aligned_channels<sample_t> _input_mapping;
+
+        detail::aligned_channels<sample_t> _output_mapping;
+
+        //the callback cannot work on the device buffers in place
+        bool _converts() const noexcept
+        {
+            return active() || mapped();
+        }
+
+        //interleaved device input as interleaved frames of the stream width, written to scratch unless the device buffer is used as it is
+        const sample_t* _interleaved_input(const void* device, std::size_t frames, sample_t* scratch) noexcept
+        {
+            if(_device_input_width != _input_width)
+            {
+                auto&& source = static_cast<const sample_t*>(device);
+                if(active())
+                {
+                    _converter.from_device(device,_input_mapping[0],frames * _device_input_width);
+                    source = _input_mapping[0];
+                }
+                map_channels(source,_device_input_width,scratch,_input_width,frames);
+                return scratch;
+            }
+            if(active())
+            {
+                _converter.from_device(device,scratch,frames * _input_width);
+                return scratch;
+            }
+            return static_cast<const sample_t*>(device);
+        }
+
+        //writes interleaved frames of the stream width to the interleaved device buffer
+        void _interleaved_output(const sample_t* rendered, void* device, std::size_t frames) noexcept
+        {
+            if(_device_output_width != _output_width)
+            {
+                auto&& target = active() ? _output_mapping[0] : static_cast<sample_t*>(device);
+                map_channels(rendered,_output_width,target,_device_output_width,frames);
+                if(active())
+                {
+                    _converter.to_device(target,device,frames * _device_output_width,_dither);
+                }
+            }
+            else if(active())
+            {
+                _converter.to_device(rendered,device,frames * _output_width,_dither);
+            }
+            else if(rendered != device)
+            {
+                //only the input channels are mapped, the output was rendered to scratch all the same
+                copy_samples(rendered,static_cast<sample_t*>(device),frames * _output_width);
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef ZAUDIO_INTERLEAVE
+#define ZAUDIO_INTERLEAVE
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "buffer_view.hpp"
+#include "planar_view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*
+     * Interleave and deinterleave kernels
+     * 32 and 64 bit samples use sse/avx shuffles with dedicated paths for 1, 2 and 6 channels
+     * every other channel count is transposed in 4x4 (32 bit) or 2x2 (64 bit) tiles, cache blocked over frames
+     * other sample types use a scalar loop
+     * the interleaved and planar buffers must not overlap
+     */
+
+    /*!
+     *\fn deinterleave
+     *\brief copies frames interleaved frames of channels samples from in to one buffer per channel in out
+     */
+    ZAUDIO_EXPORT void deinterleave(const float* in, float* const* out, std::size_t frames, std::size_t channels) noexcept;
+    ZAUDIO_EXPORT void deinterleave(const double* in, double* const* out, std::size_t frames, std::size_t channels) noexcept;
+    ZAUDIO_EXPORT void deinterleave(const std::int32_t* in, std::int32_t* const* out, std::size_t frames, std::size_t channels) noexcept;
+    ZAUDIO_EXPORT void deinterleave(const std::int64_t* in, std::int64_t* const* out, std::size_t frames, std::size_t channels) noexcept;
+
+    /*!
+     *\fn interleave
+     *\brief copies frames samples from each of channels buffers in in to interleaved frames in out
+     */
+    ZAUDIO_EXPORT void interleave(const float* const* in, float* out, std::size_t frames, std::size_t channels) noexcept;
+    ZAUDIO_EXPORT void interleave(const double* const* in, double* out, std::size_t frames, std::size_t channels) noexcept;
+    ZAUDIO_EXPORT void interleave(const std::int32_t* const* in, std::int32_t* out, std::size_t frames, std::size_t channels) noexcept;
+    ZAUDIO_EXPORT void interleave(const std::int64_t* const* in, std::int64_t* out, std::size_t frames, std::size_t channels) noexcept;
+
+    /*!
+     *\fn deinterleave
+     *\brief scalar deinterleave for the sample types without a dedicated kernel
+     */
+    template<typename sample_t>
+    void deinterleave(const sample_t* in, sample_t* const* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        for(std::size_t c = 0; c < channels; ++c)
+        {
+            auto&& dst = out[c];
+            for(std::size_t f = 0; f < frames; ++f)
+            {
+                dst[f] = in[f * channels + c];
+            }
+        }
+    }
+
+    /*!
+     *\fn interleave
+     *\brief scalar interleave for the sample types without a dedicated kernel
+     */
+    template<typename sample_t>
+    void interleave(const sample_t* const* in, sample_t* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        for(std::size_t c = 0; c < channels; ++c)
+        {
+            auto&& src = in[c];
+            for(std::size_t f = 0; f < frames; ++f)
+            {
+                out[f * channels + c] = src[f];
+            }
+        }
+    }
+
+    /*!
+     *\fn deinterleave
+     *\brief transposes an interleaved buffer_view into caller provided planar buffers
+     *\note out must have at least in.frame_count() frames and in.frame_width() channels
+     */
+    template<typename sample_t>
+    void deinterleave(buffer_view<sample_t> in, planar_view<sample_t> out) noexcept
+    {
+        deinterleave(in.data(),out.data(),in.frame_count(),in.frame_width());
+    }
+
+    /*!
+     *\fn interleave
+     *\brief transposes planar buffers into an interleaved buffer_view
+     *\note out must have at least in.frame_count() frames and in.channel_count() channels
+     */
+    template<typename sample_t>
+    void interleave(planar_view<sample_t> in, buffer_view<sample_t> out) noexcept
+    {
+        interleave(in.data(),out.data(),in.frame_count(),in.channel_count());
+    }
+}
+
+#endif
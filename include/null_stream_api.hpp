@@ -0,0 +1,482 @@
+#ifndef null_stream_api_hpp
+#define null_stream_api_hpp
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_api.hpp"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <system_error>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace zaudio
+{
+    /*!
+     *\enum null_stream_clock
+     *\brief selects how a null_stream_api paces its callbacks
+     */
+    enum class null_stream_clock
+    {
+        //one buffer per buffer period, as a device would
+        paced,
+        //the next buffer starts as soon as the previous one returns
+        free_running
+    };
+
+    /*!
+     *\fn default_null_devices
+     *\brief the fake devices reported by a null_stream_api when none are provided
+     */
+    inline std::vector<device_info> default_null_devices()
+    {
+        return {make_device_info("Null Device",0,32,32,48000.0,duration(0),duration(0),duration(0),duration(0))};
+    }
+
+    /*!
+     *\class null_stream_api
+     *\brief a stream_api that needs no audio hardware
+     *\note callbacks are driven from an internal thread, input buffers are silent and output is discarded
+     *\note the device buffers are interleaved in params.device_format(), so conversions and transposes cost the same as they would with a device
+     *\note blocking streams have no thread, a paced one makes write and read wait on a device clock that holds one buffer
+     *\note a paced stream that falls more than a buffer behind reports an output underflow and input overflow, as a device would
+     *\note with params.variable_frame_count() every buffer has a pseudo random size of up to frame_count frames, as some hosts deliver
+     *\note a callback stream simulates params.input_latency() and output_latency() of buffering, never less than one buffer, blocking streams always hold one buffer
+     *\note every stream made from one context runs its own device thread on the same clock and devices
+     */
+    template<typename sample_t>
+    class null_stream_api : public stream_api<sample_t>
+    {
+        using base = stream_api<sample_t>;
+        using audio_clock = typename base::audio_clock;
+    public:
+        explicit null_stream_api(null_stream_clock clock = null_stream_clock::paced,
+                                 std::vector<device_info> devices = default_null_devices()) : _devices(std::move(devices)),
+                                                                                              _clock(clock),
+                                                                                              _running(false),
+                                                                                              _open(false),
+                                                                                              _cpu_load(0.0),
+                                                                                              _written(0),
+                                                                                              _read_position(0)
+        {}
+        virtual ~null_stream_api()
+        {
+            close_stream();
+        }
+        using base::id;
+        virtual std::string name() const noexcept
+        {
+            return "LibZaudio: Null Stream API";
+        }
+        virtual std::string info() const noexcept
+        {
+            return "Headless stream api driven by an internal clock";
+        }
+        virtual stream_error start() noexcept
+        {
+            if(!_open)
+            {
+                return make_stream_error(stream_status::system_error,"No stream is open.");
+            }
+            _join();
+            _prepare_start();
+            _running.store(true);
+            if(_params->mode() == stream_mode::blocking)
+            {
+                //no thread, the device clock starts now and write and read wait on it
+                _started = audio_clock::now();
+                _written = 0;
+                _read_position = 0;
+                return no_error;
+            }
+            try
+            {
+                _thread = std::thread(&null_stream_api<sample_t>::_run,this);
+            }
+            catch(const std::system_error&)
+            {
+                _running.store(false);
+                return make_stream_error(stream_status::system_error,"Unable to start the null stream thread.");
+            }
+            return no_error;
+        }
+        virtual stream_error pause() noexcept
+        {
+            return stop();
+        }
+        virtual stream_error stop() noexcept
+        {
+            _running.store(false);
+            _join();
+            return no_error;
+        }
+        virtual stream_error playback_state() noexcept
+        {
+            return _running.load() ? running : stopped;
+        }
+        virtual std::string get_error_string(const stream_error& err) noexcept
+        {
+            return err.second;
+        }
+        virtual stream_error open_stream(const stream_params<sample_t>& params) noexcept
+        {
+            auto&& compat = is_configuration_supported(params);
+            if(compat == no_error)
+            {
+                stop();
+                //like most hardware the device buffers are interleaved, planar streams are transposed by _format
+                compat = _format.prepare(params,params.device_format(),buffer_layout::interleaved);
+                if(compat != no_error)
+                {
+                    return compat;
+                }
+                _params = &const_cast<stream_params<sample_t>&>(params);
+                compat = _prepare_blocking();
+                if(compat == no_error)
+                {
+                    compat = _rates.prepare(params);
+                }
+                if(compat == no_error)
+                {
+                    compat = _blocks.prepare(params);
+                }
+                if(compat != no_error)
+                {
+                    return compat;
+                }
+                auto&& size = sample_size(params.device_format());
+                try
+                {
+                    //unsigned 8 bit silence is the midpoint
+                    _input.assign(params.frame_count() * params.device_input_frame_width() * size,params.device_format() == sample_format::u8 ? 0x80 : 0);
+                    _output.assign(params.frame_count() * params.device_output_frame_width() * size,0);
+                }
+                catch(const std::bad_alloc&)
+                {
+                    return make_stream_error(stream_status::system_error,"Unable to allocate stream buffers.");
+                }
+                auto&& in = get_device_info(params.input_device_id() < 0 ? default_input_device_id() : params.input_device_id());
+                auto&& out = get_device_info(params.output_device_id() < 0 ? default_output_device_id() : params.output_device_id());
+                const duration buffer{params.frame_count() / params.device_sample_rate()};
+                const bool blocking = params.mode() == stream_mode::blocking;
+                _info = zaudio::stream_info();
+                _info.input_latency = blocking ? buffer : std::max(buffer,params.input_latency().resolve(in.default_low_input_latency,in.default_high_input_latency));
+                _info.output_latency = blocking ? buffer : std::max(buffer,params.output_latency().resolve(out.default_low_ouput_latency,out.default_high_output_latency));
+                _info.sample_rate = params.device_sample_rate();
+                _open = true;
+            }
+            return compat;
+        }
+        virtual stream_error close_stream() noexcept
+        {
+            stop();
+            _open = false;
+            _info = zaudio::stream_info();
+            return no_error;
+        }
+        virtual long get_device_count() noexcept
+        {
+            return static_cast<long>(_devices.size());
+        }
+        virtual device_info get_device_info(long id) noexcept
+        {
+            if(id >= 0 && id < get_device_count())
+            {
+                return _devices[id];
+            }
+            return device_info();
+        }
+        virtual stream_error is_configuration_supported(const stream_params<sample_t>& params) noexcept
+        {
+            if(params.sample_rate() <= 0 || params.device_sample_rate() <= 0 || params.frame_count() == 0)
+            {
+                return make_stream_error(stream_status::system_error,"Invalid sample rate or frame count.");
+            }
+            if(sample_size(params.device_format()) == 0)
+            {
+                return make_stream_error(stream_status::system_error,"Invalid device sample format.");
+            }
+            if(params.input_latency().time() < duration(0) || params.output_latency().time() < duration(0))
+            {
+                return make_stream_error(stream_status::system_error,"Invalid latency target.");
+            }
+            auto&& in = get_device_info(params.input_device_id() < 0 ? default_input_device_id() : params.input_device_id());
+            auto&& out = get_device_info(params.output_device_id() < 0 ? default_output_device_id() : params.output_device_id());
+            if(params.device_input_frame_width() > in.max_input_count || params.device_output_frame_width() > out.max_output_count)
+            {
+                return make_stream_error(stream_status::system_error,"Invalid number of channels.");
+            }
+            return no_error;
+        }
+        virtual long default_input_device_id() const noexcept
+        {
+            return _devices.empty() ? -1 : 0;
+        }
+        virtual long default_output_device_id() const noexcept
+        {
+            return _devices.empty() ? -1 : 0;
+        }
+        //measured time spent in the callback as a fraction of the buffer period, smoothed over recent buffers
+        virtual double cpu_load() const noexcept
+        {
+            return _cpu_load.load(std::memory_order_relaxed);
+        }
+
+        //a paced device holds one buffer of output, a free running one always has room and data
+        virtual long write_available() noexcept
+        {
+            if(!_running.load() || _params->mode() != stream_mode::blocking)
+            {
+                return -1;
+            }
+            if(_clock == null_stream_clock::free_running)
+            {
+                return static_cast<long>(_params->frame_count());
+            }
+            auto&& played = _device_frames();
+            auto&& queued = _written > played ? _written - played : 0;
+            return queued >= _params->frame_count() ? 0 : static_cast<long>(_params->frame_count() - queued);
+        }
+        virtual long read_available() noexcept
+        {
+            if(!_running.load() || _params->mode() != stream_mode::blocking)
+            {
+                return -1;
+            }
+            if(_clock == null_stream_clock::free_running)
+            {
+                return static_cast<long>(_params->frame_count());
+            }
+            auto&& captured = _device_frames();
+            auto&& ready = captured > _read_position ? captured - _read_position : 0;
+            return static_cast<long>(std::min(ready,_params->frame_count()));
+        }
+
+        null_stream_clock clock() const noexcept
+        {
+            return _clock;
+        }
+        //takes effect the next time the stream is started
+        void clock(null_stream_clock c) noexcept
+        {
+            _clock = c;
+        }
+
+    private:
+        using base::_params;
+
+        using base::_on_process_device;
+
+        using base::_format;
+
+        using base::_prepare_start;
+
+        using base::_callback_timing;
+
+        using base::_prepare_blocking;
+
+        using base::_rates;
+
+        using base::_blocks;
+
+        using base::_info;
+
+        std::vector<device_info> _devices;
+
+        null_stream_clock _clock;
+
+        //device buffers in params.device_format()
+        std::vector<unsigned char> _input;
+
+        std::vector<unsigned char> _output;
+
+        std::thread _thread;
+
+        std::atomic<bool> _running;
+
+        bool _open;
+
+        std::atomic<double> _cpu_load;
+
+        //the device clock of a blocking stream, _written belongs to the writing thread and _read_position to the reading one
+        typename audio_clock::time_point _started;
+
+        std::size_t _written;
+
+        std::size_t _read_position;
+
+        virtual std::unique_ptr<stream_api<sample_t>> _make_stream() noexcept
+        {
+            try
+            {
+                return std::unique_ptr<stream_api<sample_t>>(new null_stream_api<sample_t>(_clock,_devices));
+            }
+            catch(const std::bad_alloc&)
+            {
+                return nullptr;
+            }
+        }
+
+        //frames the device has played or captured since start
+        std::size_t _device_frames() const noexcept
+        {
+            return static_cast<std::size_t>(std::chrono::duration<double>(audio_clock::now() - _started).count() * _params->device_sample_rate());
+        }
+
+        void _wait_for_device_frame(std::size_t frame) const noexcept
+        {
+            auto&& due = _started + std::chrono::duration_cast<typename audio_clock::duration>(duration(frame / _params->device_sample_rate()));
+            auto&& now = audio_clock::now();
+            if(due > now)
+            {
+                thread_sleep(due - now);
+            }
+        }
+
+        virtual stream_error _write_device(const void*, std::size_t frames) noexcept
+        {
+            if(!_running.load())
+            {
+                return make_stream_error(stream_status::system_error,"The stream is not running.");
+            }
+            if(_clock == null_stream_clock::paced)
+            {
+                auto&& played = _device_frames();
+                if(_written < played)
+                {
+                    //the device ran dry and played silence, like hardware it does not wait for the late frames
+                    _written = played;
+                }
+                //the device holds one buffer, wait until everything beyond that has been played
+                if(_written + frames > played + _params->frame_count())
+                {
+                    _wait_for_device_frame(_written + frames - _params->frame_count());
+                }
+            }
+            _written += frames;
+            return no_error;
+        }
+
+        virtual stream_error _read_device(void* buffer, std::size_t frames) noexcept
+        {
+            if(!_running.load())
+            {
+                return make_stream_error(stream_status::system_error,"The stream is not running.");
+            }
+            if(_clock == null_stream_clock::paced)
+            {
+                auto&& captured = _device_frames();
+                if(captured > _read_position + _params->frame_count())
+                {
+                    //the device only holds one buffer, older input was overwritten
+                    _read_position = captured - _params->frame_count();
+                }
+                if(_read_position + frames > captured)
+                {
+                    _wait_for_device_frame(_read_position + frames);
+                }
+            }
+            _read_position += frames;
+            auto&& bytes = frames * _params->input_frame_width() * sample_size(_format.device_format());
+            std::memset(buffer,_params->device_format() == sample_format::u8 ? 0x80 : 0,bytes);
+            return no_error;
+        }
+
+        void _join() noexcept
+        {
+            if(_thread.joinable() && _thread.get_id() != std::this_thread::get_id())
+            {
+                _thread.join();
+            }
+        }
+
+        void _run() noexcept
+        {
+            const bool paced = _clock == null_stream_clock::paced;
+            const bool variable = _params->variable_frame_count();
+            auto&& input_latency = std::chrono::duration_cast<typename audio_clock::duration>(_info.input_latency);
+            auto&& output_latency = std::chrono::duration_cast<typename audio_clock::duration>(_info.output_latency);
+            auto&& next = audio_clock::now();
+            double load = 0.0;
+            //xorshift32, the same sequence of buffer sizes on every run
+            std::uint32_t state = 0x9e3779b9u;
+            //raised on the buffer after a missed deadline
+            xrun_flags xruns = xrun_flags::none;
+
+            while(_running.load(std::memory_order_acquire))
+            {
+                std::size_t frames = _params->frame_count();
+                if(variable)
+                {
+                    state ^= state << 13;
+                    state ^= state >> 17;
+                    state ^= state << 5;
+                    frames = 1 + state % _params->frame_count();
+                }
+                const duration period{frames / _params->device_sample_rate()};
+                auto&& timing = _callback_timing(frames);
+                if(paced)
+                {
+                    //the simulated device clock, next is exactly the position of this buffer
+                    //like a device with that much buffering each way, the input was captured that long ago and the output plays that much later
+                    timing.input_time = next - input_latency;
+                    timing.output_time = next + output_latency;
+                    timing.device_time = true;
+                }
+                auto&& begin = audio_clock::now();
+                auto&& ret = _on_process_device(_input.data(),_output.data(),frames,timing,xruns);
+                xruns = xrun_flags::none;
+                auto&& elapsed = std::chrono::duration_cast<duration>(audio_clock::now() - begin);
+
+                //same smoothing as a one pole lowpass, so a single slow buffer shows up without dominating
+                load += 0.1 * ((elapsed / period) - load);
+                _cpu_load.store(load,std::memory_order_relaxed);
+
+                if(ret != no_error)
+                {
+                    //mirror a device api aborting the stream
+                    _running.store(false);
+                    break;
+                }
+                if(paced)
+                {
+                    next += std::chrono::duration_cast<typename audio_clock::duration>(period);
+                    auto&& now = audio_clock::now();
+                    if(next > now)
+                    {
+                        thread_sleep(next - now);
+                    }
+                    else if(now - next > period)
+                    {
+                        //we fell more than a buffer behind, drop the missed deadlines instead of bursting
+                        //a device would have played silence and lost the input it captured meanwhile
+                        next = now;
+                        xruns = (_params->output_frame_width() != 0 ? xrun_flags::output_underflow : xrun_flags::none) |
+                                (_params->input_frame_width() != 0 ? xrun_flags::input_overflow : xrun_flags::none);
+                    }
+                }
+            }
+        }
+    };
+}
+
+#endif
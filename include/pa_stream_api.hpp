@@ -21,47 +21,62 @@ This file is part of zaudio.
 #include "stream_api.hpp"
 #include <portaudio.h>
 #include <tuple>
+#include <memory>
+#include <new>
 
 namespace zaudio
 {
     namespace internal
     {
-        template<typename sample_t>
-        constexpr PaSampleFormat _type_to_pa_sample_format() noexcept
+        //portaudio has no 64 bit formats, those streams are converted to the nearest format it has
+        constexpr sample_format _pa_device_format(sample_format format) noexcept
         {
-            return -1;
+            return format == sample_format::f64 ? sample_format::f32 :
+                  (format == sample_format::i64 ? sample_format::i32 : format);
         }
 
-        template<>
-        constexpr PaSampleFormat _type_to_pa_sample_format<sample<sample_format::f32>>() noexcept
+        constexpr PaSampleFormat _format_to_pa_sample_format(sample_format format) noexcept
         {
-            return paFloat32;
+            //REPLACE WITH SWITCH IN C++14
+            return format == sample_format::f32 ? paFloat32 :
+                  (format == sample_format::i8  ? paInt8    :
+                  (format == sample_format::u8  ? paUInt8   :
+                  (format == sample_format::i16 ? paInt16   :
+                  (format == sample_format::i24 ? paInt24   :
+                  (format == sample_format::i32 ? paInt32   :
+                  /*Error Case*/paCustomFormat)))));
         }
-        template<>
-        constexpr PaSampleFormat _type_to_pa_sample_format<sample<sample_format::i8>>() noexcept
-        {
-            return paInt8;
-        }
-        template<>
-        constexpr PaSampleFormat _type_to_pa_sample_format<sample<sample_format::u8>>() noexcept
-        {
-            return paUInt8;
-        }
-        template<>
-        constexpr PaSampleFormat _type_to_pa_sample_format<sample<sample_format::i16>>() noexcept
-        {
-            return paInt16;
-        }
-        template<>
-        constexpr PaSampleFormat _type_to_pa_sample_format<sample<sample_format::i24>>() noexcept
-        {
-            return paInt24;
-        }
-        template<>
-        constexpr PaSampleFormat _type_to_pa_sample_format<sample<sample_format::i32>>() noexcept
+
+        /*!
+         *\class pa_library
+         *\brief one Pa_Initialize and its matching Pa_Terminate, shared by every pa_stream_api made from the same context
+         */
+        class pa_library
         {
-            return paInt32;
-        }
+        public:
+            pa_library() noexcept : _status(Pa_Initialize())
+            {}
+
+            ~pa_library()
+            {
+                if(_status == paNoError)
+                {
+                    Pa_Terminate();
+                }
+            }
+
+            pa_library(const pa_library&) = delete;
+
+            pa_library& operator=(const pa_library&) = delete;
+
+            PaError status() const noexcept
+            {
+                return _status;
+            }
+
+        private:
+            PaError _status;
+        };
     }
     template<typename sample_t>
     class pa_stream_api : public stream_api<sample_t>
@@ -69,19 +84,18 @@ namespace zaudio
         using base = stream_api<sample_t>;
         using audio_clock = typename base::audio_clock;
     public:
-        static_assert(internal::_type_to_pa_sample_format<sample_t>() != -1, "Requested Sample Format Not Supported By PortAudio API");
-        pa_stream_api()
-        {
-            if(_pa_invoke(Pa_Initialize) == no_error)
-            {
-                //TODO: implement me
-            }
-        }
+        pa_stream_api() : pa_stream_api(std::make_shared<internal::pa_library>())
+        {}
+        //another stream on an already initialized portaudio
+        explicit pa_stream_api(std::shared_ptr<internal::pa_library> library) noexcept : _library(std::move(library)),
+                                                                                       stream(nullptr)
+        {}
         virtual ~pa_stream_api()
         {
-            if(_pa_invoke(Pa_Terminate) == no_error)
+            //portaudio is terminated with the last stream that shares it
+            if(stream != nullptr)
             {
-                //TODO: implement me
+                Pa_CloseStream(stream);
             }
         }
         using base::id;
@@ -95,15 +109,16 @@ namespace zaudio
         }
         virtual stream_error start() noexcept
         {
+            _prepare_start();
             return _pa_invoke(Pa_StartStream,stream);
         }
         virtual stream_error pause() noexcept
         {
-            return _pa_invoke(Pa_StopStream,stream);
+            return stream == nullptr ? no_error : _pa_invoke(Pa_StopStream,stream);
         }
         virtual stream_error stop() noexcept
         {
-            return _pa_invoke(Pa_StopStream,stream);
+            return stream == nullptr ? no_error : _pa_invoke(Pa_StopStream,stream);
         }
         virtual stream_error playback_state() noexcept
         {
@@ -127,37 +142,77 @@ namespace zaudio
         }
         virtual stream_error open_stream(const stream_params<sample_t>& params) noexcept
         {
+            if(_library->status() != paNoError)
+            {
+                return make_stream_error(stream_status::system_error,Pa_GetErrorText(_library->status()));
+            }
             auto&& compat = is_configuration_supported(params);
 
+            if(compat == no_error)
+            {
+                compat = _format.prepare(params,internal::_pa_device_format(params.device_format()),_pa_device_layout(params));
+            }
             if(compat == no_error)
             {
                 _params = &const_cast<stream_params<sample_t>&>(params);
+                compat = _prepare_blocking();
+            }
+            if(compat == no_error)
+            {
+                compat = _rates.prepare(params);
+            }
+            if(compat == no_error)
+            {
+                compat = _blocks.prepare(params);
+            }
+            if(compat == no_error)
+            {
                 double srate=0;
                 std::tie(_inparams,_outparams,srate) = _native_params_to_pa(params);
 
-                const PaStreamParameters* ip = params.input_frame_width() == 0 ? nullptr: &_inparams;
-                const PaStreamParameters* op = params.output_frame_width() == 0 ? nullptr: &_outparams;
-
-                return _pa_invoke(Pa_OpenStream,&stream,
-                                  ip,
-                                  op,
-                                  srate,
-                                  params.frame_count(),
-                                  paNoFlag,
-                                  &_pa_stream_api_callback,
-                                  (void*)this);
+                const PaStreamParameters* ip = params.device_input_frame_width() == 0 ? nullptr: &_inparams;
+                const PaStreamParameters* op = params.device_output_frame_width() == 0 ? nullptr: &_outparams;
+
+                //without a callback portaudio opens the stream for Pa_WriteStream and Pa_ReadStream
+                const bool blocking = params.mode() == stream_mode::blocking;
+                auto&& err = _pa_invoke(Pa_OpenStream,&stream,
+                                        ip,
+                                        op,
+                                        srate,
+                                        params.variable_frame_count() ? paFramesPerBufferUnspecified : params.frame_count(),
+                                        paNoFlag,
+                                        blocking ? nullptr : &_pa_stream_api_callback,
+                                        blocking ? nullptr : (void*)this);
+                if(err == no_error)
+                {
+                    //the suggested latencies were only a request, the host api rounds them to what the device can do
+                    const PaStreamInfo* info = Pa_GetStreamInfo(stream);
+                    _info = zaudio::stream_info();
+                    if(info != nullptr)
+                    {
+                        _info.input_latency = duration(info->inputLatency);
+                        _info.output_latency = duration(info->outputLatency);
+                        _info.sample_rate = info->sampleRate;
+                    }
+                }
+                return err;
             }
             else
             {
-                //TODO:
-                //maybe we should try to negotiate a compatible format instead of erroring out?
-                //would depend on if we knew what was wrong
+                //stream_api::open_negotiated searches for a configuration that works instead
                 return compat;
             }
         }
         virtual stream_error close_stream() noexcept
         {
-            return _pa_invoke(Pa_CloseStream,stream);
+            _info = zaudio::stream_info();
+            if(stream == nullptr)
+            {
+                return no_error;
+            }
+            auto&& err = _pa_invoke(Pa_CloseStream,stream);
+            stream = nullptr;
+            return err;
         }
         virtual long get_device_count() noexcept
         {
@@ -165,11 +220,16 @@ namespace zaudio
         }
         virtual device_info get_device_info(long id) noexcept
         {
+            //paNoDevice and ids past the device count have no info
             const PaDeviceInfo* info = Pa_GetDeviceInfo(id);
-            return device_info(_pa_device_info_to_native(info));
+            return info == nullptr ? device_info() : _pa_device_info_to_native(info);
         }
         virtual stream_error is_configuration_supported(const stream_params<sample_t>& params) noexcept
         {
+            if(params.input_latency().time() < duration(0) || params.output_latency().time() < duration(0))
+            {
+                return make_stream_error(stream_status::system_error,"Invalid latency target.");
+            }
             PaStreamParameters inparams;
             PaStreamParameters outparams;
             double srate=0;
@@ -203,13 +263,37 @@ namespace zaudio
         {
             return Pa_GetStreamCpuLoad(stream);
         }
+        virtual long write_available() noexcept
+        {
+            return Pa_GetStreamWriteAvailable(stream);
+        }
+        virtual long read_available() noexcept
+        {
+            return Pa_GetStreamReadAvailable(stream);
+        }
 
     private:
         using base::_params;
 
-        using base::_on_process;
+        using base::_on_process_device;
+
+        using base::_format;
+
+        using base::_report_error;
+
+        using base::_prepare_start;
+
+        using base::_callback_timing;
+
+        using base::_prepare_blocking;
 
-        using base::_error_callback;
+        using base::_rates;
+
+        using base::_blocks;
+
+        using base::_info;
+
+        std::shared_ptr<internal::pa_library> _library;
 
         PaStream* stream;
 
@@ -217,16 +301,44 @@ namespace zaudio
 
         PaStreamParameters _outparams;
 
+        static xrun_flags _pa_flags_to_xrun_flags(PaStreamCallbackFlags flags) noexcept
+        {
+            xrun_flags xruns = xrun_flags::none;
+            xruns = (flags & paInputUnderflow) ? xruns | xrun_flags::input_underflow : xruns;
+            xruns = (flags & paInputOverflow) ? xruns | xrun_flags::input_overflow : xruns;
+            xruns = (flags & paOutputUnderflow) ? xruns | xrun_flags::output_underflow : xruns;
+            xruns = (flags & paOutputOverflow) ? xruns | xrun_flags::output_overflow : xruns;
+            xruns = (flags & paPrimingOutput) ? xruns | xrun_flags::priming_output : xruns;
+            return xruns;
+        }
+
         static int _pa_stream_api_callback( const void *input,void *output,unsigned long frameCount,const PaStreamCallbackTimeInfo* timeInfo,PaStreamCallbackFlags statusFlags,void *userData )
         {
 
             pa_stream_api<sample_t> * api = (pa_stream_api<sample_t>*)userData;
 
-            //cast buffers
-            const sample_t* in = static_cast<const sample_t*>(input);
-            sample_t* out = static_cast<sample_t*>(output);
+            //portaudio times are seconds on the stream clock, currentTime is our now
+            auto&& timing = api->_callback_timing(frameCount);
+            if(timeInfo != nullptr && (timeInfo->inputBufferAdcTime != 0 || timeInfo->outputBufferDacTime != 0))
+            {
+                auto&& to_audio_clock = [&](PaTime t)
+                {
+                    return timing.callback_time + std::chrono::duration_cast<typename audio_clock::duration>(duration(t - timeInfo->currentTime));
+                };
+                if(timeInfo->inputBufferAdcTime != 0)
+                {
+                    timing.input_time = to_audio_clock(timeInfo->inputBufferAdcTime);
+                }
+                if(timeInfo->outputBufferDacTime != 0)
+                {
+                    timing.output_time = to_audio_clock(timeInfo->outputBufferDacTime);
+                }
+                timing.device_time = true;
+            }
 
-            auto&& ret = api->_on_process(in,out);
+            //buffers are in the device format, _on_process_device converts them when needed
+            //frameCount only differs from params.frame_count() when the stream was opened with paFramesPerBufferUnspecified
+            auto&& ret = api->_on_process_device(input,output,frameCount,timing,_pa_flags_to_xrun_flags(statusFlags));
             if(ret != no_error)
             {
                 return paAbort;
@@ -234,6 +346,39 @@ namespace zaudio
             else return paContinue;
         }
 
+        //an underflow or overflow still transferred the frames, it is not worth failing the call over
+        virtual stream_error _write_device(const void* buffer, std::size_t frames) noexcept
+        {
+            auto&& err = Pa_WriteStream(stream,buffer,static_cast<unsigned long>(frames));
+            if(err != paNoError && err != paOutputUnderflowed)
+            {
+                return make_stream_error(stream_status::system_error,Pa_GetErrorText(err));
+            }
+            return no_error;
+        }
+
+        virtual stream_error _read_device(void* buffer, std::size_t frames) noexcept
+        {
+            auto&& err = Pa_ReadStream(stream,buffer,static_cast<unsigned long>(frames));
+            if(err != paNoError && err != paInputOverflowed)
+            {
+                return make_stream_error(stream_status::system_error,Pa_GetErrorText(err));
+            }
+            return no_error;
+        }
+
+        virtual std::unique_ptr<stream_api<sample_t>> _make_stream() noexcept
+        {
+            return std::unique_ptr<stream_api<sample_t>>(new (std::nothrow) pa_stream_api<sample_t>(_library));
+        }
+
+        //blocking streams always exchange interleaved buffers, so do streams whose channels are mapped
+        static buffer_layout _pa_device_layout(const stream_params<sample_t>& params) noexcept
+        {
+            const bool mapped = params.device_input_frame_width() != params.input_frame_width() || params.device_output_frame_width() != params.output_frame_width();
+            return params.mode() == stream_mode::blocking || mapped ? buffer_layout::interleaved : params.layout();
+        }
+
         //attempt to invoke a pa function, on failure call user error callback;
         template<typename F, typename...args_t>
         stream_error _pa_invoke(F f,args_t&&... args)
@@ -242,7 +387,7 @@ namespace zaudio
             if(err != paNoError)
             {
                 stream_error serr = make_stream_error(stream_status::system_error,Pa_GetErrorText(err));
-                (*_error_callback)(serr);
+                _report_error(serr);
                 return serr;
             }
             return no_error;
@@ -264,13 +409,18 @@ namespace zaudio
         {
             PaStreamParameters inparams;
             PaStreamParameters outparams;
-            double srate=params.sample_rate();
+            double srate=params.device_sample_rate();
 
-            inparams.channelCount = params.input_frame_width();
-            outparams.channelCount = params.output_frame_width();
+            inparams.channelCount = params.device_input_frame_width();
+            outparams.channelCount = params.device_output_frame_width();
 
-            inparams.sampleFormat = internal::_type_to_pa_sample_format<sample_t>();
-            outparams.sampleFormat = internal::_type_to_pa_sample_format<sample_t>();
+            inparams.sampleFormat = internal::_format_to_pa_sample_format(internal::_pa_device_format(params.device_format()));
+            if(_pa_device_layout(params) == buffer_layout::planar)
+            {
+                //portaudio then passes one buffer pointer per channel
+                inparams.sampleFormat |= paNonInterleaved;
+            }
+            outparams.sampleFormat = inparams.sampleFormat;
 
             inparams.hostApiSpecificStreamInfo=nullptr;
             outparams.hostApiSpecificStreamInfo=nullptr;
@@ -293,8 +443,11 @@ namespace zaudio
                 outparams.device = params.output_device_id();
             }
 
-            inparams.suggestedLatency = Pa_GetDeviceInfo(inparams.device)->defaultLowInputLatency;
-            outparams.suggestedLatency = Pa_GetDeviceInfo(outparams.device)->defaultLowOutputLatency;
+            //portaudio raises anything below the device minimum to the minimum, so lowest asks for 0
+            auto&& indevice = Pa_GetDeviceInfo(inparams.device);
+            auto&& outdevice = Pa_GetDeviceInfo(outparams.device);
+            inparams.suggestedLatency = indevice == nullptr ? 0 : params.input_latency().resolve(duration(indevice->defaultLowInputLatency),duration(indevice->defaultHighInputLatency)).count();
+            outparams.suggestedLatency = outdevice == nullptr ? 0 : params.output_latency().resolve(duration(outdevice->defaultLowOutputLatency),duration(outdevice->defaultHighOutputLatency)).count();
 
 
             return std::make_tuple(inparams,outparams,srate);
@@ -0,0 +1,164 @@
+#ifndef PLANAR_VIEW_HPP
+#define PLANAR_VIEW_HPP
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "buffer_view.hpp"
+
+namespace zaudio
+{
+    //a contiguous run of the samples of one channel
+    template<typename sample_t>
+    using channel_view = frame_view<sample_t>;
+
+    /*!
+     *\class planar_view
+     *\brief a non-interleaved buffer, one contiguous span of frame_count samples per channel
+     *\note the channel pointers are owned by the backend and are only valid for the duration of a callback
+     */
+    template<typename sample_t>
+    class planar_view
+    {
+    public:
+        class iterator
+        {
+        public:
+            iterator():_channel(nullptr),_size(0){}
+            iterator(sample_t* const* channel, const std::size_t& size):_channel(channel),_size(size)
+            {}
+
+            iterator& operator++() noexcept
+            {
+                ++_channel;
+                return *this;
+            }
+            iterator operator++(int) noexcept
+            {
+                iterator iter =*this;
+                ++(*this);
+                return iter;
+            }
+            bool operator==(const iterator& other) const noexcept
+            {
+                return _channel == other._channel;
+            }
+            bool operator !=(const iterator& other) const  noexcept
+            {
+                return _channel != other._channel;
+            }
+            channel_view<sample_t> operator*() noexcept
+            {
+                return channel_view<sample_t>(*_channel,_size);
+            }
+            const channel_view<sample_t> operator*() const noexcept
+            {
+                return channel_view<sample_t>(*_channel,_size);
+            }
+        private:
+            sample_t* const* _channel;
+            std::size_t _size;
+        };
+        using const_iterator = const iterator;
+
+        planar_view() noexcept: _channels(nullptr),
+                                _frame_count(0),
+                                _channel_count(0)
+        {}
+        explicit planar_view(sample_t* const* channels,
+                             const std::size_t& frame_count,
+                             const std::size_t& channel_count) noexcept: _channels(channels),
+                                                                         _frame_count(frame_count),
+                                                                         _channel_count(channel_count)
+        {}
+        explicit planar_view(const sample_t* const* channels,
+                             const std::size_t& frame_count,
+                             const std::size_t& channel_count) noexcept: _channels(const_cast<sample_t* const*>(channels)),
+                                                                         _frame_count(frame_count),
+                                                                         _channel_count(channel_count)
+        {}
+
+        const channel_view<sample_t> operator[](const std::size_t& channel) const noexcept
+        {
+            return channel_view<sample_t>{_channels[channel],_frame_count};
+        }
+        channel_view<sample_t> operator[](const std::size_t& channel) noexcept
+        {
+            return channel_view<sample_t>{_channels[channel],_frame_count};
+        }
+        channel_view<sample_t> at(const std::size_t& channel)
+        {
+            if(channel < channel_count())
+            {
+                return (*this)[channel];
+            }
+            else
+            {
+                std::string err = "Channel: " + std::to_string(channel) + " is out of bounds!";
+                throw std::out_of_range(err);
+            }
+        }
+        const std::size_t size() const noexcept
+        {
+            return _channel_count * _frame_count;
+        }
+        const std::size_t& channel_count() const noexcept
+        {
+            return _channel_count;
+        }
+        const std::size_t& frame_count() const noexcept
+        {
+            return _frame_count;
+        }
+        //one pointer per channel
+        sample_t* const* data() noexcept
+        {
+            return _channels;
+        }
+
+        iterator begin() noexcept
+        {
+            return iterator(_channels,_frame_count);
+        }
+        const_iterator begin() const noexcept
+        {
+            return iterator(_channels,_frame_count);
+        }
+        const_iterator cbegin() const noexcept
+        {
+            return begin();
+        }
+        iterator end() noexcept
+        {
+            return iterator(_channels + _channel_count,_frame_count);
+        }
+        const_iterator end() const noexcept
+        {
+            return iterator(_channels + _channel_count,_frame_count);
+        }
+        const_iterator cend() const noexcept
+        {
+            return end();
+        }
+    protected:
+        sample_t* const* _channels;
+        std::size_t _frame_count;
+        std::size_t _channel_count;
+    };
+}
+
+#endif
@@ -0,0 +1,861 @@
+#ifndef ZAUDIO_PROCESSING_GRAPH
+#define ZAUDIO_PROCESSING_GRAPH
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "sample_utility.hpp"
+#include "time_utility.hpp"
+#include "error_utility.hpp"
+#include "stream_params.hpp"
+#include "stream_timing.hpp"
+#include "buffer_view.hpp"
+#include "buffer_group.hpp"
+#include "interleave.hpp"
+#include "audio_process.hpp"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\struct port_info
+     *\brief one input or output of a graph_node, a port carries interleaved frames of exactly channels channels
+     */
+    struct port_info
+    {
+        std::string name;
+
+        std::size_t channels;
+    };
+
+    /*!
+     *\struct graph_buffers
+     *\brief the port buffers handed to a graph_node, one view per port in the order the node declared them
+     *\note inputs are read only, a buffer may be shared with other nodes or be the stream input itself
+     *\note unconnected inputs read silence, every output must be written even when nothing is connected to it
+     */
+    template<typename sample_t>
+    struct graph_buffers
+    {
+        const buffer_view<sample_t>* inputs;
+
+        std::size_t input_count;
+
+        buffer_view<sample_t>* outputs;
+
+        std::size_t output_count;
+
+        //frame position and converter times of the first frame of these buffers
+        stream_timing timing;
+
+        //a copy so it can be iterated, the samples behind it are still read only
+        buffer_view<sample_t> input(std::size_t port) const noexcept
+        {
+            return inputs[port];
+        }
+
+        buffer_view<sample_t>& output(std::size_t port) noexcept
+        {
+            return outputs[port];
+        }
+    };
+
+    /*!
+     *\class graph_node
+     *\brief the unit of a processing_graph, an audio_process with any number of typed input and output ports
+     *\note on_process runs on the audio thread and must not allocate or block, allocate what a node needs in its constructor
+     *\note a node may be in the running schedule and a newly compiled one at once, only one of them runs it at a time
+     */
+    template<typename sample_t>
+    class graph_node : public detail::fail_if_type_is_not_sample<sample_t>
+    {
+    public:
+        graph_node(std::vector<port_info> inputs, std::vector<port_info> outputs) : _inputs(std::move(inputs)),
+                                                                                    _outputs(std::move(outputs))
+        {}
+
+        virtual ~graph_node() = default;
+
+        const std::vector<port_info>& inputs() const noexcept
+        {
+            return _inputs;
+        }
+
+        const std::vector<port_info>& outputs() const noexcept
+        {
+            return _outputs;
+        }
+
+        virtual stream_error on_process(graph_buffers<sample_t>&, time_point, stream_params<sample_t>&) noexcept
+        {
+            return no_error;
+        }
+
+    private:
+        std::vector<port_info> _inputs;
+
+        std::vector<port_info> _outputs;
+    };
+
+    /*!
+     *\class process_node
+     *\brief puts an existing audio_process into a graph, with one input port and one output port
+     *\note a port with 0 channels is left out, the process then sees an empty buffer_view for it
+     */
+    template<typename sample_t>
+    class process_node final : public graph_node<sample_t>
+    {
+    public:
+        process_node(std::shared_ptr<audio_process<sample_t>> proc, std::size_t input_channels, std::size_t output_channels):
+            graph_node<sample_t>(_ports("in",input_channels),_ports("out",output_channels)),
+            _proc(std::move(proc))
+        {}
+
+        stream_error on_process(graph_buffers<sample_t>& buffers, time_point tp, stream_params<sample_t>& params) noexcept override
+        {
+            buffer_view<sample_t> none(static_cast<sample_t*>(nullptr),0,0);
+            buffer_group<sample_t> group{buffers.input_count > 0 ? buffers.input(0) : none,
+                                         buffers.output_count > 0 ? buffers.output(0) : none};
+            group.timing = buffers.timing;
+            return _proc->on_process(group,tp,params);
+        }
+
+    private:
+        static std::vector<port_info> _ports(const char* name, std::size_t channels)
+        {
+            return channels == 0 ? std::vector<port_info>() : std::vector<port_info>{port_info{name,channels}};
+        }
+
+        std::shared_ptr<audio_process<sample_t>> _proc;
+    };
+
+    template<typename sample_t>
+    std::shared_ptr<graph_node<sample_t>> make_process_node(std::shared_ptr<audio_process<sample_t>> proc, std::size_t input_channels, std::size_t output_channels)
+    {
+        return std::make_shared<process_node<sample_t>>(std::move(proc),input_channels,output_channels);
+    }
+
+    /*!
+     *\struct graph_schedule_info
+     *\brief what compile made of a processing_graph
+     */
+    struct graph_schedule_info
+    {
+        //nodes run per block, the stream input and output are not counted
+        std::size_t nodes = 0;
+
+        //output ports written per block, each would need its own buffer without the liveness pass
+        std::size_t ports = 0;
+
+        //intermediate buffers the ports share after the liveness pass
+        std::size_t buffers = 0;
+
+        //samples allocated for the intermediate buffers, silence and the stream input copy
+        std::size_t samples = 0;
+
+        //frames per block, longer stream buffers run in several blocks
+        std::size_t max_frames = 0;
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, const graph_schedule_info& info);
+
+    /*!
+     *\class processing_graph
+     *\brief runs a graph of graph_nodes as one audio_process, in topological order with preallocated, shared intermediate buffers
+     *\note edits change a description only, compile sorts it, assigns buffers by liveness and swaps the result in atomically
+     *\note the old schedule is freed by compile once the audio thread has left it, the audio thread never allocates or frees
+     *\note the stream input is the single output port of input_node, the stream output the single input port of output_node
+     *\note the graph must outlive any stream running it
+     */
+    template<typename sample_t>
+    class processing_graph final : public audio_process<sample_t>
+    {
+    public:
+        using node_type = graph_node<sample_t>;
+
+        using node_id = std::size_t;
+
+        constexpr static node_id input_node = 0;
+
+        constexpr static node_id output_node = 1;
+
+        //may throw std::bad_alloc
+        processing_graph(std::size_t input_channels, std::size_t output_channels, std::size_t max_frames = 1024);
+
+        processing_graph(const processing_graph&) = delete;
+
+        processing_graph& operator=(const processing_graph&) = delete;
+
+        ~processing_graph();
+
+        //may throw std::bad_alloc
+        node_id add_node(std::shared_ptr<node_type> node);
+
+        //also drops every connection to and from the node
+        stream_error remove_node(node_id id) noexcept;
+
+        //the channel counts of both ports must match, an input port takes one connection and replaces the one it had
+        stream_error connect(node_id from, std::size_t output_port, node_id to, std::size_t input_port) noexcept;
+
+        stream_error disconnect(node_id to, std::size_t input_port) noexcept;
+
+        //may throw std::bad_alloc, returns a user_error and keeps the running schedule when the graph has a cycle
+        stream_error compile();
+
+        //the schedule compile last swapped in
+        graph_schedule_info schedule_info() const;
+
+        std::size_t input_channels() const noexcept;
+
+        std::size_t output_channels() const noexcept;
+
+        std::size_t max_frames() const noexcept;
+
+        //audio thread, runs the current schedule, silence until the first compile
+        stream_error on_process(buffer_group<sample_t>& buffers, time_point tp, stream_params<sample_t>& params) noexcept override;
+
+    private:
+        constexpr static std::size_t unconnected = std::numeric_limits<std::size_t>::max();
+
+        struct source
+        {
+            node_id node;
+
+            std::size_t port;
+        };
+
+        struct node_entry
+        {
+            std::shared_ptr<node_type> node;
+
+            //one per input port, node is unconnected when nothing feeds the port
+            std::vector<source> sources;
+        };
+
+        //a port buffer, null data stands for the stream input
+        struct binding
+        {
+            sample_t* data;
+
+            std::size_t channels;
+        };
+
+        struct step
+        {
+            node_type* node;
+
+            std::size_t first_input;
+
+            std::size_t input_count;
+
+            std::size_t first_output;
+
+            std::size_t output_count;
+        };
+
+        struct schedule
+        {
+            //keeps removed nodes alive while this schedule may still run them
+            std::vector<std::shared_ptr<node_type>> nodes;
+
+            std::vector<step> steps;
+
+            std::vector<binding> bindings;
+
+            //rebuilt from bindings for every block
+            std::vector<buffer_view<sample_t>> views;
+
+            binding output;
+
+            std::vector<sample_t> arena;
+
+            sample_t* input_copy;
+
+            //channel pointers for planar stream buffers
+            std::vector<sample_t*> planes;
+
+            graph_schedule_info info;
+        };
+
+        bool _valid(node_id id) const noexcept;
+
+        void _publish(schedule* next) noexcept;
+
+        const sample_t* _stream_input(schedule& s, buffer_group<sample_t>& buffers, std::size_t offset, std::size_t frames) noexcept;
+
+        void _silence(buffer_group<sample_t>& buffers) noexcept;
+
+        void _stream_output(schedule& s, buffer_group<sample_t>& buffers, const sample_t* data, std::size_t offset, std::size_t frames) noexcept;
+
+        std::size_t _input_channels;
+
+        std::size_t _output_channels;
+
+        std::size_t _max_frames;
+
+        mutable std::mutex _edit;
+
+        std::vector<node_entry> _nodes;
+
+        graph_schedule_info _info;
+
+        std::atomic<schedule*> _schedule;
+
+        //odd while on_process runs, see stream_api::_wait_for_process_boundary
+        std::atomic<std::size_t> _process_epoch;
+    };
+
+    template<typename sample_t>
+    constexpr typename processing_graph<sample_t>::node_id processing_graph<sample_t>::input_node;
+
+    template<typename sample_t>
+    constexpr typename processing_graph<sample_t>::node_id processing_graph<sample_t>::output_node;
+
+    template<typename sample_t>
+    constexpr std::size_t processing_graph<sample_t>::unconnected;
+
+    template<typename sample_t>
+    processing_graph<sample_t>::processing_graph(std::size_t input_channels, std::size_t output_channels, std::size_t max_frames):
+        _input_channels(input_channels),
+        _output_channels(output_channels),
+        _max_frames(std::max<std::size_t>(1,max_frames)),
+        _edit(),
+        _nodes(),
+        _info(),
+        _schedule(nullptr),
+        _process_epoch(0)
+    {
+        //the endpoints are plain nodes that never run, the stream buffers stand in for their ports
+        std::vector<port_info> stream_input;
+        std::vector<port_info> stream_output;
+        if(input_channels > 0)
+        {
+            stream_input.push_back(port_info{"stream input",input_channels});
+        }
+        if(output_channels > 0)
+        {
+            stream_output.push_back(port_info{"stream output",output_channels});
+        }
+        _nodes.push_back(node_entry{std::make_shared<node_type>(std::vector<port_info>(),stream_input),{}});
+        _nodes.push_back(node_entry{std::make_shared<node_type>(stream_output,std::vector<port_info>()),std::vector<source>(stream_output.size(),source{unconnected,0})});
+        _info.max_frames = _max_frames;
+    }
+
+    template<typename sample_t>
+    processing_graph<sample_t>::~processing_graph()
+    {
+        delete _schedule.exchange(nullptr);
+    }
+
+    template<typename sample_t>
+    typename processing_graph<sample_t>::node_id processing_graph<sample_t>::add_node(std::shared_ptr<node_type> node)
+    {
+        std::lock_guard<std::mutex> lock(_edit);
+        auto&& inputs = node->inputs().size();
+        _nodes.push_back(node_entry{std::move(node),std::vector<source>(inputs,source{unconnected,0})});
+        return _nodes.size() - 1;
+    }
+
+    template<typename sample_t>
+    bool processing_graph<sample_t>::_valid(node_id id) const noexcept
+    {
+        return id < _nodes.size() && _nodes[id].node != nullptr;
+    }
+
+    template<typename sample_t>
+    stream_error processing_graph<sample_t>::remove_node(node_id id) noexcept
+    {
+        std::lock_guard<std::mutex> lock(_edit);
+        if(id == input_node || id == output_node || !_valid(id))
+        {
+            return make_stream_error(stream_status::user_error,"The node cannot be removed from the processing graph.");
+        }
+        _nodes[id].node.reset();
+        _nodes[id].sources.clear();
+        for(auto&& entry: _nodes)
+        {
+            for(auto&& src: entry.sources)
+            {
+                if(src.node == id)
+                {
+                    src = source{unconnected,0};
+                }
+            }
+        }
+        return no_error;
+    }
+
+    template<typename sample_t>
+    stream_error processing_graph<sample_t>::connect(node_id from, std::size_t output_port, node_id to, std::size_t input_port) noexcept
+    {
+        std::lock_guard<std::mutex> lock(_edit);
+        if(!_valid(from) || !_valid(to) || from == to)
+        {
+            return make_stream_error(stream_status::user_error,"The nodes cannot be connected.");
+        }
+        auto&& outputs = _nodes[from].node->outputs();
+        auto&& inputs = _nodes[to].node->inputs();
+        if(output_port >= outputs.size() || input_port >= inputs.size())
+        {
+            return make_stream_error(stream_status::user_error,"The node has no such port.");
+        }
+        if(outputs[output_port].channels != inputs[input_port].channels)
+        {
+            return make_stream_error(stream_status::user_error,"The ports carry different channel counts.");
+        }
+        _nodes[to].sources[input_port] = source{from,output_port};
+        return no_error;
+    }
+
+    template<typename sample_t>
+    stream_error processing_graph<sample_t>::disconnect(node_id to, std::size_t input_port) noexcept
+    {
+        std::lock_guard<std::mutex> lock(_edit);
+        if(!_valid(to) || input_port >= _nodes[to].sources.size())
+        {
+            return make_stream_error(stream_status::user_error,"The node has no such port.");
+        }
+        _nodes[to].sources[input_port] = source{unconnected,0};
+        return no_error;
+    }
+
+    template<typename sample_t>
+    stream_error processing_graph<sample_t>::compile()
+    {
+        std::lock_guard<std::mutex> lock(_edit);
+        auto&& count = _nodes.size();
+
+        //kahn's algorithm, lowest id first among the ready nodes so equal graphs compile to equal schedules
+        std::vector<std::vector<node_id>> consumers(count);
+        std::vector<std::size_t> pending(count,0);
+        std::size_t alive = 0;
+        for(node_id id = 0; id < count; ++id)
+        {
+            if(!_valid(id))
+            {
+                continue;
+            }
+            ++alive;
+            for(auto&& src: _nodes[id].sources)
+            {
+                if(src.node != unconnected)
+                {
+                    consumers[src.node].push_back(id);
+                    ++pending[id];
+                }
+            }
+        }
+        std::vector<node_id> order;
+        order.reserve(alive);
+        std::vector<node_id> ready;
+        for(node_id id = 0; id < count; ++id)
+        {
+            if(_valid(id) && pending[id] == 0)
+            {
+                ready.push_back(id);
+            }
+        }
+        while(!ready.empty())
+        {
+            auto&& next = std::min_element(ready.begin(),ready.end());
+            node_id id = *next;
+            ready.erase(next);
+            order.push_back(id);
+            for(auto&& consumer: consumers[id])
+            {
+                if(--pending[consumer] == 0)
+                {
+                    ready.push_back(consumer);
+                }
+            }
+        }
+        if(order.size() != alive)
+        {
+            return make_stream_error(stream_status::user_error,"The processing graph has a cycle.");
+        }
+
+        //the endpoints do not run, the stream input is live before the first step and the stream output after the last
+        std::vector<std::size_t> position(count,0);
+        std::vector<node_id> steps;
+        for(auto&& id: order)
+        {
+            if(id != input_node && id != output_node)
+            {
+                position[id] = steps.size();
+                steps.push_back(id);
+            }
+        }
+        position[output_node] = steps.size();
+
+        //the last step that reads each output port, the port's own step when nothing reads it
+        std::vector<std::vector<std::size_t>> last_use(count);
+        for(auto&& id: steps)
+        {
+            last_use[id].assign(_nodes[id].node->outputs().size(),position[id]);
+        }
+        for(node_id id = 0; id < count; ++id)
+        {
+            if(!_valid(id))
+            {
+                continue;
+            }
+            for(auto&& src: _nodes[id].sources)
+            {
+                if(src.node != unconnected && src.node != input_node)
+                {
+                    auto&& last = last_use[src.node][src.port];
+                    last = std::max(last,position[id]);
+                }
+            }
+        }
+
+        //greedy interval colouring in step order, which needs the fewest buffers an interval schedule can have
+        //a step's outputs are taken before its inputs are freed, so no node reads and writes the same buffer
+        struct slot
+        {
+            std::size_t channels;
+
+            std::size_t free_after;
+
+            bool used;
+        };
+        std::vector<slot> slots;
+        std::vector<std::vector<std::size_t>> slot_of(count);
+        std::size_t ports = 0;
+        for(auto&& id: steps)
+        {
+            auto&& now = position[id];
+            for(auto&& sl: slots)
+            {
+                if(sl.used && sl.free_after < now)
+                {
+                    sl.used = false;
+                }
+            }
+            auto&& outputs = _nodes[id].node->outputs();
+            slot_of[id].resize(outputs.size());
+            for(std::size_t p = 0; p < outputs.size(); ++p)
+            {
+                auto&& channels = outputs[p].channels;
+                //the tightest free buffer that is wide enough, otherwise the free one that has to grow least
+                std::size_t best = slots.size();
+                for(std::size_t i = 0; i < slots.size(); ++i)
+                {
+                    if(slots[i].used)
+                    {
+                        continue;
+                    }
+                    if(best == slots.size())
+                    {
+                        best = i;
+                        continue;
+                    }
+                    auto&& fits = slots[i].channels >= channels;
+                    auto&& best_fits = slots[best].channels >= channels;
+                    if(fits != best_fits ? fits : (fits ? slots[i].channels < slots[best].channels : slots[i].channels > slots[best].channels))
+                    {
+                        best = i;
+                    }
+                }
+                if(best == slots.size())
+                {
+                    slots.push_back(slot{0,0,false});
+                }
+                slots[best].channels = std::max(slots[best].channels,channels);
+                slots[best].free_after = last_use[id][p];
+                slots[best].used = true;
+                slot_of[id][p] = best;
+                ++ports;
+            }
+        }
+
+        std::unique_ptr<schedule> next(new schedule());
+        std::size_t widest = std::max(_input_channels,_output_channels);
+        std::vector<std::size_t> offsets;
+        std::size_t samples = 0;
+        for(auto&& sl: slots)
+        {
+            offsets.push_back(samples);
+            samples += sl.channels * _max_frames;
+        }
+        for(auto&& id: steps)
+        {
+            for(auto&& port: _nodes[id].node->inputs())
+            {
+                widest = std::max(widest,port.channels);
+            }
+        }
+        const std::size_t silence = samples;
+        samples += widest * _max_frames;
+        const std::size_t input_copy = samples;
+        samples += _input_channels * _max_frames;
+        next->arena.assign(samples,sample_t(0));
+        next->input_copy = next->arena.data() + input_copy;
+        next->planes.resize(widest);
+
+        auto&& bind = [&](const source& src, std::size_t channels)
+        {
+            if(src.node == unconnected)
+            {
+                return binding{next->arena.data() + silence,channels};
+            }
+            if(src.node == input_node)
+            {
+                return binding{nullptr,channels};
+            }
+            return binding{next->arena.data() + offsets[slot_of[src.node][src.port]],channels};
+        };
+        for(auto&& id: steps)
+        {
+            auto&& entry = _nodes[id];
+            auto&& inputs = entry.node->inputs();
+            auto&& outputs = entry.node->outputs();
+            step st{entry.node.get(),next->bindings.size(),inputs.size(),next->bindings.size() + inputs.size(),outputs.size()};
+            for(std::size_t p = 0; p < inputs.size(); ++p)
+            {
+                next->bindings.push_back(bind(entry.sources[p],inputs[p].channels));
+            }
+            for(std::size_t p = 0; p < outputs.size(); ++p)
+            {
+                next->bindings.push_back(binding{next->arena.data() + offsets[slot_of[id][p]],outputs[p].channels});
+            }
+            next->steps.push_back(st);
+            next->nodes.push_back(entry.node);
+        }
+        next->output = _output_channels > 0 ? bind(_nodes[output_node].sources[0],_output_channels) : binding{next->arena.data() + silence,0};
+        next->views.assign(next->bindings.size(),buffer_view<sample_t>(static_cast<sample_t*>(nullptr),0,0));
+        next->info.nodes = steps.size();
+        next->info.ports = ports;
+        next->info.buffers = slots.size();
+        next->info.samples = samples;
+        next->info.max_frames = _max_frames;
+        _info = next->info;
+        _publish(next.release());
+        return no_error;
+    }
+
+    //same handshake as stream_api::exchange_callback, any on_process that starts after the exchange sees the new schedule
+    template<typename sample_t>
+    void processing_graph<sample_t>::_publish(schedule* next) noexcept
+    {
+        auto&& old = _schedule.exchange(next);
+        auto&& epoch = _process_epoch.load();
+        if(epoch % 2 != 0)
+        {
+            while(_process_epoch.load(std::memory_order_acquire) == epoch){ std::this_thread::yield(); }
+        }
+        delete old;
+    }
+
+    template<typename sample_t>
+    graph_schedule_info processing_graph<sample_t>::schedule_info() const
+    {
+        std::lock_guard<std::mutex> lock(_edit);
+        return _info;
+    }
+
+    template<typename sample_t>
+    std::size_t processing_graph<sample_t>::input_channels() const noexcept
+    {
+        return _input_channels;
+    }
+
+    template<typename sample_t>
+    std::size_t processing_graph<sample_t>::output_channels() const noexcept
+    {
+        return _output_channels;
+    }
+
+    template<typename sample_t>
+    std::size_t processing_graph<sample_t>::max_frames() const noexcept
+    {
+        return _max_frames;
+    }
+
+    //the stream input as interleaved frames of _input_channels, without a copy when the stream buffer already is that
+    template<typename sample_t>
+    const sample_t* processing_graph<sample_t>::_stream_input(schedule& s, buffer_group<sample_t>& buffers, std::size_t offset, std::size_t frames) noexcept
+    {
+        auto&& channels = _input_channels;
+        if(buffers.layout == buffer_layout::interleaved)
+        {
+            buffer_view<sample_t> in = buffers.input;
+            if(in.frame_width() == channels && in.data() != nullptr)
+            {
+                return in.data() + offset * channels;
+            }
+            const std::size_t width = std::min(channels,in.frame_width());
+            for(std::size_t f = 0; f < frames; ++f)
+            {
+                for(std::size_t c = 0; c < channels; ++c)
+                {
+                    s.input_copy[f * channels + c] = c < width ? in.data()[(offset + f) * in.frame_width() + c] : sample_t(0);
+                }
+            }
+            return s.input_copy;
+        }
+        planar_view<sample_t> in = buffers.planar_input;
+        const std::size_t width = std::min(channels,in.channel_count());
+        for(std::size_t c = 0; c < width; ++c)
+        {
+            s.planes[c] = in.data()[c] + offset;
+        }
+        if(width == channels)
+        {
+            interleave(s.planes.data(),s.input_copy,frames,channels);
+        }
+        else
+        {
+            std::fill(s.input_copy,s.input_copy + frames * channels,sample_t(0));
+            for(std::size_t f = 0; f < frames; ++f)
+            {
+                for(std::size_t c = 0; c < width; ++c)
+                {
+                    s.input_copy[f * channels + c] = s.planes[c][f];
+                }
+            }
+        }
+        return s.input_copy;
+    }
+
+    template<typename sample_t>
+    void processing_graph<sample_t>::_stream_output(schedule& s, buffer_group<sample_t>& buffers, const sample_t* data, std::size_t offset, std::size_t frames) noexcept
+    {
+        auto&& channels = _output_channels;
+        if(buffers.layout == buffer_layout::interleaved)
+        {
+            auto&& out = buffers.output;
+            if(out.data() == nullptr)
+            {
+                return;
+            }
+            if(out.frame_width() == channels)
+            {
+                std::memcpy(out.data() + offset * channels,data,frames * channels * sizeof(sample_t));
+                return;
+            }
+            auto&& width = out.frame_width();
+            for(std::size_t f = 0; f < frames; ++f)
+            {
+                for(std::size_t c = 0; c < width; ++c)
+                {
+                    out.data()[(offset + f) * width + c] = c < channels ? data[f * channels + c] : sample_t(0);
+                }
+            }
+            return;
+        }
+        auto&& out = buffers.planar_output;
+        if(out.data() == nullptr)
+        {
+            return;
+        }
+        if(out.channel_count() == channels)
+        {
+            for(std::size_t c = 0; c < channels; ++c)
+            {
+                s.planes[c] = out.data()[c] + offset;
+            }
+            deinterleave(data,s.planes.data(),frames,channels);
+            return;
+        }
+        for(std::size_t c = 0; c < out.channel_count(); ++c)
+        {
+            auto&& plane = out.data()[c] + offset;
+            for(std::size_t f = 0; f < frames; ++f)
+            {
+                plane[f] = c < channels ? data[f * channels + c] : sample_t(0);
+            }
+        }
+    }
+
+    template<typename sample_t>
+    void processing_graph<sample_t>::_silence(buffer_group<sample_t>& buffers) noexcept
+    {
+        if(buffers.layout == buffer_layout::interleaved)
+        {
+            auto&& out = buffers.output;
+            if(out.data() != nullptr)
+            {
+                std::fill(out.data(),out.data() + out.size(),sample_t(0));
+            }
+            return;
+        }
+        auto&& out = buffers.planar_output;
+        for(std::size_t c = 0; out.data() != nullptr && c < out.channel_count(); ++c)
+        {
+            std::fill(out.data()[c],out.data()[c] + out.frame_count(),sample_t(0));
+        }
+    }
+
+    template<typename sample_t>
+    stream_error processing_graph<sample_t>::on_process(buffer_group<sample_t>& buffers, time_point tp, stream_params<sample_t>& params) noexcept
+    {
+        //enter before loading the schedule so a concurrent compile knows to wait for us
+        _process_epoch.fetch_add(1);
+        auto&& s = _schedule.load();
+        stream_error ret = no_error;
+        auto&& frames = buffers.layout == buffer_layout::interleaved ? buffers.output.frame_count() : buffers.planar_output.frame_count();
+        if(s == nullptr)
+        {
+            _silence(buffers);
+        }
+        for(std::size_t offset = 0; s != nullptr && offset < frames; offset += _max_frames)
+        {
+            const std::size_t block = std::min(_max_frames,frames - offset);
+            auto&& input = _input_channels > 0 ? _stream_input(*s,buffers,offset,block) : nullptr;
+            for(std::size_t i = 0; i < s->bindings.size(); ++i)
+            {
+                auto&& b = s->bindings[i];
+                s->views[i] = buffer_view<sample_t>(b.data != nullptr ? b.data : const_cast<sample_t*>(input),block,b.channels);
+            }
+            auto&& timing = offset == 0 ? buffers.timing : buffers.timing.advanced(static_cast<std::int64_t>(offset));
+            for(auto&& st: s->steps)
+            {
+                graph_buffers<sample_t> io{s->views.data() + st.first_input,st.input_count,s->views.data() + st.first_output,st.output_count,timing};
+                auto&& err = st.node->on_process(io,tp,params);
+                if(err != no_error && ret == no_error)
+                {
+                    ret = err;
+                }
+            }
+            if(_output_channels > 0)
+            {
+                _stream_output(*s,buffers,s->output.data != nullptr ? s->output.data : input,offset,block);
+            }
+        }
+        _process_epoch.fetch_add(1,std::memory_order_release);
+        return ret;
+    }
+}
+
+#endif
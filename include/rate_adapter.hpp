@@ -0,0 +1,389 @@
+#ifndef ZAUDIO_RATE_ADAPTER
+#define ZAUDIO_RATE_ADAPTER
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "format_adapter.hpp"
+#include "sample_rate_converter.hpp"
+#include "sample_conversion.hpp"
+#include "interleave.hpp"
+#include "buffer_algorithm.hpp"
+#include "stream_timing.hpp"
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\class rate_adapter
+     *\brief runs the callback side of a stream at params.sample_rate() while the device runs at params.device_sample_rate()
+     *\note each device buffer is resampled to the frames it spans at the stream rate, a count that varies by a frame from buffer to buffer
+     *\note the block fifo behind it hands the callback fixed blocks again, see block_adapter
+     *\note the filters run in float through a sample_rate_converter per direction, other sample types are converted around them
+     *\note both directions are primed with silence so every device buffer is filled, input_latency() and output_latency() frames of delay come with that
+     */
+    template<typename sample_t>
+    class rate_adapter
+    {
+    public:
+        rate_adapter() noexcept : _rate(0),
+                                  _device_rate(0),
+                                  _input_width(0),
+                                  _output_width(0),
+                                  _device_frames(0),
+                                  _frames(0),
+                                  _input_capacity(0),
+                                  _output_capacity(0),
+                                  _input_queued(0),
+                                  _output_queued(0),
+                                  _phase(0),
+                                  _position(0),
+                                  _active(false),
+                                  _layout(buffer_layout::interleaved)
+        {}
+
+        //the most frames one device buffer of at most params.frame_count() frames spans at the stream rate
+        static std::size_t max_frames(const stream_params<sample_t>& params) noexcept
+        {
+            return static_cast<std::size_t>(std::ceil(params.frame_count() * params.sample_rate() / params.device_sample_rate())) + 1;
+        }
+
+        //build the converters and allocate the queues, not realtime safe
+        stream_error prepare(const stream_params<sample_t>& params) noexcept
+        {
+            _rate = params.sample_rate();
+            _device_rate = params.device_sample_rate();
+            _input_width = params.input_frame_width();
+            _output_width = params.output_frame_width();
+            _layout = params.layout();
+            _input_converter.reset();
+            _output_converter.reset();
+            _active = _rate != _device_rate;
+            if(!_active)
+            {
+                return no_error;
+            }
+            if(params.mode() == stream_mode::blocking)
+            {
+                _active = false;
+                return make_stream_error(stream_status::system_error,"Blocking streams can not run at a different rate than their device.");
+            }
+            _device_frames = params.frame_count();
+            _frames = max_frames(params);
+            //the converters hand out a frame more or less than the phase says now and then, the queues absorb that
+            _input_capacity = _frames + queue_prime * 4;
+            _output_capacity = _device_frames + queue_prime * 4;
+            try
+            {
+                if(_input_width != 0)
+                {
+                    _input_converter.reset(new sample_rate_converter(_device_rate,_rate,_input_width,resample_quality::standard,_device_frames));
+                    _input_queue.assign(_input_capacity * _input_width,0.0f);
+                }
+                if(_output_width != 0)
+                {
+                    _output_converter.reset(new sample_rate_converter(_rate,_device_rate,_output_width,resample_quality::standard,_frames));
+                    _output_queue.assign(_output_capacity * _output_width,0.0f);
+                }
+                const std::size_t width = std::max(_input_width,_output_width);
+                const std::size_t frames = std::max({_device_frames,_frames,_converter_latency(_input_converter),_converter_latency(_output_converter)});
+                _staging.assign(frames * width,0.0f);
+                if(_layout == buffer_layout::planar)
+                {
+                    _input.allocate(_input_width,_frames);
+                    _output.allocate(_output_width,_frames);
+                    _planes.allocate(width,frames);
+                }
+                else
+                {
+                    _input.allocate(1,_frames * _input_width);
+                    _output.allocate(1,_frames * _output_width);
+                    _planes.clear();
+                }
+            }
+            catch(const std::bad_alloc&)
+            {
+                _active = false;
+                return make_stream_error(stream_status::system_error,"Unable to allocate resampling buffers.");
+            }
+            catch(const std::invalid_argument&)
+            {
+                _active = false;
+                return make_stream_error(stream_status::system_error,"Invalid sample rate.");
+            }
+            reset();
+            return no_error;
+        }
+
+        //false when the device runs at the stream rate
+        bool active() const noexcept
+        {
+            return _active;
+        }
+
+        //frames at the stream rate between the device capturing a frame and the callback seeing it
+        std::size_t input_latency() const noexcept
+        {
+            return _input_converter == nullptr ? 0 : static_cast<std::size_t>(std::lround(_input_converter->latency() * _rate / _device_rate)) + queue_prime;
+        }
+
+        //frames at the stream rate between the callback writing a frame and the device playing it
+        std::size_t output_latency() const noexcept
+        {
+            return _output_converter == nullptr ? 0 : _output_converter->latency() + static_cast<std::size_t>(std::lround(queue_prime * _rate / _device_rate));
+        }
+
+        //the round trip delay in frames at the stream rate
+        std::size_t latency() const noexcept
+        {
+            return input_latency() + output_latency();
+        }
+
+        //clears the filters and queues and primes them with silence again, the stream must not be running
+        void reset() noexcept
+        {
+            _phase = 0;
+            _position = 0;
+            std::fill(_staging.begin(),_staging.end(),0.0f);
+            _input_queued = _prime(_input_converter,_input_queue,_input_width);
+            _output_queued = _prime(_output_converter,_output_queue,_output_width);
+        }
+
+        //resamples frames device frames of interleaved input, runs run(input, output, frames, timing) on the frames they span at the stream rate
+        //and resamples its output back into frames device frames
+        //frames is at most params.frame_count(), timing describes the device buffers
+        template<typename F>
+        stream_error process(const sample_t* input, sample_t* output, std::size_t frames, const stream_timing& timing, F&& run) noexcept
+        {
+            return _process(input,output,frames,timing,run);
+        }
+
+        //the same for planar buffers, one pointer per channel
+        template<typename F>
+        stream_error process(const sample_t* const* input, sample_t* const* output, std::size_t frames, const stream_timing& timing, F&& run) noexcept
+        {
+            return _process(input,output,frames,timing,run);
+        }
+
+    private:
+        //frames of silence each queue starts with, more than the converters ever fall behind the phase
+        constexpr static std::size_t queue_prime = 2;
+
+        double _rate;
+
+        double _device_rate;
+
+        std::size_t _input_width;
+
+        std::size_t _output_width;
+
+        std::size_t _device_frames;
+
+        //the most frames a device buffer spans at the stream rate
+        std::size_t _frames;
+
+        std::size_t _input_capacity;
+
+        std::size_t _output_capacity;
+
+        //stream rate frames waiting for the callback, and device rate frames waiting for the device
+        std::size_t _input_queued;
+
+        std::size_t _output_queued;
+
+        //the fraction of a stream rate frame the device buffers so far went past a whole frame
+        double _phase;
+
+        //the first stream rate frame of the next call
+        std::uint64_t _position;
+
+        bool _active;
+
+        buffer_layout _layout;
+
+        std::unique_ptr<sample_rate_converter> _input_converter;
+
+        std::unique_ptr<sample_rate_converter> _output_converter;
+
+        //interleaved float frames, the oldest at the start
+        std::vector<float> _input_queue;
+
+        std::vector<float> _output_queue;
+
+        //interleaved float frames on their way into a converter
+        std::vector<float> _staging;
+
+        //float channels between the planar buffers and the interleaved converters
+        detail::aligned_channels<float> _planes;
+
+        //the buffers handed to run, in sample_t and the layout of the stream
+        detail::aligned_channels<sample_t> _input;
+
+        detail::aligned_channels<sample_t> _output;
+
+        template<typename in_t, typename out_t, typename F>
+        stream_error _process(in_t input, out_t output, std::size_t frames, const stream_timing& timing, F& run) noexcept
+        {
+            _phase += frames * _rate / _device_rate;
+            const std::size_t count = static_cast<std::size_t>(_phase);
+            _phase -= count;
+            auto&& block_input = input == nullptr ? nullptr : _storage(input);
+            auto&& block_output = output == nullptr ? nullptr : _storage(output);
+            if(block_input != nullptr && _input_converter != nullptr)
+            {
+                _gather(input,frames,_input_width);
+                auto&& done = _input_converter->process(_staging.data(),frames,_input_queue.data() + _input_queued * _input_width,_input_capacity - _input_queued);
+                _input_queued += done.second;
+                _input_queued = _take(_input_queue,_input_queued,block_input,count,_input_width);
+            }
+            auto&& ret = run(block_input,block_output,count,_timing(timing));
+            _position += count;
+            if(block_output != nullptr && _output_converter != nullptr)
+            {
+                if(ret != no_error)
+                {
+                    //the stream is about to be aborted, leave the device silent rather than half written
+                    _silence(output,0,frames,_output_width);
+                    return ret;
+                }
+                _gather(block_output,count,_output_width);
+                auto&& done = _output_converter->process(_staging.data(),count,_output_queue.data() + _output_queued * _output_width,_output_capacity - _output_queued);
+                _output_queued += done.second;
+                _output_queued = _take(_output_queue,_output_queued,output,frames,_output_width);
+            }
+            return ret;
+        }
+
+        //the timing of the stream rate frames handed to run, their frame positions count at the stream rate from the last reset
+        stream_timing _timing(const stream_timing& device) const noexcept
+        {
+            stream_timing t = device;
+            t.sample_rate = _rate;
+            t.frame_position = _position;
+            t.input_time -= stream_timing::ticks(static_cast<double>(input_latency()) / _rate);
+            t.output_time += stream_timing::ticks(static_cast<double>(output_latency()) / _rate);
+            return t;
+        }
+
+        static std::size_t _converter_latency(const std::unique_ptr<sample_rate_converter>& converter) noexcept
+        {
+            return converter == nullptr ? 0 : converter->latency();
+        }
+
+        //feeds the filter its look ahead in silence so it produces a frame for every frame from the start, returns the frames queued
+        std::size_t _prime(std::unique_ptr<sample_rate_converter>& converter, std::vector<float>& queue, std::size_t width) noexcept
+        {
+            if(converter == nullptr)
+            {
+                return 0;
+            }
+            converter->reset();
+            std::fill(queue.begin(),queue.end(),0.0f);
+            //the filter keeps its look ahead in its history and produces nothing from it
+            const std::size_t capacity = queue.size() / width;
+            converter->process(_staging.data(),converter->latency(),queue.data(),capacity);
+            std::fill(queue.begin(),queue.end(),0.0f);
+            return queue_prime;
+        }
+
+        //moves frames frames from the front of queue into out, silence for any the converter still owes, returns the frames left
+        template<typename out_t>
+        std::size_t _take(std::vector<float>& queue, std::size_t queued, out_t out, std::size_t frames, std::size_t width) noexcept
+        {
+            const std::size_t ready = std::min(frames,queued);
+            _scatter(queue.data(),out,ready,width);
+            _silence(out,ready,frames - ready,width);
+            std::copy(queue.begin() + ready * width,queue.begin() + queued * width,queue.begin());
+            return queued - ready;
+        }
+
+        //converts frames frames into _staging as interleaved floats
+        void _gather(const sample_t* in, std::size_t frames, std::size_t width) noexcept
+        {
+            convert_samples(in,_staging.data(),frames * width);
+        }
+
+        void _gather(const sample_t* const* in, std::size_t frames, std::size_t width) noexcept
+        {
+            for(std::size_t c = 0; c < width; ++c)
+            {
+                convert_samples(in[c],_planes[c],frames);
+            }
+            interleave(_planes.channels(),_staging.data(),frames,width);
+        }
+
+        //converts frames interleaved floats into out
+        void _scatter(const float* in, sample_t* out, std::size_t frames, std::size_t width) noexcept
+        {
+            convert_samples(in,out,frames * width);
+        }
+
+        void _scatter(const float* in, sample_t* const* out, std::size_t frames, std::size_t width) noexcept
+        {
+            deinterleave(in,_planes.channels(),frames,width);
+            for(std::size_t c = 0; c < width; ++c)
+            {
+                convert_samples(_planes[c],out[c],frames);
+            }
+        }
+
+        static void _silence(sample_t* out, std::size_t frame, std::size_t frames, std::size_t width) noexcept
+        {
+            fill_samples(out + frame * width,frames * width,sample_t());
+        }
+
+        static void _silence(sample_t* const* out, std::size_t frame, std::size_t frames, std::size_t width) noexcept
+        {
+            for(std::size_t c = 0; c < width; ++c)
+            {
+                fill_samples(out[c] + frame,frames,sample_t());
+            }
+        }
+
+        sample_t* _storage(const sample_t*) noexcept
+        {
+            return _input[0];
+        }
+
+        sample_t* _storage(sample_t*) noexcept
+        {
+            return _output[0];
+        }
+
+        sample_t* const* _storage(const sample_t* const*) noexcept
+        {
+            return _input.channels();
+        }
+
+        sample_t* const* _storage(sample_t* const*) noexcept
+        {
+            return _output.channels();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef ZAUDIO_REALTIME_POLICY
+#define ZAUDIO_REALTIME_POLICY
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\enum realtime_scheduling
+     *\brief the scheduling class requested for the audio thread
+     */
+    enum class realtime_scheduling
+    {
+        //leave the class and priority the backend gave the thread alone
+        inherit,
+        //SCHED_FIFO, or time critical priority on windows
+        fifo,
+        //SCHED_RR, or time critical priority on windows
+        round_robin
+    };
+
+    /*!
+     *\enum realtime_result
+     *\brief the outcome of one part of a realtime_policy
+     */
+    enum class realtime_result
+    {
+        not_requested,
+        applied,
+        //the system refused, the matching error field of realtime_status holds the reason
+        failed,
+        //this platform has no way to do it
+        unsupported
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, realtime_result result);
+
+    /*!
+     *\class realtime_policy
+     *\brief how the thread that runs the stream callback should be configured
+     *\note a stream applies its policy on the audio thread at the start of the first callback after each start, a restarted stream may run on a new thread
+     *\note the default policy changes nothing
+     */
+    class realtime_policy
+    {
+    public:
+        constexpr realtime_policy() noexcept : _scheduling(realtime_scheduling::inherit),
+                                               _priority(0),
+                                               _cpu_mask(0),
+                                               _flush_denormals(false),
+                                               _lock_memory(false),
+                                               _prefault_stack(0)
+        {}
+
+        constexpr const realtime_scheduling& scheduling() const noexcept
+        {
+            return _scheduling;
+        }
+
+        void scheduling(realtime_scheduling s) noexcept
+        {
+            _scheduling = s;
+        }
+
+        //priority within the scheduling class, clamped to the range the system allows
+        constexpr const int& priority() const noexcept
+        {
+            return _priority;
+        }
+
+        void priority(int p) noexcept
+        {
+            _priority = p;
+        }
+
+        //bit n pins the thread to cpu n, zero leaves the affinity alone
+        constexpr const std::uint64_t& cpu_mask() const noexcept
+        {
+            return _cpu_mask;
+        }
+
+        void cpu_mask(std::uint64_t mask) noexcept
+        {
+            _cpu_mask = mask;
+        }
+
+        //sets flush to zero and denormals are zero for the audio thread, decaying filter tails stop costing 10-100x
+        constexpr const bool& flush_denormals() const noexcept
+        {
+            return _flush_denormals;
+        }
+
+        void flush_denormals(bool f) noexcept
+        {
+            _flush_denormals = f;
+        }
+
+        //locks every current and future page of the process into memory
+        constexpr const bool& lock_memory() const noexcept
+        {
+            return _lock_memory;
+        }
+
+        void lock_memory(bool l) noexcept
+        {
+            _lock_memory = l;
+        }
+
+        //bytes of stack below the callback touched up front, so later callbacks never fault in a stack page
+        constexpr const std::size_t& prefault_stack() const noexcept
+        {
+            return _prefault_stack;
+        }
+
+        void prefault_stack(std::size_t bytes) noexcept
+        {
+            _prefault_stack = bytes;
+        }
+
+        constexpr bool empty() const noexcept
+        {
+            return _scheduling == realtime_scheduling::inherit && _cpu_mask == 0 && !_flush_denormals && !_lock_memory && _prefault_stack == 0;
+        }
+
+    private:
+        realtime_scheduling _scheduling;
+
+        int _priority;
+
+        std::uint64_t _cpu_mask;
+
+        bool _flush_denormals;
+
+        bool _lock_memory;
+
+        std::size_t _prefault_stack;
+    };
+
+    /*!
+     *\class realtime_status
+     *\brief what applying a realtime_policy actually did
+     *\note error fields hold the errno (GetLastError on windows) of a failed step, zero otherwise
+     *\note scheduling, priority and cpu_mask are read back from the system after the policy was applied
+     */
+    struct realtime_status
+    {
+        //false until a policy has been applied on the audio thread
+        bool applied = false;
+
+        realtime_result scheduling = realtime_result::not_requested;
+        int scheduling_error = 0;
+        //the class and priority the thread ended up with
+        realtime_scheduling scheduling_class = realtime_scheduling::inherit;
+        int priority = 0;
+
+        realtime_result affinity = realtime_result::not_requested;
+        int affinity_error = 0;
+        //the cpus the thread may run on, limited to the first 64
+        std::uint64_t cpu_mask = 0;
+
+        realtime_result denormals = realtime_result::not_requested;
+
+        realtime_result memory_lock = realtime_result::not_requested;
+        int memory_lock_error = 0;
+
+        realtime_result stack_prefault = realtime_result::not_requested;
+        std::size_t prefaulted_bytes = 0;
+
+        //true when every requested step was applied
+        bool complete() const noexcept
+        {
+            return applied &&
+                   scheduling != realtime_result::failed && scheduling != realtime_result::unsupported &&
+                   affinity != realtime_result::failed && affinity != realtime_result::unsupported &&
+                   denormals != realtime_result::failed && denormals != realtime_result::unsupported &&
+                   memory_lock != realtime_result::failed && memory_lock != realtime_result::unsupported &&
+                   stack_prefault != realtime_result::failed && stack_prefault != realtime_result::unsupported;
+        }
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, const realtime_status& status);
+
+    /*!
+     *\fn apply_realtime_policy
+     *\brief applies policy to the calling thread and reports the result of every step
+     *\note does not allocate, locking memory and prefaulting the stack can take a while so the first buffer pays for them
+     */
+    ZAUDIO_EXPORT realtime_status apply_realtime_policy(const realtime_policy& policy) noexcept;
+
+    /*!
+     *\fn make_realtime_policy
+     *\brief a policy suited to most audio threads: fifo scheduling at priority, flushed denormals, locked memory and 64k of prefaulted stack
+     */
+    inline realtime_policy make_realtime_policy(int priority = 70, std::uint64_t cpu_mask = 0) noexcept
+    {
+        realtime_policy policy;
+        policy.scheduling(realtime_scheduling::fifo);
+        policy.priority(priority);
+        policy.cpu_mask(cpu_mask);
+        policy.flush_denormals(true);
+        policy.lock_memory(true);
+        policy.prefault_stack(64 * 1024);
+        return policy;
+    }
+}
+
+#endif
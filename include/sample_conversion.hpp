@@ -0,0 +1,291 @@
+#ifndef ZAUDIO_SAMPLE_CONVERSION
+#define ZAUDIO_SAMPLE_CONVERSION
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "sample_utility.hpp"
+#include "simd_utility.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\struct dither_state
+     *\brief the noise generator state used for dithered conversions, one per stream
+     */
+    struct ZAUDIO_EXPORT dither_state
+    {
+        explicit dither_state(std::uint32_t seed = 0x9E3779B9u) noexcept;
+
+        //independent xorshift generators, one per vector lane for each of the two draws
+        std::uint32_t lanes[16];
+    };
+
+    /*
+     * Sample conversion kernels
+     * integer samples are treated as fixed point values in [-1,1), unsigned 8 bit samples are offset by 128
+     * conversions to an integer format round to nearest and saturate
+     * when a dither_state is given, tpdf noise of +/-1 lsb is added before rounding
+     * avx2 or sse2 kernels are selected at runtime, other platforms use a scalar loop
+     */
+
+    /*!
+     *\fn convert_samples
+     *\brief converts count samples from in to out
+     */
+    ZAUDIO_EXPORT void convert_samples(const float* in, float* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const float* in, double* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const float* in, std::int8_t* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const float* in, std::uint8_t* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const float* in, std::int16_t* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const float* in, std::int32_t* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+
+    ZAUDIO_EXPORT void convert_samples(const double* in, float* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const double* in, double* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const double* in, std::int8_t* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const double* in, std::uint8_t* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const double* in, std::int16_t* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const double* in, std::int32_t* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+
+    ZAUDIO_EXPORT void convert_samples(const std::int8_t* in, float* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const std::uint8_t* in, float* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const std::int16_t* in, float* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const std::int32_t* in, float* out, std::size_t count) noexcept;
+
+    ZAUDIO_EXPORT void convert_samples(const std::int8_t* in, double* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const std::uint8_t* in, double* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const std::int16_t* in, double* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const std::int32_t* in, double* out, std::size_t count) noexcept;
+
+    /*!
+     *\fn convert_samples
+     *\brief packed 24 bit conversions, int32 to 24 bit rounds to nearest even and saturates
+     */
+    ZAUDIO_EXPORT void convert_samples(const float* in, detail::s24* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const double* in, detail::s24* out, std::size_t count, dither_state* dither = nullptr) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const std::int32_t* in, detail::s24* out, std::size_t count) noexcept;
+
+    ZAUDIO_EXPORT void convert_samples(const detail::s24* in, float* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const detail::s24* in, double* out, std::size_t count) noexcept;
+    ZAUDIO_EXPORT void convert_samples(const detail::s24* in, std::int32_t* out, std::size_t count) noexcept;
+
+    /*!
+     *\namespace detail
+     *\brief
+     */
+    namespace detail
+    {
+        /*!
+         *\struct sample_scale
+         *\brief describes the fixed point interpretation of a sample type
+         */
+        template<typename T,bool = std::is_integral<T>::value>
+        struct sample_scale
+        {
+            constexpr static bool is_integer() noexcept
+            {
+                return false;
+            }
+
+            static double to_double(const T& value) noexcept
+            {
+                return static_cast<double>(value);
+            }
+
+            static T from_double(double value, dither_state*) noexcept
+            {
+                return static_cast<T>(value);
+            }
+        };
+
+        //scalar tpdf noise in the range [-1,1) lsb
+        inline double tpdf_noise(dither_state* dither) noexcept
+        {
+            if(dither == nullptr)
+            {
+                return 0.0;
+            }
+            auto&& s = dither->lanes[0];
+            s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+            auto&& a = static_cast<std::int32_t>(s);
+            auto&& t = dither->lanes[8];
+            t ^= t << 13; t ^= t >> 17; t ^= t << 5;
+            auto&& b = static_cast<std::int32_t>(t);
+            return (double(a) + double(b)) * (1.0 / 4294967296.0);
+        }
+
+        template<typename T>
+        struct sample_scale<T,true>
+        {
+            constexpr static bool is_integer() noexcept
+            {
+                return true;
+            }
+
+            //the value that represents 1.0
+            constexpr static double scale() noexcept
+            {
+                return std::is_signed<T>::value ? -double(std::numeric_limits<T>::min()) : (double(std::numeric_limits<T>::max()) + 1.0) / 2.0;
+            }
+
+            //unsigned formats are centered on scale()
+            constexpr static double offset() noexcept
+            {
+                return std::is_signed<T>::value ? 0.0 : scale();
+            }
+
+            static double to_double(const T& value) noexcept
+            {
+                return (double(value) - offset()) / scale();
+            }
+
+            static T from_double(double value, dither_state* dither) noexcept
+            {
+                value = std::nearbyint(value * scale() + tpdf_noise(dither)) + offset();
+                if(value >= double(std::numeric_limits<T>::max()))
+                {
+                    return std::numeric_limits<T>::max();
+                }
+                if(!(value > double(std::numeric_limits<T>::min())))
+                {
+                    return std::numeric_limits<T>::min();
+                }
+                return static_cast<T>(value);
+            }
+        };
+
+        //rounds and saturates a normalized value to a 24 bit integer
+        inline std::int32_t quantize_i24(double value, dither_state* dither) noexcept
+        {
+            value = std::nearbyint(value * 8388608.0 + tpdf_noise(dither));
+            return static_cast<std::int32_t>(value > 8388607.0 ? 8388607.0 : (value > -8388608.0 ? value : -8388608.0));
+        }
+
+        template<>
+        struct sample_scale<s24,false>
+        {
+            constexpr static bool is_integer() noexcept
+            {
+                return true;
+            }
+
+            static double to_double(const s24& value) noexcept
+            {
+                return int(value) / 8388608.0;
+            }
+
+            static s24 from_double(double value, dither_state* dither) noexcept
+            {
+                return s24(quantize_i24(value,dither));
+            }
+        };
+    }
+
+    /*!
+     *\fn convert_samples
+     *\brief scalar conversion for the pairs without a dedicated kernel
+     */
+    template<typename in_t,typename out_t>
+    void convert_samples(const in_t* in, out_t* out, std::size_t count, dither_state* dither = nullptr) noexcept
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = detail::sample_scale<out_t>::from_double(detail::sample_scale<in_t>::to_double(in[i]),dither);
+        }
+    }
+
+    /*!
+     *\struct sample_converter
+     *\brief converts between sample_t and a device format chosen at runtime
+     */
+    template<typename sample_t>
+    struct sample_converter
+    {
+        using to_device_type = void (*)(const sample_t*, void*, std::size_t, dither_state*);
+
+        using from_device_type = void (*)(const void*, sample_t*, std::size_t);
+
+        to_device_type to_device;
+
+        from_device_type from_device;
+    };
+
+    namespace detail
+    {
+        template<typename sample_t,typename device_t>
+        void to_device(const sample_t* in, void* out, std::size_t count, dither_state* dither) noexcept
+        {
+            convert_samples(in,static_cast<device_t*>(out),count,dither);
+        }
+
+        template<typename sample_t,typename device_t>
+        void from_device(const void* in, sample_t* out, std::size_t count) noexcept
+        {
+            convert_samples(static_cast<const device_t*>(in),out,count);
+        }
+
+        template<typename sample_t,typename device_t>
+        constexpr sample_converter<sample_t> make_converter() noexcept
+        {
+            return sample_converter<sample_t>{&to_device<sample_t,device_t>,&from_device<sample_t,device_t>};
+        }
+    }
+
+    /*!
+     *\fn make_sample_converter
+     *\brief selects the conversion functions between sample_t and device
+     */
+    template<typename sample_t>
+    sample_converter<sample_t> make_sample_converter(sample_format device) noexcept
+    {
+        switch(device)
+        {
+        case sample_format::f32:
+            return detail::make_converter<sample_t,float>();
+        case sample_format::f64:
+            return detail::make_converter<sample_t,double>();
+        case sample_format::i8:
+            return detail::make_converter<sample_t,std::int8_t>();
+        case sample_format::u8:
+            return detail::make_converter<sample_t,std::uint8_t>();
+        case sample_format::i16:
+            return detail::make_converter<sample_t,std::int16_t>();
+        case sample_format::i24:
+            return detail::make_converter<sample_t,detail::s24>();
+        case sample_format::i32:
+            return detail::make_converter<sample_t,std::int32_t>();
+        case sample_format::i64:
+            return detail::make_converter<sample_t,std::int64_t>();
+        default:
+            return sample_converter<sample_t>{nullptr,nullptr};
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef ZAUDIO_SAMPLE_RATE_CONVERTER
+#define ZAUDIO_SAMPLE_RATE_CONVERTER
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "buffer_view.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <ostream>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\enum resample_quality
+     *\brief the filter presets of sample_rate_converter, the passband edge is given for the lower of the two rates
+     */
+    enum class resample_quality
+    {
+        //24 taps, 60dB stopband, flat to 0.70 of nyquist
+        draft,
+        //48 taps, 90dB stopband, flat to 0.76 of nyquist
+        standard,
+        //96 taps, 110dB stopband, flat to 0.85 of nyquist
+        high,
+        //192 taps, 140dB stopband, flat to 0.90 of nyquist
+        best
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, resample_quality quality);
+
+    /*!
+     *\class sample_rate_converter
+     *\brief a streaming kaiser windowed sinc polyphase resampler for interleaved float frames
+     *\note when both rates are whole numbers whose reduced output side is at most max_rational_phases, every output frame uses one exact phase of the filter bank
+     *\note any other ratio interpolates linearly between the two nearest of a finer, fixed set of phases
+     *\note the filter bank and history are allocated by the constructor, process never allocates and is realtime safe
+     *\note the dot products run on avx2 and fma when the cpu has them and on sse2 otherwise, see examples/resampler_bench
+     *\note other sample types can go through convert_samples on either side, the filter runs in float either way
+     */
+    class ZAUDIO_EXPORT sample_rate_converter
+    {
+    public:
+        constexpr static std::size_t max_rational_phases = 1024;
+
+        //may throw std::bad_alloc, throws std::invalid_argument when a rate is not positive or channels is 0
+        //process takes at most max_frames input frames into the history at a time, it loops over longer blocks
+        sample_rate_converter(double input_rate,
+                              double output_rate,
+                              std::size_t channels,
+                              resample_quality quality = resample_quality::standard,
+                              std::size_t max_frames = 4096);
+
+        //converts until the input is used up or the output is full, returns {input frames consumed, output frames produced}
+        //input frames that cannot produce an output yet stay in the history for the next call
+        std::pair<std::size_t,std::size_t> process(const float* input, std::size_t input_frames, float* output, std::size_t output_frames) noexcept;
+
+        //both views must have channel_count() channels, otherwise nothing is converted
+        std::pair<std::size_t,std::size_t> process(buffer_view<float> input, buffer_view<float> output) noexcept;
+
+        //forget the history, the next output frame lines up with the next input frame
+        void reset() noexcept;
+
+        //input frames the filter looks ahead, the output is delayed by this many input frames
+        //feed latency() frames of silence after the last block to flush it
+        std::size_t latency() const noexcept;
+
+        //the output frames expected for input_frames more input frames, rounded up, a call may produce one less
+        std::size_t expected_output(std::size_t input_frames) const noexcept;
+
+        //the input frames needed before the next output_frames output frames can all be produced
+        std::size_t required_input(std::size_t output_frames) const noexcept;
+
+        double input_rate() const noexcept;
+
+        double output_rate() const noexcept;
+
+        std::size_t channel_count() const noexcept;
+
+        resample_quality quality() const noexcept;
+
+        //filter taps per phase
+        std::size_t taps() const noexcept;
+
+        //phases in the filter bank
+        std::size_t phases() const noexcept;
+
+        //true when each output uses one exact phase
+        bool rational() const noexcept;
+
+    private:
+        //may throw std::bad_alloc
+        void _design(double cutoff, double attenuation);
+
+        //writes up to frames output frames from the history, returns how many
+        std::size_t _produce(float* output, std::size_t frames) noexcept;
+
+        double _input_rate;
+
+        double _output_rate;
+
+        std::size_t _channels;
+
+        resample_quality _quality;
+
+        std::size_t _taps;
+
+        std::size_t _phases;
+
+        bool _rational;
+
+        //rational ratios advance _index by _step_frames and _phase by _step_phases per output frame
+        std::size_t _step_frames;
+
+        std::size_t _step_phases;
+
+        //any other ratio advances _index and _fraction by _step
+        double _step;
+
+        //phase p starts at p * _taps, there is one more phase than _phases so interpolation never wraps
+        std::vector<float> _filters;
+
+        //frames per channel of the planar history
+        std::size_t _capacity;
+
+        std::vector<float> _history;
+
+        //where the next input frame goes in each channel, refreshed by every process call
+        std::vector<float*> _planes;
+
+        std::size_t _filled;
+
+        //the first history frame under the filter for the next output
+        std::size_t _index;
+
+        std::size_t _phase;
+
+        double _fraction;
+    };
+}
+
+#endif
@@ -51,34 +51,63 @@ namespace zaudio
      */
     std::ostream& operator<<(std::ostream& os, sample_format format);
 
+    /*!
+     *\enum dither_mode
+     *\brief the dither applied when samples are converted to a narrower format
+     */
+    enum class dither_mode
+    {
+        none,
+        tpdf
+    };
+
+    /*!
+     *\enum buffer_layout
+     *\brief how the samples of a multichannel buffer are arranged
+     */
+    enum class buffer_layout
+    {
+        //one frame after another, channels alternate
+        interleaved,
+        //one contiguous run of samples per channel
+        planar
+    };
+
     /*!
      *\namespace detail
      *\brief
      */
     namespace detail
     {
-        #pragma pack(push)
-        //TODO: make me better
-
-
         /*!
          *\struct s24
-         *\brief represents a 24bit integer sample
+         *\brief represents a 24bit integer sample, stored as 3 little endian bytes with no padding
+         *\note arrays of s24 have the same layout as packed 24 bit device buffers
          */
         struct s24
         {
-            int value:3;
-            inline operator int()
+            s24() noexcept = default;
+
+            constexpr s24(int v) noexcept : bytes{static_cast<std::uint8_t>(v),
+                                                  static_cast<std::uint8_t>(v >> 8),
+                                                  static_cast<std::uint8_t>(v >> 16)}
+            {}
+
+            //sign extends from bit 23
+            constexpr operator int() const noexcept
             {
-                return value;
+                return static_cast<std::int32_t>((std::uint32_t(bytes[0]) << 8) | (std::uint32_t(bytes[1]) << 16) | (std::uint32_t(bytes[2]) << 24)) >> 8;
             }
-            inline s24& operator=(int v)
+
+            inline s24& operator=(int v) noexcept
             {
-                value = v;
-                return *this;
+                return *this = s24(v);
             }
+
+            std::uint8_t bytes[3];
         };
-        #pragma pack(pop)
+
+        static_assert(sizeof(s24) == 3,"s24 must be packed");
 
 
         /*!
@@ -0,0 +1,71 @@
+#ifndef ZAUDIO_SIMD_UTILITY
+#define ZAUDIO_SIMD_UTILITY
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+
+//ZAUDIO_X86 is defined when the sse2 baseline and the x86 intrinsic headers are available
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZAUDIO_X86 1
+#endif
+
+//functions marked with a target may use instructions beyond the baseline the library is compiled for
+//they must only be called after checking the matching cpu_has_* function
+#if defined(ZAUDIO_X86) && (defined(__GNUC__) || defined(__clang__))
+#define ZAUDIO_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define ZAUDIO_TARGET_AVX2 __attribute__((target("avx2")))
+#define ZAUDIO_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#else
+#define ZAUDIO_TARGET_SSSE3
+#define ZAUDIO_TARGET_AVX2
+#define ZAUDIO_TARGET_AVX2_FMA
+#endif
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\fn cpu_has_sse2
+     *\brief returns true if the sse2 kernels can be used on this machine
+     */
+    ZAUDIO_EXPORT bool cpu_has_sse2() noexcept;
+
+    /*!
+     *\fn cpu_has_ssse3
+     *\brief returns true if the ssse3 kernels can be used on this machine
+     */
+    ZAUDIO_EXPORT bool cpu_has_ssse3() noexcept;
+
+    /*!
+     *\fn cpu_has_avx2
+     *\brief returns true if the avx2 kernels can be used on this machine
+     */
+    ZAUDIO_EXPORT bool cpu_has_avx2() noexcept;
+
+    /*!
+     *\fn cpu_has_fma
+     *\brief returns true if the fma kernels can be used on this machine
+     */
+    ZAUDIO_EXPORT bool cpu_has_fma() noexcept;
+}
+
+#endif
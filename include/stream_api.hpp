@@ -27,11 +27,22 @@ This file is part of zaudio.
 #include "device_info.hpp"
 #include "stream_callback.hpp"
 #include "buffer_group.hpp"
+#include "error_dispatcher.hpp"
+#include "format_adapter.hpp"
+#include "block_adapter.hpp"
+#include "rate_adapter.hpp"
+#include "stream_timing.hpp"
+#include "xrun_monitor.hpp"
+#include "callback_timer.hpp"
+#include "stream_negotiation.hpp"
+#include "realtime_policy.hpp"
 
 #include <memory>
-#include <mutex>
 #include <tuple>
 #include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
 
 /*!
  *\namespace zaudio
@@ -53,10 +64,14 @@ namespace zaudio
 
             using callback = stream_callback<sample_t>;
 
+            using callback_ref = stream_callback_ref<sample_t>;
+
             using error_callback = stream_error_callback;
 
             stream_api() noexcept;
 
+            virtual ~stream_api() = default;
+
             std::size_t id() const noexcept;
 
             virtual std::string name() const noexcept = 0;
@@ -77,6 +92,21 @@ namespace zaudio
 
             virtual stream_error close_stream() noexcept = 0;
 
+            //opens the cheapest configuration from negotiation_candidates that the backend supports and rewrites params to it
+            //params must outlive the stream like for open_stream, on failure it is left as it was
+            //probes and the chosen plan are cached for every stream of the backend, opening the same params again goes straight to the remembered plan
+            stream_error open_negotiated(stream_params<sample_t>& params) noexcept;
+
+            //how the last open_negotiated call presents the requested params to the callback
+            const stream_plan& plan() const noexcept;
+
+            //forget every probe and plan, for when devices come and go
+            void clear_negotiation_cache() noexcept;
+
+            //a new stream on the same backend with its own callbacks, params and state, sharing the backend initialization and negotiation cache
+            //nullptr when the backend only runs one stream per instance, see _make_stream
+            std::unique_ptr<stream_api<sample_t>> make_stream() noexcept;
+
             virtual long get_device_count() noexcept = 0;
 
             virtual device_info get_device_info(long id) noexcept = 0;
@@ -89,29 +119,197 @@ namespace zaudio
 
             virtual double cpu_load() const noexcept = 0;
 
-            void set_callback(callback& cb) noexcept;
+            void set_callback(const callback_ref& cb) noexcept;
 
             void set_error_callback(error_callback& cb) noexcept;
 
-            std::timed_mutex& callback_mutex() noexcept;
+            //publish a new callback, returns the previous one once the audio thread can no longer be using it
+            //never blocks the audio thread, the calling thread waits for at most one buffer
+            const callback_ref* exchange_callback(const callback_ref& cb) noexcept;
+
+            error_callback* exchange_error_callback(error_callback& cb) noexcept;
+
+            //stop using the published callbacks, call once the stream is closed and before they are destroyed
+            void release_callbacks() noexcept;
+
+            //errors that were discarded because the error queue was full
+            std::size_t dropped_error_count() const noexcept;
+
+            //errors that were folded into an identical error that was still waiting to be delivered
+            std::size_t coalesced_error_count() const noexcept;
+
+            //what the realtime policy of the stream did to the audio thread, applied is false until the first callback after start
+            zaudio::realtime_status realtime_status() const noexcept;
+
+            //blocking streams only, see stream_mode
+            //writes every frame of frames, waiting for the device to make room as needed
+            stream_error write(buffer_view<sample_t> frames) noexcept;
+
+            //fills every frame of frames, waiting for the device to capture them as needed
+            stream_error read(buffer_view<sample_t> frames) noexcept;
+
+            //frames that can be written or read right now without waiting, negative if the backend cannot tell
+            virtual long write_available() noexcept;
+
+            virtual long read_available() noexcept;
+
+            //frames of delay the block fifo adds between the callback output and the device, 0 when params.block_size() needs no fifo
+            std::size_t block_latency() const noexcept;
+
+            //the latencies and sample rate the device settled on, zero until a stream is open
+            const zaudio::stream_info& stream_info() const noexcept;
+
+            //device frames processed since the stream last started, safe to read from any thread
+            std::uint64_t frame_position() const noexcept;
+
+            //underflows and overflows the backend reported since the api was created or reset_xruns, safe to read from any thread
+            xrun_statistics xruns() const noexcept;
+
+            void reset_xruns() noexcept;
+
+            //processing time percentiles and the worst deadline margin of every device buffer, safe to read from any thread
+            //unlike cpu_load() nothing is smoothed, a single late buffer shows up in max, worst_margin and overruns
+            zaudio::callback_statistics callback_statistics() const noexcept;
+
+            //the counters restart from the next buffer
+            void reset_callback_statistics() noexcept;
         protected:
 
-            callback* _callback;
+            std::atomic<const callback_ref*> _callback;
+
+            std::atomic<error_callback*> _error_callback;
 
-            error_callback* _error_callback;
+            //errors from the audio thread are queued here and delivered to _error_callback on another thread
+            stream_error_dispatcher _errors;
 
             stream_params<sample_t>* _params;
 
-            std::timed_mutex _callback_mutex;
+            //incremented on entry to and exit from a device buffer, odd while one is being processed
+            std::atomic<std::size_t> _process_epoch;
+
+            //converts between the device format and sample_t around _on_process
+            format_adapter<sample_t> _format;
+
+            //resamples the converted buffers when the device runs at another rate than the stream, see stream_params::device_sample_rate
+            rate_adapter<sample_t> _rates;
+
+            //regroups the converted buffers into blocks of params.block_size() frames before _invoke
+            block_adapter<sample_t> _blocks;
+
+            //backends fill this in when open_stream succeeds and clear it in close_stream
+            zaudio::stream_info _info;
+
+            //true while open_negotiated tries candidates, a failed candidate is not worth reporting
+            bool _negotiating;
+
+            //calls the error callback on this thread, for failures of calls made from the thread that controls the stream
+            //nothing is reported while negotiating, open_negotiated reports its own failure once
+            void _report_error(const stream_error& err) noexcept;
+
+            //frames is at most _params->frame_count(), call is the published callback or the callable it refers to
+            template<typename F>
+            stream_error _on_process(const sample_t*,sample_t*,std::size_t frames,const stream_timing& timing,F& call) noexcept;
+
+            //planar buffers, one pointer per channel
+            template<typename F>
+            stream_error _on_process(const sample_t* const*,sample_t* const*,std::size_t frames,const stream_timing& timing,F& call) noexcept;
+
+            //buffers at the stream rate, after _rates
+            template<typename F>
+            stream_error _on_blocks(const sample_t*,sample_t*,std::size_t frames,const stream_timing& timing,F& call) noexcept;
+
+            template<typename F>
+            stream_error _on_blocks(const sample_t* const*,sample_t* const*,std::size_t frames,const stream_timing& timing,F& call) noexcept;
+
+            //entry point for backends that exchange buffers in _format.device_format()
+            //when _format.device_layout() is planar, input and output point to arrays of one pointer per channel
+            //frames is the size of this buffer, anything above _params->frame_count() is processed in pieces so nothing is allocated
+            //timing comes from _callback_timing, with whatever times the backend knows better filled in
+            //flags are the conditions the backend raised for this buffer, they are counted and reported when _params->report_xruns()
+            stream_error _on_process_device(const void*,void*,std::size_t frames,const stream_timing& timing,xrun_flags flags = xrun_flags::none) noexcept;
+
+            //the timing of a buffer of frames frames handed over now
+            //without device times the input is assumed to have been captured over the last buffer period and the output to play after the next one
+            stream_timing _callback_timing(std::size_t frames) const noexcept;
+
+            void _wait_for_process_boundary() const noexcept;
+
+            //backends call this before the audio thread starts, the next callback applies _params->realtime_policy()
+            void _prepare_realtime() noexcept;
+
+            //backends call this from start(), rewinds the frame position and block fifo and prepares the realtime policy
+            void _prepare_start() noexcept;
+
+            //backends call this from open_stream, allocates the conversion buffer of a blocking stream
+            stream_error _prepare_blocking() noexcept;
 
-            stream_error _on_process(const sample_t*,sample_t*) noexcept;
+            //blocking transfers of interleaved frames in _format.device_format(), frames is at most _params->frame_count() when converting
+            virtual stream_error _write_device(const void* buffer, std::size_t frames) noexcept;
+
+            virtual stream_error _read_device(void* buffer, std::size_t frames) noexcept;
+
+            //backends that can run more than one stream return a fresh instance that shares whatever they initialized once
+            //a subclass that changes how the backend behaves overrides it too, or its extra streams are the plain backend
+            virtual std::unique_ptr<stream_api<sample_t>> _make_stream() noexcept;
+
+        private:
+            template<typename,typename>
+            friend struct detail::stream_callback_dispatch;
+
+            template<typename F>
+            stream_error _invoke(buffer_group<sample_t>& buffers,F& call) noexcept;
+
+            //a whole device buffer of any size, instantiated for each callable type through stream_callback_dispatch
+            template<typename F>
+            stream_error _process_frames(const void*,void*,std::size_t frames,const stream_timing& timing,F& call) noexcept;
+
+            //one buffer of at most _params->frame_count() frames
+            template<typename F>
+            stream_error _process_device(const void*,void*,std::size_t frames,const stream_timing& timing,F& call) noexcept;
+
+            //only the audio thread writes it
+            std::atomic<std::uint64_t> _frame_position;
+
+            //shared with every stream made from this one, created on first use
+            std::shared_ptr<detail::negotiation_cache<sample_t>> _negotiation;
+
+            stream_plan _plan;
+
+            //may throw std::bad_alloc
+            detail::negotiation_cache<sample_t>& _negotiation_cache();
+
+            bool _probe(detail::negotiation_cache<sample_t>& cache, const stream_params<sample_t>& params, std::size_t& probes);
+
+            stream_error _negotiate(stream_params<sample_t>& params) noexcept;
+
+            xrun_monitor _xruns;
+
+            callback_timer _timer;
+
+            void _apply_realtime() noexcept;
+
+            //only the audio thread writes the status, it is published through _realtime_ready
+            zaudio::realtime_status _realtime_status;
+
+            std::atomic<bool> _realtime_pending;
+
+            std::atomic<bool> _realtime_ready;
+
+            //one buffer of frame_count frames in the device format, only used by blocking streams that convert
+            std::vector<unsigned char> _blocking_buffer;
 
         };
 
         template<typename sample_t>
         stream_api<sample_t>::stream_api() noexcept: _callback(nullptr),
                                                      _error_callback(nullptr),
-                                                     _params(nullptr){}
+                                                     _errors(_error_callback),
+                                                     _params(nullptr),
+                                                     _process_epoch(0),
+                                                     _negotiating(false),
+                                                     _frame_position(0),
+                                                     _realtime_pending(false),
+                                                     _realtime_ready(false){}
 
         //id will be assigned based on std::hash<std::string> of name()
         //aka: unique name = unique id
@@ -122,54 +320,581 @@ namespace zaudio
         }
 
         template<typename sample_t>
-        void stream_api<sample_t>::set_callback(callback& cb) noexcept
+        void stream_api<sample_t>::set_callback(const callback_ref& cb) noexcept
         {
-            _callback = &cb;
+            _callback.store(&cb);
         }
 
         template<typename sample_t>
         void stream_api<sample_t>::set_error_callback(error_callback&cb) noexcept
         {
-            _error_callback = &cb;
+            _error_callback.store(&cb);
+            _errors.start();
+        }
+
+        template<typename sample_t>
+        const typename stream_api<sample_t>::callback_ref* stream_api<sample_t>::exchange_callback(const callback_ref& cb) noexcept
+        {
+            auto&& old = _callback.exchange(&cb);
+            _wait_for_process_boundary();
+            return old;
+        }
+
+        template<typename sample_t>
+        typename stream_api<sample_t>::error_callback* stream_api<sample_t>::exchange_error_callback(error_callback& cb) noexcept
+        {
+            auto&& old = _error_callback.exchange(&cb);
+            _errors.wait_for_delivery_boundary();
+            return old;
+        }
+
+        template<typename sample_t>
+        void stream_api<sample_t>::release_callbacks() noexcept
+        {
+            _callback.exchange(nullptr);
+            _wait_for_process_boundary();
+            _errors.flush();
+            _error_callback.exchange(nullptr);
+            _errors.wait_for_delivery_boundary();
+        }
+
+        template<typename sample_t>
+        std::size_t stream_api<sample_t>::dropped_error_count() const noexcept
+        {
+            return _errors.dropped_error_count();
+        }
+
+        template<typename sample_t>
+        std::size_t stream_api<sample_t>::coalesced_error_count() const noexcept
+        {
+            return _errors.coalesced_error_count();
+        }
+
+        template<typename sample_t>
+        zaudio::realtime_status stream_api<sample_t>::realtime_status() const noexcept
+        {
+            return _realtime_ready.load(std::memory_order_acquire) ? _realtime_status : zaudio::realtime_status{};
+        }
+
+        template<typename sample_t>
+        void stream_api<sample_t>::_prepare_realtime() noexcept
+        {
+            _realtime_ready.store(false);
+            _realtime_pending.store(_params != nullptr);
+        }
+
+        //runs on the audio thread, a new thread is created on every start so the policy is applied again each time
+        template<typename sample_t>
+        void stream_api<sample_t>::_apply_realtime() noexcept
+        {
+            _realtime_status = apply_realtime_policy(_params->realtime_policy());
+            _realtime_pending.store(false,std::memory_order_relaxed);
+            _realtime_ready.store(true,std::memory_order_release);
+        }
+
+        template<typename sample_t>
+        stream_error stream_api<sample_t>::write(buffer_view<sample_t> frames) noexcept
+        {
+            if(_params == nullptr || _params->mode() != stream_mode::blocking)
+            {
+                return make_stream_error(stream_status::user_error,"The stream is not open in blocking mode.");
+            }
+            auto&& width = _params->output_frame_width();
+            if(frames.frame_width() != width)
+            {
+                return make_stream_error(stream_status::user_error,"The buffer does not have one sample per output channel.");
+            }
+            //no conversion needed, the device reads straight from the caller's buffer
+            if(!_format.active())
+            {
+                return _write_device(frames.data(),frames.frame_count());
+            }
+            auto&& chunk = _params->frame_count();
+            for(std::size_t done = 0; done < frames.frame_count(); done += chunk)
+            {
+                const std::size_t count = std::min(chunk,frames.frame_count() - done);
+                _format.to_device(frames.data() + done * width,_blocking_buffer.data(),count * width);
+                auto&& ret = _write_device(_blocking_buffer.data(),count);
+                if(ret != no_error)
+                {
+                    return ret;
+                }
+            }
+            return no_error;
+        }
+
+        template<typename sample_t>
+        stream_error stream_api<sample_t>::read(buffer_view<sample_t> frames) noexcept
+        {
+            if(_params == nullptr || _params->mode() != stream_mode::blocking)
+            {
+                return make_stream_error(stream_status::user_error,"The stream is not open in blocking mode.");
+            }
+            auto&& width = _params->input_frame_width();
+            if(frames.frame_width() != width)
+            {
+                return make_stream_error(stream_status::user_error,"The buffer does not have one sample per input channel.");
+            }
+            if(!_format.active())
+            {
+                return _read_device(frames.data(),frames.frame_count());
+            }
+            auto&& chunk = _params->frame_count();
+            for(std::size_t done = 0; done < frames.frame_count(); done += chunk)
+            {
+                const std::size_t count = std::min(chunk,frames.frame_count() - done);
+                auto&& ret = _read_device(_blocking_buffer.data(),count);
+                if(ret != no_error)
+                {
+                    return ret;
+                }
+                _format.from_device(_blocking_buffer.data(),frames.data() + done * width,count * width);
+            }
+            return no_error;
+        }
+
+        template<typename sample_t>
+        long stream_api<sample_t>::write_available() noexcept
+        {
+            return -1;
+        }
+
+        template<typename sample_t>
+        long stream_api<sample_t>::read_available() noexcept
+        {
+            return -1;
+        }
+
+        template<typename sample_t>
+        std::size_t stream_api<sample_t>::block_latency() const noexcept
+        {
+            return _blocks.latency();
+        }
+
+        template<typename sample_t>
+        stream_error stream_api<sample_t>::open_negotiated(stream_params<sample_t>& params) noexcept
+        {
+            _negotiating = true;
+            auto&& ret = _negotiate(params);
+            _negotiating = false;
+            if(ret != no_error)
+            {
+                _report_error(ret);
+            }
+            return ret;
+        }
+
+        template<typename sample_t>
+        stream_error stream_api<sample_t>::_negotiate(stream_params<sample_t>& params) noexcept
+        {
+            const stream_params<sample_t> requested = params;
+            std::size_t probes = 0;
+            try
+            {
+                auto&& cache = _negotiation_cache();
+                auto&& key = make_negotiation_key(requested);
+                stream_params<sample_t> remembered;
+                bool known = false;
+                {
+                    std::lock_guard<std::mutex> guard(cache.lock);
+                    auto&& found = cache.plans.find(key);
+                    if(found != cache.plans.end())
+                    {
+                        remembered = found->second;
+                        known = true;
+                    }
+                }
+                if(known)
+                {
+                    params = remembered;
+                    if(open_stream(params) == no_error)
+                    {
+                        _plan = make_stream_plan(requested,params,0,true);
+                        _plan.resample_latency = _rates.active() ? _rates.latency() : 0;
+                        return no_error;
+                    }
+                    //the device changed since, search again
+                    std::lock_guard<std::mutex> guard(cache.lock);
+                    cache.plans.erase(key);
+                    cache.probes.erase(make_negotiation_key(remembered));
+                }
+                //a direction the stream does not use may have no device at all, a headless server has no capture device
+                device_info in;
+                device_info out;
+                if(requested.input_frame_width() != 0)
+                {
+                    in = get_device_info(requested.input_device_id() < 0 ? default_input_device_id() : requested.input_device_id());
+                }
+                if(requested.output_frame_width() != 0)
+                {
+                    out = get_device_info(requested.output_device_id() < 0 ? default_output_device_id() : requested.output_device_id());
+                }
+                for(auto&& candidate: negotiation_candidates(requested,in,out))
+                {
+                    if(!_probe(cache,candidate,probes))
+                    {
+                        continue;
+                    }
+                    params = candidate;
+                    if(open_stream(params) == no_error)
+                    {
+                        std::lock_guard<std::mutex> guard(cache.lock);
+                        cache.plans[key] = params;
+                        _plan = make_stream_plan(requested,params,probes,false);
+                        _plan.resample_latency = _rates.active() ? _rates.latency() : 0;
+                        return no_error;
+                    }
+                    //the format was fine but the buffer size or latency was not
+                    std::lock_guard<std::mutex> guard(cache.lock);
+                    cache.probes[make_negotiation_key(candidate)] = false;
+                }
+            }
+            catch(const std::bad_alloc&)
+            {
+                params = requested;
+                return make_stream_error(stream_status::system_error,"Unable to allocate the negotiation cache.");
+            }
+            params = requested;
+            return make_stream_error(stream_status::system_error,"No supported configuration near the requested one.");
+        }
+
+        template<typename sample_t>
+        void stream_api<sample_t>::_report_error(const stream_error& err) noexcept
+        {
+            auto&& cb = _error_callback.load();
+            if(!_negotiating && cb != nullptr && *cb)
+            {
+                (*cb)(err);
+            }
+        }
+
+        template<typename sample_t>
+        const stream_plan& stream_api<sample_t>::plan() const noexcept
+        {
+            return _plan;
+        }
+
+        template<typename sample_t>
+        void stream_api<sample_t>::clear_negotiation_cache() noexcept
+        {
+            if(_negotiation != nullptr)
+            {
+                std::lock_guard<std::mutex> guard(_negotiation->lock);
+                _negotiation->probes.clear();
+                _negotiation->plans.clear();
+            }
+        }
+
+        template<typename sample_t>
+        std::unique_ptr<stream_api<sample_t>> stream_api<sample_t>::make_stream() noexcept
+        {
+            std::unique_ptr<stream_api<sample_t>> stream = _make_stream();
+            if(stream != nullptr)
+            {
+                try
+                {
+                    _negotiation_cache();
+                    stream->_negotiation = _negotiation;
+                }
+                catch(const std::bad_alloc&)
+                {
+                    //the new stream keeps a cache of its own
+                }
+            }
+            return stream;
+        }
+
+        template<typename sample_t>
+        std::unique_ptr<stream_api<sample_t>> stream_api<sample_t>::_make_stream() noexcept
+        {
+            return nullptr;
+        }
+
+        template<typename sample_t>
+        detail::negotiation_cache<sample_t>& stream_api<sample_t>::_negotiation_cache()
+        {
+            if(_negotiation == nullptr)
+            {
+                _negotiation = std::make_shared<detail::negotiation_cache<sample_t>>();
+            }
+            return *_negotiation;
+        }
+
+        //may throw std::bad_alloc
+        template<typename sample_t>
+        bool stream_api<sample_t>::_probe(detail::negotiation_cache<sample_t>& cache, const stream_params<sample_t>& params, std::size_t& probes)
+        {
+            auto&& key = make_negotiation_key(params);
+            {
+                std::lock_guard<std::mutex> guard(cache.lock);
+                auto&& known = cache.probes.find(key);
+                if(known != cache.probes.end())
+                {
+                    return known->second;
+                }
+            }
+            ++probes;
+            const bool supported = is_configuration_supported(params) == no_error;
+            std::lock_guard<std::mutex> guard(cache.lock);
+            cache.probes.emplace(key,supported);
+            return supported;
+        }
+
+        template<typename sample_t>
+        const zaudio::stream_info& stream_api<sample_t>::stream_info() const noexcept
+        {
+            return _info;
+        }
+
+        template<typename sample_t>
+        std::uint64_t stream_api<sample_t>::frame_position() const noexcept
+        {
+            return _frame_position.load(std::memory_order_relaxed);
         }
 
         template<typename sample_t>
-        std::timed_mutex& stream_api<sample_t>::callback_mutex() noexcept
+        xrun_statistics stream_api<sample_t>::xruns() const noexcept
         {
-            return _callback_mutex;
+            return _xruns.statistics();
         }
 
         template<typename sample_t>
-        stream_error stream_api<sample_t>::_on_process(const sample_t* input, sample_t* output) noexcept
+        void stream_api<sample_t>::reset_xruns() noexcept
+        {
+            _xruns.reset();
+        }
+
+        template<typename sample_t>
+        zaudio::callback_statistics stream_api<sample_t>::callback_statistics() const noexcept
+        {
+            return _timer.statistics();
+        }
+
+        template<typename sample_t>
+        void stream_api<sample_t>::reset_callback_statistics() noexcept
+        {
+            _timer.reset();
+        }
+
+        template<typename sample_t>
+        void stream_api<sample_t>::_prepare_start() noexcept
+        {
+            _prepare_realtime();
+            //a restarted stream does not replay the partial block and queued output of the last run
+            _rates.reset();
+            _blocks.reset();
+            _frame_position.store(0);
+        }
+
+        template<typename sample_t>
+        stream_timing stream_api<sample_t>::_callback_timing(std::size_t frames) const noexcept
+        {
+            stream_timing timing;
+            timing.callback_time = audio_clock::now();
+            timing.sample_rate = _params->device_sample_rate();
+            timing.frame_position = _frame_position.load(std::memory_order_relaxed);
+            auto&& period = std::chrono::duration_cast<typename audio_clock::duration>(duration(frames / timing.sample_rate));
+            timing.input_time = timing.callback_time - period;
+            timing.output_time = timing.callback_time + period;
+            return timing;
+        }
+
+        template<typename sample_t>
+        stream_error stream_api<sample_t>::_prepare_blocking() noexcept
         {
             try
             {
-                std::unique_lock<std::timed_mutex> lk{ _callback_mutex, std::defer_lock };
-                //the only reason we should not get this lock every time is in the case of a user callback swap
-                while(!lk.try_lock()){ continue; }
+                if(_params != nullptr && _params->mode() == stream_mode::blocking && _format.active())
+                {
+                    const std::size_t width = std::max(_params->input_frame_width(),_params->output_frame_width());
+                    _blocking_buffer.assign(_params->frame_count() * width * sample_size(_format.device_format()),0);
+                }
+                else
+                {
+                    _blocking_buffer.clear();
+                }
+            }
+            catch(const std::bad_alloc&)
+            {
+                return make_stream_error(stream_status::system_error,"Unable to allocate stream buffers.");
+            }
+            return no_error;
+        }
+
+        template<typename sample_t>
+        stream_error stream_api<sample_t>::_write_device(const void*, std::size_t) noexcept
+        {
+            return make_stream_error(stream_status::system_error,"This stream api does not support blocking streams.");
+        }
+
+        template<typename sample_t>
+        stream_error stream_api<sample_t>::_read_device(void*, std::size_t) noexcept
+        {
+            return make_stream_error(stream_status::system_error,"This stream api does not support blocking streams.");
+        }
 
-                buffer_group<sample_t> buffers{buffer_view<sample_t>{input,_params->frame_count(),_params->input_frame_width()},
-                                               buffer_view<sample_t>{output,_params->frame_count(),_params->output_frame_width()}};
+        //called after a new callback is published
+        //any _on_process_device that starts from here on sees the new pointer, so we only need to wait out one that is in flight
+        template<typename sample_t>
+        void stream_api<sample_t>::_wait_for_process_boundary() const noexcept
+        {
+            auto&& epoch = _process_epoch.load();
+            if(epoch % 2 != 0)
+            {
+                while(_process_epoch.load(std::memory_order_acquire) == epoch){ std::this_thread::yield(); }
+            }
+        }
 
-                auto&& ret = (*_callback)(buffers,audio_clock::now(),*_params);
+        template<typename sample_t>
+        template<typename F>
+        stream_error stream_api<sample_t>::_on_process(const sample_t* input, sample_t* output, std::size_t frames, const stream_timing& timing, F& call) noexcept
+        {
+            if(_rates.active())
+            {
+                return _rates.process(input,output,frames,timing,[this,&call](const sample_t* in, sample_t* out, std::size_t count, const stream_timing& t){ return _on_blocks(in,out,count,t,call); });
+            }
+            return _on_blocks(input,output,frames,timing,call);
+        }
+
+        template<typename sample_t>
+        template<typename F>
+        stream_error stream_api<sample_t>::_on_process(const sample_t* const* input, sample_t* const* output, std::size_t frames, const stream_timing& timing, F& call) noexcept
+        {
+            if(_rates.active())
+            {
+                return _rates.process(input,output,frames,timing,[this,&call](const sample_t* const* in, sample_t* const* out, std::size_t count, const stream_timing& t){ return _on_blocks(in,out,count,t,call); });
+            }
+            return _on_blocks(input,output,frames,timing,call);
+        }
+
+        template<typename sample_t>
+        template<typename F>
+        stream_error stream_api<sample_t>::_on_blocks(const sample_t* input, sample_t* output, std::size_t frames, const stream_timing& timing, F& call) noexcept
+        {
+            if(_blocks.active())
+            {
+                return _blocks.process(input,output,frames,timing,[this,&call](buffer_group<sample_t>& buffers){ return _invoke(buffers,call); });
+            }
+            buffer_group<sample_t> buffers{buffer_view<sample_t>{input,frames,_params->input_frame_width()},
+                                           buffer_view<sample_t>{output,frames,_params->output_frame_width()}};
+            buffers.timing = timing;
+            return _invoke(buffers,call);
+        }
+
+        template<typename sample_t>
+        template<typename F>
+        stream_error stream_api<sample_t>::_on_blocks(const sample_t* const* input, sample_t* const* output, std::size_t frames, const stream_timing& timing, F& call) noexcept
+        {
+            if(_blocks.active())
+            {
+                return _blocks.process(input,output,frames,timing,[this,&call](buffer_group<sample_t>& buffers){ return _invoke(buffers,call); });
+            }
+            buffer_group<sample_t> buffers{planar_view<sample_t>{input,frames,input == nullptr ? 0 : _params->input_frame_width()},
+                                           planar_view<sample_t>{output,frames,output == nullptr ? 0 : _params->output_frame_width()}};
+            buffers.timing = timing;
+            return _invoke(buffers,call);
+        }
+
+        template<typename sample_t>
+        template<typename F>
+        stream_error stream_api<sample_t>::_invoke(buffer_group<sample_t>& buffers, F& call) noexcept
+        {
+            stream_error ret = no_error;
+            try
+            {
+                ret = call(buffers,buffers.timing.callback_time,*_params);
                 if(ret != no_error)
                 {
-                    throw stream_exception(ret);
+                    _errors.report(ret);
                 }
-                return ret;
             }
+            //errors are only queued here, the error callback runs on the dispatcher thread
+            //messages are copied by report so they can be taken from the exception before it goes away
             catch(const stream_exception& e)
             {
-                auto&& err = e.error();
-                (*_error_callback)(err);
-                return err;
+                _errors.report(e.error());
+                ret = make_stream_error(e.error().first,"stream callback threw a stream_exception");
             }
             catch (const std::exception& e)
             {
-                auto&& err = make_stream_error(stream_status::system_error,e.what());
-                (*_error_callback)(err);
-                return err;
+                _errors.report(make_stream_error(stream_status::system_error,e.what()));
+                ret = make_stream_error(stream_status::system_error,"stream callback threw an exception");
+            }
+            return ret;
+        }
+
+        template<typename sample_t>
+        stream_error stream_api<sample_t>::_on_process_device(const void* input, void* output, std::size_t frames, const stream_timing& timing, xrun_flags flags) noexcept
+        {
+            if(_realtime_pending.load(std::memory_order_relaxed))
+            {
+                _apply_realtime();
+            }
+            if(flags != xrun_flags::none)
+            {
+                auto&& xrun = _xruns.record(flags,timing);
+                if(xrun != no_error && _params->report_xruns())
+                {
+                    _errors.report(xrun);
+                }
+            }
+            //enter before loading the callback so a concurrent exchange knows to wait for us
+            _process_epoch.fetch_add(1);
+            auto&& cb = _callback.load();
+            //the one indirect call of the buffer, from here on the callable type is known
+            auto&& ret = cb->process != nullptr ? cb->process(*this,input,output,frames,timing,cb->object) : _process_frames(input,output,frames,timing,*cb);
+            _process_epoch.fetch_add(1,std::memory_order_release);
+            _frame_position.store(timing.frame_position + frames,std::memory_order_relaxed);
+            //callback_time was taken on entry, so this is the only extra clock reading
+            auto&& elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(audio_clock::now() - timing.callback_time).count();
+            _timer.record(static_cast<std::uint64_t>(elapsed < 0 ? 0 : elapsed),static_cast<std::uint64_t>(frames * 1e9 / timing.sample_rate));
+            return ret;
+        }
+
+        template<typename sample_t>
+        template<typename F>
+        stream_error stream_api<sample_t>::_process_frames(const void* input, void* output, std::size_t frames, const stream_timing& timing, F& call) noexcept
+        {
+            auto&& limit = _params->frame_count();
+            if(frames <= limit)
+            {
+                return _process_device(input,output,frames,timing,call);
+            }
+            //the host handed over more than the scratch buffers were sized for
+            stream_error ret = no_error;
+            for(std::size_t done = 0; done < frames && ret == no_error; done += limit)
+            {
+                const std::size_t count = std::min(limit,frames - done);
+                ret = _process_device(_format.device_input_at(input,done),_format.device_output_at(output,done),count,timing.advanced(static_cast<std::int64_t>(done)),call);
             }
+            return ret;
+        }
+
+        template<typename sample_t>
+        template<typename F>
+        stream_error stream_api<sample_t>::_process_device(const void* input, void* output, std::size_t frames, const stream_timing& timing, F& call) noexcept
+        {
+            if(_format.layout() == buffer_layout::planar)
+            {
+                auto&& ret = _on_process(_format.planar_input(input,frames),_format.planar_output(output),frames,timing,call);
+                _format.commit_planar_output(output,frames);
+                return ret;
+            }
+            auto&& ret = _on_process(_format.input(input,frames),_format.output(output),frames,timing,call);
+            _format.commit_output(output,frames);
+            return ret;
+        }
+
+        namespace detail
+        {
+            template<typename sample_t,typename F>
+            struct stream_callback_dispatch
+            {
+                static stream_error process(stream_api<sample_t>& api, const void* input, void* output, std::size_t frames, const stream_timing& timing, void* object) noexcept
+                {
+                    return api._process_frames(input,output,frames,timing,*static_cast<F*>(object));
+                }
+            };
         }
 
 
@@ -17,12 +17,25 @@ This file is part of zaudio.
     along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <functional>
+#include <type_traits>
+#include <utility>
 #include "stream_params.hpp"
 #include "time_utility.hpp"
 #include "buffer_group.hpp"
+#include "buffer_algorithm.hpp"
 #include "error_utility.hpp"
 namespace zaudio
 {
+    template<typename sample_t>
+    class stream_api;
+
+    namespace detail
+    {
+        //defined in stream_api.hpp, processes one device buffer with the callable type known
+        template<typename sample_t,typename F>
+        struct stream_callback_dispatch;
+    }
+
     /*!
      *\typedef stream_callback
      *\brief a function object type that represents an audio stream callback function
@@ -32,16 +45,122 @@ namespace zaudio
                                                          time_point,
                                                          stream_params<sample_t>&)>;
 
+    /*!
+     *\struct stream_callback_ref
+     *\brief a non owning, statically dispatched reference to a stream callback
+     *\note process runs a whole device buffer in a stream_api instantiated for the exact callable type, every call to the callable in it is resolved statically and can be inlined
+     *\note a ref built by hand may leave process null, the stream_api then calls invoke for every block instead
+     */
+    template<typename sample_t>
+    struct stream_callback_ref
+    {
+        using invoke_type = stream_error (*)(void*,
+                                             buffer_group<sample_t>&,
+                                             time_point,
+                                             stream_params<sample_t>&);
+
+        using process_type = stream_error (*)(stream_api<sample_t>&,
+                                              const void*,
+                                              void*,
+                                              std::size_t,
+                                              const stream_timing&,
+                                              void*);
+
+        invoke_type invoke;
+
+        void* object;
+
+        process_type process;
+
+        stream_error operator()(buffer_group<sample_t>& buffers, time_point tp, stream_params<sample_t>& params) const
+        {
+            return invoke(object,buffers,tp,params);
+        }
+    };
+
+    namespace detail
+    {
+        /*!
+         *\struct is_stream_callable
+         *\brief tests if F can be called like a stream_callback
+         */
+        template<typename sample_t,typename F,typename = void>
+        struct is_stream_callable : std::false_type
+        {};
+
+        template<typename sample_t,typename F>
+        struct is_stream_callable<sample_t,F,typename std::enable_if<std::is_convertible<decltype(std::declval<typename std::decay<F>::type&>()(std::declval<buffer_group<sample_t>&>(),
+                                                                                                                                                 std::declval<time_point>(),
+                                                                                                                                                 std::declval<stream_params<sample_t>&>())),
+                                                                                              stream_error>::value>::type> : std::true_type
+        {};
+
+        template<typename sample_t,typename F>
+        stream_error invoke_stream_callback(void* object,
+                                            buffer_group<sample_t>& buffers,
+                                            time_point tp,
+                                            stream_params<sample_t>& params)
+        {
+            return (*static_cast<F*>(object))(buffers,tp,params);
+        }
+
+        /*!
+         *\struct callback_holder
+         *\brief owns a callable of any type and exposes it as a stream_callback_ref
+         */
+        template<typename sample_t>
+        struct callback_holder
+        {
+            virtual ~callback_holder() = default;
+
+            //move the held callable out as a type erased stream_callback
+            virtual stream_callback<sample_t> release() = 0;
+
+            stream_callback_ref<sample_t> ref;
+        };
+
+        template<typename sample_t,typename F>
+        struct callback_holder_impl : callback_holder<sample_t>
+        {
+            template<typename T>
+            explicit callback_holder_impl(T&& f) : fn(std::forward<T>(f))
+            {
+                this->ref = stream_callback_ref<sample_t>{&invoke_stream_callback<sample_t,F>,&fn,&stream_callback_dispatch<sample_t,F>::process};
+            }
+
+            virtual stream_callback<sample_t> release()
+            {
+                return stream_callback<sample_t>(std::move(fn));
+            }
+
+            F fn;
+        };
+
+        /*!
+         *\fn make_callback_holder
+         *\brief constructs a callback_holder that owns a decayed copy of f
+         */
+        template<typename sample_t,typename F>
+        callback_holder<sample_t>* make_callback_holder(F&& f)
+        {
+            return new callback_holder_impl<sample_t,typename std::decay<F>::type>(std::forward<F>(f));
+        }
+    }
+
     template<typename sample_t>
     static stream_error write_silence(buffer_group<sample_t>& buffers, time_point tp, stream_params<sample_t>& params) noexcept
     {
-        for(auto&& frame: buffers.output)
+        if(buffers.layout == buffer_layout::planar)
         {
-            for(auto&& samp: frame)
+            for(auto&& channel: buffers.planar_output)
             {
-                samp = 0.0;
+                fill_samples(channel,sample_t());
             }
         }
+        else
+        {
+            fill_samples(buffers.output,sample_t());
+        }
         return no_error;
     }
 }
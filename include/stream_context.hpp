@@ -19,6 +19,10 @@ This file is part of zaudio.
 */
 
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <algorithm>
 
 #include "sample_utility.hpp"
 #include "stream_params.hpp"
@@ -34,9 +38,9 @@ namespace zaudio
 {
     /*!
      *\class stream_context
-     *\brief
-     * //NOTE: DOES NOT ACCOUNT FOR MULTIPLE STREAMS YET
-     * //TODO: Account for multiple streams / APIs
+     *\brief a backend and every stream running on it
+     *\note each audio_stream acquires its own stream_api from stream_api::make_stream, so streams keep their own callbacks, params and state
+     *\note api() is the instance the backend was created as, it answers device queries and runs a stream itself only when the backend cannot make more
      */
 
 
@@ -66,12 +70,36 @@ namespace zaudio
 
         long default_output_device_id() const noexcept;
 
+        //a stream_api for one more stream, nullptr when the backend cannot run another one
+        //safe to call from any thread, the stream stays owned by the context until release_stream
+        api_type* acquire_stream() noexcept;
+
+        //hand back a stream from acquire_stream once it is closed, anything else is ignored
+        void release_stream(api_type* stream) noexcept;
+
+        //streams acquired and not yet released
+        std::size_t stream_count() const noexcept;
+
     private:
+        struct stream_registry
+        {
+            std::mutex lock;
+
+            std::vector<std::unique_ptr<api_type>> streams;
+
+            //api() itself runs a stream
+            bool primary_in_use = false;
+        };
+
         std::unique_ptr<api_type> _api;
+
+        //on the heap so the context stays movable
+        std::unique_ptr<stream_registry> _streams;
     };
 
     template<typename sample_t>
-    stream_context<sample_t>::stream_context(std::unique_ptr<typename stream_context<sample_t>::api_type> api) noexcept:_api(std::move(api))
+    stream_context<sample_t>::stream_context(std::unique_ptr<typename stream_context<sample_t>::api_type> api) noexcept:_api(std::move(api)),
+                                                                                                                          _streams(new (std::nothrow) stream_registry())
     {}
 
     template<typename sample_t>
@@ -121,6 +149,73 @@ namespace zaudio
         return _api.get()->default_output_device_id();
     }
 
+    template<typename sample_t>
+    typename stream_context<sample_t>::api_type* stream_context<sample_t>::acquire_stream() noexcept
+    {
+        if(_api == nullptr || _streams == nullptr)
+        {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> guard(_streams->lock);
+        std::unique_ptr<api_type> stream = _api->make_stream();
+        if(stream != nullptr)
+        {
+            try
+            {
+                _streams->streams.push_back(std::move(stream));
+                return _streams->streams.back().get();
+            }
+            catch(const std::bad_alloc&)
+            {
+                return nullptr;
+            }
+        }
+        //single stream backends
+        if(_streams->primary_in_use)
+        {
+            return nullptr;
+        }
+        _streams->primary_in_use = true;
+        return _api.get();
+    }
+
+    template<typename sample_t>
+    void stream_context<sample_t>::release_stream(typename stream_context<sample_t>::api_type* stream) noexcept
+    {
+        if(stream == nullptr || _streams == nullptr)
+        {
+            return;
+        }
+        std::unique_ptr<api_type> released;
+        {
+            std::lock_guard<std::mutex> guard(_streams->lock);
+            if(stream == _api.get())
+            {
+                _streams->primary_in_use = false;
+                return;
+            }
+            auto&& streams = _streams->streams;
+            auto&& found = std::find_if(streams.begin(),streams.end(),[stream](const std::unique_ptr<api_type>& s){ return s.get() == stream; });
+            if(found != streams.end())
+            {
+                released = std::move(*found);
+                streams.erase(found);
+            }
+        }
+        //destroyed outside the lock, a backend may join its threads here
+    }
+
+    template<typename sample_t>
+    std::size_t stream_context<sample_t>::stream_count() const noexcept
+    {
+        if(_streams == nullptr)
+        {
+            return 0;
+        }
+        std::lock_guard<std::mutex> guard(_streams->lock);
+        return _streams->streams.size() + (_streams->primary_in_use ? 1 : 0);
+    }
+
 
     /*!
      *\fn make_stream_context
@@ -133,6 +228,18 @@ namespace zaudio
     }
 
 
+    /*!
+     *\fn make_stream_context
+     *\brief helper function that creates a stream_context object using the given stream_api
+     * ie: make_stream_context<float,null_stream_api>()
+     */
+    template<typename sample_t,template<typename> class api>
+    stream_context<typename std::decay<sample_t>::type> make_stream_context() noexcept
+    {
+        return stream_context<typename std::decay<sample_t>::type>{make_stream_api<sample_t,api>()};
+    }
+
+
     /*!
      *\fn default_stream_context
      *\brief helper function that creates the a stream_context object with default values
@@ -0,0 +1,397 @@
+#ifndef ZAUDIO_STREAM_NEGOTIATION
+#define ZAUDIO_STREAM_NEGOTIATION
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "stream_params.hpp"
+#include "device_info.hpp"
+#include "block_adapter.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <tuple>
+#include <map>
+#include <mutex>
+#include <cmath>
+#include <ostream>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\struct stream_plan
+     *\brief how an open stream differs from the stream_params it was asked for
+     *\note the callback always sees the requested sample format, frame widths, buffer size and sample rate, the rest is done between it and the device
+     */
+    struct stream_plan
+    {
+        //false when the device took the requested configuration as it is
+        bool negotiated = false;
+
+        //true when the plan was remembered from an earlier open and nothing was probed
+        bool cached = false;
+
+        //configurations asked of the backend during this open, cached answers are not counted
+        std::size_t probes = 0;
+
+        //the rank the plan won with, 0 for the requested configuration
+        std::size_t cost = 0;
+
+        sample_format requested_format = sample_format::err;
+
+        sample_format device_format = sample_format::err;
+
+        std::size_t requested_frame_count = 0;
+
+        std::size_t device_frame_count = 0;
+
+        //frames of delay the block fifo adds to present the requested buffer size
+        std::size_t block_latency = 0;
+
+        double requested_sample_rate = 0;
+
+        double device_sample_rate = 0;
+
+        //frames of round trip delay the resamplers add at the requested rate, see rate_adapter
+        std::size_t resample_latency = 0;
+
+        std::size_t input_width = 0;
+
+        std::size_t device_input_width = 0;
+
+        std::size_t output_width = 0;
+
+        std::size_t device_output_width = 0;
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, const stream_plan& plan);
+
+    /*!
+     *\struct negotiation_key
+     *\brief everything about a stream_params that a backend may accept or refuse, used to cache probes and plans
+     */
+    struct negotiation_key
+    {
+        long input_device;
+        long output_device;
+        double sample_rate;
+        double device_sample_rate;
+        sample_format format;
+        std::size_t frame_count;
+        std::size_t block_size;
+        std::size_t input_width;
+        std::size_t output_width;
+        std::size_t device_input_width;
+        std::size_t device_output_width;
+        buffer_layout layout;
+        stream_mode mode;
+        bool variable_frame_count;
+        latency_mode input_latency;
+        double input_latency_time;
+        latency_mode output_latency;
+        double output_latency_time;
+
+        bool operator<(const negotiation_key& other) const noexcept
+        {
+            return _tie() < other._tie();
+        }
+
+    private:
+        std::tuple<long,long,double,double,sample_format,std::size_t,std::size_t,std::size_t,std::size_t,std::size_t,std::size_t,buffer_layout,stream_mode,bool,latency_mode,double,latency_mode,double> _tie() const noexcept
+        {
+            return std::make_tuple(input_device,output_device,sample_rate,device_sample_rate,format,frame_count,block_size,input_width,output_width,
+                                   device_input_width,device_output_width,layout,mode,variable_frame_count,input_latency,input_latency_time,output_latency,output_latency_time);
+        }
+    };
+
+    template<typename sample_t>
+    negotiation_key make_negotiation_key(const stream_params<sample_t>& params) noexcept
+    {
+        return negotiation_key{params.input_device_id(),
+                               params.output_device_id(),
+                               params.sample_rate(),
+                               params.device_sample_rate(),
+                               params.device_format(),
+                               params.frame_count(),
+                               params.block_size(),
+                               params.input_frame_width(),
+                               params.output_frame_width(),
+                               params.device_input_frame_width(),
+                               params.device_output_frame_width(),
+                               params.layout(),
+                               params.mode(),
+                               params.variable_frame_count(),
+                               params.input_latency().mode(),
+                               params.input_latency().time().count(),
+                               params.output_latency().mode(),
+                               params.output_latency().time().count()};
+    }
+
+    namespace detail
+    {
+        /*!
+         *\struct negotiation_cache
+         *\brief the probes and plans of every stream made from one backend, see stream_api::make_stream
+         */
+        template<typename sample_t>
+        struct negotiation_cache
+        {
+            std::mutex lock;
+
+            //whether the backend supported each configuration it was asked about, opens that failed count as unsupported
+            std::map<negotiation_key,bool> probes;
+
+            //the configuration each requested one was opened with
+            std::map<negotiation_key,stream_params<sample_t>> plans;
+        };
+
+        //bits of resolution a device format carries
+        constexpr std::size_t format_bits(sample_format format) noexcept
+        {
+            return format == sample_format::f32 ? 25 :
+                  (format == sample_format::f64 ? 54 :
+                  (format == sample_format::u8  ? 8  :
+                  (format == sample_format::i8  ? 8  :
+                  (format == sample_format::i16 ? 16 :
+                  (format == sample_format::i24 ? 24 :
+                  (format == sample_format::i32 ? 32 :
+                  (format == sample_format::i64 ? 64 : 0)))))));
+        }
+
+        //lossless conversions cost little, a wider format a little more for the bytes moved, a narrower one costs by the bits it throws away
+        inline std::size_t format_cost(sample_format requested, sample_format device) noexcept
+        {
+            if(requested == device)
+            {
+                return 0;
+            }
+            auto&& kept = format_bits(device);
+            auto&& wanted = format_bits(requested);
+            if(kept >= wanted)
+            {
+                return sample_size(device) > sample_size(requested) ? 2 : 1;
+            }
+            return 8 + (wanted - kept) / 4;
+        }
+
+        //extra channels are silent or dropped, missing ones lose content or duplicate it
+        inline std::size_t width_cost(std::size_t requested, std::size_t device) noexcept
+        {
+            return requested == device ? 0 : (device > requested ? 3 : 6);
+        }
+
+        //a whole number of blocks per device buffer only costs the split, anything else costs its fifo delay in eighths of a buffer
+        inline std::size_t frame_cost(std::size_t requested, std::size_t device) noexcept
+        {
+            if(requested == device)
+            {
+                return 0;
+            }
+            if(device % requested == 0)
+            {
+                return 2;
+            }
+            return 4 + (requested - greatest_common_divisor(requested,device)) * 8 / requested;
+        }
+
+        //resampling is lossy and delays by its filter, about what dropping a float stream to 16 bits costs
+        inline std::size_t rate_cost(double requested, double device) noexcept
+        {
+            return requested == device ? 0 : 12;
+        }
+
+        //the requested buffer size, then 2x, 4x, 1/2 and 1/4 of it
+        inline std::vector<std::size_t> frame_candidates(std::size_t frames, bool search)
+        {
+            std::vector<std::size_t> counts{frames};
+            if(search && frames != 0)
+            {
+                counts.push_back(frames * 2);
+                counts.push_back(frames * 4);
+                if(frames % 2 == 0)
+                {
+                    counts.push_back(frames / 2);
+                }
+                if(frames % 4 == 0)
+                {
+                    counts.push_back(frames / 4);
+                }
+            }
+            return counts;
+        }
+
+        inline void add_rate(std::vector<double>& rates, double rate)
+        {
+            if(rate > 0 && std::find(rates.begin(),rates.end(),rate) == rates.end())
+            {
+                rates.push_back(rate);
+            }
+        }
+
+        inline void add_width(std::vector<std::size_t>& widths, std::size_t width, std::size_t limit)
+        {
+            if(width != 0 && (limit == 0 || width <= limit) && std::find(widths.begin(),widths.end(),width) == widths.end())
+            {
+                widths.push_back(width);
+            }
+        }
+
+        //the requested width, then the device's own, stereo and mono
+        inline std::vector<std::size_t> width_candidates(std::size_t requested, std::size_t limit, bool fixed)
+        {
+            std::vector<std::size_t> widths{requested};
+            if(requested != 0 && !fixed)
+            {
+                add_width(widths,limit,limit);
+                add_width(widths,2,limit);
+                add_width(widths,1,limit);
+            }
+            return widths;
+        }
+    }
+
+    /*!
+     *\fn negotiation_cost
+     *\brief ranks a candidate against the requested configuration, lower is better and 0 is the requested configuration itself
+     */
+    template<typename sample_t>
+    std::size_t negotiation_cost(const stream_params<sample_t>& requested, const stream_params<sample_t>& candidate) noexcept
+    {
+        //a resampled device buffer is compared by the frames it spans at the requested rate
+        auto&& span = candidate.device_sample_rate() == requested.device_sample_rate() ? candidate.frame_count() :
+                      static_cast<std::size_t>(std::lround(candidate.frame_count() * requested.device_sample_rate() / candidate.device_sample_rate()));
+        return detail::format_cost(requested.device_format(),candidate.device_format()) +
+               detail::width_cost(requested.input_frame_width(),candidate.device_input_frame_width()) +
+               detail::width_cost(requested.output_frame_width(),candidate.device_output_frame_width()) +
+               detail::rate_cost(requested.device_sample_rate(),candidate.device_sample_rate()) +
+               detail::frame_cost(requested.frame_count(),span);
+    }
+
+    /*!
+     *\fn negotiation_candidates
+     *\brief every nearby configuration that can present requested to the callback, cheapest first and requested itself at the front
+     *\note device formats, channel counts, buffer sizes and device sample rates are searched, the rates are the devices' defaults and the common 48k, 44.1k and 96k
+     *\note a device rate other than the requested one is resampled by rate_adapter, the device buffer sizes are then scaled to span about the requested buffer
+     *\note blocking streams only search device formats, variable_frame_count() streams keep their buffer size
+     *\note may throw std::bad_alloc
+     */
+    template<typename sample_t>
+    std::vector<stream_params<sample_t>> negotiation_candidates(const stream_params<sample_t>& requested, const device_info& input, const device_info& output)
+    {
+        const bool blocking = requested.mode() == stream_mode::blocking;
+        auto&& inputs = detail::width_candidates(requested.input_frame_width(),input.max_input_count,blocking);
+        auto&& outputs = detail::width_candidates(requested.output_frame_width(),output.max_output_count,blocking);
+        const std::size_t fc = requested.frame_count();
+        const double sr = requested.device_sample_rate();
+        std::vector<double> rates{sr};
+        if(!blocking)
+        {
+            detail::add_rate(rates,input.default_sample_rate);
+            detail::add_rate(rates,output.default_sample_rate);
+            detail::add_rate(rates,48000.0);
+            detail::add_rate(rates,44100.0);
+            detail::add_rate(rates,96000.0);
+        }
+        std::vector<std::pair<std::size_t,stream_params<sample_t>>> ranked;
+        for(auto&& rate: rates)
+        {
+            const std::size_t scaled = rate == sr || fc == 0 ? fc : std::max<std::size_t>(1,static_cast<std::size_t>(std::lround(fc * rate / sr)));
+            auto&& frames = detail::frame_candidates(scaled,!blocking && !requested.variable_frame_count());
+            for(auto&& format: {sample_format::f32,sample_format::f64,sample_format::i32,sample_format::i24,
+                                sample_format::i16,sample_format::i64,sample_format::i8,sample_format::u8})
+            {
+                for(auto&& in: inputs)
+                {
+                    for(auto&& out: outputs)
+                    {
+                        for(auto&& count: frames)
+                        {
+                            stream_params<sample_t> candidate = requested;
+                            candidate.device_format(format);
+                            candidate.device_input_frame_width(in);
+                            candidate.device_output_frame_width(out);
+                            candidate.device_sample_rate(rate);
+                            candidate.frame_count(count);
+                            if((count != fc || rate != sr) && candidate.block_size() == 0)
+                            {
+                                //the fifo hands the callback the buffers it asked for
+                                candidate.block_size(fc);
+                            }
+                            ranked.emplace_back(negotiation_cost(requested,candidate),candidate);
+                        }
+                    }
+                }
+            }
+        }
+        //the requested device format is not always in the list above
+        ranked.emplace_back(0,requested);
+        std::stable_sort(ranked.begin(),ranked.end(),[](const std::pair<std::size_t,stream_params<sample_t>>& a, const std::pair<std::size_t,stream_params<sample_t>>& b)
+        {
+            return a.first < b.first;
+        });
+        std::vector<stream_params<sample_t>> candidates;
+        candidates.reserve(ranked.size());
+        for(auto&& entry: ranked)
+        {
+            //the requested configuration may appear twice
+            if(entry.first != 0 || candidates.empty())
+            {
+                candidates.push_back(entry.second);
+            }
+        }
+        return candidates;
+    }
+
+    /*!
+     *\fn make_stream_plan
+     *\brief describes how chosen presents requested to the callback
+     */
+    template<typename sample_t>
+    stream_plan make_stream_plan(const stream_params<sample_t>& requested, const stream_params<sample_t>& chosen, std::size_t probes, bool cached) noexcept
+    {
+        stream_plan plan;
+        plan.cost = negotiation_cost(requested,chosen);
+        plan.negotiated = plan.cost != 0;
+        plan.cached = cached;
+        plan.probes = probes;
+        plan.requested_format = requested.device_format();
+        plan.device_format = chosen.device_format();
+        plan.requested_frame_count = requested.frame_count();
+        plan.device_frame_count = chosen.frame_count();
+        plan.requested_sample_rate = requested.sample_rate();
+        plan.device_sample_rate = chosen.device_sample_rate();
+        auto&& block = chosen.block_size();
+        //resampled buffers vary in size like host picked ones, see block_adapter
+        const bool variable = chosen.variable_frame_count() || chosen.device_sample_rate() != chosen.sample_rate();
+        if(block != 0 && (block != chosen.frame_count() || variable))
+        {
+            plan.block_latency = variable ? block - 1 : block - detail::greatest_common_divisor(block,chosen.frame_count());
+        }
+        plan.input_width = requested.input_frame_width();
+        plan.device_input_width = chosen.device_input_frame_width();
+        plan.output_width = requested.output_frame_width();
+        plan.device_output_width = chosen.device_output_frame_width();
+        return plan;
+    }
+}
+
+#endif
@@ -24,6 +24,7 @@ This file is part of zaudio.
 #include <functional>
 #include "sample_utility.hpp"
 #include "time_utility.hpp"
+#include "realtime_policy.hpp"
 
 
 /*!
@@ -32,6 +33,98 @@ This file is part of zaudio.
  */
 namespace zaudio
 {
+    /*!
+     *\enum stream_mode
+     *\brief how audio is exchanged with an open stream
+     */
+    enum class stream_mode
+    {
+        //the backend pulls each buffer from the stream callback
+        callback,
+        //the program pushes and pulls audio with audio_stream::write and read, which block until the device has room or data
+        blocking
+    };
+
+    /*!
+     *\enum latency_mode
+     *\brief how much buffering a stream asks the device for, less latency means less room for a late callback
+     */
+    enum class latency_mode
+    {
+        //as little as the device allows
+        lowest,
+        //the device's default for interactive use
+        low,
+        //the device's default for robust playback
+        high,
+        //the duration held by the latency_target
+        custom
+    };
+
+    /*!
+     *\class latency_target
+     *\brief the latency a stream asks for in one direction, either a latency_mode or an explicit duration
+     *\note the device has the last word, stream_api::stream_info reports what the open stream got
+     */
+    class latency_target
+    {
+    public:
+        constexpr latency_target() noexcept : _mode(latency_mode::low),
+                                              _time(0)
+        {}
+
+        constexpr latency_target(latency_mode mode) noexcept : _mode(mode),
+                                                               _time(0)
+        {}
+
+        //a custom target
+        constexpr latency_target(duration time) noexcept : _mode(latency_mode::custom),
+                                                           _time(time)
+        {}
+
+        constexpr const latency_mode& mode() const noexcept
+        {
+            return _mode;
+        }
+
+        //only meaningful for latency_mode::custom
+        constexpr const duration& time() const noexcept
+        {
+            return _time;
+        }
+
+        //the latency to request from a device with the given defaults
+        constexpr duration resolve(duration device_low, duration device_high) const noexcept
+        {
+            return _mode == latency_mode::lowest ? duration(0) :
+                  (_mode == latency_mode::low ? device_low :
+                  (_mode == latency_mode::high ? device_high : _time));
+        }
+
+    private:
+        latency_mode _mode;
+
+        duration _time;
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, const latency_target& target);
+
+    /*!
+     *\struct stream_info
+     *\brief what an open stream actually got from the device
+     *\note latencies are the device's own, a block_size() that is not a divisor of the device buffers adds stream_api::block_latency() on top
+     */
+    struct stream_info
+    {
+        duration input_latency = duration(0);
+
+        duration output_latency = duration(0);
+
+        double sample_rate = 0;
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, const stream_info& info);
+
     /*!
      *\class stream_params
      *\brief a collection of values that describe the audio stream setings
@@ -60,6 +153,9 @@ namespace zaudio
 
         constexpr const std::size_t& frame_count() const noexcept;
 
+        //the device buffer size, negotiation changes it and keeps the callback on the old size with block_size()
+        void frame_count(std::size_t frames) noexcept;
+
         constexpr const std::size_t& input_frame_width() const noexcept;
 
         constexpr const std::size_t& output_frame_width() const noexcept;
@@ -82,6 +178,82 @@ namespace zaudio
 
         constexpr const long& output_device_id() const noexcept;
 
+        //the format exchanged with the device, the stream converts to and from sample_t around the callback
+        //defaults to the format of sample_t
+        constexpr const sample_format& device_format() const noexcept;
+
+        void device_format(sample_format format) noexcept;
+
+        //dither applied when converting to a narrower device format
+        constexpr const zaudio::dither_mode& dither_mode() const noexcept;
+
+        void dither_mode(zaudio::dither_mode mode) noexcept;
+
+        //planar asks the backend for non-interleaved buffers, the callback then receives buffer_group::planar_input and planar_output
+        constexpr const buffer_layout& layout() const noexcept;
+
+        void layout(buffer_layout l) noexcept;
+
+        //how the audio thread is configured, applied on the first callback after the stream starts
+        constexpr const zaudio::realtime_policy& realtime_policy() const noexcept;
+
+        void realtime_policy(const zaudio::realtime_policy& policy) noexcept;
+
+        //blocking streams never call the callback, their buffers are always interleaved
+        //there is no audio thread to apply realtime_policy() to, call apply_realtime_policy from the thread that writes
+        constexpr const stream_mode& mode() const noexcept;
+
+        void mode(stream_mode m) noexcept;
+
+        //frames handed to the callback at a time, 0 hands over each device buffer of frame_count() frames as it is
+        //other sizes run through a fifo that adds stream_api::block_latency() frames of delay unless frame_count() is a fixed multiple of it
+        constexpr const std::size_t& block_size() const noexcept;
+
+        void block_size(std::size_t frames) noexcept;
+
+        //true lets the host pick the size of every buffer, with portaudio that is paFramesPerBufferUnspecified
+        //frame_count() is then the largest buffer the stream prepares for, larger host buffers reach the callback in pieces
+        constexpr const bool& variable_frame_count() const noexcept;
+
+        void variable_frame_count(bool variable) noexcept;
+
+        //also send each buffer with an underflow or overflow to the error callback as stream_status::xrun
+        //they are always counted, see stream_api::xruns
+        constexpr const bool& report_xruns() const noexcept;
+
+        void report_xruns(bool report) noexcept;
+
+        //the buffering asked of the input and output device, low by default
+        constexpr const latency_target& input_latency() const noexcept;
+
+        void input_latency(latency_target target) noexcept;
+
+        constexpr const latency_target& output_latency() const noexcept;
+
+        void output_latency(latency_target target) noexcept;
+
+        //channels opened on the device, the frame widths unless a negotiated plan maps between them, see stream_api::open_negotiated
+        //a device with one channel is spread to or mixed down from every stream channel, otherwise extra channels are silent or dropped
+        constexpr const std::size_t device_input_frame_width() const noexcept;
+
+        void device_input_frame_width(std::size_t width) noexcept;
+
+        constexpr const std::size_t device_output_frame_width() const noexcept;
+
+        void device_output_frame_width(std::size_t width) noexcept;
+
+        //the rate the device runs at, the sample rate unless a negotiated plan resamples between them
+        //frame_count() counts device frames, the callback and block_size() stay at sample_rate()
+        //without a block_size() each callback gets the frames one device buffer spans, a frame more or less from call to call
+        constexpr const double device_sample_rate() const noexcept;
+
+        void device_sample_rate(double rate) noexcept;
+
+        //true lets audio_stream open the cheapest nearby configuration the device supports when this one is not
+        constexpr const bool& negotiate() const noexcept;
+
+        void negotiate(bool allow) noexcept;
+
         friend std::ostream& operator<<(std::ostream& os, stream_params<sample_t>& params);
 
     private:
@@ -97,6 +269,38 @@ namespace zaudio
 
         long _output_device_id;
 
+        sample_format _device_format;
+
+        zaudio::dither_mode _dither_mode;
+
+        buffer_layout _layout;
+
+        zaudio::realtime_policy _realtime_policy;
+
+        stream_mode _mode;
+
+        std::size_t _block_size;
+
+        bool _variable_frame_count;
+
+        bool _report_xruns;
+
+        latency_target _input_latency;
+
+        latency_target _output_latency;
+
+        //same_width follows the frame width
+        std::size_t _device_input_frame_width;
+
+        std::size_t _device_output_frame_width;
+
+        //0 follows the sample rate
+        double _device_sample_rate;
+
+        bool _negotiate;
+
+        constexpr static std::size_t same_width = static_cast<std::size_t>(-1);
+
     };
 
 
@@ -106,7 +310,21 @@ namespace zaudio
                                                                  _frame_count(512),
                                                                  _sample_rate(44100),
                                                                  _input_device_id(-1),
-                                                                 _output_device_id(-1)
+                                                                 _output_device_id(-1),
+                                                                 _device_format(detail::type_to_format_id<sample_t>::value),
+                                                                 _dither_mode(zaudio::dither_mode::none),
+                                                                 _layout(buffer_layout::interleaved),
+                                                                 _realtime_policy(),
+                                                                 _mode(stream_mode::callback),
+                                                                 _block_size(0),
+                                                                 _variable_frame_count(false),
+                                                                 _report_xruns(false),
+                                                                 _input_latency(),
+                                                                 _output_latency(),
+                                                                 _device_input_frame_width(same_width),
+                                                                 _device_output_frame_width(same_width),
+                                                                 _device_sample_rate(0),
+                                                                 _negotiate(false)
     {}
 
     template<typename sample_t>
@@ -117,7 +335,21 @@ namespace zaudio
                                                                                 _frame_count(fc),
                                                                                 _sample_rate(sr),
                                                                                 _input_device_id(-1),
-                                                                                _output_device_id(-1)
+                                                                                _output_device_id(-1),
+                                                                                _device_format(detail::type_to_format_id<sample_t>::value),
+                                                                                _dither_mode(zaudio::dither_mode::none),
+                                                                                _layout(buffer_layout::interleaved),
+                                                                                _realtime_policy(),
+                                                                                _mode(stream_mode::callback),
+                                                                                _block_size(0),
+                                                                                _variable_frame_count(false),
+                                                                                _report_xruns(false),
+                                                                                _input_latency(),
+                                                                                _output_latency(),
+                                                                                _device_input_frame_width(same_width),
+                                                                                _device_output_frame_width(same_width),
+                                                                                _device_sample_rate(0),
+                                                                                _negotiate(false)
     {}
 
     template<typename sample_t>
@@ -129,7 +361,21 @@ namespace zaudio
                                                                                  _frame_count(fc),
                                                                                  _sample_rate(sr),
                                                                                  _input_device_id(-1),
-                                                                                 _output_device_id(-1)
+                                                                                 _output_device_id(-1),
+                                                                                 _device_format(detail::type_to_format_id<sample_t>::value),
+                                                                                 _dither_mode(zaudio::dither_mode::none),
+                                                                                 _layout(buffer_layout::interleaved),
+                                                                                 _realtime_policy(),
+                                                                                 _mode(stream_mode::callback),
+                                                                                 _block_size(0),
+                                                                                 _variable_frame_count(false),
+                                                                                 _report_xruns(false),
+                                                                                 _input_latency(),
+                                                                                 _output_latency(),
+                                                                                 _device_input_frame_width(same_width),
+                                                                                 _device_output_frame_width(same_width),
+                                                                                 _device_sample_rate(0),
+                                                                                 _negotiate(false)
     {}
 
     template<typename sample_t>
@@ -143,7 +389,21 @@ namespace zaudio
                                                                            _frame_count(fc),
                                                                            _sample_rate(sr),
                                                                            _input_device_id(idid),
-                                                                           _output_device_id(odid)
+                                                                           _output_device_id(odid),
+                                                                           _device_format(detail::type_to_format_id<sample_t>::value),
+                                                                           _dither_mode(zaudio::dither_mode::none),
+                                                                           _layout(buffer_layout::interleaved),
+                                                                           _realtime_policy(),
+                                                                           _mode(stream_mode::callback),
+                                                                           _block_size(0),
+                                                                           _variable_frame_count(false),
+                                                                           _report_xruns(false),
+                                                                           _input_latency(),
+                                                                           _output_latency(),
+                                                                           _device_input_frame_width(same_width),
+                                                                           _device_output_frame_width(same_width),
+                                                                           _device_sample_rate(0),
+                                                                           _negotiate(false)
     {}
 
     template<typename sample_t>
@@ -152,6 +412,12 @@ namespace zaudio
         return _frame_count;
     }
 
+    template<typename sample_t>
+    void stream_params<sample_t>::frame_count(std::size_t frames) noexcept
+    {
+        _frame_count = frames;
+    }
+
     template<typename sample_t>
     constexpr const std::size_t& stream_params<sample_t>::input_frame_width() const noexcept
     {
@@ -218,15 +484,197 @@ namespace zaudio
         return _output_device_id;
     }
 
+    template<typename sample_t>
+    constexpr const sample_format& stream_params<sample_t>::device_format() const noexcept
+    {
+        return _device_format;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::device_format(sample_format format) noexcept
+    {
+        _device_format = format;
+    }
+
+    template<typename sample_t>
+    constexpr const zaudio::dither_mode& stream_params<sample_t>::dither_mode() const noexcept
+    {
+        return _dither_mode;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::dither_mode(zaudio::dither_mode mode) noexcept
+    {
+        _dither_mode = mode;
+    }
+
+    template<typename sample_t>
+    constexpr const buffer_layout& stream_params<sample_t>::layout() const noexcept
+    {
+        return _layout;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::layout(buffer_layout l) noexcept
+    {
+        _layout = l;
+    }
+
+    template<typename sample_t>
+    constexpr const zaudio::realtime_policy& stream_params<sample_t>::realtime_policy() const noexcept
+    {
+        return _realtime_policy;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::realtime_policy(const zaudio::realtime_policy& policy) noexcept
+    {
+        _realtime_policy = policy;
+    }
+
+    template<typename sample_t>
+    constexpr const stream_mode& stream_params<sample_t>::mode() const noexcept
+    {
+        return _mode;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::mode(stream_mode m) noexcept
+    {
+        _mode = m;
+    }
+
+    template<typename sample_t>
+    constexpr const std::size_t& stream_params<sample_t>::block_size() const noexcept
+    {
+        return _block_size;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::block_size(std::size_t frames) noexcept
+    {
+        _block_size = frames;
+    }
+
+    template<typename sample_t>
+    constexpr const bool& stream_params<sample_t>::variable_frame_count() const noexcept
+    {
+        return _variable_frame_count;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::variable_frame_count(bool variable) noexcept
+    {
+        _variable_frame_count = variable;
+    }
+
+    template<typename sample_t>
+    constexpr const bool& stream_params<sample_t>::report_xruns() const noexcept
+    {
+        return _report_xruns;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::report_xruns(bool report) noexcept
+    {
+        _report_xruns = report;
+    }
+
+    template<typename sample_t>
+    constexpr const latency_target& stream_params<sample_t>::input_latency() const noexcept
+    {
+        return _input_latency;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::input_latency(latency_target target) noexcept
+    {
+        _input_latency = target;
+    }
+
+    template<typename sample_t>
+    constexpr const latency_target& stream_params<sample_t>::output_latency() const noexcept
+    {
+        return _output_latency;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::output_latency(latency_target target) noexcept
+    {
+        _output_latency = target;
+    }
+
+    template<typename sample_t>
+    constexpr const std::size_t stream_params<sample_t>::device_input_frame_width() const noexcept
+    {
+        return _device_input_frame_width == same_width ? _input_frame_width : _device_input_frame_width;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::device_input_frame_width(std::size_t width) noexcept
+    {
+        _device_input_frame_width = width;
+    }
+
+    template<typename sample_t>
+    constexpr const std::size_t stream_params<sample_t>::device_output_frame_width() const noexcept
+    {
+        return _device_output_frame_width == same_width ? _output_frame_width : _device_output_frame_width;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::device_output_frame_width(std::size_t width) noexcept
+    {
+        _device_output_frame_width = width;
+    }
+
+    template<typename sample_t>
+    constexpr const double stream_params<sample_t>::device_sample_rate() const noexcept
+    {
+        return _device_sample_rate == 0 ? _sample_rate : _device_sample_rate;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::device_sample_rate(double rate) noexcept
+    {
+        _device_sample_rate = rate;
+    }
+
+    template<typename sample_t>
+    constexpr const bool& stream_params<sample_t>::negotiate() const noexcept
+    {
+        return _negotiate;
+    }
+
+    template<typename sample_t>
+    void stream_params<sample_t>::negotiate(bool allow) noexcept
+    {
+        _negotiate = allow;
+    }
+
     template<typename sample_t>
     std::ostream& operator<<(std::ostream& os, stream_params<sample_t>& params)
     {
         os<<"Input Frame Width: "<<params.input_frame_width()<<std::endl;
         os<<"Output Frame Width: "<<params.output_frame_width()<<std::endl;
-        os<<"Frame Count: "<<params.frame_count()<<std::endl;
+        os<<"Frame Count: "<<params.frame_count()<<(params.variable_frame_count() ? " at most" : "")<<std::endl;
         os<<"Sample Rate: "<<params.sample_rate()<<std::endl;
         os<<"Input Device ID: "<<params.input_device_id()<<std::endl;
         os<<"Ouput Device ID: "<<params.output_device_id()<<std::endl;
+        os<<"Device Format: "<<params.device_format()<<std::endl;
+        os<<"Layout: "<<(params.layout() == buffer_layout::planar ? "planar" : "interleaved")<<std::endl;
+        os<<"Mode: "<<(params.mode() == stream_mode::blocking ? "blocking" : "callback")<<std::endl;
+        os<<"Block Size: "<<params.block_size()<<std::endl;
+        os<<"Input Latency: "<<params.input_latency()<<std::endl;
+        os<<"Output Latency: "<<params.output_latency()<<std::endl;
+        if(params.device_input_frame_width() != params.input_frame_width() || params.device_output_frame_width() != params.output_frame_width())
+        {
+            os<<"Device Frame Widths: "<<params.device_input_frame_width()<<" in, "<<params.device_output_frame_width()<<" out"<<std::endl;
+        }
+        if(params.device_sample_rate() != params.sample_rate())
+        {
+            os<<"Device Sample Rate: "<<params.device_sample_rate()<<std::endl;
+        }
         return os;
     }
 
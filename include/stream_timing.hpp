@@ -0,0 +1,104 @@
+#ifndef ZAUDIO_STREAM_TIMING
+#define ZAUDIO_STREAM_TIMING
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "time_utility.hpp"
+
+#include <cstdint>
+#include <cmath>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\struct stream_timing
+     *\brief where a buffer sits in the stream and when it meets the converters
+     *\note times are on the audio_clock, backends that keep their own clock are mapped onto it at the start of each callback
+     *\note frame positions count from the first frame after the stream started and never wrap
+     */
+    struct stream_timing
+    {
+        //the first frame of this buffer
+        std::uint64_t frame_position;
+
+        //when the first input frame was captured by the adc
+        time_point input_time;
+
+        //when the first output frame will be played by the dac
+        time_point output_time;
+
+        //when the backend called into the stream
+        time_point callback_time;
+
+        double sample_rate;
+
+        //true when the backend reported input_time and output_time, false when they were estimated from callback_time
+        bool device_time;
+
+        stream_timing() noexcept : frame_position(0),
+                                   input_time(),
+                                   output_time(),
+                                   callback_time(),
+                                   sample_rate(0),
+                                   device_time(false)
+        {}
+
+        //the same timing frames further into the stream, or earlier when frames is negative
+        stream_timing advanced(std::int64_t frames) const noexcept
+        {
+            stream_timing t = *this;
+            auto&& offset = ticks(static_cast<double>(frames) / sample_rate);
+            t.frame_position = frame_position + static_cast<std::uint64_t>(frames);
+            t.input_time += offset;
+            t.output_time += offset;
+            return t;
+        }
+
+        //when frame reaches the dac
+        time_point output_time_of(std::uint64_t frame) const noexcept
+        {
+            return output_time + ticks((static_cast<double>(frame) - static_cast<double>(frame_position)) / sample_rate);
+        }
+
+        //when frame left the adc
+        time_point input_time_of(std::uint64_t frame) const noexcept
+        {
+            return input_time + ticks((static_cast<double>(frame) - static_cast<double>(frame_position)) / sample_rate);
+        }
+
+        //the frame the dac plays at t, negative before the stream started
+        //times only keep the clock resolution, so a thousandth of a frame is allowed for rounding
+        std::int64_t output_frame_at(time_point t) const noexcept
+        {
+            return static_cast<std::int64_t>(frame_position) + static_cast<std::int64_t>(std::floor(std::chrono::duration_cast<duration>(t - output_time).count() * sample_rate + 0.001));
+        }
+
+        //seconds as the nearest audio_clock tick
+        static time_point::duration ticks(double seconds) noexcept
+        {
+            using period = time_point::duration::period;
+            return time_point::duration(static_cast<time_point::duration::rep>(std::llround(seconds * period::den / period::num)));
+        }
+    };
+}
+
+#endif
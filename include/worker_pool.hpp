@@ -0,0 +1,118 @@
+#ifndef ZAUDIO_WORKER_POOL
+#define ZAUDIO_WORKER_POOL
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "realtime_policy.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <type_traits>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\struct worker_pool_statistics
+     *\brief counters of a worker_pool since it started, summed over the caller and every worker
+     */
+    struct worker_pool_statistics
+    {
+        //ranges of job indices run, a stolen half counts once for the thread that ran it
+        std::uint64_t ranges = 0;
+
+        //ranges taken from another thread's queue
+        std::uint64_t steals = 0;
+
+        //times a worker stopped spinning and went to sleep
+        std::uint64_t sleeps = 0;
+
+        //runs that had to wake sleeping workers, each costs the caller one system call
+        std::uint64_t wakeups = 0;
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, const worker_pool_statistics& stats);
+
+    /*!
+     *\class worker_pool
+     *\brief realtime worker threads a stream callback can spread independent jobs over, joined before run returns
+     *\note every thread owns a fixed size work stealing deque, run splits its index range in halves that idle threads steal
+     *\note idle workers spin for the spin time, then sleep on a futex (WaitOnAddress on windows, short sleeps elsewhere)
+     *\note a spin time a little longer than the stream period keeps the workers awake between callbacks
+     *\note everything is allocated by the constructor, run never allocates, locks or sleeps
+     */
+    class ZAUDIO_EXPORT worker_pool
+    {
+    public:
+        using job_function = void (*)(void* context, std::size_t index);
+
+        constexpr static std::size_t max_workers = 63;
+
+        //may throw std::bad_alloc or std::system_error, waits until every worker has applied policy
+        //when policy.cpu_mask() is not zero worker n is pinned to the n-th cpu of the mask alone, wrapping around
+        explicit worker_pool(std::size_t workers,
+                             const realtime_policy& policy = realtime_policy(),
+                             std::chrono::nanoseconds spin = std::chrono::microseconds(200));
+
+        worker_pool(const worker_pool&) = delete;
+
+        worker_pool& operator=(const worker_pool&) = delete;
+
+        ~worker_pool();
+
+        //calls job(context,i) for every i below count on the calling thread and the workers, returns once all have returned
+        //one thread outside the pool may run at a time, jobs may run nested batches of their own
+        void run(std::size_t count, job_function job, void* context) noexcept;
+
+        //f(i) for every i below count
+        template<typename F>
+        void run(std::size_t count, F&& f) noexcept
+        {
+            using function_type = typename std::remove_reference<F>::type;
+            run(count,&_invoke<function_type>,const_cast<void*>(static_cast<const void*>(&f)));
+        }
+
+        std::size_t worker_count() const noexcept;
+
+        //what applying the policy did on worker n
+        realtime_status worker_status(std::size_t worker) const noexcept;
+
+        //any thread, the counters are read without stopping the workers
+        worker_pool_statistics statistics() const noexcept;
+
+    private:
+        template<typename F>
+        static void _invoke(void* f, std::size_t index)
+        {
+            (*static_cast<F*>(f))(index);
+        }
+
+        struct state;
+
+        std::unique_ptr<state> _state;
+    };
+}
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef ZAUDIO_XRUN_MONITOR
+#define ZAUDIO_XRUN_MONITOR
+
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.hpp"
+#include "error_utility.hpp"
+#include "stream_timing.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+/*!
+ *\namespace zaudio
+ *\brief primary namespace for the zaudio library
+ */
+namespace zaudio
+{
+    /*!
+     *\enum xrun_flags
+     *\brief the conditions a backend can raise for a buffer, combined as bits
+     */
+    enum class xrun_flags : unsigned
+    {
+        none = 0,
+        //the input buffer contains silence where the device had no data
+        input_underflow = 1,
+        //input was discarded because the stream fell behind the device
+        input_overflow = 2,
+        //the device played silence because the output arrived too late
+        output_underflow = 4,
+        //output was discarded
+        output_overflow = 8,
+        //the output is priming the device buffers before the stream really starts, not a dropout
+        priming_output = 16
+    };
+
+    constexpr xrun_flags operator|(xrun_flags a, xrun_flags b) noexcept
+    {
+        return static_cast<xrun_flags>(static_cast<unsigned>(a) | static_cast<unsigned>(b));
+    }
+
+    constexpr xrun_flags operator&(xrun_flags a, xrun_flags b) noexcept
+    {
+        return static_cast<xrun_flags>(static_cast<unsigned>(a) & static_cast<unsigned>(b));
+    }
+
+    //true when any dropout bit is set, priming alone does not count
+    constexpr bool is_xrun(xrun_flags flags) noexcept
+    {
+        return (static_cast<unsigned>(flags) & ~static_cast<unsigned>(xrun_flags::priming_output)) != 0;
+    }
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, xrun_flags flags);
+
+    /*!
+     *\struct xrun_statistics
+     *\brief a snapshot of the xrun counters of a stream
+     */
+    struct xrun_statistics
+    {
+        std::uint64_t input_underflows = 0;
+
+        std::uint64_t input_overflows = 0;
+
+        std::uint64_t output_underflows = 0;
+
+        std::uint64_t output_overflows = 0;
+
+        std::uint64_t priming_outputs = 0;
+
+        //buffers that had at least one dropout, a buffer that under and overflowed counts once
+        std::uint64_t xrun_buffers = 0;
+
+        //the most recent buffer with a dropout, meaningless while xrun_buffers is 0
+        xrun_flags last_flags = xrun_flags::none;
+
+        std::uint64_t last_frame_position = 0;
+
+        time_point last_time = time_point();
+    };
+
+    ZAUDIO_EXPORT std::ostream& operator<<(std::ostream& os, const xrun_statistics& stats);
+
+    /*!
+     *\class xrun_monitor
+     *\brief counts the xruns a backend reports, written by the audio thread and read from any other
+     *\note only the audio thread writes, record never allocates or waits, statistics retries if it races with a record
+     *\note reset only asks the audio thread to zero the counters at its next record, so a preempted caller cannot stall it
+     */
+    class ZAUDIO_EXPORT xrun_monitor
+    {
+    public:
+        xrun_monitor() noexcept;
+
+        //audio thread only, returns an xrun error describing flags when is_xrun(flags)
+        stream_error record(xrun_flags flags, const stream_timing& timing) noexcept;
+
+        xrun_statistics statistics() const noexcept;
+
+        //zero every counter, safe to call from any thread while the stream runs
+        void reset() noexcept;
+
+    private:
+        //odd while record is writing
+        std::atomic<std::uint32_t> _sequence;
+
+        //set by reset, cleared by the audio thread once it has zeroed the counters
+        std::atomic<bool> _reset_requested;
+
+        std::atomic<std::uint64_t> _input_underflows;
+
+        std::atomic<std::uint64_t> _input_overflows;
+
+        std::atomic<std::uint64_t> _output_underflows;
+
+        std::atomic<std::uint64_t> _output_overflows;
+
+        std::atomic<std::uint64_t> _priming_outputs;
+
+        std::atomic<std::uint64_t> _xrun_buffers;
+
+        std::atomic<unsigned> _last_flags;
+
+        std::atomic<std::uint64_t> _last_frame_position;
+
+        std::atomic<time_point::rep> _last_time;
+
+        std::uint32_t _begin_write() noexcept;
+
+        void _end_write(std::uint32_t sequence) noexcept;
+
+        //audio thread only, inside a write
+        void _clear() noexcept;
+    };
+}
+
+#endif
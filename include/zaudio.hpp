@@ -23,17 +23,40 @@ This file is part of zaudio.
 #include "config.hpp"
 #include "constants.hpp"
 #include "sample_utility.hpp"
+#include "simd_utility.hpp"
+#include "sample_conversion.hpp"
 #include "buffer_view.hpp"
+#include "planar_view.hpp"
+#include "interleave.hpp"
+#include "buffer_algorithm.hpp"
 #include "buffer_group.hpp"
 #include "time_utility.hpp"
+#include "stream_timing.hpp"
+#include "realtime_policy.hpp"
+#include "worker_pool.hpp"
 #include "error_utility.hpp"
+#include "error_dispatcher.hpp"
+#include "xrun_monitor.hpp"
+#include "callback_timer.hpp"
+#include "stream_negotiation.hpp"
 #include "stream_params.hpp"
+#include "format_adapter.hpp"
+#include "rate_adapter.hpp"
+#include "block_adapter.hpp"
+#include "audio_ring_buffer.hpp"
+#include "adaptive_resampler.hpp"
+#include "sample_rate_converter.hpp"
+#include "audio_file.hpp"
 #include "device_info.hpp"
 #include "stream_api.hpp"
 #include "stream_context.hpp"
 #include "audio_stream.hpp"
 #include "audio_process.hpp"
+#include "processing_graph.hpp"
 #include "pa_stream_api.hpp"
+#include "null_stream_api.hpp"
+#include "duplex_stream_api.hpp"
+#include "file_stream_api.hpp"
 #include "zaudio_defaults.hpp"
 
 
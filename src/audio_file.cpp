@@ -0,0 +1,744 @@
+#include <audio_file.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <utility>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+namespace zaudio
+{
+    namespace
+    {
+        //riff fields are little endian whatever the host is
+        std::uint16_t get_u16(const unsigned char* p) noexcept
+        {
+            return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        std::uint32_t get_u32(const unsigned char* p) noexcept
+        {
+            return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+                   (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+        }
+
+        std::uint64_t get_u64(const unsigned char* p) noexcept
+        {
+            return static_cast<std::uint64_t>(get_u32(p)) | (static_cast<std::uint64_t>(get_u32(p + 4)) << 32);
+        }
+
+        void put_u16(unsigned char* p, std::uint16_t v) noexcept
+        {
+            p[0] = static_cast<unsigned char>(v);
+            p[1] = static_cast<unsigned char>(v >> 8);
+        }
+
+        void put_u32(unsigned char* p, std::uint32_t v) noexcept
+        {
+            put_u16(p,static_cast<std::uint16_t>(v));
+            put_u16(p + 2,static_cast<std::uint16_t>(v >> 16));
+        }
+
+        void put_u64(unsigned char* p, std::uint64_t v) noexcept
+        {
+            put_u32(p,static_cast<std::uint32_t>(v));
+            put_u32(p + 4,static_cast<std::uint32_t>(v >> 32));
+        }
+
+        bool is_id(const unsigned char* p, const char* id) noexcept
+        {
+            return std::memcmp(p,id,4) == 0;
+        }
+
+        const std::uint16_t wave_format_pcm = 1;
+
+        const std::uint16_t wave_format_float = 3;
+
+        const std::uint16_t wave_format_extensible = 0xfffe;
+
+        //the riff header, the ds64 or reserved chunk in its place and the data chunk header
+        const std::size_t riff_header_bytes = 12;
+
+        const std::size_t ds64_bytes = 8 + 28;
+
+        const std::size_t data_header_bytes = 8;
+
+        //the size fields of an rf64 file that point at ds64
+        const std::uint32_t rf64_size = 0xffffffffu;
+
+        std::uint16_t wave_tag(sample_format format) noexcept
+        {
+            switch(format)
+            {
+            case sample_format::u8:
+            case sample_format::i16:
+            case sample_format::i24:
+            case sample_format::i32:
+                return wave_format_pcm;
+            case sample_format::f32:
+            case sample_format::f64:
+                return wave_format_float;
+            default:
+                return 0;
+            }
+        }
+
+        sample_format wave_sample_format(std::uint16_t tag, std::uint16_t bits) noexcept
+        {
+            if(tag == wave_format_pcm)
+            {
+                return bits == 8  ? sample_format::u8  :
+                       bits == 16 ? sample_format::i16 :
+                       bits == 24 ? sample_format::i24 :
+                       bits == 32 ? sample_format::i32 : sample_format::err;
+            }
+            if(tag == wave_format_float)
+            {
+                return bits == 32 ? sample_format::f32 :
+                       bits == 64 ? sample_format::f64 : sample_format::err;
+            }
+            return sample_format::err;
+        }
+
+        //microsoft recommends the extensible header for anything but mono and stereo 8 and 16 bit pcm
+        bool wants_extensible(const audio_file_format& format) noexcept
+        {
+            return format.channels > 2 || sample_size(format.format) > 2;
+        }
+
+        std::size_t fmt_bytes(const audio_file_format& format) noexcept
+        {
+            return 8 + (wants_extensible(format) ? 40 : 16);
+        }
+    }
+
+    std::ostream& operator<<(std::ostream& os, audio_file_type type)
+    {
+        switch(type)
+        {
+        case audio_file_type::wav:
+            return os<<"wav";
+        case audio_file_type::rf64:
+            return os<<"rf64";
+        case audio_file_type::raw:
+            return os<<"raw";
+        }
+        return os<<"unknown";
+    }
+
+    std::ostream& operator<<(std::ostream& os, const audio_file_format& format)
+    {
+        os<<"Type: "<<format.type<<std::endl;
+        os<<"Sample Format: "<<format.format<<std::endl;
+        os<<"Channels: "<<format.channels<<std::endl;
+        os<<"Sample Rate: "<<format.sample_rate<<std::endl;
+        return os;
+    }
+
+    audio_file_reader::audio_file_reader() noexcept: _mapping(nullptr),
+                                                     _mapping_size(0),
+                                                     _data(nullptr),
+                                                     _frames(0),
+                                                     _handle(nullptr){}
+
+    audio_file_reader::audio_file_reader(audio_file_reader&& other) noexcept: _format(other._format),
+                                                                              _mapping(other._mapping),
+                                                                              _mapping_size(other._mapping_size),
+                                                                              _data(other._data),
+                                                                              _frames(other._frames),
+                                                                              _handle(other._handle)
+    {
+        other._mapping = nullptr;
+        other._mapping_size = 0;
+        other._data = nullptr;
+        other._frames = 0;
+        other._handle = nullptr;
+    }
+
+    audio_file_reader& audio_file_reader::operator=(audio_file_reader&& other) noexcept
+    {
+        if(this != &other)
+        {
+            _release();
+            _format = other._format;
+            _mapping = other._mapping;
+            _mapping_size = other._mapping_size;
+            _data = other._data;
+            _frames = other._frames;
+            _handle = other._handle;
+            other._mapping = nullptr;
+            other._mapping_size = 0;
+            other._data = nullptr;
+            other._frames = 0;
+            other._handle = nullptr;
+        }
+        return *this;
+    }
+
+    audio_file_reader::~audio_file_reader()
+    {
+        _release();
+    }
+
+    stream_error audio_file_reader::open(const std::string& path) noexcept
+    {
+        close();
+        auto&& ret = _map(path);
+        if(ret == no_error)
+        {
+            ret = _parse();
+        }
+        if(ret != no_error)
+        {
+            close();
+        }
+        return ret;
+    }
+
+    stream_error audio_file_reader::open_raw(const std::string& path, const audio_file_format& raw) noexcept
+    {
+        close();
+        if(raw.channels == 0 || sample_size(raw.format) == 0 || !(raw.sample_rate > 0))
+        {
+            return make_stream_error(stream_status::user_error,"Invalid raw file format.");
+        }
+        auto&& ret = _map(path);
+        if(ret != no_error)
+        {
+            close();
+            return ret;
+        }
+        _format = raw;
+        _format.type = audio_file_type::raw;
+        _frames = _mapping_size / _format.frame_bytes();
+        _data = _frames != 0 ? _mapping : nullptr;
+        return no_error;
+    }
+
+    void audio_file_reader::close() noexcept
+    {
+        _release();
+        _format = audio_file_format();
+    }
+
+    bool audio_file_reader::is_open() const noexcept
+    {
+        return _handle != nullptr;
+    }
+
+    const audio_file_format& audio_file_reader::format() const noexcept
+    {
+        return _format;
+    }
+
+    std::uint64_t audio_file_reader::frame_count() const noexcept
+    {
+        return _frames;
+    }
+
+    const void* audio_file_reader::data() const noexcept
+    {
+        return _data;
+    }
+
+    const void* audio_file_reader::frame(std::uint64_t frame) const noexcept
+    {
+        return _data + frame * _format.frame_bytes();
+    }
+
+    void audio_file_reader::prefetch(std::uint64_t frame, std::uint64_t frames) const noexcept
+    {
+        if(_data == nullptr || frame >= _frames)
+        {
+            return;
+        }
+        frames = std::min(frames,_frames - frame);
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(_WIN32)
+        static const std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+        auto&& begin = reinterpret_cast<std::uintptr_t>(_data + frame * _format.frame_bytes());
+        auto&& end = begin + frames * _format.frame_bytes();
+        begin &= ~(page - 1);
+        madvise(reinterpret_cast<void*>(begin),static_cast<std::size_t>(end - begin),MADV_WILLNEED);
+#endif
+        //windows reads ahead on its own once a mapped file is read sequentially
+    }
+
+    stream_error audio_file_reader::_map(const std::string& path) noexcept
+    {
+#if defined(_WIN32)
+        auto&& file = CreateFileA(path.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,nullptr);
+        if(file == INVALID_HANDLE_VALUE)
+        {
+            return make_stream_error(stream_status::system_error,"Unable to open the audio file.");
+        }
+        LARGE_INTEGER size;
+        if(!GetFileSizeEx(file,&size) || static_cast<unsigned long long>(size.QuadPart) > std::numeric_limits<std::size_t>::max())
+        {
+            CloseHandle(file);
+            return make_stream_error(stream_status::system_error,"Unable to map the audio file.");
+        }
+        _mapping_size = static_cast<std::uint64_t>(size.QuadPart);
+        if(_mapping_size == 0)
+        {
+            //an empty file cannot be mapped, the handle only marks the reader open
+            CloseHandle(file);
+            _handle = INVALID_HANDLE_VALUE;
+            return no_error;
+        }
+        auto&& mapping = CreateFileMappingW(file,nullptr,PAGE_READONLY,0,0,nullptr);
+        CloseHandle(file);
+        if(mapping == nullptr)
+        {
+            return make_stream_error(stream_status::system_error,"Unable to map the audio file.");
+        }
+        auto&& view = MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+        if(view == nullptr)
+        {
+            CloseHandle(mapping);
+            return make_stream_error(stream_status::system_error,"Unable to map the audio file.");
+        }
+        _mapping = static_cast<const unsigned char*>(view);
+        _handle = mapping;
+        return no_error;
+#elif defined(__unix__) || defined(__APPLE__)
+        auto&& fd = ::open(path.c_str(),O_RDONLY);
+        if(fd < 0)
+        {
+            return make_stream_error(stream_status::system_error,"Unable to open the audio file.");
+        }
+        struct stat st;
+        if(fstat(fd,&st) != 0 || static_cast<unsigned long long>(st.st_size) > std::numeric_limits<std::size_t>::max())
+        {
+            ::close(fd);
+            return make_stream_error(stream_status::system_error,"Unable to map the audio file.");
+        }
+        _mapping_size = static_cast<std::uint64_t>(st.st_size);
+        //posix has no handle to keep, the reader is open once it gets here
+        _handle = reinterpret_cast<void*>(static_cast<std::uintptr_t>(1));
+        if(_mapping_size == 0)
+        {
+            ::close(fd);
+            return no_error;
+        }
+        auto&& view = mmap(nullptr,static_cast<std::size_t>(_mapping_size),PROT_READ,MAP_PRIVATE,fd,0);
+        //the mapping keeps the file alive once the descriptor is closed
+        ::close(fd);
+        if(view == MAP_FAILED)
+        {
+            _handle = nullptr;
+            _mapping_size = 0;
+            return make_stream_error(stream_status::system_error,"Unable to map the audio file.");
+        }
+        madvise(view,static_cast<std::size_t>(_mapping_size),MADV_SEQUENTIAL);
+        _mapping = static_cast<const unsigned char*>(view);
+        return no_error;
+#else
+        (void)path;
+        return make_stream_error(stream_status::system_error,"Memory mapped files are not supported on this platform.");
+#endif
+    }
+
+    stream_error audio_file_reader::_parse() noexcept
+    {
+        auto&& p = _mapping;
+        auto&& size = _mapping_size;
+        if(size < riff_header_bytes || !(is_id(p,"RIFF") || is_id(p,"RF64") || is_id(p,"BW64")) || !is_id(p + 8,"WAVE"))
+        {
+            return make_stream_error(stream_status::user_error,"Not a wav or rf64 file.");
+        }
+        const bool rf64 = !is_id(p,"RIFF");
+        std::uint64_t data_size64 = 0;
+        bool have_ds64 = false;
+        bool have_fmt = false;
+        std::uint64_t offset = riff_header_bytes;
+        while(offset + 8 <= size)
+        {
+            auto&& id = p + offset;
+            std::uint64_t chunk = get_u32(id + 4);
+            auto&& body = offset + 8;
+            if(is_id(id,"ds64") && chunk >= 24 && body + 24 <= size)
+            {
+                data_size64 = get_u64(p + body + 8);
+                have_ds64 = true;
+            }
+            else if(is_id(id,"fmt ") && chunk >= 16 && body + chunk <= size)
+            {
+                auto&& fmt = p + body;
+                std::uint16_t tag = get_u16(fmt);
+                auto&& channels = get_u16(fmt + 2);
+                auto&& rate = get_u32(fmt + 4);
+                auto&& block = get_u16(fmt + 12);
+                auto&& bits = get_u16(fmt + 14);
+                if(tag == wave_format_extensible)
+                {
+                    if(chunk < 40)
+                    {
+                        return make_stream_error(stream_status::user_error,"Invalid wav format chunk.");
+                    }
+                    //the first two bytes of the sub format guid are the plain format tag
+                    tag = get_u16(fmt + 24);
+                }
+                _format.type = rf64 ? audio_file_type::rf64 : audio_file_type::wav;
+                _format.format = wave_sample_format(tag,bits);
+                _format.channels = channels;
+                _format.sample_rate = rate;
+                if(_format.format == sample_format::err)
+                {
+                    return make_stream_error(stream_status::user_error,"Unsupported wav sample format.");
+                }
+                if(channels == 0 || rate == 0 || block != _format.frame_bytes())
+                {
+                    return make_stream_error(stream_status::user_error,"Invalid wav format chunk.");
+                }
+                have_fmt = true;
+            }
+            else if(is_id(id,"data"))
+            {
+                if(!have_fmt)
+                {
+                    return make_stream_error(stream_status::user_error,"The wav data chunk comes before its format.");
+                }
+                if(rf64 && chunk == rf64_size)
+                {
+                    if(!have_ds64)
+                    {
+                        return make_stream_error(stream_status::user_error,"The rf64 file has no ds64 chunk.");
+                    }
+                    chunk = data_size64;
+                }
+                //a truncated file keeps the frames it has
+                chunk = std::min(chunk,size - body);
+                _frames = chunk / _format.frame_bytes();
+                _data = _frames != 0 ? p + body : nullptr;
+                return no_error;
+            }
+            offset = body + chunk + (chunk & 1);
+        }
+        return make_stream_error(stream_status::user_error,"The wav file has no data chunk.");
+    }
+
+    void audio_file_reader::_release() noexcept
+    {
+#if defined(_WIN32)
+        if(_mapping != nullptr)
+        {
+            UnmapViewOfFile(_mapping);
+        }
+        if(_handle != nullptr && _handle != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(_handle);
+        }
+#elif defined(__unix__) || defined(__APPLE__)
+        if(_mapping != nullptr)
+        {
+            munmap(const_cast<unsigned char*>(_mapping),static_cast<std::size_t>(_mapping_size));
+        }
+#endif
+        _mapping = nullptr;
+        _mapping_size = 0;
+        _data = nullptr;
+        _frames = 0;
+        _handle = nullptr;
+    }
+
+    audio_file_writer::audio_file_writer() noexcept: _file(-1),
+                                                     _batch_frames(0),
+                                                     _batched(0),
+                                                     _frames(0),
+                                                     _data_offset(0){}
+
+    audio_file_writer::~audio_file_writer()
+    {
+        close();
+    }
+
+    stream_error audio_file_writer::open(const std::string& path, const audio_file_format& format, std::size_t batch_frames) noexcept
+    {
+        close();
+        if(format.channels == 0 || sample_size(format.format) == 0 || !(format.sample_rate > 0) || batch_frames == 0)
+        {
+            return make_stream_error(stream_status::user_error,"Invalid audio file format.");
+        }
+        if(format.type != audio_file_type::raw &&
+           (wave_tag(format.format) == 0 || format.channels > 0xffff || format.sample_rate > 0xffffffffu || format.frame_bytes() > 0xffff))
+        {
+            return make_stream_error(stream_status::user_error,"The sample format or layout cannot be stored in a wav file.");
+        }
+        _batch.reset(new(std::nothrow) unsigned char[batch_frames * format.frame_bytes()]);
+        if(!_batch)
+        {
+            return make_stream_error(stream_status::system_error,"Unable to allocate the write batch.");
+        }
+#if defined(_WIN32)
+        auto&& file = CreateFileA(path.c_str(),GENERIC_WRITE,FILE_SHARE_READ,nullptr,CREATE_ALWAYS,FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,nullptr);
+        if(file == INVALID_HANDLE_VALUE)
+        {
+            _batch.reset();
+            return make_stream_error(stream_status::system_error,"Unable to create the audio file.");
+        }
+        _file = reinterpret_cast<std::intptr_t>(file);
+#elif defined(__unix__) || defined(__APPLE__)
+        auto&& fd = ::open(path.c_str(),O_WRONLY | O_CREAT | O_TRUNC,0644);
+        if(fd < 0)
+        {
+            _batch.reset();
+            return make_stream_error(stream_status::system_error,"Unable to create the audio file.");
+        }
+        _file = fd;
+#else
+        (void)path;
+        _batch.reset();
+        return make_stream_error(stream_status::system_error,"Audio files are not supported on this platform.");
+#endif
+        _format = format;
+        _batch_frames = batch_frames;
+        _batched = 0;
+        _frames = 0;
+        _data_offset = format.type == audio_file_type::raw ? 0 : riff_header_bytes + ds64_bytes + fmt_bytes(format) + data_header_bytes;
+        auto&& ret = _write_header(false);
+        if(ret != no_error)
+        {
+            close();
+        }
+        return ret;
+    }
+
+    stream_error audio_file_writer::close() noexcept
+    {
+        if(!is_open())
+        {
+            return no_error;
+        }
+        auto&& ret = _write(_batch.get(),_batched * _format.frame_bytes());
+        _batched = 0;
+        auto&& bytes = _frames * _format.frame_bytes();
+        if(ret == no_error && _format.type != audio_file_type::raw && (bytes & 1) != 0)
+        {
+            //riff chunks are padded to an even size, only once nothing more can be appended
+            const unsigned char pad = 0;
+            ret = _write(&pad,1);
+            if(ret == no_error)
+            {
+                ret = _write_header(true);
+            }
+        }
+        else if(ret == no_error)
+        {
+            ret = _write_header(false);
+        }
+#if defined(_WIN32)
+        CloseHandle(reinterpret_cast<HANDLE>(_file));
+#elif defined(__unix__) || defined(__APPLE__)
+        ::close(static_cast<int>(_file));
+#endif
+        _file = -1;
+        _batch.reset();
+        return ret;
+    }
+
+    bool audio_file_writer::is_open() const noexcept
+    {
+        return _file != -1;
+    }
+
+    const audio_file_format& audio_file_writer::format() const noexcept
+    {
+        return _format;
+    }
+
+    std::uint64_t audio_file_writer::frame_count() const noexcept
+    {
+        return _frames;
+    }
+
+    void* audio_file_writer::write_window(std::size_t frames) noexcept
+    {
+        if(!is_open() || frames > _batch_frames)
+        {
+            return nullptr;
+        }
+        if(_batched + frames > _batch_frames)
+        {
+            if(_write(_batch.get(),_batched * _format.frame_bytes()) != no_error)
+            {
+                return nullptr;
+            }
+            _batched = 0;
+        }
+        return _batch.get() + _batched * _format.frame_bytes();
+    }
+
+    void audio_file_writer::commit_write(std::size_t frames) noexcept
+    {
+        _batched += frames;
+        _frames += frames;
+    }
+
+    stream_error audio_file_writer::write(const void* frames, std::size_t count) noexcept
+    {
+        auto&& bytes = static_cast<const unsigned char*>(frames);
+        while(count != 0)
+        {
+            const std::size_t n = std::min(count,_batch_frames);
+            auto&& window = write_window(n);
+            if(window == nullptr)
+            {
+                return make_stream_error(stream_status::system_error,"Unable to write the audio file.");
+            }
+            std::memcpy(window,bytes,n * _format.frame_bytes());
+            commit_write(n);
+            bytes += n * _format.frame_bytes();
+            count -= n;
+        }
+        return no_error;
+    }
+
+    stream_error audio_file_writer::flush() noexcept
+    {
+        if(!is_open())
+        {
+            return make_stream_error(stream_status::system_error,"The audio file is not open.");
+        }
+        auto&& ret = _write(_batch.get(),_batched * _format.frame_bytes());
+        if(ret == no_error)
+        {
+            _batched = 0;
+            ret = _write_header(false);
+        }
+        return ret;
+    }
+
+    stream_error audio_file_writer::_write(const void* bytes, std::size_t size) noexcept
+    {
+        auto&& p = static_cast<const unsigned char*>(bytes);
+        while(size != 0)
+        {
+#if defined(_WIN32)
+            //one call moves at most a gigabyte so the count fits a DWORD
+            auto&& chunk = static_cast<DWORD>(std::min<std::size_t>(size,std::size_t(1) << 30));
+            DWORD written = 0;
+            if(!WriteFile(reinterpret_cast<HANDLE>(_file),p,chunk,&written,nullptr) || written == 0)
+            {
+                return make_stream_error(stream_status::system_error,"Unable to write the audio file.");
+            }
+#elif defined(__unix__) || defined(__APPLE__)
+            auto&& written = ::write(static_cast<int>(_file),p,size);
+            if(written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(written <= 0)
+            {
+                return make_stream_error(stream_status::system_error,"Unable to write the audio file.");
+            }
+#else
+            std::size_t written = size;
+#endif
+            p += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return no_error;
+    }
+
+    stream_error audio_file_writer::_write_header(bool pad) noexcept
+    {
+        if(_format.type == audio_file_type::raw)
+        {
+            return no_error;
+        }
+        unsigned char header[riff_header_bytes + ds64_bytes + 8 + 40 + data_header_bytes] = {};
+        auto&& data_bytes = static_cast<std::uint64_t>(_frames) * _format.frame_bytes();
+        auto&& riff_bytes = _data_offset - 8 + data_bytes + (pad ? 1 : 0);
+        const bool rf64 = _format.type == audio_file_type::rf64 || riff_bytes > 0xffffffffu;
+        auto&& bits = static_cast<std::uint16_t>(sample_size(_format.format) * 8);
+        auto&& block = static_cast<std::uint16_t>(_format.frame_bytes());
+        auto&& rate = static_cast<std::uint32_t>(_format.sample_rate);
+
+        std::memcpy(header,rf64 ? "RF64" : "RIFF",4);
+        put_u32(header + 4,rf64 ? rf64_size : static_cast<std::uint32_t>(riff_bytes));
+        std::memcpy(header + 8,"WAVE",4);
+
+        //a plain wav keeps the space ds64 needs as a chunk every reader skips
+        auto&& ds64 = header + riff_header_bytes;
+        std::memcpy(ds64,rf64 ? "ds64" : "JUNK",4);
+        put_u32(ds64 + 4,28);
+        if(rf64)
+        {
+            put_u64(ds64 + 8,riff_bytes);
+            put_u64(ds64 + 16,data_bytes);
+            put_u64(ds64 + 24,_frames);
+        }
+
+        auto&& fmt = ds64 + ds64_bytes;
+        const bool extensible = wants_extensible(_format);
+        std::memcpy(fmt,"fmt ",4);
+        put_u32(fmt + 4,extensible ? 40 : 16);
+        put_u16(fmt + 8,extensible ? wave_format_extensible : wave_tag(_format.format));
+        put_u16(fmt + 10,static_cast<std::uint16_t>(_format.channels));
+        put_u32(fmt + 12,rate);
+        put_u32(fmt + 16,rate * block);
+        put_u16(fmt + 20,block);
+        put_u16(fmt + 22,bits);
+        if(extensible)
+        {
+            //valid bits, no speaker mask and the sub format guid of the plain tag
+            static const unsigned char guid_tail[14] = {0x00,0x00,0x00,0x00,0x10,0x00,0x80,0x00,0x00,0xaa,0x00,0x38,0x9b,0x71};
+            put_u16(fmt + 24,22);
+            put_u16(fmt + 26,bits);
+            put_u32(fmt + 28,0);
+            put_u16(fmt + 32,wave_tag(_format.format));
+            std::memcpy(fmt + 34,guid_tail,sizeof(guid_tail));
+        }
+
+        auto&& data = header + _data_offset - data_header_bytes;
+        std::memcpy(data,"data",4);
+        put_u32(data + 4,rf64 ? rf64_size : static_cast<std::uint32_t>(data_bytes));
+
+        //the header is rewritten in place, the next batch still goes to the end of the file
+#if defined(_WIN32)
+        auto&& file = reinterpret_cast<HANDLE>(_file);
+        LARGE_INTEGER zero;
+        zero.QuadPart = 0;
+        DWORD written = 0;
+        if(!SetFilePointerEx(file,zero,nullptr,FILE_BEGIN) ||
+           !WriteFile(file,header,static_cast<DWORD>(_data_offset),&written,nullptr) || written != _data_offset ||
+           !SetFilePointerEx(file,zero,nullptr,FILE_END))
+        {
+            return make_stream_error(stream_status::system_error,"Unable to write the audio file header.");
+        }
+#elif defined(__unix__) || defined(__APPLE__)
+        if(pwrite(static_cast<int>(_file),header,_data_offset,0) != static_cast<ssize_t>(_data_offset) ||
+           lseek(static_cast<int>(_file),0,SEEK_END) < 0)
+        {
+            return make_stream_error(stream_status::system_error,"Unable to write the audio file header.");
+        }
+#endif
+        return no_error;
+    }
+}
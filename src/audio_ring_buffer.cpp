@@ -0,0 +1,211 @@
+#include <audio_ring_buffer.hpp>
+#include <utility>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <atomic>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+namespace zaudio
+{
+#if defined(__unix__) || defined(__APPLE__)
+    namespace
+    {
+        //an anonymous shared memory object, the mapping keeps it alive once the descriptor is closed
+        int shared_memory(std::size_t bytes) noexcept
+        {
+            int fd = -1;
+#if defined(__linux__) && defined(SYS_memfd_create)
+            fd = static_cast<int>(syscall(SYS_memfd_create,"zaudio_ring",0));
+#endif
+            if(fd < 0)
+            {
+                static std::atomic<unsigned> counter{0};
+                char name[64];
+                std::snprintf(name,sizeof(name),"/zaudio_ring_%ld_%u",static_cast<long>(getpid()),counter.fetch_add(1));
+                fd = shm_open(name,O_RDWR | O_CREAT | O_EXCL,0600);
+                if(fd >= 0)
+                {
+                    shm_unlink(name);
+                }
+            }
+            if(fd >= 0 && ftruncate(fd,static_cast<off_t>(bytes)) != 0)
+            {
+                close(fd);
+                fd = -1;
+            }
+            return fd;
+        }
+    }
+#endif
+
+    mirrored_memory::mirrored_memory() noexcept: _data(nullptr),
+                                                 _size(0),
+                                                 _handle(nullptr){}
+
+    mirrored_memory::mirrored_memory(std::size_t bytes) noexcept: mirrored_memory()
+    {
+        if(bytes == 0 || bytes % granularity() != 0)
+        {
+            return;
+        }
+#if defined(_WIN32)
+        auto&& mapping = CreateFileMappingW(INVALID_HANDLE_VALUE,nullptr,PAGE_READWRITE,
+                                            static_cast<DWORD>(static_cast<unsigned long long>(bytes) >> 32),
+                                            static_cast<DWORD>(bytes & 0xffffffffu),nullptr);
+        if(mapping == nullptr)
+        {
+            return;
+        }
+        //find a free range twice the size, then map both views into it
+        //another thread can take the range between the release and the map, so retry a few times
+        for(int attempt = 0; attempt < 16 && _data == nullptr; ++attempt)
+        {
+            auto&& range = static_cast<unsigned char*>(VirtualAlloc(nullptr,bytes * 2,MEM_RESERVE,PAGE_NOACCESS));
+            if(range == nullptr)
+            {
+                break;
+            }
+            VirtualFree(range,0,MEM_RELEASE);
+            auto&& first = MapViewOfFileEx(mapping,FILE_MAP_ALL_ACCESS,0,0,bytes,range);
+            auto&& second = first == nullptr ? nullptr : MapViewOfFileEx(mapping,FILE_MAP_ALL_ACCESS,0,0,bytes,range + bytes);
+            if(second != nullptr)
+            {
+                _data = range;
+            }
+            else if(first != nullptr)
+            {
+                UnmapViewOfFile(first);
+            }
+        }
+        if(_data == nullptr)
+        {
+            CloseHandle(mapping);
+            return;
+        }
+        _handle = mapping;
+        _size = bytes;
+#elif defined(__unix__) || defined(__APPLE__)
+        auto&& fd = shared_memory(bytes);
+        if(fd < 0)
+        {
+            return;
+        }
+        //reserve the whole range first so nothing else can land between the two views
+        auto&& range = mmap(nullptr,bytes * 2,PROT_NONE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+        if(range != MAP_FAILED)
+        {
+            auto&& base = static_cast<unsigned char*>(range);
+            auto&& first = mmap(base,bytes,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_FIXED,fd,0);
+            auto&& second = mmap(base + bytes,bytes,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_FIXED,fd,0);
+            if(first == MAP_FAILED || second == MAP_FAILED)
+            {
+                munmap(range,bytes * 2);
+            }
+            else
+            {
+                _data = base;
+                _size = bytes;
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    mirrored_memory::mirrored_memory(mirrored_memory&& other) noexcept: _data(other._data),
+                                                                        _size(other._size),
+                                                                        _handle(other._handle)
+    {
+        other._data = nullptr;
+        other._size = 0;
+        other._handle = nullptr;
+    }
+
+    mirrored_memory& mirrored_memory::operator=(mirrored_memory&& other) noexcept
+    {
+        if(this != &other)
+        {
+            _release();
+            std::swap(_data,other._data);
+            std::swap(_size,other._size);
+            std::swap(_handle,other._handle);
+        }
+        return *this;
+    }
+
+    mirrored_memory::~mirrored_memory()
+    {
+        _release();
+    }
+
+    void* mirrored_memory::data() const noexcept
+    {
+        return _data;
+    }
+
+    std::size_t mirrored_memory::size() const noexcept
+    {
+        return _size;
+    }
+
+    std::size_t mirrored_memory::granularity() noexcept
+    {
+#if defined(_WIN32)
+        static const std::size_t size = []
+        {
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            return static_cast<std::size_t>(info.dwAllocationGranularity);
+        }();
+        return size;
+#elif defined(__unix__) || defined(__APPLE__)
+        static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+#else
+        return 4096;
+#endif
+    }
+
+    void mirrored_memory::_release() noexcept
+    {
+        if(_data == nullptr)
+        {
+            return;
+        }
+#if defined(_WIN32)
+        UnmapViewOfFile(_data + _size);
+        UnmapViewOfFile(_data);
+        CloseHandle(_handle);
+#elif defined(__unix__) || defined(__APPLE__)
+        munmap(_data,_size * 2);
+#endif
+        _data = nullptr;
+        _size = 0;
+        _handle = nullptr;
+    }
+}
@@ -0,0 +1,735 @@
+#include <buffer_algorithm.hpp>
+#include <simd_utility.hpp>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#ifdef ZAUDIO_X86
+#include <immintrin.h>
+#endif
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+namespace zaudio
+{
+    namespace
+    {
+        //the ramp kernels count frames in floating point lanes, which is exact up to here
+        template<typename T>
+        bool exact_frame_count(std::size_t frames) noexcept
+        {
+            return static_cast<std::uint64_t>(frames) <= (std::uint64_t(1) << std::numeric_limits<T>::digits);
+        }
+
+#ifdef ZAUDIO_X86
+        //one set of vector operations per instruction set and sample type, so each kernel is written once per instruction set
+        template<typename T>
+        struct sse2_ops;
+
+        template<>
+        struct sse2_ops<float>
+        {
+            using reg = __m128;
+            constexpr static std::size_t width = 4;
+            static reg load(const float* p) noexcept { return _mm_loadu_ps(p); }
+            static void store(float* p, reg v) noexcept { _mm_storeu_ps(p,v); }
+            static reg set1(float v) noexcept { return _mm_set1_ps(v); }
+            static reg zero() noexcept { return _mm_setzero_ps(); }
+            static reg add(reg a, reg b) noexcept { return _mm_add_ps(a,b); }
+            static reg sub(reg a, reg b) noexcept { return _mm_sub_ps(a,b); }
+            static reg mul(reg a, reg b) noexcept { return _mm_mul_ps(a,b); }
+            //min and max return b when either is nan, like b < a ? b : a
+            static reg min(reg a, reg b) noexcept { return _mm_min_ps(a,b); }
+            static reg max(reg a, reg b) noexcept { return _mm_max_ps(a,b); }
+            static reg bit_and(reg a, reg b) noexcept { return _mm_and_ps(a,b); }
+            static reg cmpge(reg a, reg b) noexcept { return _mm_cmpge_ps(a,b); }
+            static reg abs(reg a) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.f),a); }
+        };
+
+        template<>
+        struct sse2_ops<double>
+        {
+            using reg = __m128d;
+            constexpr static std::size_t width = 2;
+            static reg load(const double* p) noexcept { return _mm_loadu_pd(p); }
+            static void store(double* p, reg v) noexcept { _mm_storeu_pd(p,v); }
+            static reg set1(double v) noexcept { return _mm_set1_pd(v); }
+            static reg zero() noexcept { return _mm_setzero_pd(); }
+            static reg add(reg a, reg b) noexcept { return _mm_add_pd(a,b); }
+            static reg sub(reg a, reg b) noexcept { return _mm_sub_pd(a,b); }
+            static reg mul(reg a, reg b) noexcept { return _mm_mul_pd(a,b); }
+            static reg min(reg a, reg b) noexcept { return _mm_min_pd(a,b); }
+            static reg max(reg a, reg b) noexcept { return _mm_max_pd(a,b); }
+            static reg bit_and(reg a, reg b) noexcept { return _mm_and_pd(a,b); }
+            static reg cmpge(reg a, reg b) noexcept { return _mm_cmpge_pd(a,b); }
+            static reg abs(reg a) noexcept { return _mm_andnot_pd(_mm_set1_pd(-0.0),a); }
+        };
+
+        template<typename T>
+        struct avx2_ops;
+
+        template<>
+        struct avx2_ops<float>
+        {
+            using reg = __m256;
+            constexpr static std::size_t width = 8;
+            ZAUDIO_TARGET_AVX2 static reg load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+            ZAUDIO_TARGET_AVX2 static void store(float* p, reg v) noexcept { _mm256_storeu_ps(p,v); }
+            ZAUDIO_TARGET_AVX2 static reg set1(float v) noexcept { return _mm256_set1_ps(v); }
+            ZAUDIO_TARGET_AVX2 static reg zero() noexcept { return _mm256_setzero_ps(); }
+            ZAUDIO_TARGET_AVX2 static reg add(reg a, reg b) noexcept { return _mm256_add_ps(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg sub(reg a, reg b) noexcept { return _mm256_sub_ps(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg mul(reg a, reg b) noexcept { return _mm256_mul_ps(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg min(reg a, reg b) noexcept { return _mm256_min_ps(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg max(reg a, reg b) noexcept { return _mm256_max_ps(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg bit_and(reg a, reg b) noexcept { return _mm256_and_ps(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg cmpge(reg a, reg b) noexcept { return _mm256_cmp_ps(a,b,_CMP_GE_OS); }
+            ZAUDIO_TARGET_AVX2 static reg abs(reg a) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.f),a); }
+        };
+
+        template<>
+        struct avx2_ops<double>
+        {
+            using reg = __m256d;
+            constexpr static std::size_t width = 4;
+            ZAUDIO_TARGET_AVX2 static reg load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+            ZAUDIO_TARGET_AVX2 static void store(double* p, reg v) noexcept { _mm256_storeu_pd(p,v); }
+            ZAUDIO_TARGET_AVX2 static reg set1(double v) noexcept { return _mm256_set1_pd(v); }
+            ZAUDIO_TARGET_AVX2 static reg zero() noexcept { return _mm256_setzero_pd(); }
+            ZAUDIO_TARGET_AVX2 static reg add(reg a, reg b) noexcept { return _mm256_add_pd(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg sub(reg a, reg b) noexcept { return _mm256_sub_pd(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg mul(reg a, reg b) noexcept { return _mm256_mul_pd(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg min(reg a, reg b) noexcept { return _mm256_min_pd(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg max(reg a, reg b) noexcept { return _mm256_max_pd(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg bit_and(reg a, reg b) noexcept { return _mm256_and_pd(a,b); }
+            ZAUDIO_TARGET_AVX2 static reg cmpge(reg a, reg b) noexcept { return _mm256_cmp_pd(a,b,_CMP_GE_OS); }
+            ZAUDIO_TARGET_AVX2 static reg abs(reg a) noexcept { return _mm256_andnot_pd(_mm256_set1_pd(-0.0),a); }
+        };
+
+        //the sse2 and avx2 kernels are the same code over different ops, each needs its own target to inline them
+        //every kernel finishes the samples that do not fill a vector with the reference template
+
+        template<typename T>
+        void sse2_fill(T* data, std::size_t count, T value) noexcept
+        {
+            using V = sse2_ops<T>;
+            auto&& v = V::set1(value);
+            std::size_t i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                V::store(data + i,v);
+            }
+            fill_samples<T>(data + i,count - i,value);
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 void avx2_fill(T* data, std::size_t count, T value) noexcept
+        {
+            using V = avx2_ops<T>;
+            auto&& v = V::set1(value);
+            std::size_t i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                V::store(data + i,v);
+            }
+            fill_samples<T>(data + i,count - i,value);
+        }
+
+        template<typename T>
+        void sse2_gain(T* data, std::size_t count, T gain) noexcept
+        {
+            using V = sse2_ops<T>;
+            auto&& g = V::set1(gain);
+            std::size_t i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                V::store(data + i,V::mul(V::load(data + i),g));
+            }
+            apply_gain<T>(data + i,count - i,gain);
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 void avx2_gain(T* data, std::size_t count, T gain) noexcept
+        {
+            using V = avx2_ops<T>;
+            auto&& g = V::set1(gain);
+            std::size_t i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                V::store(data + i,V::mul(V::load(data + i),g));
+            }
+            apply_gain<T>(data + i,count - i,gain);
+        }
+
+        //each lane tracks the frame and channel of the sample it holds, stepping by a whole vector of samples at a time
+        template<typename T>
+        void sse2_gain_ramp(T* data, std::size_t frames, std::size_t channels, T start, T end) noexcept
+        {
+            using V = sse2_ops<T>;
+            const T step = (end - start) / static_cast<T>(frames);
+            const std::size_t count = frames * channels;
+            std::size_t i = 0;
+            if(count >= V::width)
+            {
+                T frame[V::width];
+                T channel[V::width];
+                for(std::size_t k = 0; k < V::width; ++k)
+                {
+                    frame[k] = static_cast<T>(k / channels);
+                    channel[k] = static_cast<T>(k % channels);
+                }
+                auto&& f = V::load(frame);
+                auto&& c = V::load(channel);
+                auto&& width = V::set1(static_cast<T>(channels));
+                auto&& frame_step = V::set1(static_cast<T>(V::width / channels));
+                auto&& channel_step = V::set1(static_cast<T>(V::width % channels));
+                auto&& one = V::set1(1);
+                auto&& first = V::set1(start);
+                auto&& slope = V::set1(step);
+                if(V::width % channels == 0)
+                {
+                    //the lanes never change channel, two independent frame counters hide the add latency
+                    auto&& g = V::add(f,frame_step);
+                    auto&& pair_step = V::add(frame_step,frame_step);
+                    for(; i + 2 * V::width <= count; i += 2 * V::width)
+                    {
+                        V::store(data + i,V::mul(V::load(data + i),V::add(first,V::mul(slope,f))));
+                        V::store(data + i + V::width,V::mul(V::load(data + i + V::width),V::add(first,V::mul(slope,g))));
+                        f = V::add(f,pair_step);
+                        g = V::add(g,pair_step);
+                    }
+                }
+                for(; i + V::width <= count; i += V::width)
+                {
+                    V::store(data + i,V::mul(V::load(data + i),V::add(first,V::mul(slope,f))));
+                    c = V::add(c,channel_step);
+                    f = V::add(f,frame_step);
+                    auto&& wrap = V::cmpge(c,width);
+                    c = V::sub(c,V::bit_and(wrap,width));
+                    f = V::add(f,V::bit_and(wrap,one));
+                }
+            }
+            for(; i < count; ++i)
+            {
+                data[i] = data[i] * detail::ramp_gain(start,step,i / channels);
+            }
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 void avx2_gain_ramp(T* data, std::size_t frames, std::size_t channels, T start, T end) noexcept
+        {
+            using V = avx2_ops<T>;
+            const T step = (end - start) / static_cast<T>(frames);
+            const std::size_t count = frames * channels;
+            std::size_t i = 0;
+            if(count >= V::width)
+            {
+                T frame[V::width];
+                T channel[V::width];
+                for(std::size_t k = 0; k < V::width; ++k)
+                {
+                    frame[k] = static_cast<T>(k / channels);
+                    channel[k] = static_cast<T>(k % channels);
+                }
+                auto&& f = V::load(frame);
+                auto&& c = V::load(channel);
+                auto&& width = V::set1(static_cast<T>(channels));
+                auto&& frame_step = V::set1(static_cast<T>(V::width / channels));
+                auto&& channel_step = V::set1(static_cast<T>(V::width % channels));
+                auto&& one = V::set1(1);
+                auto&& first = V::set1(start);
+                auto&& slope = V::set1(step);
+                if(V::width % channels == 0)
+                {
+                    //the lanes never change channel, two independent frame counters hide the add latency
+                    auto&& g = V::add(f,frame_step);
+                    auto&& pair_step = V::add(frame_step,frame_step);
+                    for(; i + 2 * V::width <= count; i += 2 * V::width)
+                    {
+                        V::store(data + i,V::mul(V::load(data + i),V::add(first,V::mul(slope,f))));
+                        V::store(data + i + V::width,V::mul(V::load(data + i + V::width),V::add(first,V::mul(slope,g))));
+                        f = V::add(f,pair_step);
+                        g = V::add(g,pair_step);
+                    }
+                }
+                for(; i + V::width <= count; i += V::width)
+                {
+                    V::store(data + i,V::mul(V::load(data + i),V::add(first,V::mul(slope,f))));
+                    c = V::add(c,channel_step);
+                    f = V::add(f,frame_step);
+                    auto&& wrap = V::cmpge(c,width);
+                    c = V::sub(c,V::bit_and(wrap,width));
+                    f = V::add(f,V::bit_and(wrap,one));
+                }
+            }
+            for(; i < count; ++i)
+            {
+                data[i] = data[i] * detail::ramp_gain(start,step,i / channels);
+            }
+        }
+
+        template<typename T>
+        void sse2_mix(const T* in, T* out, std::size_t count, T gain) noexcept
+        {
+            using V = sse2_ops<T>;
+            auto&& g = V::set1(gain);
+            std::size_t i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                V::store(out + i,V::add(V::load(out + i),V::mul(V::load(in + i),g)));
+            }
+            mix_samples<T>(in + i,out + i,count - i,gain);
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 void avx2_mix(const T* in, T* out, std::size_t count, T gain) noexcept
+        {
+            using V = avx2_ops<T>;
+            auto&& g = V::set1(gain);
+            std::size_t i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                V::store(out + i,V::add(V::load(out + i),V::mul(V::load(in + i),g)));
+            }
+            mix_samples<T>(in + i,out + i,count - i,gain);
+        }
+
+        template<typename T>
+        void sse2_clip(T* data, std::size_t count, T lo, T hi) noexcept
+        {
+            using V = sse2_ops<T>;
+            auto&& l = V::set1(lo);
+            auto&& h = V::set1(hi);
+            std::size_t i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                V::store(data + i,V::min(V::max(V::load(data + i),l),h));
+            }
+            clip_samples<T>(data + i,count - i,lo,hi);
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 void avx2_clip(T* data, std::size_t count, T lo, T hi) noexcept
+        {
+            using V = avx2_ops<T>;
+            auto&& l = V::set1(lo);
+            auto&& h = V::set1(hi);
+            std::size_t i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                V::store(data + i,V::min(V::max(V::load(data + i),l),h));
+            }
+            clip_samples<T>(data + i,count - i,lo,hi);
+        }
+
+        //the peak kernels keep as many accumulators as the sums, the maximum does not depend on their order
+        template<typename T>
+        T sse2_peak(const T* data, std::size_t count) noexcept
+        {
+            using V = sse2_ops<T>;
+            constexpr std::size_t lanes = detail::sum_lanes<T>();
+            typename V::reg acc[lanes / V::width];
+            for(auto&& a: acc)
+            {
+                a = V::zero();
+            }
+            std::size_t i = 0;
+            for(; i + lanes <= count; i += lanes)
+            {
+                for(std::size_t r = 0; r < lanes / V::width; ++r)
+                {
+                    acc[r] = V::max(V::abs(V::load(data + i + r * V::width)),acc[r]);
+                }
+            }
+            T partial[lanes];
+            for(std::size_t r = 0; r < lanes / V::width; ++r)
+            {
+                V::store(partial + r * V::width,acc[r]);
+            }
+            auto&& peak = sample_peak<T>(partial,lanes);
+            auto&& rest = sample_peak<T>(data + i,count - i);
+            return rest > peak ? rest : peak;
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 T avx2_peak(const T* data, std::size_t count) noexcept
+        {
+            using V = avx2_ops<T>;
+            constexpr std::size_t lanes = detail::sum_lanes<T>();
+            typename V::reg acc[lanes / V::width];
+            for(auto&& a: acc)
+            {
+                a = V::zero();
+            }
+            std::size_t i = 0;
+            for(; i + lanes <= count; i += lanes)
+            {
+                for(std::size_t r = 0; r < lanes / V::width; ++r)
+                {
+                    acc[r] = V::max(V::abs(V::load(data + i + r * V::width)),acc[r]);
+                }
+            }
+            T partial[lanes];
+            for(std::size_t r = 0; r < lanes / V::width; ++r)
+            {
+                V::store(partial + r * V::width,acc[r]);
+            }
+            auto&& peak = sample_peak<T>(partial,lanes);
+            auto&& rest = sample_peak<T>(data + i,count - i);
+            return rest > peak ? rest : peak;
+        }
+
+        //the rest of detail::finish_sum once the accumulators are folded down to one register of n partial sums
+        template<typename T, std::size_t n>
+        T finish_folded(T (&partial)[n], const T* data, std::size_t first, std::size_t count) noexcept
+        {
+            for(std::size_t width = n / 2; width > 0; width /= 2)
+            {
+                for(std::size_t j = 0; j < width; ++j)
+                {
+                    partial[j] = partial[j] + partial[j + width];
+                }
+            }
+            T sum = partial[0];
+            for(std::size_t i = first; i < count; ++i)
+            {
+                sum = sum + data[i];
+            }
+            return sum;
+        }
+
+        //lane j of accumulator r is partial sum r * width + j of the reference
+        //the accumulators are named so they stay in registers, an array of them was kept on the stack and every add waited on a store
+        //folding accumulator r + k into r is the fold of partial sums j + k * width into j, so the result is the reference's to the bit
+        template<typename T>
+        T sse2_sum(const T* data, std::size_t count) noexcept
+        {
+            using V = sse2_ops<T>;
+            constexpr std::size_t lanes = detail::sum_lanes<T>();
+            static_assert(lanes == 8 * V::width,"eight accumulators hold the partial sums");
+            auto a0 = V::zero(), a1 = V::zero(), a2 = V::zero(), a3 = V::zero();
+            auto a4 = V::zero(), a5 = V::zero(), a6 = V::zero(), a7 = V::zero();
+            std::size_t i = 0;
+            for(; i + lanes <= count; i += lanes)
+            {
+                auto&& p = data + i;
+                a0 = V::add(a0,V::load(p));
+                a1 = V::add(a1,V::load(p + V::width));
+                a2 = V::add(a2,V::load(p + 2 * V::width));
+                a3 = V::add(a3,V::load(p + 3 * V::width));
+                a4 = V::add(a4,V::load(p + 4 * V::width));
+                a5 = V::add(a5,V::load(p + 5 * V::width));
+                a6 = V::add(a6,V::load(p + 6 * V::width));
+                a7 = V::add(a7,V::load(p + 7 * V::width));
+            }
+            a0 = V::add(a0,a4);
+            a1 = V::add(a1,a5);
+            a2 = V::add(a2,a6);
+            a3 = V::add(a3,a7);
+            a0 = V::add(a0,a2);
+            a1 = V::add(a1,a3);
+            T partial[V::width];
+            V::store(partial,V::add(a0,a1));
+            return finish_folded(partial,data,i,count);
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 T avx2_sum(const T* data, std::size_t count) noexcept
+        {
+            using V = avx2_ops<T>;
+            constexpr std::size_t lanes = detail::sum_lanes<T>();
+            static_assert(lanes == 4 * V::width,"four accumulators hold the partial sums");
+            auto a0 = V::zero(), a1 = V::zero(), a2 = V::zero(), a3 = V::zero();
+            std::size_t i = 0;
+            for(; i + lanes <= count; i += lanes)
+            {
+                auto&& p = data + i;
+                a0 = V::add(a0,V::load(p));
+                a1 = V::add(a1,V::load(p + V::width));
+                a2 = V::add(a2,V::load(p + 2 * V::width));
+                a3 = V::add(a3,V::load(p + 3 * V::width));
+            }
+            a0 = V::add(a0,a2);
+            a1 = V::add(a1,a3);
+            T partial[V::width];
+            V::store(partial,V::add(a0,a1));
+            return finish_folded(partial,data,i,count);
+        }
+
+        //the filter is recursive in time, so the vectors run across the channels of each frame
+        template<typename T>
+        void sse2_remove_dc(T* data, std::size_t frames, std::size_t channels, T pole, T* x1, T* y1) noexcept
+        {
+            using V = sse2_ops<T>;
+            auto&& p = V::set1(pole);
+            for(std::size_t f = 0; f < frames; ++f)
+            {
+                auto&& frame = data + f * channels;
+                std::size_t c = 0;
+                for(; c + V::width <= channels; c += V::width)
+                {
+                    auto&& x = V::load(frame + c);
+                    auto&& y = V::add(V::sub(x,V::load(x1 + c)),V::mul(p,V::load(y1 + c)));
+                    V::store(x1 + c,x);
+                    V::store(y1 + c,y);
+                    V::store(frame + c,y);
+                }
+                remove_dc<T>(frame + c,1,channels - c,pole,x1 + c,y1 + c);
+            }
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 void avx2_remove_dc(T* data, std::size_t frames, std::size_t channels, T pole, T* x1, T* y1) noexcept
+        {
+            using V = avx2_ops<T>;
+            auto&& p = V::set1(pole);
+            for(std::size_t f = 0; f < frames; ++f)
+            {
+                auto&& frame = data + f * channels;
+                std::size_t c = 0;
+                for(; c + V::width <= channels; c += V::width)
+                {
+                    auto&& x = V::load(frame + c);
+                    auto&& y = V::add(V::sub(x,V::load(x1 + c)),V::mul(p,V::load(y1 + c)));
+                    V::store(x1 + c,x);
+                    V::store(y1 + c,y);
+                    V::store(frame + c,y);
+                }
+                remove_dc<T>(frame + c,1,channels - c,pole,x1 + c,y1 + c);
+            }
+        }
+
+        const bool use_avx2 = cpu_has_avx2();
+#endif
+
+        template<typename T>
+        void fill_kernel(T* data, std::size_t count, T value) noexcept
+        {
+            //silence is all zero bits, libc clears memory faster than any store loop
+            const T zero = 0;
+            if(count != 0 && std::memcmp(&value,&zero,sizeof(T)) == 0)
+            {
+                std::memset(data,0,count * sizeof(T));
+                return;
+            }
+#ifdef ZAUDIO_X86
+            if(use_avx2)
+            {
+                return avx2_fill(data,count,value);
+            }
+            sse2_fill(data,count,value);
+#else
+            fill_samples<T>(data,count,value);
+#endif
+        }
+
+        template<typename T>
+        void gain_kernel(T* data, std::size_t count, T gain) noexcept
+        {
+#ifdef ZAUDIO_X86
+            if(use_avx2)
+            {
+                return avx2_gain(data,count,gain);
+            }
+            sse2_gain(data,count,gain);
+#else
+            apply_gain<T>(data,count,gain);
+#endif
+        }
+
+        template<typename T>
+        void gain_ramp_kernel(T* data, std::size_t frames, std::size_t channels, T start, T end) noexcept
+        {
+#ifdef ZAUDIO_X86
+            if(frames != 0 && exact_frame_count<T>(frames))
+            {
+                if(use_avx2)
+                {
+                    return avx2_gain_ramp(data,frames,channels,start,end);
+                }
+                return sse2_gain_ramp(data,frames,channels,start,end);
+            }
+#endif
+            apply_gain_ramp<T>(data,frames,channels,start,end);
+        }
+
+        template<typename T>
+        void mix_kernel(const T* in, T* out, std::size_t count, T gain) noexcept
+        {
+#ifdef ZAUDIO_X86
+            if(use_avx2)
+            {
+                return avx2_mix(in,out,count,gain);
+            }
+            sse2_mix(in,out,count,gain);
+#else
+            mix_samples<T>(in,out,count,gain);
+#endif
+        }
+
+        template<typename T>
+        void clip_kernel(T* data, std::size_t count, T lo, T hi) noexcept
+        {
+#ifdef ZAUDIO_X86
+            if(use_avx2)
+            {
+                return avx2_clip(data,count,lo,hi);
+            }
+            sse2_clip(data,count,lo,hi);
+#else
+            clip_samples<T>(data,count,lo,hi);
+#endif
+        }
+
+        template<typename T>
+        T peak_kernel(const T* data, std::size_t count) noexcept
+        {
+#ifdef ZAUDIO_X86
+            if(use_avx2)
+            {
+                return avx2_peak(data,count);
+            }
+            return sse2_peak(data,count);
+#else
+            return sample_peak<T>(data,count);
+#endif
+        }
+
+        template<typename T>
+        T sum_kernel(const T* data, std::size_t count) noexcept
+        {
+#ifdef ZAUDIO_X86
+            if(use_avx2)
+            {
+                return avx2_sum(data,count);
+            }
+            return sse2_sum(data,count);
+#else
+            return sample_sum<T>(data,count);
+#endif
+        }
+
+        template<typename T>
+        void remove_dc_kernel(T* data, std::size_t frames, std::size_t channels, T pole, T* x1, T* y1) noexcept
+        {
+#ifdef ZAUDIO_X86
+            if(use_avx2)
+            {
+                return avx2_remove_dc(data,frames,channels,pole,x1,y1);
+            }
+            sse2_remove_dc(data,frames,channels,pole,x1,y1);
+#else
+            remove_dc<T>(data,frames,channels,pole,x1,y1);
+#endif
+        }
+    }
+
+    void fill_samples(float* data, std::size_t count, float value) noexcept
+    {
+        fill_kernel(data,count,value);
+    }
+
+    void fill_samples(double* data, std::size_t count, double value) noexcept
+    {
+        fill_kernel(data,count,value);
+    }
+
+    //libc already picks the widest copy the machine has, empty views may carry null pointers
+    void copy_samples(const float* in, float* out, std::size_t count) noexcept
+    {
+        if(count != 0)
+        {
+            std::memmove(out,in,count * sizeof(float));
+        }
+    }
+
+    void copy_samples(const double* in, double* out, std::size_t count) noexcept
+    {
+        if(count != 0)
+        {
+            std::memmove(out,in,count * sizeof(double));
+        }
+    }
+
+    void apply_gain(float* data, std::size_t count, float gain) noexcept
+    {
+        gain_kernel(data,count,gain);
+    }
+
+    void apply_gain(double* data, std::size_t count, double gain) noexcept
+    {
+        gain_kernel(data,count,gain);
+    }
+
+    void apply_gain_ramp(float* data, std::size_t frames, std::size_t channels, float start, float end) noexcept
+    {
+        gain_ramp_kernel(data,frames,channels,start,end);
+    }
+
+    void apply_gain_ramp(double* data, std::size_t frames, std::size_t channels, double start, double end) noexcept
+    {
+        gain_ramp_kernel(data,frames,channels,start,end);
+    }
+
+    void mix_samples(const float* in, float* out, std::size_t count, float gain) noexcept
+    {
+        mix_kernel(in,out,count,gain);
+    }
+
+    void mix_samples(const double* in, double* out, std::size_t count, double gain) noexcept
+    {
+        mix_kernel(in,out,count,gain);
+    }
+
+    void clip_samples(float* data, std::size_t count, float lo, float hi) noexcept
+    {
+        clip_kernel(data,count,lo,hi);
+    }
+
+    void clip_samples(double* data, std::size_t count, double lo, double hi) noexcept
+    {
+        clip_kernel(data,count,lo,hi);
+    }
+
+    float sample_peak(const float* data, std::size_t count) noexcept
+    {
+        return peak_kernel(data,count);
+    }
+
+    double sample_peak(const double* data, std::size_t count) noexcept
+    {
+        return peak_kernel(data,count);
+    }
+
+    float sample_sum(const float* data, std::size_t count) noexcept
+    {
+        return sum_kernel(data,count);
+    }
+
+    double sample_sum(const double* data, std::size_t count) noexcept
+    {
+        return sum_kernel(data,count);
+    }
+
+    void remove_dc(float* data, std::size_t frames, std::size_t channels, float pole, float* x1, float* y1) noexcept
+    {
+        remove_dc_kernel(data,frames,channels,pole,x1,y1);
+    }
+
+    void remove_dc(double* data, std::size_t frames, std::size_t channels, double pole, double* x1, double* y1) noexcept
+    {
+        remove_dc_kernel(data,frames,channels,pole,x1,y1);
+    }
+}
@@ -0,0 +1,484 @@
+#include <interleave.hpp>
+#include <simd_utility.hpp>
+#include <algorithm>
+#include <cstring>
+#ifdef ZAUDIO_X86
+#include <immintrin.h>
+#endif
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+namespace zaudio
+{
+    namespace
+    {
+        //the tiled kernels walk one block of frames per pass over the channel groups
+        //neighbouring groups share the cache line they read from each frame, so a block keeps one line per frame in l1
+        constexpr std::size_t transpose_block_bytes = 16384;
+
+        constexpr std::size_t cache_line = 64;
+
+        //frames per block, a multiple of every tile height
+        constexpr std::size_t block_frames = transpose_block_bytes / cache_line;
+
+        //the scalar kernels cover any sub-rectangle of frames and channels, the vector kernels use them for their edges
+        template<typename T>
+        void scalar_deinterleave(const T* in, T* const* out, std::size_t channels,
+                                 std::size_t f0, std::size_t f1, std::size_t c0, std::size_t c1) noexcept
+        {
+            for(std::size_t c = c0; c < c1; ++c)
+            {
+                auto&& dst = out[c];
+                for(std::size_t f = f0; f < f1; ++f)
+                {
+                    dst[f] = in[f * channels + c];
+                }
+            }
+        }
+
+        template<typename T>
+        void scalar_interleave(const T* const* in, T* out, std::size_t channels,
+                               std::size_t f0, std::size_t f1, std::size_t c0, std::size_t c1) noexcept
+        {
+            for(std::size_t c = c0; c < c1; ++c)
+            {
+                auto&& src = in[c];
+                for(std::size_t f = f0; f < f1; ++f)
+                {
+                    out[f * channels + c] = src[f];
+                }
+            }
+        }
+
+#ifdef ZAUDIO_X86
+        //the kernels move bits only, int32 and int64 samples go through the float and double registers
+        template<typename T>
+        inline const float* ps(const T* p) noexcept
+        {
+            return reinterpret_cast<const float*>(p);
+        }
+
+        template<typename T>
+        inline float* ps(T* p) noexcept
+        {
+            return reinterpret_cast<float*>(p);
+        }
+
+        template<typename T>
+        inline const double* pd(const T* p) noexcept
+        {
+            return reinterpret_cast<const double*>(p);
+        }
+
+        template<typename T>
+        inline double* pd(T* p) noexcept
+        {
+            return reinterpret_cast<double*>(p);
+        }
+
+        //two adjacent 32 bit samples, no alignment required
+        template<typename T>
+        inline __m128i load_pair(const T* p) noexcept
+        {
+            return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        }
+
+        template<typename T>
+        inline void store_pair(T* p, __m128i v) noexcept
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p),v);
+        }
+
+        //32 bit samples
+
+        template<typename T>
+        void sse2_deinterleave_2x32(const T* in, T* const* out, std::size_t frames) noexcept
+        {
+            auto l = out[0];
+            auto r = out[1];
+            std::size_t f = 0;
+            for(; f + 4 <= frames; f += 4)
+            {
+                auto&& a = _mm_loadu_ps(ps(in + f * 2));
+                auto&& b = _mm_loadu_ps(ps(in + f * 2 + 4));
+                _mm_storeu_ps(ps(l + f),_mm_shuffle_ps(a,b,_MM_SHUFFLE(2,0,2,0)));
+                _mm_storeu_ps(ps(r + f),_mm_shuffle_ps(a,b,_MM_SHUFFLE(3,1,3,1)));
+            }
+            scalar_deinterleave(in,out,2,f,frames,0,2);
+        }
+
+        template<typename T>
+        void sse2_interleave_2x32(const T* const* in, T* out, std::size_t frames) noexcept
+        {
+            auto l = in[0];
+            auto r = in[1];
+            std::size_t f = 0;
+            for(; f + 4 <= frames; f += 4)
+            {
+                auto&& a = _mm_loadu_ps(ps(l + f));
+                auto&& b = _mm_loadu_ps(ps(r + f));
+                _mm_storeu_ps(ps(out + f * 2),_mm_unpacklo_ps(a,b));
+                _mm_storeu_ps(ps(out + f * 2 + 4),_mm_unpackhi_ps(a,b));
+            }
+            scalar_interleave(in,out,2,f,frames,0,2);
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 void avx2_deinterleave_2x32(const T* in, T* const* out, std::size_t frames) noexcept
+        {
+            auto l = out[0];
+            auto r = out[1];
+            std::size_t f = 0;
+            for(; f + 8 <= frames; f += 8)
+            {
+                //shuffle_ps works per 128 bit lane, the 64 bit permute puts the pairs back in frame order
+                auto&& a = _mm256_loadu_ps(ps(in + f * 2));
+                auto&& b = _mm256_loadu_ps(ps(in + f * 2 + 8));
+                auto&& even = _mm256_castps_pd(_mm256_shuffle_ps(a,b,_MM_SHUFFLE(2,0,2,0)));
+                auto&& odd = _mm256_castps_pd(_mm256_shuffle_ps(a,b,_MM_SHUFFLE(3,1,3,1)));
+                _mm256_storeu_ps(ps(l + f),_mm256_castpd_ps(_mm256_permute4x64_pd(even,_MM_SHUFFLE(3,1,2,0))));
+                _mm256_storeu_ps(ps(r + f),_mm256_castpd_ps(_mm256_permute4x64_pd(odd,_MM_SHUFFLE(3,1,2,0))));
+            }
+            scalar_deinterleave(in,out,2,f,frames,0,2);
+        }
+
+        template<typename T>
+        ZAUDIO_TARGET_AVX2 void avx2_interleave_2x32(const T* const* in, T* out, std::size_t frames) noexcept
+        {
+            auto l = in[0];
+            auto r = in[1];
+            std::size_t f = 0;
+            for(; f + 8 <= frames; f += 8)
+            {
+                auto&& a = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_loadu_ps(ps(l + f))),_MM_SHUFFLE(3,1,2,0)));
+                auto&& b = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_loadu_ps(ps(r + f))),_MM_SHUFFLE(3,1,2,0)));
+                _mm256_storeu_ps(ps(out + f * 2),_mm256_unpacklo_ps(a,b));
+                _mm256_storeu_ps(ps(out + f * 2 + 8),_mm256_unpackhi_ps(a,b));
+            }
+            scalar_interleave(in,out,2,f,frames,0,2);
+        }
+
+        template<typename T>
+        void sse2_deinterleave_6x32(const T* in, T* const* out, std::size_t frames) noexcept
+        {
+            std::size_t f = 0;
+            for(; f + 4 <= frames; f += 4)
+            {
+                auto&& p = in + f * 6;
+                //channels 0 to 3 are a 4x4 transpose of the first four samples of each frame
+                auto&& r0 = _mm_loadu_ps(ps(p));
+                auto&& r1 = _mm_loadu_ps(ps(p + 6));
+                auto&& r2 = _mm_loadu_ps(ps(p + 12));
+                auto&& r3 = _mm_loadu_ps(ps(p + 18));
+                _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+                _mm_storeu_ps(ps(out[0] + f),r0);
+                _mm_storeu_ps(ps(out[1] + f),r1);
+                _mm_storeu_ps(ps(out[2] + f),r2);
+                _mm_storeu_ps(ps(out[3] + f),r3);
+                //channels 4 and 5 are gathered two frames at a time
+                auto&& lo = _mm_castsi128_ps(_mm_unpacklo_epi64(load_pair(p + 4),load_pair(p + 10)));
+                auto&& hi = _mm_castsi128_ps(_mm_unpacklo_epi64(load_pair(p + 16),load_pair(p + 22)));
+                _mm_storeu_ps(ps(out[4] + f),_mm_shuffle_ps(lo,hi,_MM_SHUFFLE(2,0,2,0)));
+                _mm_storeu_ps(ps(out[5] + f),_mm_shuffle_ps(lo,hi,_MM_SHUFFLE(3,1,3,1)));
+            }
+            scalar_deinterleave(in,out,6,f,frames,0,6);
+        }
+
+        template<typename T>
+        void sse2_interleave_6x32(const T* const* in, T* out, std::size_t frames) noexcept
+        {
+            std::size_t f = 0;
+            for(; f + 4 <= frames; f += 4)
+            {
+                auto&& p = out + f * 6;
+                auto&& r0 = _mm_loadu_ps(ps(in[0] + f));
+                auto&& r1 = _mm_loadu_ps(ps(in[1] + f));
+                auto&& r2 = _mm_loadu_ps(ps(in[2] + f));
+                auto&& r3 = _mm_loadu_ps(ps(in[3] + f));
+                _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+                auto&& c4 = _mm_loadu_ps(ps(in[4] + f));
+                auto&& c5 = _mm_loadu_ps(ps(in[5] + f));
+                auto&& lo = _mm_castps_si128(_mm_unpacklo_ps(c4,c5));
+                auto&& hi = _mm_castps_si128(_mm_unpackhi_ps(c4,c5));
+                _mm_storeu_ps(ps(p),r0);
+                store_pair(p + 4,lo);
+                _mm_storeu_ps(ps(p + 6),r1);
+                store_pair(p + 10,_mm_unpackhi_epi64(lo,lo));
+                _mm_storeu_ps(ps(p + 12),r2);
+                store_pair(p + 16,hi);
+                _mm_storeu_ps(ps(p + 18),r3);
+                store_pair(p + 22,_mm_unpackhi_epi64(hi,hi));
+            }
+            scalar_interleave(in,out,6,f,frames,0,6);
+        }
+
+        //any channel count, 4x4 tiles over blocks of frames
+        template<typename T>
+        void sse2_deinterleave_nx32(const T* in, T* const* out, std::size_t frames, std::size_t channels) noexcept
+        {
+            auto&& groups = channels / 4 * 4;
+            for(std::size_t b = 0; b < frames; b += block_frames)
+            {
+                const std::size_t end = std::min(frames,b + block_frames);
+                auto&& tiles = b + (end - b) / 4 * 4;
+                for(std::size_t c = 0; c < groups; c += 4)
+                {
+                    auto o0 = out[c];
+                    auto o1 = out[c + 1];
+                    auto o2 = out[c + 2];
+                    auto o3 = out[c + 3];
+                    for(std::size_t f = b; f < tiles; f += 4)
+                    {
+                        auto&& p = in + f * channels + c;
+                        auto&& r0 = _mm_loadu_ps(ps(p));
+                        auto&& r1 = _mm_loadu_ps(ps(p + channels));
+                        auto&& r2 = _mm_loadu_ps(ps(p + channels * 2));
+                        auto&& r3 = _mm_loadu_ps(ps(p + channels * 3));
+                        _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+                        _mm_storeu_ps(ps(o0 + f),r0);
+                        _mm_storeu_ps(ps(o1 + f),r1);
+                        _mm_storeu_ps(ps(o2 + f),r2);
+                        _mm_storeu_ps(ps(o3 + f),r3);
+                    }
+                }
+                scalar_deinterleave(in,out,channels,b,tiles,groups,channels);
+                scalar_deinterleave(in,out,channels,tiles,end,0,channels);
+            }
+        }
+
+        template<typename T>
+        void sse2_interleave_nx32(const T* const* in, T* out, std::size_t frames, std::size_t channels) noexcept
+        {
+            auto&& groups = channels / 4 * 4;
+            for(std::size_t b = 0; b < frames; b += block_frames)
+            {
+                const std::size_t end = std::min(frames,b + block_frames);
+                auto&& tiles = b + (end - b) / 4 * 4;
+                for(std::size_t c = 0; c < groups; c += 4)
+                {
+                    auto i0 = in[c];
+                    auto i1 = in[c + 1];
+                    auto i2 = in[c + 2];
+                    auto i3 = in[c + 3];
+                    for(std::size_t f = b; f < tiles; f += 4)
+                    {
+                        auto&& r0 = _mm_loadu_ps(ps(i0 + f));
+                        auto&& r1 = _mm_loadu_ps(ps(i1 + f));
+                        auto&& r2 = _mm_loadu_ps(ps(i2 + f));
+                        auto&& r3 = _mm_loadu_ps(ps(i3 + f));
+                        _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+                        auto&& p = out + f * channels + c;
+                        _mm_storeu_ps(ps(p),r0);
+                        _mm_storeu_ps(ps(p + channels),r1);
+                        _mm_storeu_ps(ps(p + channels * 2),r2);
+                        _mm_storeu_ps(ps(p + channels * 3),r3);
+                    }
+                }
+                scalar_interleave(in,out,channels,b,tiles,groups,channels);
+                scalar_interleave(in,out,channels,tiles,end,0,channels);
+            }
+        }
+
+        //64 bit samples, any channel count, 2x2 tiles over blocks of frames
+
+        template<typename T>
+        void sse2_deinterleave_nx64(const T* in, T* const* out, std::size_t frames, std::size_t channels) noexcept
+        {
+            auto&& pairs = channels / 2 * 2;
+            for(std::size_t b = 0; b < frames; b += block_frames)
+            {
+                const std::size_t end = std::min(frames,b + block_frames);
+                auto&& tiles = b + (end - b) / 2 * 2;
+                for(std::size_t c = 0; c < pairs; c += 2)
+                {
+                    auto o0 = out[c];
+                    auto o1 = out[c + 1];
+                    for(std::size_t f = b; f < tiles; f += 2)
+                    {
+                        auto&& p = in + f * channels + c;
+                        auto&& r0 = _mm_loadu_pd(pd(p));
+                        auto&& r1 = _mm_loadu_pd(pd(p + channels));
+                        _mm_storeu_pd(pd(o0 + f),_mm_unpacklo_pd(r0,r1));
+                        _mm_storeu_pd(pd(o1 + f),_mm_unpackhi_pd(r0,r1));
+                    }
+                }
+                scalar_deinterleave(in,out,channels,b,tiles,pairs,channels);
+                scalar_deinterleave(in,out,channels,tiles,end,0,channels);
+            }
+        }
+
+        template<typename T>
+        void sse2_interleave_nx64(const T* const* in, T* out, std::size_t frames, std::size_t channels) noexcept
+        {
+            auto&& pairs = channels / 2 * 2;
+            for(std::size_t b = 0; b < frames; b += block_frames)
+            {
+                const std::size_t end = std::min(frames,b + block_frames);
+                auto&& tiles = b + (end - b) / 2 * 2;
+                for(std::size_t c = 0; c < pairs; c += 2)
+                {
+                    auto i0 = in[c];
+                    auto i1 = in[c + 1];
+                    for(std::size_t f = b; f < tiles; f += 2)
+                    {
+                        auto&& r0 = _mm_loadu_pd(pd(i0 + f));
+                        auto&& r1 = _mm_loadu_pd(pd(i1 + f));
+                        auto&& p = out + f * channels + c;
+                        _mm_storeu_pd(pd(p),_mm_unpacklo_pd(r0,r1));
+                        _mm_storeu_pd(pd(p + channels),_mm_unpackhi_pd(r0,r1));
+                    }
+                }
+                scalar_interleave(in,out,channels,b,tiles,pairs,channels);
+                scalar_interleave(in,out,channels,tiles,end,0,channels);
+            }
+        }
+
+        const bool use_avx2 = cpu_has_avx2();
+#endif
+
+        template<typename T>
+        void deinterleave_32(const T* in, T* const* out, std::size_t frames, std::size_t channels) noexcept
+        {
+            if(channels == 0)
+            {
+                return;
+            }
+            if(channels == 1)
+            {
+                std::memcpy(out[0],in,frames * sizeof(T));
+                return;
+            }
+#ifdef ZAUDIO_X86
+            switch(channels)
+            {
+            case 2:
+                return use_avx2 ? avx2_deinterleave_2x32(in,out,frames) : sse2_deinterleave_2x32(in,out,frames);
+            case 6:
+                return sse2_deinterleave_6x32(in,out,frames);
+            default:
+                return sse2_deinterleave_nx32(in,out,frames,channels);
+            }
+#else
+            scalar_deinterleave(in,out,channels,0,frames,0,channels);
+#endif
+        }
+
+        template<typename T>
+        void interleave_32(const T* const* in, T* out, std::size_t frames, std::size_t channels) noexcept
+        {
+            if(channels == 0)
+            {
+                return;
+            }
+            if(channels == 1)
+            {
+                std::memcpy(out,in[0],frames * sizeof(T));
+                return;
+            }
+#ifdef ZAUDIO_X86
+            switch(channels)
+            {
+            case 2:
+                return use_avx2 ? avx2_interleave_2x32(in,out,frames) : sse2_interleave_2x32(in,out,frames);
+            case 6:
+                return sse2_interleave_6x32(in,out,frames);
+            default:
+                return sse2_interleave_nx32(in,out,frames,channels);
+            }
+#else
+            scalar_interleave(in,out,channels,0,frames,0,channels);
+#endif
+        }
+
+        template<typename T>
+        void deinterleave_64(const T* in, T* const* out, std::size_t frames, std::size_t channels) noexcept
+        {
+            if(channels == 0)
+            {
+                return;
+            }
+            if(channels == 1)
+            {
+                std::memcpy(out[0],in,frames * sizeof(T));
+                return;
+            }
+#ifdef ZAUDIO_X86
+            sse2_deinterleave_nx64(in,out,frames,channels);
+#else
+            scalar_deinterleave(in,out,channels,0,frames,0,channels);
+#endif
+        }
+
+        template<typename T>
+        void interleave_64(const T* const* in, T* out, std::size_t frames, std::size_t channels) noexcept
+        {
+            if(channels == 0)
+            {
+                return;
+            }
+            if(channels == 1)
+            {
+                std::memcpy(out,in[0],frames * sizeof(T));
+                return;
+            }
+#ifdef ZAUDIO_X86
+            sse2_interleave_nx64(in,out,frames,channels);
+#else
+            scalar_interleave(in,out,channels,0,frames,0,channels);
+#endif
+        }
+    }
+
+    void deinterleave(const float* in, float* const* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        deinterleave_32(in,out,frames,channels);
+    }
+
+    void deinterleave(const double* in, double* const* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        deinterleave_64(in,out,frames,channels);
+    }
+
+    void deinterleave(const std::int32_t* in, std::int32_t* const* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        deinterleave_32(in,out,frames,channels);
+    }
+
+    void deinterleave(const std::int64_t* in, std::int64_t* const* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        deinterleave_64(in,out,frames,channels);
+    }
+
+    void interleave(const float* const* in, float* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        interleave_32(in,out,frames,channels);
+    }
+
+    void interleave(const double* const* in, double* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        interleave_64(in,out,frames,channels);
+    }
+
+    void interleave(const std::int32_t* const* in, std::int32_t* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        interleave_32(in,out,frames,channels);
+    }
+
+    void interleave(const std::int64_t* const* in, std::int64_t* out, std::size_t frames, std::size_t channels) noexcept
+    {
+        interleave_64(in,out,frames,channels);
+    }
+}
@@ -1,5 +1,11 @@
 #include <zaudio.hpp>
 #include <sstream>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#if defined(_MSC_VER) && defined(ZAUDIO_X86)
+#include <intrin.h>
+#endif
 /*
 This file is part of zaudio.
 
@@ -167,6 +173,48 @@ namespace zaudio
          return os;
      }
 
+     std::ostream& operator<<(std::ostream& os, const latency_target& target)
+     {
+         switch(target.mode())
+         {
+             case latency_mode::lowest: return os<<"lowest";
+             case latency_mode::low: return os<<"low";
+             case latency_mode::high: return os<<"high";
+             case latency_mode::custom: return os<<target.time().count()<<"s";
+         }
+         return os;
+     }
+
+     std::ostream& operator<<(std::ostream& os, const stream_info& info)
+     {
+         os<<"Input Latency: "<<info.input_latency.count()<<"s"<<std::endl;
+         os<<"Output Latency: "<<info.output_latency.count()<<"s"<<std::endl;
+         os<<"Sample Rate: "<<info.sample_rate<<std::endl;
+         return os;
+     }
+
+     std::ostream& operator<<(std::ostream& os, const stream_plan& plan)
+     {
+         if(!plan.negotiated)
+         {
+             return os<<"Requested configuration"<<(plan.cached ? " (cached)" : "")<<std::endl;
+         }
+         os<<"Negotiated configuration, cost "<<plan.cost<<(plan.cached ? " (cached)" : "")<<", "<<plan.probes<<" probes"<<std::endl;
+         os<<"\tDevice Format: "<<plan.device_format<<(plan.device_format != plan.requested_format ? " converted" : "")<<std::endl;
+         os<<"\tDevice Frame Count: "<<plan.device_frame_count;
+         if(plan.device_frame_count != plan.requested_frame_count)
+         {
+             os<<" in blocks of "<<plan.requested_frame_count<<", "<<plan.block_latency<<" frames added latency";
+         }
+         os<<std::endl;
+         if(plan.device_sample_rate != plan.requested_sample_rate)
+         {
+             os<<"\tDevice Sample Rate: "<<plan.device_sample_rate<<" resampled to "<<plan.requested_sample_rate<<", "<<plan.resample_latency<<" frames added latency"<<std::endl;
+         }
+         os<<"\tDevice Channels: "<<plan.device_input_width<<" in for "<<plan.input_width<<", "<<plan.device_output_width<<" out for "<<plan.output_width<<std::endl;
+         return os;
+     }
+
      std::ostream& operator<<(std::ostream& os, const std::vector<device_info>& vinfo)
      {
          for(auto idx = 0ul; idx < vinfo.size(); ++idx)
@@ -178,5 +226,648 @@ namespace zaudio
      }
 
 
+    constexpr std::size_t stream_error_queue::capacity;
+    constexpr std::size_t stream_error_queue::message_size;
+
+    stream_error_queue::stream_error_queue() noexcept: _head(0),
+                                                       _tail(0),
+                                                       _dropped(0),
+                                                       _coalesced(0){}
+
+    bool stream_error_queue::push(const stream_error& err) noexcept
+    {
+        const char* message = err.second == nullptr ? "" : err.second;
+        auto&& tail = _tail.load(std::memory_order_relaxed);
+        auto&& head = _head.load(std::memory_order_acquire);
+        if(head != tail)
+        {
+            //an identical error is still waiting to be delivered, fold this one into it
+            auto&& last = _entries[(tail - 1) % capacity];
+            if(last.status == err.first && std::strncmp(last.message,message,message_size - 1) == 0)
+            {
+                _coalesced.fetch_add(1,std::memory_order_relaxed);
+                return false;
+            }
+        }
+        if(tail - head == capacity)
+        {
+            _dropped.fetch_add(1,std::memory_order_relaxed);
+            return false;
+        }
+        auto&& slot = _entries[tail % capacity];
+        slot.status = err.first;
+        std::strncpy(slot.message,message,message_size - 1);
+        slot.message[message_size - 1] = '\0';
+        _tail.store(tail + 1,std::memory_order_release);
+        return true;
+    }
+
+    bool stream_error_queue::pop(stream_error& err) noexcept
+    {
+        auto&& head = _head.load(std::memory_order_relaxed);
+        if(head == _tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        _popped = _entries[head % capacity];
+        _head.store(head + 1,std::memory_order_release);
+        err = make_stream_error(_popped.status,_popped.message);
+        return true;
+    }
+
+    bool stream_error_queue::empty() const noexcept
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t stream_error_queue::dropped() const noexcept
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    std::size_t stream_error_queue::coalesced() const noexcept
+    {
+        return _coalesced.load(std::memory_order_relaxed);
+    }
+
+
+
+    std::ostream& operator<<(std::ostream& os, xrun_flags flags)
+    {
+        if(flags == xrun_flags::none)
+        {
+            return os<<"none";
+        }
+        const char* names[] = {"input underflow","input overflow","output underflow","output overflow","priming output"};
+        const char* separator = "";
+        for(unsigned bit = 0; bit < 5; ++bit)
+        {
+            if((static_cast<unsigned>(flags) >> bit) & 1)
+            {
+                os<<separator<<names[bit];
+                separator = ", ";
+            }
+        }
+        return os;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const xrun_statistics& stats)
+    {
+        os<<"Buffers With Xruns: "<<stats.xrun_buffers<<std::endl;
+        os<<"Input Underflows: "<<stats.input_underflows<<std::endl;
+        os<<"Input Overflows: "<<stats.input_overflows<<std::endl;
+        os<<"Output Underflows: "<<stats.output_underflows<<std::endl;
+        os<<"Output Overflows: "<<stats.output_overflows<<std::endl;
+        os<<"Priming Outputs: "<<stats.priming_outputs<<std::endl;
+        if(stats.xrun_buffers != 0)
+        {
+            os<<"Last Xrun: "<<stats.last_flags<<" at frame "<<stats.last_frame_position<<std::endl;
+        }
+        return os;
+    }
+
+    xrun_monitor::xrun_monitor() noexcept: _sequence(0),
+                                           _reset_requested(false),
+                                           _input_underflows(0),
+                                           _input_overflows(0),
+                                           _output_underflows(0),
+                                           _output_overflows(0),
+                                           _priming_outputs(0),
+                                           _xrun_buffers(0),
+                                           _last_flags(0),
+                                           _last_frame_position(0),
+                                           _last_time(0){}
+
+    std::uint32_t xrun_monitor::_begin_write() noexcept
+    {
+        //the audio thread is the only writer, so there is nothing to wait for
+        const std::uint32_t sequence = _sequence.load(std::memory_order_relaxed) + 1;
+        _sequence.store(sequence,std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return sequence;
+    }
+
+    void xrun_monitor::_end_write(std::uint32_t sequence) noexcept
+    {
+        _sequence.store(sequence + 1,std::memory_order_release);
+    }
+
+    stream_error xrun_monitor::record(xrun_flags flags, const stream_timing& timing) noexcept
+    {
+        if(flags == xrun_flags::none)
+        {
+            return no_error;
+        }
+        auto&& bump = [&](std::atomic<std::uint64_t>& counter, xrun_flags flag)
+        {
+            if((flags & flag) != xrun_flags::none)
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+            }
+        };
+        auto&& sequence = _begin_write();
+        if(_reset_requested.exchange(false,std::memory_order_acquire))
+        {
+            _clear();
+        }
+        bump(_input_underflows,xrun_flags::input_underflow);
+        bump(_input_overflows,xrun_flags::input_overflow);
+        bump(_output_underflows,xrun_flags::output_underflow);
+        bump(_output_overflows,xrun_flags::output_overflow);
+        bump(_priming_outputs,xrun_flags::priming_output);
+        auto&& xrun = is_xrun(flags);
+        if(xrun)
+        {
+            _xrun_buffers.store(_xrun_buffers.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+            _last_flags.store(static_cast<unsigned>(flags),std::memory_order_relaxed);
+            _last_frame_position.store(timing.frame_position,std::memory_order_relaxed);
+            _last_time.store(timing.callback_time.time_since_epoch().count(),std::memory_order_relaxed);
+        }
+        _end_write(sequence);
+        if(!xrun)
+        {
+            return no_error;
+        }
+        //static messages, so a burst of identical xruns coalesces in the error queue
+        auto&& input = (flags & (xrun_flags::input_underflow | xrun_flags::input_overflow)) != xrun_flags::none;
+        auto&& output = (flags & (xrun_flags::output_underflow | xrun_flags::output_overflow)) != xrun_flags::none;
+        if(input && output)
+        {
+            return make_stream_error(stream_status::xrun,"Input and output xrun.");
+        }
+        if((flags & xrun_flags::output_underflow) != xrun_flags::none)
+        {
+            return make_stream_error(stream_status::xrun,"Output underflow.");
+        }
+        if((flags & xrun_flags::output_overflow) != xrun_flags::none)
+        {
+            return make_stream_error(stream_status::xrun,"Output overflow.");
+        }
+        if((flags & xrun_flags::input_overflow) != xrun_flags::none)
+        {
+            return make_stream_error(stream_status::xrun,"Input overflow.");
+        }
+        return make_stream_error(stream_status::xrun,"Input underflow.");
+    }
+
+    xrun_statistics xrun_monitor::statistics() const noexcept
+    {
+        xrun_statistics stats;
+        if(_reset_requested.load(std::memory_order_relaxed))
+        {
+            //the counters are zeroed at the next record, until then they already read as zero
+            return stats;
+        }
+        std::uint32_t before = 0;
+        std::uint32_t after = 0;
+        do
+        {
+            before = _sequence.load(std::memory_order_acquire);
+            stats.input_underflows = _input_underflows.load(std::memory_order_relaxed);
+            stats.input_overflows = _input_overflows.load(std::memory_order_relaxed);
+            stats.output_underflows = _output_underflows.load(std::memory_order_relaxed);
+            stats.output_overflows = _output_overflows.load(std::memory_order_relaxed);
+            stats.priming_outputs = _priming_outputs.load(std::memory_order_relaxed);
+            stats.xrun_buffers = _xrun_buffers.load(std::memory_order_relaxed);
+            stats.last_flags = static_cast<xrun_flags>(_last_flags.load(std::memory_order_relaxed));
+            stats.last_frame_position = _last_frame_position.load(std::memory_order_relaxed);
+            stats.last_time = time_point(time_point::duration(_last_time.load(std::memory_order_relaxed)));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _sequence.load(std::memory_order_relaxed);
+        }
+        while(before % 2 != 0 || before != after);
+        return stats;
+    }
+
+    void xrun_monitor::reset() noexcept
+    {
+        _reset_requested.store(true,std::memory_order_release);
+    }
+
+    void xrun_monitor::_clear() noexcept
+    {
+        for(auto&& counter: {&_input_underflows,&_input_overflows,&_output_underflows,&_output_overflows,&_priming_outputs,&_xrun_buffers,&_last_frame_position})
+        {
+            counter->store(0,std::memory_order_relaxed);
+        }
+        _last_flags.store(0,std::memory_order_relaxed);
+        _last_time.store(0,std::memory_order_relaxed);
+    }
+
+
+
+    constexpr std::size_t timing_histogram::sub_buckets;
+    constexpr std::size_t timing_histogram::bucket_count;
+
+    timing_histogram::timing_histogram() noexcept: _count(0),
+                                                   _sum(0),
+                                                   _max(0)
+    {
+        for(auto&& bucket: _buckets)
+        {
+            bucket.store(0,std::memory_order_relaxed);
+        }
+    }
+
+    void timing_histogram::clear() noexcept
+    {
+        for(auto&& bucket: _buckets)
+        {
+            bucket.store(0,std::memory_order_relaxed);
+        }
+        _count.store(0,std::memory_order_relaxed);
+        _sum.store(0,std::memory_order_relaxed);
+        _max.store(0,std::memory_order_relaxed);
+    }
+
+    std::uint64_t timing_histogram::count() const noexcept
+    {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t timing_histogram::max() const noexcept
+    {
+        return _max.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t timing_histogram::mean() const noexcept
+    {
+        auto&& n = count();
+        return n == 0 ? 0 : _sum.load(std::memory_order_relaxed) / n;
+    }
+
+    std::uint64_t timing_histogram::bucket_limit(std::size_t bucket) noexcept
+    {
+        if(bucket < sub_buckets)
+        {
+            return bucket;
+        }
+        auto&& shift = bucket / sub_buckets - 1;
+        auto&& low = static_cast<std::uint64_t>(sub_buckets + bucket % sub_buckets) << shift;
+        return low + ((std::uint64_t(1) << shift) - 1);
+    }
+
+    std::uint64_t timing_histogram::percentile(double fraction) const noexcept
+    {
+        //the total is taken from the buckets themselves so a record racing with us cannot push the rank past the end
+        std::uint64_t counts[bucket_count];
+        std::uint64_t total = 0;
+        for(std::size_t b = 0; b < bucket_count; ++b)
+        {
+            counts[b] = _buckets[b].load(std::memory_order_relaxed);
+            total += counts[b];
+        }
+        if(total == 0)
+        {
+            return 0;
+        }
+        auto&& rank = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+        rank = rank == 0 ? 1 : (rank > total ? total : rank);
+        std::uint64_t seen = 0;
+        for(std::size_t b = 0; b < bucket_count; ++b)
+        {
+            seen += counts[b];
+            if(seen >= rank)
+            {
+                //never report more than the largest duration actually seen
+                auto&& limit = bucket_limit(b);
+                auto&& largest = max();
+                return largest != 0 && largest < limit ? largest : limit;
+            }
+        }
+        return max();
+    }
+
+    callback_timer::callback_timer() noexcept: _worst_margin(std::numeric_limits<std::int64_t>::max()),
+                                               _overruns(0),
+                                               _reset_requested(false){}
+
+    void callback_timer::_clear() noexcept
+    {
+        _durations.clear();
+        _margins.clear();
+        _worst_margin.store(std::numeric_limits<std::int64_t>::max(),std::memory_order_relaxed);
+        _overruns.store(0,std::memory_order_relaxed);
+        _reset_requested.store(false,std::memory_order_relaxed);
+    }
+
+    void callback_timer::reset() noexcept
+    {
+        _reset_requested.store(true,std::memory_order_relaxed);
+    }
+
+    callback_statistics callback_timer::statistics() const noexcept
+    {
+        callback_statistics stats;
+        if(_reset_requested.load(std::memory_order_relaxed))
+        {
+            return stats;
+        }
+        stats.callbacks = _durations.count();
+        if(stats.callbacks == 0)
+        {
+            return stats;
+        }
+        stats.mean = std::chrono::nanoseconds(_durations.mean());
+        stats.p50 = std::chrono::nanoseconds(_durations.percentile(0.5));
+        stats.p99 = std::chrono::nanoseconds(_durations.percentile(0.99));
+        stats.p999 = std::chrono::nanoseconds(_durations.percentile(0.999));
+        stats.max = std::chrono::nanoseconds(_durations.max());
+        stats.margin_p50 = std::chrono::nanoseconds(_margins.percentile(0.5));
+        stats.margin_p1 = std::chrono::nanoseconds(_margins.percentile(0.01));
+        stats.margin_p01 = std::chrono::nanoseconds(_margins.percentile(0.001));
+        stats.worst_margin = std::chrono::nanoseconds(_worst_margin.load(std::memory_order_relaxed));
+        stats.overruns = _overruns.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const callback_statistics& stats)
+    {
+        auto&& us = [](std::chrono::nanoseconds ns)
+        {
+            return static_cast<double>(ns.count()) / 1000.0;
+        };
+        os<<"Callbacks: "<<stats.callbacks<<std::endl;
+        os<<"Processing Time (us): mean "<<us(stats.mean)<<", p50 "<<us(stats.p50)<<", p99 "<<us(stats.p99)<<", p99.9 "<<us(stats.p999)<<", max "<<us(stats.max)<<std::endl;
+        os<<"Deadline Margin (us): p50 "<<us(stats.margin_p50)<<", p1 "<<us(stats.margin_p1)<<", p0.1 "<<us(stats.margin_p01)<<", worst "<<us(stats.worst_margin)<<std::endl;
+        os<<"Overruns: "<<stats.overruns<<std::endl;
+        return os;
+    }
+
+    constexpr double drift_controller::max_drift;
+
+    constexpr double drift_controller::max_correction;
+
+    drift_controller::drift_controller() noexcept: _sample_rate(0),
+                                                   _target(0),
+                                                   _kp(0),
+                                                   _ki(0),
+                                                   _smoothing(0),
+                                                   _error(0),
+                                                   _drift(0),
+                                                   _ratio(1){}
+
+    void drift_controller::prepare(double sample_rate, double target_fill, double bandwidth) noexcept
+    {
+        //error'' = -_kp error' - _ki error, damped by 1/sqrt(2) so it settles without ringing
+        auto&& w = two_pi * bandwidth;
+        _sample_rate = sample_rate;
+        _target = target_fill;
+        _kp = std::sqrt(2.0) * w;
+        _ki = w * w;
+        //well above the loop bandwidth so it adds little phase lag
+        _smoothing = 10.0 * bandwidth;
+        _drift = 0;
+        reset();
+    }
+
+    void drift_controller::reset() noexcept
+    {
+        _error = 0;
+        _ratio = 1.0 + _drift;
+    }
+
+    double drift_controller::update(double fill, std::size_t frames) noexcept
+    {
+        auto&& dt = frames / _sample_rate;
+        auto&& error = (fill - _target) / _sample_rate;
+        _error += (1.0 - std::exp(-two_pi * _smoothing * dt)) * (error - _error);
+        _drift = std::max(-max_drift,std::min(max_drift,_drift + _ki * _error * dt));
+        _ratio = std::max(1.0 - max_correction,std::min(1.0 + max_correction,1.0 + _drift + _kp * _error));
+        return _ratio;
+    }
+
+    double drift_controller::ratio() const noexcept
+    {
+        return _ratio;
+    }
+
+    double drift_controller::drift() const noexcept
+    {
+        return _drift;
+    }
+
+    double drift_controller::fill() const noexcept
+    {
+        return _target + _error * _sample_rate;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const drift_statistics& stats)
+    {
+        os<<"Drift: "<<stats.drift_ppm<<" ppm, ratio "<<stats.ratio<<(stats.locked ? "" : " (not locked)")<<std::endl;
+        os<<"Fifo Fill: "<<stats.fill<<" frames, target "<<stats.target_fill<<", max "<<stats.max_fill<<std::endl;
+        os<<"Underflows: "<<stats.underflows<<", Overflows: "<<stats.overflows<<std::endl;
+        return os;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const graph_schedule_info& info)
+    {
+        os<<"Nodes: "<<info.nodes<<", Ports: "<<info.ports<<", Buffers: "<<info.buffers<<std::endl;
+        os<<"Samples: "<<info.samples<<" in blocks of "<<info.max_frames<<" frames"<<std::endl;
+        return os;
+    }
+
+
+
+    //how often the dispatcher checks for new errors, the audio thread never wakes it directly
+    constexpr static auto error_dispatch_interval = std::chrono::milliseconds(5);
+
+    stream_error_dispatcher::stream_error_dispatcher(std::atomic<stream_error_callback*>& callback) noexcept: _callback(callback),
+                                                                                                              _delivery_epoch(0),
+                                                                                                              _running(false){}
+
+    stream_error_dispatcher::~stream_error_dispatcher()
+    {
+        stop();
+    }
+
+    void stream_error_dispatcher::start() noexcept
+    {
+        if(!_running.exchange(true))
+        {
+            try
+            {
+                _thread = std::thread(&stream_error_dispatcher::_run,this);
+            }
+            catch(const std::system_error&)
+            {
+                _running.store(false);
+            }
+        }
+    }
+
+    void stream_error_dispatcher::stop() noexcept
+    {
+        _running.store(false);
+        if(_thread.joinable())
+        {
+            _thread.join();
+        }
+    }
+
+    bool stream_error_dispatcher::report(const stream_error& err) noexcept
+    {
+        return _queue.push(err);
+    }
+
+    void stream_error_dispatcher::wait_for_delivery_boundary() const noexcept
+    {
+        auto&& epoch = _delivery_epoch.load();
+        if(epoch % 2 != 0)
+        {
+            while(_delivery_epoch.load(std::memory_order_acquire) == epoch){ std::this_thread::yield(); }
+        }
+    }
+
+    void stream_error_dispatcher::flush() const noexcept
+    {
+        while(_running.load(std::memory_order_acquire) && !_queue.empty())
+        {
+            std::this_thread::sleep_for(error_dispatch_interval);
+        }
+        wait_for_delivery_boundary();
+    }
+
+    std::size_t stream_error_dispatcher::dropped_error_count() const noexcept
+    {
+        return _queue.dropped();
+    }
+
+    std::size_t stream_error_dispatcher::coalesced_error_count() const noexcept
+    {
+        return _queue.coalesced();
+    }
+
+    void stream_error_dispatcher::_run() noexcept
+    {
+        while(_running.load(std::memory_order_acquire))
+        {
+            _deliver_pending();
+            std::this_thread::sleep_for(error_dispatch_interval);
+        }
+        _deliver_pending();
+    }
+
+    void stream_error_dispatcher::_deliver_pending() noexcept
+    {
+        stream_error err;
+        while(_queue.pop(err))
+        {
+            _delivery_epoch.fetch_add(1);
+            auto&& cb = _callback.load();
+            try
+            {
+                if(cb != nullptr && *cb)
+                {
+                    (*cb)(err);
+                }
+            }
+            catch(...)
+            {
+                //the error callback is allowed to throw, there is nobody left to report that to
+            }
+            _delivery_epoch.fetch_add(1,std::memory_order_release);
+        }
+    }
+
+
+#if defined(ZAUDIO_X86) && (defined(__GNUC__) || defined(__clang__))
+    //__builtin_cpu_init is required when this runs from a static initializer
+    bool cpu_has_sse2() noexcept
+    {
+        __builtin_cpu_init();
+        static const bool has = __builtin_cpu_supports("sse2");
+        return has;
+    }
+
+    bool cpu_has_ssse3() noexcept
+    {
+        __builtin_cpu_init();
+        static const bool has = __builtin_cpu_supports("ssse3");
+        return has;
+    }
+
+    bool cpu_has_avx2() noexcept
+    {
+        __builtin_cpu_init();
+        static const bool has = __builtin_cpu_supports("avx2");
+        return has;
+    }
+
+    bool cpu_has_fma() noexcept
+    {
+        __builtin_cpu_init();
+        static const bool has = __builtin_cpu_supports("fma");
+        return has;
+    }
+#elif defined(ZAUDIO_X86) && defined(_MSC_VER)
+    namespace
+    {
+        //the avx state must also be enabled by the os before avx instructions can be used
+        bool os_saves_ymm() noexcept
+        {
+            int info[4];
+            __cpuid(info,1);
+            return (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        }
+    }
+
+    bool cpu_has_sse2() noexcept
+    {
+        return true;
+    }
+
+    bool cpu_has_ssse3() noexcept
+    {
+        static const bool has = []
+        {
+            int info[4];
+            __cpuid(info,1);
+            return (info[2] & (1 << 9)) != 0;
+        }();
+        return has;
+    }
+
+    bool cpu_has_avx2() noexcept
+    {
+        static const bool has = []
+        {
+            int info[4];
+            __cpuidex(info,7,0);
+            return (info[1] & (1 << 5)) != 0 && os_saves_ymm();
+        }();
+        return has;
+    }
+
+    bool cpu_has_fma() noexcept
+    {
+        static const bool has = []
+        {
+            int info[4];
+            __cpuid(info,1);
+            return (info[2] & (1 << 12)) != 0 && os_saves_ymm();
+        }();
+        return has;
+    }
+#else
+    bool cpu_has_sse2() noexcept
+    {
+        return false;
+    }
 
+    bool cpu_has_ssse3() noexcept
+    {
+        return false;
+    }
+
+    bool cpu_has_avx2() noexcept
+    {
+        return false;
+    }
+
+    bool cpu_has_fma() noexcept
+    {
+        return false;
+    }
+#endif
 }
@@ -0,0 +1,264 @@
+#include <realtime_policy.hpp>
+#include <simd_utility.hpp>
+#include <cerrno>
+#include <system_error>
+#ifdef ZAUDIO_X86
+#include <immintrin.h>
+#endif
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(_MSC_VER)
+#define ZAUDIO_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__) || defined(__clang__)
+#define ZAUDIO_NOINLINE __attribute__((noinline))
+#else
+#define ZAUDIO_NOINLINE
+#endif
+
+namespace zaudio
+{
+    namespace
+    {
+        constexpr std::size_t prefault_chunk = 4096;
+
+        //each call owns one chunk of stack, the read after the recursive call keeps it from becoming a tail call
+        ZAUDIO_NOINLINE std::size_t prefault(std::size_t bytes) noexcept
+        {
+            volatile unsigned char chunk[prefault_chunk];
+            for(std::size_t i = 0; i < prefault_chunk; i += 256)
+            {
+                chunk[i] = 0;
+            }
+            std::size_t done = prefault_chunk;
+            if(bytes > prefault_chunk)
+            {
+                done += prefault(bytes - prefault_chunk);
+            }
+            static_cast<void>(chunk[0]);
+            return done;
+        }
+
+        //flush to zero and denormals are zero, read back so the status reflects the thread state
+        realtime_result flush_denormals() noexcept
+        {
+#if defined(ZAUDIO_X86)
+            _mm_setcsr(_mm_getcsr() | 0x8040);
+            return (_mm_getcsr() & 0x8040) == 0x8040 ? realtime_result::applied : realtime_result::failed;
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+            std::uint64_t fpcr;
+            __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+            __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (std::uint64_t(1) << 24)));
+            __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+            return (fpcr & (std::uint64_t(1) << 24)) != 0 ? realtime_result::applied : realtime_result::failed;
+#else
+            return realtime_result::unsupported;
+#endif
+        }
+
+#if defined(_WIN32)
+        void apply_scheduling(const realtime_policy& policy, realtime_status& status) noexcept
+        {
+            //windows has no realtime classes for a single thread, time critical is the closest
+            auto&& thread = GetCurrentThread();
+            status.scheduling = SetThreadPriority(thread,THREAD_PRIORITY_TIME_CRITICAL) ? realtime_result::applied : realtime_result::failed;
+            status.scheduling_error = status.scheduling == realtime_result::failed ? static_cast<int>(GetLastError()) : 0;
+            status.priority = GetThreadPriority(thread);
+            status.scheduling_class = status.priority == THREAD_PRIORITY_TIME_CRITICAL ? policy.scheduling() : realtime_scheduling::inherit;
+        }
+
+        void apply_affinity(const realtime_policy& policy, realtime_status& status) noexcept
+        {
+            auto&& mask = static_cast<DWORD_PTR>(policy.cpu_mask());
+            if(SetThreadAffinityMask(GetCurrentThread(),mask) != 0)
+            {
+                status.affinity = realtime_result::applied;
+                status.cpu_mask = mask;
+            }
+            else
+            {
+                status.affinity = realtime_result::failed;
+                status.affinity_error = static_cast<int>(GetLastError());
+            }
+        }
+
+        void apply_memory_lock(realtime_status& status) noexcept
+        {
+            //VirtualLock only covers ranges that already exist, there is no equivalent of locking future pages
+            status.memory_lock = realtime_result::unsupported;
+        }
+#elif defined(__unix__) || defined(__APPLE__)
+        void apply_scheduling(const realtime_policy& policy, realtime_status& status) noexcept
+        {
+            auto&& thread = pthread_self();
+            const int requested = policy.scheduling() == realtime_scheduling::round_robin ? SCHED_RR : SCHED_FIFO;
+            auto&& lo = sched_get_priority_min(requested);
+            auto&& hi = sched_get_priority_max(requested);
+            sched_param param{};
+            param.sched_priority = policy.priority() < lo ? lo : (policy.priority() > hi ? hi : policy.priority());
+            auto&& err = pthread_setschedparam(thread,requested,&param);
+            status.scheduling = err == 0 ? realtime_result::applied : realtime_result::failed;
+            status.scheduling_error = err;
+            int actual = 0;
+            if(pthread_getschedparam(thread,&actual,&param) == 0)
+            {
+                status.scheduling_class = actual == SCHED_FIFO ? realtime_scheduling::fifo :
+                                         (actual == SCHED_RR ? realtime_scheduling::round_robin : realtime_scheduling::inherit);
+                status.priority = param.sched_priority;
+            }
+        }
+
+        void apply_affinity(const realtime_policy& policy, realtime_status& status) noexcept
+        {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for(int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu)
+            {
+                if((policy.cpu_mask() >> cpu) & 1)
+                {
+                    CPU_SET(cpu,&set);
+                }
+            }
+            auto&& thread = pthread_self();
+            auto&& err = pthread_setaffinity_np(thread,sizeof(set),&set);
+            status.affinity = err == 0 ? realtime_result::applied : realtime_result::failed;
+            status.affinity_error = err;
+            if(pthread_getaffinity_np(thread,sizeof(set),&set) == 0)
+            {
+                for(int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu)
+                {
+                    if(CPU_ISSET(cpu,&set))
+                    {
+                        status.cpu_mask |= std::uint64_t(1) << cpu;
+                    }
+                }
+            }
+#else
+            //macos only offers affinity hints between threads, not pinning
+            static_cast<void>(policy);
+            status.affinity = realtime_result::unsupported;
+#endif
+        }
+
+        void apply_memory_lock(realtime_status& status) noexcept
+        {
+            auto&& ok = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+            status.memory_lock = ok ? realtime_result::applied : realtime_result::failed;
+            status.memory_lock_error = ok ? 0 : errno;
+        }
+#else
+        void apply_scheduling(const realtime_policy&, realtime_status& status) noexcept
+        {
+            status.scheduling = realtime_result::unsupported;
+        }
+
+        void apply_affinity(const realtime_policy&, realtime_status& status) noexcept
+        {
+            status.affinity = realtime_result::unsupported;
+        }
+
+        void apply_memory_lock(realtime_status& status) noexcept
+        {
+            status.memory_lock = realtime_result::unsupported;
+        }
+#endif
+
+        const char* realtime_scheduling_name(realtime_scheduling s) noexcept
+        {
+            return s == realtime_scheduling::fifo ? "fifo" : (s == realtime_scheduling::round_robin ? "round robin" : "default");
+        }
+    }
+
+    realtime_status apply_realtime_policy(const realtime_policy& policy) noexcept
+    {
+        realtime_status status;
+        //memory first so the stack pages touched below stay resident
+        if(policy.lock_memory())
+        {
+            apply_memory_lock(status);
+        }
+        if(policy.prefault_stack() != 0)
+        {
+            status.prefaulted_bytes = prefault(policy.prefault_stack());
+            status.stack_prefault = realtime_result::applied;
+        }
+        if(policy.flush_denormals())
+        {
+            status.denormals = flush_denormals();
+        }
+        if(policy.cpu_mask() != 0)
+        {
+            apply_affinity(policy,status);
+        }
+        if(policy.scheduling() != realtime_scheduling::inherit)
+        {
+            apply_scheduling(policy,status);
+        }
+        status.applied = true;
+        return status;
+    }
+
+    std::ostream& operator<<(std::ostream& os, realtime_result result)
+    {
+        switch(result)
+        {
+            case realtime_result::not_requested: return os<<"not requested";
+            case realtime_result::applied: return os<<"applied";
+            case realtime_result::failed: return os<<"failed";
+            case realtime_result::unsupported: return os<<"unsupported";
+        }
+        return os;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const realtime_status& status)
+    {
+        auto&& reason = [&](int err)
+        {
+            if(err != 0)
+            {
+                os<<" ("<<std::error_code(err,std::system_category()).message()<<")";
+            }
+        };
+        if(!status.applied)
+        {
+            return os<<"Realtime Policy: not applied yet"<<std::endl;
+        }
+        os<<"Scheduling: "<<status.scheduling;
+        reason(status.scheduling_error);
+        os<<", running "<<realtime_scheduling_name(status.scheduling_class)<<" at priority "<<status.priority<<std::endl;
+        os<<"Affinity: "<<status.affinity;
+        reason(status.affinity_error);
+        os<<", cpu mask 0x"<<std::hex<<status.cpu_mask<<std::dec<<std::endl;
+        os<<"Denormals Flushed: "<<status.denormals<<std::endl;
+        os<<"Memory Lock: "<<status.memory_lock;
+        reason(status.memory_lock_error);
+        os<<std::endl;
+        os<<"Stack Prefault: "<<status.stack_prefault<<", "<<status.prefaulted_bytes<<" bytes"<<std::endl;
+        return os;
+    }
+}
@@ -0,0 +1,1051 @@
+#include <sample_conversion.hpp>
+#include <cmath>
+#include <cstring>
+#ifdef ZAUDIO_X86
+#include <immintrin.h>
+#endif
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+namespace zaudio
+{
+    dither_state::dither_state(std::uint32_t seed) noexcept
+    {
+        for(auto&& lane: lanes)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            //xorshift never leaves zero
+            lane = seed != 0 ? seed : 1;
+        }
+    }
+
+    namespace
+    {
+        //block size used when a conversion goes through an intermediate float buffer
+        constexpr std::size_t conversion_block = 256;
+
+        //each integer format is described by its full scale and the range samples are clamped to before rounding
+        //unsigned 8 bit is converted as signed 8 bit with the top bit flipped
+        struct int_range
+        {
+            float scale;
+            float lo;
+            float hi;
+        };
+
+        constexpr int_range i8_range{128.f,-128.f,127.f};
+        constexpr int_range i16_range{32768.f,-32768.f,32767.f};
+        constexpr int_range i24_range{8388608.f,-8388608.f,8388607.f};
+        //2^31 does not fit, the kernels saturate it to the largest int32 after rounding
+        constexpr int_range i32_range{2147483648.f,-2147483648.f,2147483648.f};
+
+        inline std::uint32_t next_noise(std::uint32_t& s) noexcept
+        {
+            s ^= s << 13;
+            s ^= s >> 17;
+            s ^= s << 5;
+            return s;
+        }
+
+        inline float scalar_noise(dither_state* dither) noexcept
+        {
+            if(dither == nullptr)
+            {
+                return 0.f;
+            }
+            auto&& a = static_cast<std::int32_t>(next_noise(dither->lanes[0]));
+            auto&& b = static_cast<std::int32_t>(next_noise(dither->lanes[8]));
+            return (float(a) + float(b)) * (1.f / 4294967296.f);
+        }
+
+        //written to match the nan and rounding behaviour of the vector kernels
+        inline std::int32_t scalar_quantize(float v, const int_range& r, dither_state* dither) noexcept
+        {
+            v = v * r.scale + scalar_noise(dither);
+            v = v > r.lo ? v : r.lo;
+            v = v < r.hi ? v : r.hi;
+            return v >= 2147483648.f ? 2147483647 : static_cast<std::int32_t>(std::lrintf(v));
+        }
+
+        template<typename out_t>
+        void scalar_to_int(const float* in, out_t* out, std::size_t count, const int_range& r, std::int32_t offset, dither_state* dither) noexcept
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = static_cast<out_t>(scalar_quantize(in[i],r,dither) + offset);
+            }
+        }
+
+        template<typename in_t>
+        void scalar_from_int(const in_t* in, float* out, std::size_t count, float scale, std::int32_t offset) noexcept
+        {
+            const float inv = 1.f / scale;
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = float(std::int32_t(in[i]) - offset) * inv;
+            }
+        }
+
+        void scalar_f64_to_i32(const double* in, std::int32_t* out, std::size_t count, dither_state* dither) noexcept
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                auto&& v = in[i] * 2147483648.0 + scalar_noise(dither);
+                v = v > -2147483648.0 ? v : -2147483648.0;
+                v = v < 2147483647.0 ? v : 2147483647.0;
+                out[i] = static_cast<std::int32_t>(std::lrint(v));
+            }
+        }
+
+        void scalar_i32_to_f64(const std::int32_t* in, double* out, std::size_t count) noexcept
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = in[i] * (1.0 / 2147483648.0);
+            }
+        }
+
+        //rounds to nearest even like the float kernels, the one value that would overflow is saturated
+        inline std::int32_t scalar_i32_to_i24(std::int32_t v) noexcept
+        {
+            auto&& q = v >> 8;
+            auto&& r = q + (((v & 0xFF) + (q & 1)) > 128 ? 1 : 0);
+            return r == 0x800000 ? 0x7FFFFF : r;
+        }
+
+        void scalar_f32_to_s24(const float* in, detail::s24* out, std::size_t count, dither_state* dither) noexcept
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = detail::s24(scalar_quantize(in[i],i24_range,dither));
+            }
+        }
+
+        //rounded in double precision, a float holds too few bits to round a 24 bit sample to nearest
+        void scalar_f64_to_s24(const double* in, detail::s24* out, std::size_t count, dither_state* dither) noexcept
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                auto&& v = in[i] * 8388608.0 + scalar_noise(dither);
+                v = v > -8388608.0 ? v : -8388608.0;
+                v = v < 8388607.0 ? v : 8388607.0;
+                out[i] = detail::s24(static_cast<std::int32_t>(std::lrint(v)));
+            }
+        }
+
+        void scalar_i32_to_s24(const std::int32_t* in, detail::s24* out, std::size_t count) noexcept
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = detail::s24(scalar_i32_to_i24(in[i]));
+            }
+        }
+
+        void scalar_s24_to_f32(const detail::s24* in, float* out, std::size_t count) noexcept
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = float(int(in[i])) * (1.f / 8388608.f);
+            }
+        }
+
+        void scalar_s24_to_i32(const detail::s24* in, std::int32_t* out, std::size_t count) noexcept
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = static_cast<std::int32_t>(static_cast<std::uint32_t>(int(in[i])) << 8);
+            }
+        }
+
+#ifdef ZAUDIO_X86
+        /*
+         * sse2 kernels, the baseline on every x86 target this library builds for
+         */
+
+        //two sets of four independent generators, one for each half of the tpdf sum so the two draws do not wait on each other
+        //the state is written back when the kernel finishes
+        class sse2_quantizer
+        {
+        public:
+            sse2_quantizer(const int_range& r, dither_state* dither) noexcept : _scale(_mm_set1_ps(r.scale)),
+                                                                                _lo(_mm_set1_ps(r.lo)),
+                                                                                _hi(_mm_set1_ps(r.hi)),
+                                                                                _dither(dither),
+                                                                                _a(dither != nullptr ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes)) : _mm_setzero_si128()),
+                                                                                _b(dither != nullptr ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->lanes + 4)) : _mm_setzero_si128())
+            {}
+            __m128i operator()(__m128 v) noexcept
+            {
+                v = _mm_mul_ps(v,_scale);
+                if(_dither != nullptr)
+                {
+                    v = _mm_add_ps(v,noise());
+                }
+                v = _mm_min_ps(_mm_max_ps(v,_lo),_hi);
+                //out of range conversions give 0x80000000, flipping every bit of those lanes gives 0x7fffffff
+                return _mm_xor_si128(_mm_cvtps_epi32(v),_mm_castps_si128(_mm_cmpge_ps(v,_mm_set1_ps(2147483648.f))));
+            }
+            __m128i operator()(const float* p) noexcept
+            {
+                return (*this)(_mm_loadu_ps(p));
+            }
+            //tpdf noise in the range [-1,1) lsb
+            __m128 noise() noexcept
+            {
+                _a = _next(_a);
+                _b = _next(_b);
+                return _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(_a),_mm_cvtepi32_ps(_b)),_mm_set1_ps(1.f / 4294967296.f));
+            }
+            void store() noexcept
+            {
+                if(_dither != nullptr)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(_dither->lanes),_a);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(_dither->lanes + 4),_b);
+                }
+            }
+        private:
+            static __m128i _next(__m128i s) noexcept
+            {
+                s = _mm_xor_si128(s,_mm_slli_epi32(s,13));
+                s = _mm_xor_si128(s,_mm_srli_epi32(s,17));
+                return _mm_xor_si128(s,_mm_slli_epi32(s,5));
+            }
+            __m128 _scale;
+            __m128 _lo;
+            __m128 _hi;
+            dither_state* _dither;
+            __m128i _a;
+            __m128i _b;
+        };
+
+        template<bool flip>
+        void sse2_f32_to_8bit(const float* in, std::uint8_t* out, std::size_t count, dither_state* dither) noexcept
+        {
+            sse2_quantizer q(i8_range,dither);
+            const __m128i bias = _mm_set1_epi8(flip ? char(0x80) : 0);
+            std::size_t i = 0;
+            for(; i + 16 <= count; i += 16)
+            {
+                auto&& ab = _mm_packs_epi32(q(in + i),q(in + i + 4));
+                auto&& cd = _mm_packs_epi32(q(in + i + 8),q(in + i + 12));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),_mm_xor_si128(_mm_packs_epi16(ab,cd),bias));
+            }
+            q.store();
+            scalar_to_int(in + i,out + i,count - i,i8_range,flip ? 128 : 0,dither);
+        }
+
+        void sse2_f32_to_i16(const float* in, std::int16_t* out, std::size_t count, dither_state* dither) noexcept
+        {
+            sse2_quantizer q(i16_range,dither);
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),_mm_packs_epi32(q(in + i),q(in + i + 4)));
+            }
+            q.store();
+            scalar_to_int(in + i,out + i,count - i,i16_range,0,dither);
+        }
+
+        void sse2_f32_to_i32(const float* in, std::int32_t* out, std::size_t count, dither_state* dither) noexcept
+        {
+            sse2_quantizer q(i32_range,dither);
+            std::size_t i = 0;
+            for(; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),q(in + i));
+            }
+            q.store();
+            scalar_to_int(in + i,out + i,count - i,i32_range,0,dither);
+        }
+
+        template<bool flip>
+        void sse2_8bit_to_f32(const std::uint8_t* in, float* out, std::size_t count) noexcept
+        {
+            const __m128i bias = _mm_set1_epi8(flip ? char(0x80) : 0);
+            const __m128 scale = _mm_set1_ps(1.f / 128.f);
+            std::size_t i = 0;
+            for(; i + 16 <= count; i += 16)
+            {
+                auto&& v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)),bias);
+                //place each byte in the top of a wider lane and shift it back down to sign extend
+                auto&& lo = _mm_unpacklo_epi8(v,v);
+                auto&& hi = _mm_unpackhi_epi8(v,v);
+                _mm_storeu_ps(out + i,     _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo,lo),24)),scale));
+                _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo,lo),24)),scale));
+                _mm_storeu_ps(out + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi,hi),24)),scale));
+                _mm_storeu_ps(out + i + 12,_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi,hi),24)),scale));
+            }
+            if(flip)
+            {
+                scalar_from_int(in + i,out + i,count - i,128.f,128);
+            }
+            else
+            {
+                scalar_from_int(reinterpret_cast<const std::int8_t*>(in) + i,out + i,count - i,128.f,0);
+            }
+        }
+
+        void sse2_i16_to_f32(const std::int16_t* in, float* out, std::size_t count) noexcept
+        {
+            const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                auto&& v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                _mm_storeu_ps(out + i,    _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v,v),16)),scale));
+                _mm_storeu_ps(out + i + 4,_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v,v),16)),scale));
+            }
+            scalar_from_int(in + i,out + i,count - i,32768.f,0);
+        }
+
+        void sse2_i32_to_f32(const std::int32_t* in, float* out, std::size_t count) noexcept
+        {
+            const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+            std::size_t i = 0;
+            for(; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_ps(out + i,_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))),scale));
+            }
+            scalar_from_int(in + i,out + i,count - i,2147483648.f,0);
+        }
+
+        void sse2_f32_to_f64(const float* in, double* out, std::size_t count) noexcept
+        {
+            std::size_t i = 0;
+            for(; i + 4 <= count; i += 4)
+            {
+                auto&& v = _mm_loadu_ps(in + i);
+                _mm_storeu_pd(out + i,    _mm_cvtps_pd(v));
+                _mm_storeu_pd(out + i + 2,_mm_cvtps_pd(_mm_movehl_ps(v,v)));
+            }
+            for(; i < count; ++i)
+            {
+                out[i] = in[i];
+            }
+        }
+
+        void sse2_f64_to_f32(const double* in, float* out, std::size_t count) noexcept
+        {
+            std::size_t i = 0;
+            for(; i + 4 <= count; i += 4)
+            {
+                auto&& lo = _mm_cvtpd_ps(_mm_loadu_pd(in + i));
+                auto&& hi = _mm_cvtpd_ps(_mm_loadu_pd(in + i + 2));
+                _mm_storeu_ps(out + i,_mm_movelh_ps(lo,hi));
+            }
+            for(; i < count; ++i)
+            {
+                out[i] = static_cast<float>(in[i]);
+            }
+        }
+
+        void sse2_f64_to_i32(const double* in, std::int32_t* out, std::size_t count, dither_state* dither) noexcept
+        {
+            //the noise is generated in single precision, it is far below the resolution of the result
+            sse2_quantizer q(i32_range,dither);
+            const __m128d scale = _mm_set1_pd(2147483648.0);
+            const __m128d lo = _mm_set1_pd(-2147483648.0);
+            const __m128d hi = _mm_set1_pd(2147483647.0);
+            std::size_t i = 0;
+            for(; i + 4 <= count; i += 4)
+            {
+                auto&& a = _mm_mul_pd(_mm_loadu_pd(in + i),scale);
+                auto&& b = _mm_mul_pd(_mm_loadu_pd(in + i + 2),scale);
+                if(dither != nullptr)
+                {
+                    auto&& n = q.noise();
+                    a = _mm_add_pd(a,_mm_cvtps_pd(n));
+                    b = _mm_add_pd(b,_mm_cvtps_pd(_mm_movehl_ps(n,n)));
+                }
+                a = _mm_min_pd(_mm_max_pd(a,lo),hi);
+                b = _mm_min_pd(_mm_max_pd(b,lo),hi);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),_mm_unpacklo_epi64(_mm_cvtpd_epi32(a),_mm_cvtpd_epi32(b)));
+            }
+            q.store();
+            scalar_f64_to_i32(in + i,out + i,count - i,dither);
+        }
+
+        void sse2_i32_to_f64(const std::int32_t* in, double* out, std::size_t count) noexcept
+        {
+            const __m128d scale = _mm_set1_pd(1.0 / 2147483648.0);
+            std::size_t i = 0;
+            for(; i + 4 <= count; i += 4)
+            {
+                auto&& v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                _mm_storeu_pd(out + i,    _mm_mul_pd(_mm_cvtepi32_pd(v),scale));
+                _mm_storeu_pd(out + i + 2,_mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(v,v)),scale));
+            }
+            scalar_i32_to_f64(in + i,out + i,count - i);
+        }
+
+        /*
+         * avx2 kernels, only called when cpu_has_avx2() is true
+         */
+
+        class avx2_quantizer
+        {
+        public:
+            ZAUDIO_TARGET_AVX2 avx2_quantizer(const int_range& r, dither_state* dither) noexcept : _scale(_mm256_set1_ps(r.scale)),
+                                                                                                   _lo(_mm256_set1_ps(r.lo)),
+                                                                                                   _hi(_mm256_set1_ps(r.hi)),
+                                                                                                   _dither(dither),
+                                                                                                   _a(dither != nullptr ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither->lanes)) : _mm256_setzero_si256()),
+                                                                                                   _b(dither != nullptr ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither->lanes + 8)) : _mm256_setzero_si256())
+            {}
+            ZAUDIO_TARGET_AVX2 __m256i operator()(const float* p) noexcept
+            {
+                auto&& v = _mm256_mul_ps(_mm256_loadu_ps(p),_scale);
+                if(_dither != nullptr)
+                {
+                    _a = _next(_a);
+                    _b = _next(_b);
+                    v = _mm256_add_ps(v,_mm256_mul_ps(_mm256_add_ps(_mm256_cvtepi32_ps(_a),_mm256_cvtepi32_ps(_b)),_mm256_set1_ps(1.f / 4294967296.f)));
+                }
+                v = _mm256_min_ps(_mm256_max_ps(v,_lo),_hi);
+                return _mm256_xor_si256(_mm256_cvtps_epi32(v),_mm256_castps_si256(_mm256_cmp_ps(v,_mm256_set1_ps(2147483648.f),_CMP_GE_OQ)));
+            }
+            ZAUDIO_TARGET_AVX2 void store() noexcept
+            {
+                if(_dither != nullptr)
+                {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(_dither->lanes),_a);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(_dither->lanes + 8),_b);
+                }
+            }
+        private:
+            ZAUDIO_TARGET_AVX2 static __m256i _next(__m256i s) noexcept
+            {
+                s = _mm256_xor_si256(s,_mm256_slli_epi32(s,13));
+                s = _mm256_xor_si256(s,_mm256_srli_epi32(s,17));
+                return _mm256_xor_si256(s,_mm256_slli_epi32(s,5));
+            }
+            __m256 _scale;
+            __m256 _lo;
+            __m256 _hi;
+            dither_state* _dither;
+            __m256i _a;
+            __m256i _b;
+        };
+
+        template<bool flip>
+        ZAUDIO_TARGET_AVX2 void avx2_f32_to_8bit(const float* in, std::uint8_t* out, std::size_t count, dither_state* dither) noexcept
+        {
+            avx2_quantizer q(i8_range,dither);
+            const __m256i bias = _mm256_set1_epi8(flip ? char(0x80) : 0);
+            //the packs work within each 128 bit lane, this puts the 4 byte groups back in order
+            const __m256i order = _mm256_setr_epi32(0,4,1,5,2,6,3,7);
+            std::size_t i = 0;
+            for(; i + 32 <= count; i += 32)
+            {
+                auto&& ab = _mm256_packs_epi32(q(in + i),q(in + i + 8));
+                auto&& cd = _mm256_packs_epi32(q(in + i + 16),q(in + i + 24));
+                auto&& v = _mm256_permutevar8x32_epi32(_mm256_packs_epi16(ab,cd),order);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),_mm256_xor_si256(v,bias));
+            }
+            q.store();
+            scalar_to_int(in + i,out + i,count - i,i8_range,flip ? 128 : 0,dither);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_f32_to_i16(const float* in, std::int16_t* out, std::size_t count, dither_state* dither) noexcept
+        {
+            avx2_quantizer q(i16_range,dither);
+            std::size_t i = 0;
+            for(; i + 16 <= count; i += 16)
+            {
+                auto&& v = _mm256_permute4x64_epi64(_mm256_packs_epi32(q(in + i),q(in + i + 8)),0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),v);
+            }
+            q.store();
+            scalar_to_int(in + i,out + i,count - i,i16_range,0,dither);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_f32_to_i32(const float* in, std::int32_t* out, std::size_t count, dither_state* dither) noexcept
+        {
+            avx2_quantizer q(i32_range,dither);
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),q(in + i));
+            }
+            q.store();
+            scalar_to_int(in + i,out + i,count - i,i32_range,0,dither);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_i8_to_f32(const std::int8_t* in, float* out, std::size_t count) noexcept
+        {
+            const __m256 scale = _mm256_set1_ps(1.f / 128.f);
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                auto&& v = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+                _mm256_storeu_ps(out + i,_mm256_mul_ps(_mm256_cvtepi32_ps(v),scale));
+            }
+            scalar_from_int(in + i,out + i,count - i,128.f,0);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_u8_to_f32(const std::uint8_t* in, float* out, std::size_t count) noexcept
+        {
+            const __m256 scale = _mm256_set1_ps(1.f / 128.f);
+            const __m256i bias = _mm256_set1_epi32(128);
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                auto&& v = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i))),bias);
+                _mm256_storeu_ps(out + i,_mm256_mul_ps(_mm256_cvtepi32_ps(v),scale));
+            }
+            scalar_from_int(in + i,out + i,count - i,128.f,128);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_i16_to_f32(const std::int16_t* in, float* out, std::size_t count) noexcept
+        {
+            const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                auto&& v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+                _mm256_storeu_ps(out + i,_mm256_mul_ps(_mm256_cvtepi32_ps(v),scale));
+            }
+            scalar_from_int(in + i,out + i,count - i,32768.f,0);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_i32_to_f32(const std::int32_t* in, float* out, std::size_t count) noexcept
+        {
+            const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                auto&& v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                _mm256_storeu_ps(out + i,_mm256_mul_ps(_mm256_cvtepi32_ps(v),scale));
+            }
+            scalar_from_int(in + i,out + i,count - i,2147483648.f,0);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_f32_to_f64(const float* in, double* out, std::size_t count) noexcept
+        {
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                _mm256_storeu_pd(out + i,    _mm256_cvtps_pd(_mm_loadu_ps(in + i)));
+                _mm256_storeu_pd(out + i + 4,_mm256_cvtps_pd(_mm_loadu_ps(in + i + 4)));
+            }
+            for(; i < count; ++i)
+            {
+                out[i] = in[i];
+            }
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_f64_to_f32(const double* in, float* out, std::size_t count) noexcept
+        {
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                auto&& lo = _mm256_cvtpd_ps(_mm256_loadu_pd(in + i));
+                auto&& hi = _mm256_cvtpd_ps(_mm256_loadu_pd(in + i + 4));
+                _mm256_storeu_ps(out + i,_mm256_set_m128(hi,lo));
+            }
+            for(; i < count; ++i)
+            {
+                out[i] = static_cast<float>(in[i]);
+            }
+        }
+
+        /*
+         * packed 24 bit kernels, ssse3 and avx2 only
+         * unpacking places each sample in the top 3 bytes of a 32 bit lane, which is already its int32 value
+         * loads may read up to 4 bytes past the samples they use, the loop bounds keep those reads inside the buffer
+         */
+
+        ZAUDIO_TARGET_SSSE3 inline __m128i ssse3_unpack24(const detail::s24* p) noexcept
+        {
+            const __m128i spread = _mm_setr_epi8(-1,0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11);
+            return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),spread);
+        }
+
+        //v holds 24 bit values in the low 3 bytes of each lane, exactly 12 bytes are written
+        ZAUDIO_TARGET_SSSE3 inline void ssse3_pack24(__m128i v, detail::s24* p) noexcept
+        {
+            const __m128i gather = _mm_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+            v = _mm_shuffle_epi8(v,gather);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p),v);
+            auto&& tail = _mm_cvtsi128_si32(_mm_srli_si128(v,8));
+            std::memcpy(reinterpret_cast<char*>(p) + 8,&tail,4);
+        }
+
+        inline __m128i sse2_i32_to_i24(__m128i v) noexcept
+        {
+            auto&& q = _mm_srai_epi32(v,8);
+            auto&& rem = _mm_add_epi32(_mm_and_si128(v,_mm_set1_epi32(0xFF)),_mm_and_si128(q,_mm_set1_epi32(1)));
+            //subtracting the all ones compare mask adds one
+            auto&& r = _mm_sub_epi32(q,_mm_cmpgt_epi32(rem,_mm_set1_epi32(128)));
+            return _mm_add_epi32(r,_mm_cmpeq_epi32(r,_mm_set1_epi32(0x800000)));
+        }
+
+        ZAUDIO_TARGET_SSSE3 void ssse3_f32_to_s24(const float* in, detail::s24* out, std::size_t count, dither_state* dither) noexcept
+        {
+            sse2_quantizer q(i24_range,dither);
+            std::size_t i = 0;
+            for(; i + 4 <= count; i += 4)
+            {
+                ssse3_pack24(q(in + i),out + i);
+            }
+            q.store();
+            scalar_f32_to_s24(in + i,out + i,count - i,dither);
+        }
+
+        ZAUDIO_TARGET_SSSE3 void ssse3_f64_to_s24(const double* in, detail::s24* out, std::size_t count, dither_state* dither) noexcept
+        {
+            //the noise is generated in single precision like sse2_f64_to_i32, the rounding is done in double
+            sse2_quantizer q(i24_range,dither);
+            const __m128d scale = _mm_set1_pd(8388608.0);
+            const __m128d lo = _mm_set1_pd(-8388608.0);
+            const __m128d hi = _mm_set1_pd(8388607.0);
+            std::size_t i = 0;
+            for(; i + 4 <= count; i += 4)
+            {
+                auto&& a = _mm_mul_pd(_mm_loadu_pd(in + i),scale);
+                auto&& b = _mm_mul_pd(_mm_loadu_pd(in + i + 2),scale);
+                if(dither != nullptr)
+                {
+                    auto&& n = q.noise();
+                    a = _mm_add_pd(a,_mm_cvtps_pd(n));
+                    b = _mm_add_pd(b,_mm_cvtps_pd(_mm_movehl_ps(n,n)));
+                }
+                a = _mm_min_pd(_mm_max_pd(a,lo),hi);
+                b = _mm_min_pd(_mm_max_pd(b,lo),hi);
+                ssse3_pack24(_mm_unpacklo_epi64(_mm_cvtpd_epi32(a),_mm_cvtpd_epi32(b)),out + i);
+            }
+            q.store();
+            scalar_f64_to_s24(in + i,out + i,count - i,dither);
+        }
+
+        ZAUDIO_TARGET_SSSE3 void ssse3_i32_to_s24(const std::int32_t* in, detail::s24* out, std::size_t count) noexcept
+        {
+            std::size_t i = 0;
+            for(; i + 4 <= count; i += 4)
+            {
+                ssse3_pack24(sse2_i32_to_i24(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))),out + i);
+            }
+            scalar_i32_to_s24(in + i,out + i,count - i);
+        }
+
+        ZAUDIO_TARGET_SSSE3 void ssse3_s24_to_f32(const detail::s24* in, float* out, std::size_t count) noexcept
+        {
+            const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+            std::size_t i = 0;
+            for(; i + 6 <= count; i += 4)
+            {
+                _mm_storeu_ps(out + i,_mm_mul_ps(_mm_cvtepi32_ps(ssse3_unpack24(in + i)),scale));
+            }
+            scalar_s24_to_f32(in + i,out + i,count - i);
+        }
+
+        ZAUDIO_TARGET_SSSE3 void ssse3_s24_to_i32(const detail::s24* in, std::int32_t* out, std::size_t count) noexcept
+        {
+            std::size_t i = 0;
+            for(; i + 6 <= count; i += 4)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),ssse3_unpack24(in + i));
+            }
+            scalar_s24_to_i32(in + i,out + i,count - i);
+        }
+
+        ZAUDIO_TARGET_AVX2 inline __m256i avx2_unpack24(const detail::s24* p) noexcept
+        {
+            const __m256i spread = _mm256_setr_epi8(-1,0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11,
+                                                    -1,0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11);
+            auto&& lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            auto&& hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+            return _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo),hi,1),spread);
+        }
+
+        //exactly 24 bytes are written
+        ZAUDIO_TARGET_AVX2 inline void avx2_pack24(__m256i v, detail::s24* p) noexcept
+        {
+            const __m256i gather = _mm256_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1,
+                                                    0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+            //move the 12 bytes of the upper lane down next to the 12 bytes of the lower lane
+            const __m256i order = _mm256_setr_epi32(0,1,2,4,5,6,3,7);
+            v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v,gather),order);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p),_mm256_castsi256_si128(v));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(reinterpret_cast<char*>(p) + 16),_mm256_extracti128_si256(v,1));
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_f32_to_s24(const float* in, detail::s24* out, std::size_t count, dither_state* dither) noexcept
+        {
+            avx2_quantizer q(i24_range,dither);
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                avx2_pack24(q(in + i),out + i);
+            }
+            q.store();
+            scalar_f32_to_s24(in + i,out + i,count - i,dither);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_i32_to_s24(const std::int32_t* in, detail::s24* out, std::size_t count) noexcept
+        {
+            const __m256i one = _mm256_set1_epi32(1);
+            const __m256i low = _mm256_set1_epi32(0xFF);
+            const __m256i half = _mm256_set1_epi32(128);
+            const __m256i overflow = _mm256_set1_epi32(0x800000);
+            std::size_t i = 0;
+            for(; i + 8 <= count; i += 8)
+            {
+                auto&& v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                auto&& q = _mm256_srai_epi32(v,8);
+                auto&& rem = _mm256_add_epi32(_mm256_and_si256(v,low),_mm256_and_si256(q,one));
+                auto&& r = _mm256_sub_epi32(q,_mm256_cmpgt_epi32(rem,half));
+                avx2_pack24(_mm256_add_epi32(r,_mm256_cmpeq_epi32(r,overflow)),out + i);
+            }
+            scalar_i32_to_s24(in + i,out + i,count - i);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_s24_to_f32(const detail::s24* in, float* out, std::size_t count) noexcept
+        {
+            const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+            std::size_t i = 0;
+            for(; i + 10 <= count; i += 8)
+            {
+                _mm256_storeu_ps(out + i,_mm256_mul_ps(_mm256_cvtepi32_ps(avx2_unpack24(in + i)),scale));
+            }
+            scalar_s24_to_f32(in + i,out + i,count - i);
+        }
+
+        ZAUDIO_TARGET_AVX2 void avx2_s24_to_i32(const detail::s24* in, std::int32_t* out, std::size_t count) noexcept
+        {
+            std::size_t i = 0;
+            for(; i + 10 <= count; i += 8)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),avx2_unpack24(in + i));
+            }
+            scalar_s24_to_i32(in + i,out + i,count - i);
+        }
+
+        const bool use_avx2 = cpu_has_avx2();
+
+        const bool use_ssse3 = cpu_has_ssse3();
+#endif
+
+        //double to 8 and 16 bit formats goes through single precision, which holds every value exactly
+        template<typename out_t>
+        void f64_through_f32(const double* in, out_t* out, std::size_t count, dither_state* dither) noexcept
+        {
+            float block[conversion_block];
+            while(count > 0)
+            {
+                auto&& n = count < conversion_block ? count : conversion_block;
+                convert_samples(in,block,n);
+                convert_samples(block,out,n,dither);
+                in += n;
+                out += n;
+                count -= n;
+            }
+        }
+
+        template<typename in_t>
+        void f32_through_f64(const in_t* in, double* out, std::size_t count) noexcept
+        {
+            float block[conversion_block];
+            while(count > 0)
+            {
+                auto&& n = count < conversion_block ? count : conversion_block;
+                convert_samples(in,block,n);
+                convert_samples(block,out,n);
+                in += n;
+                out += n;
+                count -= n;
+            }
+        }
+    }
+
+    void convert_samples(const float* in, float* out, std::size_t count, dither_state*) noexcept
+    {
+        if(in != out)
+        {
+            std::memmove(out,in,count * sizeof(float));
+        }
+    }
+
+    void convert_samples(const float* in, double* out, std::size_t count, dither_state*) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_f32_to_f64(in,out,count);
+        }
+        sse2_f32_to_f64(in,out,count);
+#else
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = in[i];
+        }
+#endif
+    }
+
+    void convert_samples(const float* in, std::int8_t* out, std::size_t count, dither_state* dither) noexcept
+    {
+        auto&& bytes = reinterpret_cast<std::uint8_t*>(out);
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_f32_to_8bit<false>(in,bytes,count,dither);
+        }
+        sse2_f32_to_8bit<false>(in,bytes,count,dither);
+#else
+        scalar_to_int(in,bytes,count,i8_range,0,dither);
+#endif
+    }
+
+    void convert_samples(const float* in, std::uint8_t* out, std::size_t count, dither_state* dither) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_f32_to_8bit<true>(in,out,count,dither);
+        }
+        sse2_f32_to_8bit<true>(in,out,count,dither);
+#else
+        scalar_to_int(in,out,count,i8_range,128,dither);
+#endif
+    }
+
+    void convert_samples(const float* in, std::int16_t* out, std::size_t count, dither_state* dither) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_f32_to_i16(in,out,count,dither);
+        }
+        sse2_f32_to_i16(in,out,count,dither);
+#else
+        scalar_to_int(in,out,count,i16_range,0,dither);
+#endif
+    }
+
+    void convert_samples(const float* in, std::int32_t* out, std::size_t count, dither_state* dither) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_f32_to_i32(in,out,count,dither);
+        }
+        sse2_f32_to_i32(in,out,count,dither);
+#else
+        scalar_to_int(in,out,count,i32_range,0,dither);
+#endif
+    }
+
+    void convert_samples(const double* in, float* out, std::size_t count, dither_state*) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_f64_to_f32(in,out,count);
+        }
+        sse2_f64_to_f32(in,out,count);
+#else
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = static_cast<float>(in[i]);
+        }
+#endif
+    }
+
+    void convert_samples(const double* in, double* out, std::size_t count, dither_state*) noexcept
+    {
+        if(in != out)
+        {
+            std::memmove(out,in,count * sizeof(double));
+        }
+    }
+
+    void convert_samples(const double* in, std::int8_t* out, std::size_t count, dither_state* dither) noexcept
+    {
+        f64_through_f32(in,out,count,dither);
+    }
+
+    void convert_samples(const double* in, std::uint8_t* out, std::size_t count, dither_state* dither) noexcept
+    {
+        f64_through_f32(in,out,count,dither);
+    }
+
+    void convert_samples(const double* in, std::int16_t* out, std::size_t count, dither_state* dither) noexcept
+    {
+        f64_through_f32(in,out,count,dither);
+    }
+
+    void convert_samples(const double* in, std::int32_t* out, std::size_t count, dither_state* dither) noexcept
+    {
+#ifdef ZAUDIO_X86
+        sse2_f64_to_i32(in,out,count,dither);
+#else
+        scalar_f64_to_i32(in,out,count,dither);
+#endif
+    }
+
+    void convert_samples(const std::int8_t* in, float* out, std::size_t count) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_i8_to_f32(in,out,count);
+        }
+        sse2_8bit_to_f32<false>(reinterpret_cast<const std::uint8_t*>(in),out,count);
+#else
+        scalar_from_int(in,out,count,128.f,0);
+#endif
+    }
+
+    void convert_samples(const std::uint8_t* in, float* out, std::size_t count) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_u8_to_f32(in,out,count);
+        }
+        sse2_8bit_to_f32<true>(in,out,count);
+#else
+        scalar_from_int(in,out,count,128.f,128);
+#endif
+    }
+
+    void convert_samples(const std::int16_t* in, float* out, std::size_t count) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_i16_to_f32(in,out,count);
+        }
+        sse2_i16_to_f32(in,out,count);
+#else
+        scalar_from_int(in,out,count,32768.f,0);
+#endif
+    }
+
+    void convert_samples(const std::int32_t* in, float* out, std::size_t count) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_i32_to_f32(in,out,count);
+        }
+        sse2_i32_to_f32(in,out,count);
+#else
+        scalar_from_int(in,out,count,2147483648.f,0);
+#endif
+    }
+
+    void convert_samples(const std::int8_t* in, double* out, std::size_t count) noexcept
+    {
+        f32_through_f64(in,out,count);
+    }
+
+    void convert_samples(const std::uint8_t* in, double* out, std::size_t count) noexcept
+    {
+        f32_through_f64(in,out,count);
+    }
+
+    void convert_samples(const std::int16_t* in, double* out, std::size_t count) noexcept
+    {
+        f32_through_f64(in,out,count);
+    }
+
+    void convert_samples(const std::int32_t* in, double* out, std::size_t count) noexcept
+    {
+#ifdef ZAUDIO_X86
+        sse2_i32_to_f64(in,out,count);
+#else
+        scalar_i32_to_f64(in,out,count);
+#endif
+    }
+
+    void convert_samples(const float* in, detail::s24* out, std::size_t count, dither_state* dither) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_f32_to_s24(in,out,count,dither);
+        }
+        if(use_ssse3)
+        {
+            return ssse3_f32_to_s24(in,out,count,dither);
+        }
+#endif
+        scalar_f32_to_s24(in,out,count,dither);
+    }
+
+    void convert_samples(const double* in, detail::s24* out, std::size_t count, dither_state* dither) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_ssse3)
+        {
+            return ssse3_f64_to_s24(in,out,count,dither);
+        }
+#endif
+        scalar_f64_to_s24(in,out,count,dither);
+    }
+
+    void convert_samples(const std::int32_t* in, detail::s24* out, std::size_t count) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_i32_to_s24(in,out,count);
+        }
+        if(use_ssse3)
+        {
+            return ssse3_i32_to_s24(in,out,count);
+        }
+#endif
+        scalar_i32_to_s24(in,out,count);
+    }
+
+    void convert_samples(const detail::s24* in, float* out, std::size_t count) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_s24_to_f32(in,out,count);
+        }
+        if(use_ssse3)
+        {
+            return ssse3_s24_to_f32(in,out,count);
+        }
+#endif
+        scalar_s24_to_f32(in,out,count);
+    }
+
+    void convert_samples(const detail::s24* in, double* out, std::size_t count) noexcept
+    {
+        f32_through_f64(in,out,count);
+    }
+
+    void convert_samples(const detail::s24* in, std::int32_t* out, std::size_t count) noexcept
+    {
+#ifdef ZAUDIO_X86
+        if(use_avx2)
+        {
+            return avx2_s24_to_i32(in,out,count);
+        }
+        if(use_ssse3)
+        {
+            return ssse3_s24_to_i32(in,out,count);
+        }
+#endif
+        scalar_s24_to_i32(in,out,count);
+    }
+}
@@ -0,0 +1,519 @@
+#include <sample_rate_converter.hpp>
+#include <simd_utility.hpp>
+#include <interleave.hpp>
+#include <constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#ifdef ZAUDIO_X86
+#include <immintrin.h>
+#endif
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+namespace zaudio
+{
+    namespace
+    {
+        struct quality_preset
+        {
+            //taps at the lower of the two rates, a multiple of 8
+            std::size_t taps;
+
+            double attenuation;
+
+            //phases for ratios that are not rational, linear interpolation between them stays below the stopband
+            std::size_t phases;
+        };
+
+        quality_preset preset_of(resample_quality quality) noexcept
+        {
+            switch(quality)
+            {
+            case resample_quality::draft:
+                return {24,60.0,64};
+            case resample_quality::high:
+                return {96,110.0,1024};
+            case resample_quality::best:
+                return {192,140.0,4096};
+            default:
+                return {48,90.0,256};
+            }
+        }
+
+        //the kernels never need a scalar tail, the filters are zero padded to this
+        constexpr std::size_t tap_alignment = 8;
+
+        std::size_t align_taps(std::size_t taps) noexcept
+        {
+            return (taps + tap_alignment - 1) / tap_alignment * tap_alignment;
+        }
+
+        //zeroth order modified bessel function of the first kind
+        double bessel_i0(double x) noexcept
+        {
+            double sum = 1.0;
+            double term = 1.0;
+            for(std::size_t k = 1; k < 500; ++k)
+            {
+                auto&& half = x / (2.0 * static_cast<double>(k));
+                term *= half * half;
+                sum += term;
+                if(term < sum * 1e-21)
+                {
+                    break;
+                }
+            }
+            return sum;
+        }
+
+        //whole rates below 2^32, so their greatest common divisor is exact
+        bool whole_rate(double rate) noexcept
+        {
+            return rate == std::floor(rate) && rate <= 4294967295.0;
+        }
+
+        std::uint64_t gcd(std::uint64_t a, std::uint64_t b) noexcept
+        {
+            while(b != 0)
+            {
+                auto&& r = a % b;
+                a = b;
+                b = r;
+            }
+            return a;
+        }
+
+#ifdef ZAUDIO_X86
+        float sse2_sum(__m128 v) noexcept
+        {
+            v = _mm_add_ps(v,_mm_movehl_ps(v,v));
+            v = _mm_add_ss(v,_mm_shuffle_ps(v,v,1));
+            return _mm_cvtss_f32(v);
+        }
+
+        float sse2_dot(const float* a, const float* x, std::size_t n) noexcept
+        {
+            __m128 sum0 = _mm_setzero_ps();
+            __m128 sum1 = _mm_setzero_ps();
+            for(std::size_t i = 0; i < n; i += 8)
+            {
+                sum0 = _mm_add_ps(sum0,_mm_mul_ps(_mm_loadu_ps(a + i),_mm_loadu_ps(x + i)));
+                sum1 = _mm_add_ps(sum1,_mm_mul_ps(_mm_loadu_ps(a + i + 4),_mm_loadu_ps(x + i + 4)));
+            }
+            return sse2_sum(_mm_add_ps(sum0,sum1));
+        }
+
+        float sse2_lerp_dot(const float* a, float w, const float* x, std::size_t n) noexcept
+        {
+            auto&& b = a + n;
+            auto&& vw = _mm_set1_ps(w);
+            __m128 sum0 = _mm_setzero_ps();
+            __m128 sum1 = _mm_setzero_ps();
+            for(std::size_t i = 0; i < n; i += 8)
+            {
+                auto&& a0 = _mm_loadu_ps(a + i);
+                auto&& a1 = _mm_loadu_ps(a + i + 4);
+                auto&& c0 = _mm_add_ps(a0,_mm_mul_ps(vw,_mm_sub_ps(_mm_loadu_ps(b + i),a0)));
+                auto&& c1 = _mm_add_ps(a1,_mm_mul_ps(vw,_mm_sub_ps(_mm_loadu_ps(b + i + 4),a1)));
+                sum0 = _mm_add_ps(sum0,_mm_mul_ps(c0,_mm_loadu_ps(x + i)));
+                sum1 = _mm_add_ps(sum1,_mm_mul_ps(c1,_mm_loadu_ps(x + i + 4)));
+            }
+            return sse2_sum(_mm_add_ps(sum0,sum1));
+        }
+
+        ZAUDIO_TARGET_AVX2_FMA float avx2_sum(__m256 v) noexcept
+        {
+            auto&& half = _mm_add_ps(_mm256_castps256_ps128(v),_mm256_extractf128_ps(v,1));
+            auto&& quarter = _mm_add_ps(half,_mm_movehl_ps(half,half));
+            return _mm_cvtss_f32(_mm_add_ss(quarter,_mm_shuffle_ps(quarter,quarter,1)));
+        }
+
+        //two accumulators hide the fma latency, n is a multiple of 8 so at most one vector is left after the pairs
+        ZAUDIO_TARGET_AVX2_FMA float avx2_fma_dot(const float* a, const float* x, std::size_t n) noexcept
+        {
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            std::size_t i = 0;
+            for(; i + 16 <= n; i += 16)
+            {
+                sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),_mm256_loadu_ps(x + i),sum0);
+                sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),_mm256_loadu_ps(x + i + 8),sum1);
+            }
+            if(i < n)
+            {
+                sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),_mm256_loadu_ps(x + i),sum0);
+            }
+            return avx2_sum(_mm256_add_ps(sum0,sum1));
+        }
+
+        ZAUDIO_TARGET_AVX2_FMA float avx2_fma_lerp_dot(const float* a, float w, const float* x, std::size_t n) noexcept
+        {
+            auto&& b = a + n;
+            auto&& vw = _mm256_set1_ps(w);
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            std::size_t i = 0;
+            for(; i + 16 <= n; i += 16)
+            {
+                auto&& a0 = _mm256_loadu_ps(a + i);
+                auto&& a1 = _mm256_loadu_ps(a + i + 8);
+                auto&& c0 = _mm256_fmadd_ps(vw,_mm256_sub_ps(_mm256_loadu_ps(b + i),a0),a0);
+                auto&& c1 = _mm256_fmadd_ps(vw,_mm256_sub_ps(_mm256_loadu_ps(b + i + 8),a1),a1);
+                sum0 = _mm256_fmadd_ps(c0,_mm256_loadu_ps(x + i),sum0);
+                sum1 = _mm256_fmadd_ps(c1,_mm256_loadu_ps(x + i + 8),sum1);
+            }
+            if(i < n)
+            {
+                auto&& a0 = _mm256_loadu_ps(a + i);
+                auto&& c0 = _mm256_fmadd_ps(vw,_mm256_sub_ps(_mm256_loadu_ps(b + i),a0),a0);
+                sum0 = _mm256_fmadd_ps(c0,_mm256_loadu_ps(x + i),sum0);
+            }
+            return avx2_sum(_mm256_add_ps(sum0,sum1));
+        }
+
+        const bool use_avx2_fma = cpu_has_avx2() && cpu_has_fma();
+#else
+        float scalar_dot(const float* a, const float* x, std::size_t n) noexcept
+        {
+            float sum = 0.f;
+            for(std::size_t i = 0; i < n; ++i)
+            {
+                sum += a[i] * x[i];
+            }
+            return sum;
+        }
+
+        //the filter between a and b, which follows it in the bank, at w
+        float scalar_lerp_dot(const float* a, float w, const float* x, std::size_t n) noexcept
+        {
+            auto&& b = a + n;
+            float sum = 0.f;
+            for(std::size_t i = 0; i < n; ++i)
+            {
+                sum += (a[i] + w * (b[i] - a[i])) * x[i];
+            }
+            return sum;
+        }
+#endif
+
+        float dot_kernel(const float* a, const float* x, std::size_t n) noexcept
+        {
+#ifdef ZAUDIO_X86
+            if(use_avx2_fma)
+            {
+                return avx2_fma_dot(a,x,n);
+            }
+            return sse2_dot(a,x,n);
+#else
+            return scalar_dot(a,x,n);
+#endif
+        }
+
+        float lerp_dot_kernel(const float* a, float w, const float* x, std::size_t n) noexcept
+        {
+#ifdef ZAUDIO_X86
+            if(use_avx2_fma)
+            {
+                return avx2_fma_lerp_dot(a,w,x,n);
+            }
+            return sse2_lerp_dot(a,w,x,n);
+#else
+            return scalar_lerp_dot(a,w,x,n);
+#endif
+        }
+    }
+
+    std::ostream& operator<<(std::ostream& os, resample_quality quality)
+    {
+        switch(quality)
+        {
+        case resample_quality::draft:
+            return os<<"draft";
+        case resample_quality::standard:
+            return os<<"standard";
+        case resample_quality::high:
+            return os<<"high";
+        case resample_quality::best:
+            return os<<"best";
+        }
+        return os<<"unknown";
+    }
+
+    sample_rate_converter::sample_rate_converter(double input_rate,
+                                                 double output_rate,
+                                                 std::size_t channels,
+                                                 resample_quality quality,
+                                                 std::size_t max_frames):
+        _input_rate(input_rate),
+        _output_rate(output_rate),
+        _channels(channels),
+        _quality(quality),
+        _taps(0),
+        _phases(0),
+        _rational(false),
+        _step_frames(0),
+        _step_phases(0),
+        _step(0.0),
+        _capacity(0),
+        _filled(0),
+        _index(0),
+        _phase(0),
+        _fraction(0.0)
+    {
+        if(!(input_rate > 0.0) || !(output_rate > 0.0) || !std::isfinite(input_rate) || !std::isfinite(output_rate))
+        {
+            throw std::invalid_argument("sample_rate_converter: the sample rates must be positive");
+        }
+        if(channels == 0 || max_frames == 0)
+        {
+            throw std::invalid_argument("sample_rate_converter: channels and max_frames must not be 0");
+        }
+        auto&& preset = preset_of(quality);
+        //downsampling lowers the cutoff below the input nyquist, which takes proportionally more input taps
+        const double decimation = std::max(1.0,input_rate / output_rate);
+        _taps = align_taps(static_cast<std::size_t>(std::ceil(static_cast<double>(preset.taps) * decimation)));
+        _step = input_rate / output_rate;
+        if(whole_rate(input_rate) && whole_rate(output_rate))
+        {
+            auto&& in = static_cast<std::uint64_t>(input_rate);
+            auto&& out = static_cast<std::uint64_t>(output_rate);
+            auto&& divisor = gcd(in,out);
+            if(out / divisor <= max_rational_phases)
+            {
+                _rational = true;
+                _phases = static_cast<std::size_t>(out / divisor);
+                _step_frames = static_cast<std::size_t>((in / divisor) / _phases);
+                _step_phases = static_cast<std::size_t>((in / divisor) % _phases);
+            }
+        }
+        if(!_rational)
+        {
+            //the same stretch of the filter spans more phases when downsampling, so it needs fewer of them
+            _phases = std::max<std::size_t>(16,static_cast<std::size_t>(static_cast<double>(preset.phases) / std::ceil(decimation)));
+        }
+        _filters.resize((_phases + 1) * _taps);
+        //kaiser's estimate of the transition width for this length and attenuation, as a fraction of nyquist
+        //the stopband starts at nyquist of the lower rate
+        auto&& transition = (preset.attenuation - 7.95) / (2.285 * static_cast<double>(preset.taps) * pi);
+        _design((1.0 - transition / 2.0) / decimation,preset.attenuation);
+        _capacity = _taps + max_frames;
+        _history.resize(_capacity * _channels);
+        _planes.resize(_channels);
+        reset();
+    }
+
+    void sample_rate_converter::_design(double cutoff, double attenuation)
+    {
+        auto&& beta = attenuation > 50.0 ? 0.1102 * (attenuation - 8.7) : 0.5842 * std::pow(attenuation - 21.0,0.4) + 0.07886 * (attenuation - 21.0);
+        auto&& i0_beta = bessel_i0(beta);
+        auto&& half = static_cast<double>(_taps / 2);
+        std::vector<double> taps(_taps);
+        for(std::size_t p = 0; p <= _phases; ++p)
+        {
+            auto&& filter = _filters.data() + p * _taps;
+            auto&& fraction = static_cast<double>(p) / static_cast<double>(_phases);
+            double sum = 0.0;
+            for(std::size_t i = 0; i < _taps; ++i)
+            {
+                //distance in input frames from the output instant to tap i
+                auto&& x = fraction + half - 1.0 - static_cast<double>(i);
+                auto&& u = x / half;
+                double value = 0.0;
+                if(u > -1.0 && u < 1.0)
+                {
+                    auto&& arg = pi * cutoff * x;
+                    auto&& sinc = x == 0.0 ? 1.0 : std::sin(arg) / arg;
+                    value = cutoff * sinc * bessel_i0(beta * std::sqrt(1.0 - u * u)) / i0_beta;
+                }
+                taps[i] = value;
+                sum += value;
+            }
+            //unity gain at dc for every phase, otherwise the phase pattern shows up as a tone
+            for(std::size_t i = 0; i < _taps; ++i)
+            {
+                filter[i] = static_cast<float>(taps[i] / sum);
+            }
+        }
+    }
+
+    std::pair<std::size_t,std::size_t> sample_rate_converter::process(const float* input, std::size_t input_frames, float* output, std::size_t output_frames) noexcept
+    {
+        std::size_t consumed = 0;
+        std::size_t produced = 0;
+        for(;;)
+        {
+            produced += _produce(output + produced * _channels,output_frames - produced);
+            //drop the frames no later output needs, this keeps at least the whole filter free for new input
+            if(_index > 0)
+            {
+                const std::size_t drop = std::min(_index,_filled);
+                for(std::size_t c = 0; c < _channels; ++c)
+                {
+                    auto&& plane = _history.data() + c * _capacity;
+                    std::memmove(plane,plane + drop,(_filled - drop) * sizeof(float));
+                }
+                _filled -= drop;
+                _index -= drop;
+            }
+            if(consumed == input_frames || produced == output_frames)
+            {
+                break;
+            }
+            const std::size_t take = std::min(_capacity - _filled,input_frames - consumed);
+            for(std::size_t c = 0; c < _channels; ++c)
+            {
+                _planes[c] = _history.data() + c * _capacity + _filled;
+            }
+            deinterleave(input + consumed * _channels,_planes.data(),take,_channels);
+            _filled += take;
+            consumed += take;
+        }
+        return std::make_pair(consumed,produced);
+    }
+
+    std::pair<std::size_t,std::size_t> sample_rate_converter::process(buffer_view<float> input, buffer_view<float> output) noexcept
+    {
+        if(input.frame_width() != _channels || output.frame_width() != _channels)
+        {
+            return std::make_pair(std::size_t(0),std::size_t(0));
+        }
+        return process(input.data(),input.frame_count(),output.data(),output.frame_count());
+    }
+
+    std::size_t sample_rate_converter::_produce(float* output, std::size_t frames) noexcept
+    {
+        std::size_t produced = 0;
+        if(_rational)
+        {
+            while(produced < frames && _index + _taps <= _filled)
+            {
+                auto&& filter = _filters.data() + _phase * _taps;
+                for(std::size_t c = 0; c < _channels; ++c)
+                {
+                    output[c] = dot_kernel(filter,_history.data() + c * _capacity + _index,_taps);
+                }
+                output += _channels;
+                ++produced;
+                _index += _step_frames;
+                _phase += _step_phases;
+                if(_phase >= _phases)
+                {
+                    _phase -= _phases;
+                    ++_index;
+                }
+            }
+        }
+        else
+        {
+            while(produced < frames && _index + _taps <= _filled)
+            {
+                auto&& position = _fraction * static_cast<double>(_phases);
+                const std::size_t phase = std::min(static_cast<std::size_t>(position),_phases - 1);
+                auto&& weight = static_cast<float>(position - static_cast<double>(phase));
+                auto&& filter = _filters.data() + phase * _taps;
+                for(std::size_t c = 0; c < _channels; ++c)
+                {
+                    output[c] = lerp_dot_kernel(filter,weight,_history.data() + c * _capacity + _index,_taps);
+                }
+                output += _channels;
+                ++produced;
+                _fraction += _step;
+                auto&& whole = std::floor(_fraction);
+                _index += static_cast<std::size_t>(whole);
+                _fraction -= whole;
+            }
+        }
+        return produced;
+    }
+
+    void sample_rate_converter::reset() noexcept
+    {
+        //the output starts at the first input frame, so the filter begins with its leading half over silence
+        std::fill(_history.begin(),_history.end(),0.f);
+        _filled = _taps / 2 - 1;
+        _index = 0;
+        _phase = 0;
+        _fraction = 0.0;
+    }
+
+    std::size_t sample_rate_converter::latency() const noexcept
+    {
+        return _taps / 2;
+    }
+
+    std::size_t sample_rate_converter::expected_output(std::size_t input_frames) const noexcept
+    {
+        return static_cast<std::size_t>(std::ceil(static_cast<double>(input_frames) / _step));
+    }
+
+    std::size_t sample_rate_converter::required_input(std::size_t output_frames) const noexcept
+    {
+        if(output_frames == 0)
+        {
+            return 0;
+        }
+        auto&& steps = static_cast<std::uint64_t>(output_frames - 1);
+        std::size_t last = 0;
+        if(_rational)
+        {
+            auto&& position = static_cast<std::uint64_t>(_phase) + steps * (static_cast<std::uint64_t>(_step_frames) * _phases + _step_phases);
+            last = _index + static_cast<std::size_t>(position / _phases);
+        }
+        else
+        {
+            last = _index + static_cast<std::size_t>(std::floor(_fraction + static_cast<double>(steps) * _step));
+        }
+        return last + _taps > _filled ? last + _taps - _filled : 0;
+    }
+
+    double sample_rate_converter::input_rate() const noexcept
+    {
+        return _input_rate;
+    }
+
+    double sample_rate_converter::output_rate() const noexcept
+    {
+        return _output_rate;
+    }
+
+    std::size_t sample_rate_converter::channel_count() const noexcept
+    {
+        return _channels;
+    }
+
+    resample_quality sample_rate_converter::quality() const noexcept
+    {
+        return _quality;
+    }
+
+    std::size_t sample_rate_converter::taps() const noexcept
+    {
+        return _taps;
+    }
+
+    std::size_t sample_rate_converter::phases() const noexcept
+    {
+        return _phases;
+    }
+
+    bool sample_rate_converter::rational() const noexcept
+    {
+        return _rational;
+    }
+}
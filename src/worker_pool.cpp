@@ -0,0 +1,529 @@
+#include <worker_pool.hpp>
+#include <simd_utility.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <system_error>
+#ifdef ZAUDIO_X86
+#include <immintrin.h>
+#endif
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#if defined(_MSC_VER)
+#pragma comment(lib,"Synchronization.lib")
+#endif
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#endif
+/*
+This file is part of zaudio.
+
+    zaudio is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    zaudio is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with zaudio.  If not, see <http://www.gnu.org/licenses/>.
+*/
+namespace zaudio
+{
+    namespace
+    {
+        //keeps the fields written by different threads on different cache lines
+        constexpr std::size_t cache_line = 64;
+
+        inline void cpu_relax() noexcept
+        {
+#ifdef ZAUDIO_X86
+            _mm_pause();
+#endif
+        }
+
+        //sleeps while word still holds expected, may return early
+        void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept
+        {
+#if defined(_WIN32)
+            WaitOnAddress(reinterpret_cast<volatile VOID*>(&word),&expected,sizeof(expected),INFINITE);
+#elif defined(__linux__)
+            syscall(SYS_futex,reinterpret_cast<std::uint32_t*>(&word),FUTEX_WAIT_PRIVATE,expected,nullptr,nullptr,0);
+#else
+            //no portable address wait, poll often enough that a sleeping worker costs well under a millisecond
+            if(word.load(std::memory_order_acquire) == expected)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+#endif
+        }
+
+        void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept
+        {
+#if defined(_WIN32)
+            WakeByAddressAll(reinterpret_cast<PVOID>(&word));
+#elif defined(__linux__)
+            syscall(SYS_futex,reinterpret_cast<std::uint32_t*>(&word),FUTEX_WAKE_PRIVATE,INT_MAX,nullptr,nullptr,0);
+#else
+            static_cast<void>(word);
+#endif
+        }
+
+        //the jobs of one run call, it lives on the caller's stack until pending reaches zero
+        struct batch
+        {
+            worker_pool::job_function job;
+
+            void* context;
+
+            std::atomic<std::size_t> pending;
+        };
+
+        struct job_range
+        {
+            batch* owner;
+
+            std::size_t begin;
+
+            std::size_t end;
+        };
+
+        /*!
+         *\class job_deque
+         *\brief a fixed size chase-lev deque, the owner pushes and pops at the bottom, any thread steals from the top
+         *\note the slots are atomics, a thief may read one the owner is about to reuse but then loses the race for top and drops it
+         *\note follows Le, Pop, Cohen and Zappa Nardelli, "Correct and efficient work-stealing for weak memory models", 2013
+         */
+        class job_deque
+        {
+        public:
+            constexpr static std::int64_t capacity = 256;
+
+            job_deque() noexcept : _top(0),
+                                   _bottom(0)
+            {
+                for(auto&& s: _slots)
+                {
+                    s.owner.store(nullptr,std::memory_order_relaxed);
+                    s.begin.store(0,std::memory_order_relaxed);
+                    s.end.store(0,std::memory_order_relaxed);
+                }
+            }
+
+            //owner only, false when full
+            bool push(const job_range& job) noexcept
+            {
+                auto&& b = _bottom.load(std::memory_order_relaxed);
+                auto&& t = _top.load(std::memory_order_acquire);
+                if(b - t >= capacity)
+                {
+                    return false;
+                }
+                _write(b,job);
+                //publishes the slot and the batch behind it to thieves, which load bottom with acquire
+                _bottom.store(b + 1,std::memory_order_release);
+                return true;
+            }
+
+            //owner only
+            bool pop(job_range& job) noexcept
+            {
+                auto&& b = _bottom.load(std::memory_order_relaxed) - 1;
+                _bottom.store(b,std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto&& t = _top.load(std::memory_order_relaxed);
+                if(t > b)
+                {
+                    _bottom.store(b + 1,std::memory_order_relaxed);
+                    return false;
+                }
+                _read(b,job);
+                if(t == b)
+                {
+                    //the last job, thieves may be after it too
+                    std::int64_t expected = t;
+                    auto&& won = _top.compare_exchange_strong(expected,t + 1,std::memory_order_seq_cst,std::memory_order_relaxed);
+                    _bottom.store(b + 1,std::memory_order_relaxed);
+                    return won;
+                }
+                return true;
+            }
+
+            //any thread
+            bool steal(job_range& job) noexcept
+            {
+                std::int64_t t = _top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto&& b = _bottom.load(std::memory_order_acquire);
+                if(t >= b)
+                {
+                    return false;
+                }
+                _read(t,job);
+                return _top.compare_exchange_strong(t,t + 1,std::memory_order_seq_cst,std::memory_order_relaxed);
+            }
+
+        private:
+            struct slot
+            {
+                std::atomic<batch*> owner;
+
+                std::atomic<std::size_t> begin;
+
+                std::atomic<std::size_t> end;
+            };
+
+            void _write(std::int64_t index, const job_range& job) noexcept
+            {
+                auto&& s = _slots[index & (capacity - 1)];
+                s.owner.store(job.owner,std::memory_order_relaxed);
+                s.begin.store(job.begin,std::memory_order_relaxed);
+                s.end.store(job.end,std::memory_order_relaxed);
+            }
+
+            void _read(std::int64_t index, job_range& job) const noexcept
+            {
+                auto&& s = _slots[index & (capacity - 1)];
+                job.owner = s.owner.load(std::memory_order_relaxed);
+                job.begin = s.begin.load(std::memory_order_relaxed);
+                job.end = s.end.load(std::memory_order_relaxed);
+            }
+
+            std::atomic<std::int64_t> _top;
+
+            char _top_pad[cache_line - sizeof(std::atomic<std::int64_t>)];
+
+            std::atomic<std::int64_t> _bottom;
+
+            char _bottom_pad[cache_line - sizeof(std::atomic<std::int64_t>)];
+
+            slot _slots[capacity];
+        };
+
+        //the caller is participant 0, worker n is participant n + 1
+        struct participant
+        {
+            job_deque jobs;
+
+            //counters are written by the owning thread alone
+            std::atomic<std::uint64_t> ranges;
+
+            std::atomic<std::uint64_t> steals;
+
+            std::atomic<std::uint64_t> sleeps;
+
+            //xorshift state for picking victims
+            std::uint32_t random;
+
+            realtime_status status;
+
+            char pad[cache_line];
+
+            participant() noexcept : jobs(),
+                                     ranges(0),
+                                     steals(0),
+                                     sleeps(0),
+                                     random(0),
+                                     status(),
+                                     pad()
+            {}
+
+            void count(std::atomic<std::uint64_t>& counter) noexcept
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+            }
+
+            std::uint32_t next_random() noexcept
+            {
+                random ^= random << 13;
+                random ^= random >> 17;
+                random ^= random << 5;
+                return random;
+            }
+        };
+    }
+
+    struct worker_pool::state
+    {
+        std::unique_ptr<participant[]> participants;
+
+        std::size_t count;
+
+        std::chrono::nanoseconds spin;
+
+        //bumped by every run that posts work and by shutdown, the word sleeping workers wait on
+        std::atomic<std::uint32_t> epoch;
+
+        std::atomic<std::uint32_t> sleepers;
+
+        std::atomic<std::uint64_t> wakeups;
+
+        std::atomic<bool> stop;
+
+        std::atomic<std::size_t> started;
+
+        std::vector<std::thread> threads;
+
+        state(std::size_t workers, std::chrono::nanoseconds spin_time) : participants(new participant[workers + 1]),
+                                                                         count(workers + 1),
+                                                                         spin(spin_time),
+                                                                         epoch(0),
+                                                                         sleepers(0),
+                                                                         wakeups(0),
+                                                                         stop(false),
+                                                                         started(0),
+                                                                         threads()
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                participants[i].random = static_cast<std::uint32_t>(2654435761u * (i + 1));
+            }
+        }
+
+        void wake() noexcept
+        {
+            epoch.fetch_add(1);
+            if(sleepers.load() != 0)
+            {
+                wakeups.store(wakeups.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+                futex_wake_all(epoch);
+            }
+        }
+
+        //own queue first, newest job first, then the oldest job of the other threads starting at a random one
+        bool find(participant& self, job_range& job) noexcept
+        {
+            if(self.jobs.pop(job))
+            {
+                return true;
+            }
+            auto&& first = self.next_random() % count;
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                auto&& victim = participants[(first + i) % count];
+                if(&victim != &self && victim.jobs.steal(job))
+                {
+                    self.count(self.steals);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //keeps halving the range, leaving the upper halves for thieves, then runs what is left
+        void execute(participant& self, job_range job) noexcept
+        {
+            while(job.end - job.begin > 1)
+            {
+                auto&& middle = job.begin + (job.end - job.begin) / 2;
+                if(!self.jobs.push(job_range{job.owner,middle,job.end}))
+                {
+                    break;
+                }
+                job.end = middle;
+            }
+            for(std::size_t i = job.begin; i < job.end; ++i)
+            {
+                job.owner->job(job.owner->context,i);
+            }
+            self.count(self.ranges);
+            job.owner->pending.fetch_sub(job.end - job.begin,std::memory_order_acq_rel);
+        }
+
+        void work(std::size_t index, const realtime_policy& policy) noexcept;
+    };
+
+    namespace
+    {
+        //which pool, if any, the current thread works for, so nested runs use that worker's own queue
+        thread_local const void* current_pool = nullptr;
+
+        thread_local std::size_t current_participant = 0;
+
+        //the n-th set bit of mask, wrapping around
+        std::uint64_t nth_cpu(std::uint64_t mask, std::size_t n) noexcept
+        {
+            std::size_t bits = 0;
+            for(std::size_t cpu = 0; cpu < 64; ++cpu)
+            {
+                bits += (mask >> cpu) & 1;
+            }
+            n %= bits;
+            for(std::size_t cpu = 0; cpu < 64; ++cpu)
+            {
+                if(((mask >> cpu) & 1) && n-- == 0)
+                {
+                    return std::uint64_t(1) << cpu;
+                }
+            }
+            return 0;
+        }
+    }
+
+    void worker_pool::state::work(std::size_t index, const realtime_policy& policy) noexcept
+    {
+        current_pool = this;
+        current_participant = index;
+        auto&& self = participants[index];
+        self.status = apply_realtime_policy(policy);
+        started.fetch_add(1);
+        job_range job;
+        while(!stop.load(std::memory_order_acquire))
+        {
+            if(find(self,job))
+            {
+                execute(self,job);
+                continue;
+            }
+            //spin while a new run is likely soon, reading the clock only every few dozen tries
+            auto&& seen = epoch.load(std::memory_order_acquire);
+            auto&& deadline = std::chrono::steady_clock::now() + spin;
+            bool found = false;
+            for(std::size_t tries = 1; !found; ++tries)
+            {
+                found = find(self,job);
+                if(found || epoch.load(std::memory_order_acquire) != seen)
+                {
+                    break;
+                }
+                if(tries % 32 == 0 && std::chrono::steady_clock::now() > deadline)
+                {
+                    break;
+                }
+                cpu_relax();
+            }
+            if(found)
+            {
+                execute(self,job);
+                continue;
+            }
+            if(epoch.load(std::memory_order_acquire) != seen)
+            {
+                continue;
+            }
+            //announce the sleep before the last look at epoch, wake bumps epoch before it looks at sleepers, so one of us sees the other
+            sleepers.fetch_add(1);
+            if(epoch.load() == seen && !stop.load())
+            {
+                self.count(self.sleeps);
+                futex_wait(epoch,seen);
+            }
+            sleepers.fetch_sub(1);
+        }
+    }
+
+    worker_pool::worker_pool(std::size_t workers, const realtime_policy& policy, std::chrono::nanoseconds spin) :
+        _state(new state(workers < max_workers ? workers : max_workers,spin))
+    {
+        auto&& s = *_state;
+        try
+        {
+            for(std::size_t i = 1; i < s.count; ++i)
+            {
+                realtime_policy own = policy;
+                if(policy.cpu_mask() != 0)
+                {
+                    own.cpu_mask(nth_cpu(policy.cpu_mask(),i - 1));
+                }
+                s.threads.emplace_back([&s,i,own]{ s.work(i,own); });
+            }
+        }
+        catch(...)
+        {
+            s.stop.store(true);
+            s.wake();
+            for(auto&& t: s.threads)
+            {
+                t.join();
+            }
+            throw;
+        }
+        while(s.started.load() != s.threads.size())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    worker_pool::~worker_pool()
+    {
+        _state->stop.store(true);
+        _state->wake();
+        for(auto&& t: _state->threads)
+        {
+            t.join();
+        }
+    }
+
+    void worker_pool::run(std::size_t count, job_function job, void* context) noexcept
+    {
+        auto&& s = *_state;
+        if(count == 0)
+        {
+            return;
+        }
+        auto&& self = s.participants[current_pool == &s ? current_participant : 0];
+        batch work{job,context,{count}};
+        if(count == 1 || s.count == 1 || !self.jobs.push(job_range{&work,0,count}))
+        {
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                job(context,i);
+            }
+            return;
+        }
+        s.wake();
+        //help instead of waiting, any job found may belong to another batch but all of them finish
+        job_range next;
+        while(work.pending.load(std::memory_order_acquire) != 0)
+        {
+            if(s.find(self,next))
+            {
+                s.execute(self,next);
+            }
+            else
+            {
+                cpu_relax();
+            }
+        }
+    }
+
+    std::size_t worker_pool::worker_count() const noexcept
+    {
+        return _state->count - 1;
+    }
+
+    realtime_status worker_pool::worker_status(std::size_t worker) const noexcept
+    {
+        return worker + 1 < _state->count ? _state->participants[worker + 1].status : realtime_status();
+    }
+
+    worker_pool_statistics worker_pool::statistics() const noexcept
+    {
+        worker_pool_statistics stats;
+        for(std::size_t i = 0; i < _state->count; ++i)
+        {
+            auto&& p = _state->participants[i];
+            stats.ranges += p.ranges.load(std::memory_order_relaxed);
+            stats.steals += p.steals.load(std::memory_order_relaxed);
+            stats.sleeps += p.sleeps.load(std::memory_order_relaxed);
+        }
+        stats.wakeups = _state->wakeups.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const worker_pool_statistics& stats)
+    {
+        os<<"Ranges: "<<stats.ranges<<", Steals: "<<stats.steals<<std::endl;
+        os<<"Sleeps: "<<stats.sleeps<<", Wakeups: "<<stats.wakeups<<std::endl;
+        return os;
+    }
+}